@@ -0,0 +1,522 @@
+/*
+ * bench_chat.c
+ *  - Chat 서버 부하 측정 도구 (make bench → ./coshell_bench)
+ *  - 로컬에 chat_server()를 자식 프로세스로 띄우고 N개의 가상 클라이언트가
+ *    정해진 속도/크기로 메시지를 보내, 다른 클라이언트에 도착하기까지의
+ *    중계(fan-out) 지연과 처리량, 서버 CPU/RSS를 보고합니다.
+ *
+ * 사용 예:
+ *   ./coshell_bench                          # 4 클라이언트, 각 100 msg/s, 64B, 5초
+ *   ./coshell_bench -n 5 -r 1000 -s 256 -d 10
+ *   ./coshell_bench -r 0                     # 속도 제한 없이 최대 처리량
+ *   ./coshell_bench -n 64 -r 0 -S 1          # 서버 샤드(리액터) 수를 정해 확장성 비교
+ *   ./coshell_bench -I uring                 # 서버 소켓 I/O를 io_uring으로 (make bench-io: epoll과 비교)
+ *   ./coshell_bench -U                       # TCP 루프백 대신 서버의 유닉스 소켓(@coshell-chat-<port>)으로
+ *   ./coshell_bench -a 127.0.0.1:12345 -P <pid>   # 이미 떠 있는 서버(다른 빌드) 측정
+ *   ./coshell_bench -j                       # 결과를 JSON 한 줄로 출력 (CI 비교용)
+ *
+ * 메시지 형식은 실제 클라이언트와 같은 "[닉네임][HH:MM:SS] 본문\n" 이며,
+ * 본문 앞에 보낸 시각(CLOCK_MONOTONIC ns)을 넣어 받는 쪽에서 지연을 계산합니다.
+ * (같은 호스트에서 돌리므로 시계가 공유됨)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "chat.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#define BENCH_DEFAULT_PORT 23456    // 실행 중인 coshell 서버(12345)와 겹치지 않게
+#define BENCH_MIN_SIZE     48       // 헤더 + 시각이 들어갈 최소 크기
+#define BENCH_DRAIN_MS     1000     // 전송을 멈춘 뒤 남은 메시지를 기다리는 시간
+
+/*==============================*/
+/*   지연 히스토그램 (로그 구간)  */
+/*==============================*/
+// 2의 거듭제곱 구간마다 32칸 → 상대 오차 약 3% 이내, 메모리 고정
+#define HIST_SUB     32
+#define HIST_BUCKETS (HIST_SUB + 59 * HIST_SUB)
+
+typedef struct {
+    uint64_t count[HIST_BUCKETS];
+    uint64_t total;
+    uint64_t max;
+    double   sum;
+} Histogram;
+
+static int hist_index(uint64_t v) {
+    if (v < HIST_SUB) return (int)v;
+    int e = 63 - __builtin_clzll(v);                // e >= 5
+    int sub = (int)(v >> (e - 5)) - HIST_SUB;       // 0..31
+    int idx = HIST_SUB + (e - 5) * HIST_SUB + sub;
+    return idx < HIST_BUCKETS ? idx : HIST_BUCKETS - 1;
+}
+
+// 구간의 대표값(중간값)
+static uint64_t hist_value(int idx) {
+    if (idx < HIST_SUB) return (uint64_t)idx;
+    int e = (idx - HIST_SUB) / HIST_SUB + 5;
+    uint64_t sub = (uint64_t)((idx - HIST_SUB) % HIST_SUB) + HIST_SUB;
+    uint64_t lo = sub << (e - 5);
+    return lo + ((1ull << (e - 5)) >> 1);
+}
+
+static void hist_add(Histogram* h, uint64_t v) {
+    h->count[hist_index(v)]++;
+    h->total++;
+    h->sum += (double)v;
+    if (v > h->max) h->max = v;
+}
+
+static void hist_merge(Histogram* dst, const Histogram* src) {
+    for (int i = 0; i < HIST_BUCKETS; i++) dst->count[i] += src->count[i];
+    dst->total += src->total;
+    dst->sum += src->sum;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+static uint64_t hist_percentile(const Histogram* h, double p) {
+    if (h->total == 0) return 0;
+    uint64_t rank = (uint64_t)(p * (double)h->total);
+    if (rank >= h->total) rank = h->total - 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->count[i];
+        if (seen > rank) {
+            uint64_t v = hist_value(i);
+            return v < h->max ? v : h->max;
+        }
+    }
+    return h->max;
+}
+
+/*==============================*/
+/*         설정 / 상태          */
+/*==============================*/
+typedef struct {
+    int    clients;
+    int    rate;        // 클라이언트당 초당 메시지 수 (0이면 제한 없음)
+    int    size;        // 메시지 크기 (개행 포함)
+    int    seconds;
+    char   host[128];
+    int    port;
+    int    shards;      // 띄우는 서버의 샤드 수 (0이면 CPU 수)
+    int    io;          // 띄우는 서버의 소켓 I/O (CHAT_IO_EPOLL / CHAT_IO_URING)
+    pid_t  server_pid;  // CPU/RSS 측정 대상 (0이면 측정 안 함)
+    int    external;    // 1이면 서버를 띄우지 않고 -a 주소에 접속
+    int    local;       // 1이면 유닉스 소켓으로 접속 (같은 호스트 클라이언트 경로)
+    int    json;
+} BenchOptions;
+
+typedef struct {
+    int       id;
+    int       sock;
+    uint64_t  sent;
+    uint64_t  received;
+    uint64_t  send_blocked;     // 소켓 버퍼가 가득 차 제때 못 보낸 횟수
+    Histogram hist;
+    int       error;
+} BenchClient;
+
+static BenchOptions      opt;
+static pthread_barrier_t start_barrier;
+static uint64_t          send_until_ns;    // 이 시각까지 전송
+static uint64_t          recv_until_ns;    // 이 시각까지 수신(드레인)
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_ms(long ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    while (nanosleep(&ts, &ts) < 0 && errno == EINTR) {}
+}
+
+/*==============================*/
+/*       서버 CPU / RSS          */
+/*==============================*/
+typedef struct {
+    double cpu_sec;     // utime + stime
+    long   rss_kb;
+    long   hwm_kb;      // 최대 RSS
+} ProcStat;
+
+static int read_proc_stat(pid_t pid, ProcStat* ps) {
+    char path[64], buf[1024];
+    memset(ps, 0, sizeof(*ps));
+
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+    FILE* fp = fopen(path, "r");
+    if (!fp) return -1;
+    size_t n = fread(buf, 1, sizeof(buf) - 1, fp);
+    fclose(fp);
+    buf[n] = '\0';
+    // comm에 공백이 있을 수 있으므로 마지막 ')' 뒤부터 필드를 셈 (state가 3번째 필드)
+    char* p = strrchr(buf, ')');
+    if (!p) return -1;
+    unsigned long utime = 0, stime = 0;
+    if (sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+               &utime, &stime) != 2) return -1;
+    ps->cpu_sec = (double)(utime + stime) / (double)sysconf(_SC_CLK_TCK);
+
+    snprintf(path, sizeof(path), "/proc/%d/status", (int)pid);
+    fp = fopen(path, "r");
+    if (!fp) return -1;
+    while (fgets(buf, sizeof(buf), fp)) {
+        if (strncmp(buf, "VmRSS:", 6) == 0) ps->rss_kb = atol(buf + 6);
+        else if (strncmp(buf, "VmHWM:", 6) == 0) ps->hwm_kb = atol(buf + 6);
+    }
+    fclose(fp);
+    return 0;
+}
+
+/*==============================*/
+/*        가상 클라이언트        */
+/*==============================*/
+static int bench_connect(void) {
+    if (opt.local) {
+        struct sockaddr_un un = { .sun_family = AF_UNIX };
+        int n = snprintf(un.sun_path + 1, sizeof(un.sun_path) - 1, CHAT_LOCAL_SOCK_FMT, opt.port);
+        socklen_t len = (socklen_t)(offsetof(struct sockaddr_un, sun_path) + 1 + (size_t)n);
+        int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (sock < 0) return -1;
+        if (connect(sock, (struct sockaddr*)&un, len) < 0) {
+            close(sock);
+            return -1;
+        }
+        return sock;
+    }
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(opt.port) };
+    if (inet_pton(AF_INET, opt.host, &addr.sin_addr) != 1) return -1;
+    int sock = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0) return -1;
+    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(sock);
+        return -1;
+    }
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &(int){1}, sizeof(int));
+    return sock;
+}
+
+// "[benchK][HH:MM:SS] B <ns> xxxx...\n" 를 size 바이트로 채움
+static int build_message(char* buf, int id, uint64_t ts) {
+    int n = snprintf(buf, (size_t)opt.size, "[bench%d][00:00:00] B %llu ",
+                     id, (unsigned long long)ts);
+    while (n < opt.size - 1) buf[n++] = 'x';
+    buf[n++] = '\n';
+    return n;
+}
+
+// 받은 한 줄에서 보낸 시각을 꺼내 지연을 기록
+static void on_line(BenchClient* c, const char* line, uint64_t now) {
+    const char* p = strstr(line, "] B ");
+    if (!p) return;
+    unsigned long long ts = strtoull(p + 4, NULL, 10);
+    c->received++;
+    if (ts && now >= ts) hist_add(&c->hist, now - ts);
+}
+
+static void* client_thread(void* arg) {
+    BenchClient* c = arg;
+    char out[BUF_SIZE];
+    int  out_len = 0, out_off = 0;
+    char in[BUF_SIZE * 8];
+    int  in_len = 0;
+
+    fcntl(c->sock, F_SETFL, fcntl(c->sock, F_GETFL) | O_NONBLOCK);
+    pthread_barrier_wait(&start_barrier);
+
+    uint64_t interval = opt.rate > 0 ? 1000000000ull / (uint64_t)opt.rate : 0;
+    // 클라이언트마다 첫 전송 시각을 조금씩 엇갈리게 해서 동시에 몰리지 않도록
+    uint64_t next_send = now_ns() + (interval ? interval * (uint64_t)c->id / (uint64_t)opt.clients : 0);
+
+    for (;;) {
+        uint64_t now = now_ns();
+        if (now >= recv_until_ns) break;
+        int sending = now < send_until_ns;
+
+        // 보낼 차례면 다음 메시지 준비 (이전 메시지가 다 나가야 다음으로)
+        if (sending && out_off == out_len && now >= next_send) {
+            out_len = build_message(out, c->id, now);
+            out_off = 0;
+            next_send = interval ? next_send + interval : now;
+            // 한참 밀렸으면 따라잡으려 몰아 보내지 않고 현재 시각 기준으로 다시 맞춤
+            if (interval && next_send + 10 * interval < now) next_send = now + interval;
+        }
+        if (out_off < out_len) {
+            ssize_t w = send(c->sock, out + out_off, (size_t)(out_len - out_off), MSG_NOSIGNAL);
+            if (w > 0) {
+                out_off += (int)w;
+                if (out_off == out_len) c->sent++;
+            }
+            else if (w < 0 && errno != EAGAIN && errno != EINTR) {
+                c->error = errno;
+                break;
+            }
+            else c->send_blocked++;
+        }
+
+        // 다음 전송 시각까지 수신 대기
+        int timeout;
+        if (out_off < out_len) timeout = 1;
+        else if (sending && interval) timeout = next_send > now ? (int)((next_send - now) / 1000000) : 0;
+        else if (sending) timeout = 0;
+        else timeout = (int)((recv_until_ns - now) / 1000000) + 1;
+
+        struct pollfd pfd = { .fd = c->sock, .events = POLLIN };
+        if (out_off < out_len) pfd.events |= POLLOUT;
+        if (poll(&pfd, 1, timeout) < 0 && errno != EINTR) break;
+        if (!(pfd.revents & (POLLIN | POLLHUP | POLLERR))) continue;
+
+        ssize_t r = recv(c->sock, in + in_len, sizeof(in) - 1 - (size_t)in_len, 0);
+        if (r == 0) { c->error = ECONNRESET; break; }   // 서버가 끊음 (MAX_CLIENTS 초과 등)
+        if (r < 0) {
+            if (errno == EAGAIN || errno == EINTR) continue;
+            c->error = errno;
+            break;
+        }
+        in_len += (int)r;
+        in[in_len] = '\0';
+
+        // 줄 단위로 잘라 처리 (TCP는 경계가 없으므로 남은 조각은 다음으로)
+        uint64_t t = now_ns();
+        char* line = in;
+        char* nl;
+        while ((nl = memchr(line, '\n', (size_t)(in + in_len - line))) != NULL) {
+            *nl = '\0';
+            on_line(c, line, t);
+            line = nl + 1;
+        }
+        in_len = (int)(in + in_len - line);
+        memmove(in, line, (size_t)in_len);
+        if (in_len == (int)sizeof(in) - 1) in_len = 0;     // 개행 없는 비정상 데이터
+    }
+    return NULL;
+}
+
+/*==============================*/
+/*        로컬 서버 실행         */
+/*==============================*/
+static pid_t spawn_server(void) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        int devnull = open("/dev/null", O_WRONLY);
+        if (devnull >= 0) dup2(devnull, STDOUT_FILENO);
+        chat_server_shards = opt.shards;
+        chat_server_io = opt.io;
+        chat_server(opt.port);
+        _exit(1);
+    }
+    return pid;
+}
+
+// 서버가 listen 할 때까지 접속을 재시도 (확인용 연결은 바로 닫음)
+static int wait_for_server(pid_t pid) {
+    for (int i = 0; i < 200; i++) {
+        if (pid > 0 && waitpid(pid, NULL, WNOHANG) == pid) return -1;   // bind 실패 등
+        int s = bench_connect();
+        if (s >= 0) {
+            close(s);
+            sleep_ms(20);        // 서버가 확인용 연결을 정리할 시간
+            return 0;
+        }
+        sleep_ms(10);
+    }
+    return -1;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+        "Usage: %s [-n clients] [-r msgs/s per client, 0=unlimited] [-s bytes] [-d seconds]\n"
+        "          [-p port] [-S server shards, 0=CPUs] [-I epoll|uring]\n"
+        "          [-a host:port -P server_pid] [-U] [-j]\n", prog);
+}
+
+static int parse_options(int argc, char* argv[]) {
+    opt.clients = 4;
+    opt.rate = 100;
+    opt.size = 64;
+    opt.seconds = 5;
+    opt.port = BENCH_DEFAULT_PORT;
+    strcpy(opt.host, "127.0.0.1");
+
+    int c;
+    while ((c = getopt(argc, argv, "n:r:s:d:p:S:I:a:P:Ujh")) != -1) {
+        switch (c) {
+        case 'n': opt.clients = atoi(optarg); break;
+        case 'r': opt.rate = atoi(optarg); break;
+        case 's': opt.size = atoi(optarg); break;
+        case 'd': opt.seconds = atoi(optarg); break;
+        case 'p': opt.port = atoi(optarg); break;
+        case 'S': opt.shards = atoi(optarg); break;
+        case 'I':
+            if (strcmp(optarg, "uring") == 0) opt.io = CHAT_IO_URING;
+            else if (strcmp(optarg, "epoll") == 0) opt.io = CHAT_IO_EPOLL;
+            else return -1;
+            break;
+        case 'P': opt.server_pid = (pid_t)atoi(optarg); break;
+        case 'U': opt.local = 1; break;
+        case 'j': opt.json = 1; break;
+        case 'a': {
+            char* colon = strrchr(optarg, ':');
+            if (!colon) return -1;
+            snprintf(opt.host, sizeof(opt.host), "%.*s", (int)(colon - optarg), optarg);
+            opt.port = atoi(colon + 1);
+            opt.external = 1;
+            break;
+        }
+        default: return -1;
+        }
+    }
+    if (opt.clients < 2 || opt.rate < 0 || opt.seconds <= 0 ||
+        opt.port <= 0 || opt.port > 65535) return -1;
+    if (opt.size < BENCH_MIN_SIZE) opt.size = BENCH_MIN_SIZE;
+    if (opt.size > BUF_SIZE - 1) opt.size = BUF_SIZE - 1;   // 서버 recv 버퍼 한 번에 들어가는 크기
+    return 0;
+}
+
+/*==============================*/
+/*            main              */
+/*==============================*/
+int main(int argc, char* argv[]) {
+    if (parse_options(argc, argv) < 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    if (!opt.external && opt.clients > MAX_CLIENTS) {
+        fprintf(stderr, "warning: server accepts at most %d clients (MAX_CLIENTS)\n", MAX_CLIENTS);
+    }
+
+    pid_t child = 0;
+    if (!opt.external) {
+        child = spawn_server();
+        if (child < 0) { perror("fork"); return 1; }
+        opt.server_pid = child;
+    }
+    if (wait_for_server(child) < 0) {
+        fprintf(stderr, "cannot reach chat server at %s:%d\n", opt.host, opt.port);
+        if (child > 0) { kill(child, SIGTERM); waitpid(child, NULL, 0); }
+        return 1;
+    }
+
+    BenchClient* clients = calloc((size_t)opt.clients, sizeof(BenchClient));
+    pthread_t* tids = calloc((size_t)opt.clients, sizeof(pthread_t));
+    if (!clients || !tids) { perror("calloc"); return 1; }
+    for (int i = 0; i < opt.clients; i++) {
+        clients[i].id = i;
+        clients[i].sock = bench_connect();
+        if (clients[i].sock < 0) {
+            fprintf(stderr, "client %d: connect failed: %s\n", i, strerror(errno));
+            return 1;
+        }
+    }
+    sleep_ms(100);      // 서버가 모든 접속을 목록에 올릴 시간
+
+    ProcStat ps0 = { 0 }, ps1 = { 0 };
+    int have_ps = opt.server_pid > 0 && read_proc_stat(opt.server_pid, &ps0) == 0;
+
+    pthread_barrier_init(&start_barrier, NULL, (unsigned)opt.clients + 1);
+    for (int i = 0; i < opt.clients; i++) {
+        pthread_create(&tids[i], NULL, client_thread, &clients[i]);
+    }
+    uint64_t t0 = now_ns();
+    send_until_ns = t0 + (uint64_t)opt.seconds * 1000000000ull;
+    recv_until_ns = send_until_ns + (uint64_t)BENCH_DRAIN_MS * 1000000ull;
+    pthread_barrier_wait(&start_barrier);
+
+    for (int i = 0; i < opt.clients; i++) pthread_join(tids[i], NULL);
+    if (have_ps) have_ps = read_proc_stat(opt.server_pid, &ps1) == 0;
+
+    for (int i = 0; i < opt.clients; i++) close(clients[i].sock);
+    if (child > 0) {
+        kill(child, SIGTERM);
+        waitpid(child, NULL, 0);
+    }
+
+    /*==============================*/
+    /*            결과              */
+    /*==============================*/
+    Histogram all;
+    memset(&all, 0, sizeof(all));
+    uint64_t sent = 0, received = 0, blocked = 0;
+    int errors = 0;
+    for (int i = 0; i < opt.clients; i++) {
+        hist_merge(&all, &clients[i].hist);
+        sent += clients[i].sent;
+        received += clients[i].received;
+        blocked += clients[i].send_blocked;
+        if (clients[i].error) {
+            errors++;
+            fprintf(stderr, "client %d: %s\n", i, strerror(clients[i].error));
+        }
+    }
+    double secs = (double)opt.seconds;
+    uint64_t expected = sent * (uint64_t)(opt.clients - 1);
+    double p50 = hist_percentile(&all, 0.50) / 1e3;
+    double p99 = hist_percentile(&all, 0.99) / 1e3;
+    double p999 = hist_percentile(&all, 0.999) / 1e3;
+    double mean = all.total ? all.sum / (double)all.total / 1e3 : 0;
+    double cpu = have_ps ? (ps1.cpu_sec - ps0.cpu_sec) : 0;
+
+    if (opt.json) {
+        printf("{\"clients\":%d,\"rate\":%d,\"size\":%d,\"seconds\":%d,\"shards\":%d,\"io\":\"%s\","
+               "\"sent\":%llu,\"delivered\":%llu,\"expected\":%llu,"
+               "\"send_msgs_per_sec\":%.1f,\"delivered_msgs_per_sec\":%.1f,"
+               "\"latency_us\":{\"mean\":%.1f,\"p50\":%.1f,\"p99\":%.1f,\"p999\":%.1f,\"max\":%.1f},"
+               "\"transport\":\"%s\",\"send_blocked\":%llu,\"errors\":%d",
+               opt.clients, opt.rate, opt.size, opt.seconds, opt.external ? -1 : opt.shards,
+               opt.external ? "external" : opt.io == CHAT_IO_URING ? "uring" : "epoll",
+               (unsigned long long)sent, (unsigned long long)received, (unsigned long long)expected,
+               sent / secs, received / secs, mean, p50, p99, p999, all.max / 1e3,
+               opt.local ? "unix" : "tcp", (unsigned long long)blocked, errors);
+        if (have_ps)
+            printf(",\"server\":{\"cpu_sec\":%.2f,\"cpu_pct\":%.1f,\"rss_kb\":%ld,\"rss_peak_kb\":%ld}",
+                   cpu, cpu / secs * 100.0, ps1.rss_kb, ps1.hwm_kb);
+        printf("}\n");
+    }
+    else {
+        char rate[32];
+        if (opt.rate) snprintf(rate, sizeof(rate), "%d msg/s", opt.rate);
+        else snprintf(rate, sizeof(rate), "unlimited");
+        printf("clients %d, %s each, %d bytes, %d s (server %s:%d%s%s)\n",
+               opt.clients, rate, opt.size, opt.seconds, opt.host, opt.port,
+               opt.external ? "" : opt.io == CHAT_IO_URING ? ", io_uring" : ", epoll",
+               opt.local ? ", unix socket" : "");
+        printf("  sent        %10llu  (%.1f msg/s)\n", (unsigned long long)sent, sent / secs);
+        printf("  delivered   %10llu  (%.1f msg/s, %.2f%% of %llu expected)\n",
+               (unsigned long long)received, received / secs,
+               expected ? 100.0 * (double)received / (double)expected : 0.0,
+               (unsigned long long)expected);
+        printf("  latency us  mean %.1f  p50 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+               mean, p50, p99, p999, all.max / 1e3);
+        if (blocked) printf("  send blocked %llu times (socket buffer full)\n", (unsigned long long)blocked);
+        if (have_ps)
+            printf("  server      cpu %.2f s (%.1f%%)  rss %ld KB  peak %ld KB\n",
+                   cpu, cpu / secs * 100.0, ps1.rss_kb, ps1.hwm_kb);
+        else
+            printf("  server      cpu/rss not measured (pass -P <pid> with -a)\n");
+    }
+
+    free(clients);
+    free(tids);
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,263 @@
+/*
+ * bench_todo.c
+ *  - ToDo Core 마이크로벤치마크 (make bench → ./todo_bench)
+ *  - todo_core.c / todo_client.c 의 함수를 그대로 링크해서
+ *    load_todo, add_todo, del_todo, edit_todo, parse_todo_list, draw_todo 를
+ *    목록 크기별(기본 10 ~ 100k)로 측정하고 결과를 JSON으로 출력합니다.
+ *
+ * 사용 예:
+ *   ./todo_bench                       # 기본 크기, 결과는 stdout (JSON)
+ *   ./todo_bench -s 10,1000 -t 0.5     # 크기 목록, 연산당 최소 측정 시간(초)
+ *   ./todo_bench -o todo_bench.json    # 파일로 저장해 빌드 간 비교
+ *
+ * - 실제 파일 입출력을 재므로 임시 디렉터리(mkdtemp)에서 todo_user.txt를 만들어 사용
+ * - draw_todo는 /dev/null로 출력하는 헤드리스 curses 화면(newterm)에 그림
+ * - 앱의 MAX_TODO(100)로는 큰 목록을 만들 수 없어 이 바이너리만 -DMAX_TODO로 한도를 올려 빌드
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "todo.h"
+#include "todo_client.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <ncurses.h>
+
+#define BENCH_MIN_ITERS   5
+#define BENCH_MAX_ITERS   10000
+#define BENCH_ITEM_FMT    "benchmark task number %d [ ]"
+
+static const int default_sizes[] = { 10, 100, 1000, 10000, 100000 };
+
+static double  min_seconds = 0.2;   // 연산마다 최소 이 시간만큼 반복
+static FILE*   out;
+static int     first_result = 1;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/*==============================*/
+/*          측정 / 출력          */
+/*==============================*/
+typedef struct {
+    uint64_t* samples;
+    int       count;
+    int       cap;
+    uint64_t  started;
+} Samples;
+
+static void samples_reset(Samples* s) {
+    s->count = 0;
+    s->started = now_ns();
+}
+
+static void samples_add(Samples* s, uint64_t ns) {
+    if (s->count == s->cap) {
+        s->cap = s->cap ? s->cap * 2 : 256;
+        s->samples = realloc(s->samples, sizeof(uint64_t) * (size_t)s->cap);
+        if (!s->samples) { perror("realloc"); exit(1); }
+    }
+    s->samples[s->count++] = ns;
+}
+
+// 최소 반복 횟수와 최소 시간을 모두 채웠는지
+static int samples_done(const Samples* s) {
+    if (s->count < BENCH_MIN_ITERS) return 0;
+    if (s->count >= BENCH_MAX_ITERS) return 1;
+    return (double)(now_ns() - s->started) / 1e9 >= min_seconds;
+}
+
+static int cmp_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+static void report(const char* op, int size, Samples* s) {
+    qsort(s->samples, (size_t)s->count, sizeof(uint64_t), cmp_u64);
+    double sum = 0;
+    for (int i = 0; i < s->count; i++) sum += (double)s->samples[i];
+    fprintf(out, "%s\n    {\"op\":\"%s\",\"size\":%d,\"iters\":%d,"
+            "\"mean_ns\":%.0f,\"p50_ns\":%llu,\"p99_ns\":%llu,\"min_ns\":%llu,\"max_ns\":%llu}",
+            first_result ? "" : ",", op, size, s->count, sum / s->count,
+            (unsigned long long)s->samples[s->count / 2],
+            (unsigned long long)s->samples[(int)(s->count * 0.99)],
+            (unsigned long long)s->samples[0],
+            (unsigned long long)s->samples[s->count - 1]);
+    first_result = 0;
+    fflush(out);
+}
+
+/*==============================*/
+/*         입력 데이터 준비       */
+/*==============================*/
+static void write_todo_file(int n) {
+    FILE* fp = fopen(USER_TODO_FILE, "w");
+    if (!fp) { perror(USER_TODO_FILE); exit(1); }
+    for (int i = 0; i < n; i++) fprintf(fp, BENCH_ITEM_FMT "\n", i + 1);
+    fclose(fp);
+}
+
+// team 서버 "list" 응답과 같은 형식 (항목당 한 줄)
+static char* build_list_response(int n) {
+    size_t cap = (size_t)n * 48 + 1, len = 0;
+    char* buf = malloc(cap);
+    if (!buf) { perror("malloc"); exit(1); }
+    for (int i = 0; i < n; i++)
+        len += (size_t)snprintf(buf + len, cap - len, BENCH_ITEM_FMT "\n", i + 1);
+    buf[len] = '\0';
+    return buf;
+}
+
+/*==============================*/
+/*        크기별 측정 루틴        */
+/*==============================*/
+static void bench_size(int n, WINDOW* win, Samples* s) {
+    uint64_t t;
+
+    // load_todo: 파일 전체 읽기
+    write_todo_file(n);
+    samples_reset(s);
+    while (!samples_done(s)) {
+        t = now_ns();
+        load_todo();
+        samples_add(s, now_ns() - t);
+    }
+    report("load_todo", n, s);
+
+    // add_todo: 끝에 추가 (매번 파일 전체 다시 쓰기). 크기를 n으로 유지하려고
+    // 측정하지 않는 del_todo(1)로 되돌림
+    samples_reset(s);
+    while (!samples_done(s)) {
+        t = now_ns();
+        add_todo("benchmark added item");
+        samples_add(s, now_ns() - t);
+        del_todo(1);
+    }
+    report("add_todo", n, s);
+
+    // del_todo: 맨 앞 삭제 (배열 당기기 + 파일 쓰기), 측정하지 않는 add_todo로 복구
+    samples_reset(s);
+    while (!samples_done(s)) {
+        t = now_ns();
+        del_todo(1);
+        samples_add(s, now_ns() - t);
+        add_todo("benchmark added item");
+    }
+    report("del_todo", n, s);
+
+    // edit_todo: 가운데 항목 수정
+    samples_reset(s);
+    while (!samples_done(s)) {
+        t = now_ns();
+        edit_todo(todo_count / 2 + 1, "benchmark edited item");
+        samples_add(s, now_ns() - t);
+    }
+    report("edit_todo", n, s);
+
+    // parse_todo_list: team 모드 서버 응답 파싱
+    char* response = build_list_response(n);
+    samples_reset(s);
+    while (!samples_done(s)) {
+        t = now_ns();
+        parse_todo_list(response);
+        samples_add(s, now_ns() - t);
+    }
+    free(response);
+    report("parse_todo_list", n, s);
+
+    // draw_todo: 보이는 줄은 창 높이까지지만 함수는 전체 목록을 순회
+    samples_reset(s);
+    while (!samples_done(s)) {
+        t = now_ns();
+        draw_todo(win);
+        samples_add(s, now_ns() - t);
+    }
+    report("draw_todo", n, s);
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr, "Usage: %s [-s n1,n2,...] [-t min_seconds_per_op] [-o out.json]\n", prog);
+}
+
+int main(int argc, char* argv[]) {
+    int sizes[32], nsizes = 0;
+    const char* out_path = NULL;
+    int c;
+
+    while ((c = getopt(argc, argv, "s:t:o:h")) != -1) {
+        switch (c) {
+        case 's': {
+            char* save = NULL;
+            for (char* tok = strtok_r(optarg, ",", &save); tok && nsizes < 32;
+                 tok = strtok_r(NULL, ",", &save)) {
+                sizes[nsizes++] = atoi(tok);
+            }
+            break;
+        }
+        case 't': min_seconds = atof(optarg); break;
+        case 'o': out_path = optarg; break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (nsizes == 0) {
+        for (size_t i = 0; i < sizeof(default_sizes) / sizeof(default_sizes[0]); i++)
+            sizes[nsizes++] = default_sizes[i];
+    }
+    for (int i = 0; i < nsizes; i++) {
+        if (sizes[i] < 1 || sizes[i] >= MAX_TODO) {
+            fprintf(stderr, "size %d out of range (1..%d)\n", sizes[i], MAX_TODO - 1);
+            return 2;
+        }
+    }
+
+    out = stdout;
+    if (out_path && !(out = fopen(out_path, "w"))) {
+        perror(out_path);
+        return 1;
+    }
+
+    // 임시 디렉터리에서 실행 (USER_TODO_FILE은 상대 경로)
+    char dir[] = "/tmp/todo_bench.XXXXXX";
+    if (!mkdtemp(dir) || chdir(dir) < 0) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    // 헤드리스 curses: 출력은 /dev/null, 창 크기는 일반적인 터미널 정도
+    FILE* devnull = fopen("/dev/null", "w+");
+    SCREEN* scr = devnull ? newterm("xterm", devnull, devnull) : NULL;
+    if (!scr) {
+        fprintf(stderr, "cannot create headless curses screen\n");
+        return 1;
+    }
+    WINDOW* win = newwin(40, 60, 0, 0);
+
+    time_t now = time(NULL);
+    char stamp[32];
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    fprintf(out, "{\n  \"bench\":\"todo_core\",\"timestamp\":\"%s\",\"max_todo\":%d,"
+            "\"min_seconds\":%.3f,\n  \"results\":[", stamp, MAX_TODO, min_seconds);
+
+    Samples s = { 0 };
+    for (int i = 0; i < nsizes; i++) bench_size(sizes[i], win, &s);
+    fprintf(out, "\n  ]\n}\n");
+
+    delwin(win);
+    endwin();
+    delscreen(scr);
+    fclose(devnull);
+    if (out != stdout) fclose(out);
+    free(s.samples);
+
+    unlink(USER_TODO_FILE);
+    if (chdir("/") == 0) rmdir(dir);
+    return 0;
+}
@@ -1,14 +1,24 @@
 /*
  * chat.c
- *  - Chat 서버/클라이언트 구현 (최종판)
- *  - SIGWINCH 처리 및 non-blocking 입력 루프 적용
- *  - /add, /del, /done, /undo 명령을 로컬 ToDo로 즉시 처리
+ *  - Chat 클라이언트 구현 (서버는 chat_server.c)
+ *  - 클라이언트는 이벤트 루프(event.c)가 소켓/키 입력을 넘겨주는 방식
+ *    (접속은 호출측이 dial.c로 비동기로 마친 뒤 소켓을 넘겨줌)
+ *  - /add, /del, /done, /undo, /edit 는 "/todo ..." 제어 줄로 서버에 보내 채팅방 공유 목록에 적용
+ *    (서버가 번호를 붙여 모두에게 중계한 연산을 그 순서대로 사본에 반영, /list 로 출력)
+ *  - /send <경로> 는 채팅 서버에 전송용 연결을 따로 열어 파일을 올리고(xfer.c 쓰레드), 서버가 모두에게
+ *    알린 "/file ..." 은 번호를 붙여 보여 주었다가 /get <번호> 로 받음 (진행 상황은 render_post로 화면에)
+ *  - 보낸 메시지마다 "/ping <id>"를 붙여 서버 중계까지의 왕복 시간(RTT)을 잼 (perf.c)
+ *  - 조용할 때도 주기적으로 /ping(하트비트)을 보내고, /pong 조차 오지 않으면 연결 끊김으로 처리
+ *  - 접속하면 "/session"으로 재접속 세션을 열고 받은 바이트 수를 세어 두었다가, 끊기면
+ *    "/resume <token> <받은 바이트>"로 다시 붙어 놓친 메시지를 이어 받음 (끊긴 동안 입력은 outbox)
  */
 
 #define _POSIX_C_SOURCE 200809L
 
 #include "chat.h"
-#include "todo.h"            // add_todo(), del_todo(), done_todo(), undo_todo(), load_todo(), draw_todo()
+#include "perf.h"
+#include "render.h"
+#include "xfer.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -20,22 +30,19 @@
 #include <pthread.h>
 #include <time.h>
 #include <ncurses.h>
-#include <signal.h>
 #include <ctype.h>
+#include <errno.h>
 
 #define MAX_HISTORY 1000
+#define PING_SLOTS  64      // 응답을 기다리는 /ping 최대 개수 (id % PING_SLOTS)
+#define OUTBOX_SIZE (BUF_SIZE * 16)     // 끊긴 동안 입력한 메시지를 모아 두는 한도
+#define FILE_OFFERS 32      // /get 으로 받을 수 있는 최근 파일 알림 수
 
- // Chat 서버 관련 externs
-extern void    create_windows(int in_lobby);
+// coshell.c 창 externs
 extern WINDOW* win_custom;
 extern WINDOW* win_input;
 extern WINDOW* win_todo;
 
-// 전역 변수 (chat.h 에서 extern)
-pthread_mutex_t clients_lock = PTHREAD_MUTEX_INITIALIZER;
-int             client_socks[MAX_CLIENTS];
-int             client_count = 0;
-
 // 채팅 히스토리
 static char* chat_history[MAX_HISTORY];
 static int   history_count = 0;
@@ -50,266 +57,582 @@ static void add_history(const char* msg) {
 }
 
 // 내부 전역
-static int      sockfd;
+static int      sockfd = -1;
 static WINDOW* win_chat_border;
 static WINDOW* win_chat_inner;
 static WINDOW* g_win_input;
 static char     g_nickname[64];
+static char     inputbuf[BUF_SIZE];
+static int      input_len = 0;
+static int      unread = 0;          // 백그라운드(화면 없음) 상태에서 받은 메시지 수
+static char     rxbuf[BUF_SIZE * 2]; // 아직 개행이 오지 않은 수신 조각
+static size_t   rxlen = 0;
+static unsigned ping_seq = 0;
+static uint64_t ping_sent_ns[PING_SLOTS];
+static uint64_t last_rx_ns = 0;       // 마지막으로 무엇이든(/pong 포함) 받은 시각
+
+// 재접속 세션
+enum { HS_NONE, HS_SESSION, HS_RESUME };    // 기다리는 서버 응답: "/session <token>" / "/resumed <lost>"
+static int      handshake = HS_NONE;
+static uint64_t session_token = 0;    // 0이면 세션 없음 (재접속 불가)
+static uint64_t session_rx = 0;       // 세션 시작 후 처리한 줄의 바이트 수 (서버의 시퀀스 번호와 같음)
+static char     outbox[OUTBOX_SIZE];  // 끊겼거나 재접속 응답을 기다리는 동안 입력한 메시지
+static size_t   outbox_len = 0;
 
-// SIGWINCH 처리
-volatile sig_atomic_t win_resized = 0;
-static void handle_winch(int sig) { (void)sig; win_resized = 1; }
+// 채팅방 공유 ToDo 목록의 사본 (서버가 보낸 "/todo <seq> ..." 를 번호 순서대로 적용)
+static char*    room_todos[CHAT_TODO_MAX];     // "text [ ]" / "text [x]"
+static int      room_todo_count = 0;
+static uint64_t room_todo_seq = 0;     // 마지막으로 적용한 연산 번호
+static int      room_todo_items = 0;   // 받는 중인 목록에서 남은 항목 수
+static int      room_todo_syncing = 0; // "/todo list" 응답을 기다림 (그 전에 온 연산은 목록에 이미 들어 있음)
+static int      room_todo_show = 0;    // 목록을 다 받으면 화면에 출력 (처음 접속, 비어 있지 않을 때)
+static void     room_todos_clear(void);
 
-// 전방 선언
-static void* chat_server_handler(void* arg);
-static void* chat_recv_handler_internal(void* arg);
+// 서버가 알린 파일 ("/file <id> <size> <nick> <name>"), 번호는 알림을 받은 순서 (1부터)
+typedef struct {
+    char     id[17];
+    uint64_t size;
+    char     name[256];
+} FileOffer;
+static FileOffer file_offers[FILE_OFFERS];     // 번호 % FILE_OFFERS
+static int       file_offer_count = 0;
 
 /*==============================*/
-/*      Chat 서버 구현         */
+/*    Chat 클라이언트 구현       */
 /*==============================*/
-void chat_server(int port) {
-    int server_sock = socket(AF_INET, SOCK_STREAM, 0);
-    setsockopt(server_sock, SOL_SOCKET, SO_REUSEADDR, &(int){1}, sizeof(int));
-    struct sockaddr_in addr = {
-        .sin_family = AF_INET,
-        .sin_addr.s_addr = INADDR_ANY,
-        .sin_port = htons(port)
-    };
-    bind(server_sock, (struct sockaddr*)&addr, sizeof(addr));
-    listen(server_sock, MAX_CLIENTS);
-    printf("Chat server listening on port %d...\n", port);
-
-    while (1) {
-        int client = accept(server_sock, NULL, NULL);
-        if (client < 0) continue;
-        pthread_mutex_lock(&clients_lock);
-        if (client_count < MAX_CLIENTS) {
-            client_socks[client_count++] = client;
-            int* pclient = malloc(sizeof(int));
-            *pclient = client;
-            pthread_t tid;
-            pthread_create(&tid, NULL, chat_server_handler, pclient);
-            pthread_detach(tid);
-        }
-        else {
-            close(client);
-        }
-        pthread_mutex_unlock(&clients_lock);
+
+// 안내 한 줄: 히스토리에 남기고 화면이 붙어 있으면 출력
+static void notice(const char* msg) {
+    add_history(msg);
+    if (win_chat_inner) {
+        wprintw(win_chat_inner, "%s", msg);
+        wnoutrefresh(win_chat_inner);
     }
 }
 
-/*==============================*/
-/*  Chat 서버 쓰레드 핸들러    */
-/*==============================*/
-static void* chat_server_handler(void* arg) {
-    int sock = *(int*)arg; free(arg);
-    char buf[BUF_SIZE];
-    while (1) {
-        int len = recv(sock, buf, sizeof(buf) - 1, 0);
-        if (len <= 0) break;
-        buf[len] = '\0';
-        pthread_mutex_lock(&clients_lock);
-        for (int i = 0; i < client_count; i++) {
-            if (client_socks[i] != sock)
-                send(client_socks[i], buf, len, 0);
-        }
-        pthread_mutex_unlock(&clients_lock);
-    }
-    close(sock);
-    pthread_mutex_lock(&clients_lock);
-    for (int i = 0; i < client_count; i++) {
-        if (client_socks[i] == sock) {
-            client_socks[i] = client_socks[--client_count];
-            break;
-        }
-    }
-    pthread_mutex_unlock(&clients_lock);
-    return NULL;
+// 채팅창 테두리 안쪽에 메시지 창을 만들고 히스토리를 다시 출력
+static void chat_setup_windows(WINDOW* border, WINDOW* input) {
+    win_chat_border = border;
+    g_win_input = input;
+
+    box(win_chat_border, 0, 0);
+    mvwprintw(win_chat_border, 0, 2, " /bg: background  /quit: leave ");
+    wnoutrefresh(win_chat_border);
+
+    // derwin 대신 newwin: 부모(win_custom)가 리사이즈로 지워져도 독립적으로 정리 가능
+    int h, w, y, x;
+    getmaxyx(win_chat_border, h, w);
+    getbegyx(win_chat_border, y, x);
+    if (win_chat_inner) delwin(win_chat_inner);
+    win_chat_inner = newwin(h - 2, w - 2, y + 1, x + 1);
+    scrollok(win_chat_inner, TRUE);
+    unread = 0;
+    for (int i = 0; i < history_count; i++)
+        wprintw(win_chat_inner, "%s", chat_history[i]);
+    wnoutrefresh(win_chat_inner);
+
+    keypad(g_win_input, TRUE);
 }
 
-/*==============================*/
-/*    Chat 클라이언트 구현       */
-/*==============================*/
-void chat_client(const char* host,
-    int port,
+int chat_client_start(int fd,
     const char* nickname,
     WINDOW* client_border,
     WINDOW* client_input)
 {
     // 1) 초기화
     strncpy(g_nickname, nickname, sizeof(g_nickname) - 1);
-    win_chat_border = client_border;
-    g_win_input = client_input;
-
-    // 2) SIGWINCH 핸들러
-    struct sigaction sa = { .sa_handler = handle_winch };
-    sigaction(SIGWINCH, &sa, NULL);
-
-    // 3) Chat 서버 연결
-    struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_STREAM }, * res;
-    char port_str[6];
-    snprintf(port_str, sizeof(port_str), "%d", port);
-    if (getaddrinfo(host, port_str, &hints, &res) != 0) return;
-    sockfd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
-    if (sockfd < 0) { freeaddrinfo(res); return; }
-    if (connect(sockfd, res->ai_addr, res->ai_addrlen) < 0) {
-        freeaddrinfo(res);
-        close(sockfd);
+    input_len = 0;
+    inputbuf[0] = '\0';
+    unread = 0;
+    rxlen = 0;
+    memset(ping_sent_ns, 0, sizeof(ping_sent_ns));
+    last_rx_ns = perf_now_ns();
+    session_token = 0;
+    session_rx = 0;
+    outbox_len = 0;
+    room_todos_clear();     // 다른 서버일 수 있으므로 목록은 새로 받음
+    room_todo_seq = 0;
+    room_todo_syncing = 0;
+    file_offer_count = 0;   // 파일 id는 서버마다 다름
+
+    // 2) 재접속 세션 요청 (세션을 모르는 구버전 서버면 응답 없이 그냥 채팅)
+    sockfd = fd;
+    chat_tune_socket(sockfd, chat_idle_timeout_sec);
+    send(sockfd, "/session\n", 9, MSG_NOSIGNAL);
+    handshake = HS_SESSION;
+
+    // 3) 윈도우 설정
+    chat_setup_windows(client_border, client_input);
+    chat_client_draw_input();
+    return sockfd;
+}
+
+void chat_client_resize(WINDOW* client_border, WINDOW* client_input) {
+    chat_setup_windows(client_border, client_input);
+    chat_client_draw_input();
+}
+
+// 연결은 유지한 채 채팅 화면만 내려놓음 (수신 메시지는 히스토리에 쌓이고 unread 증가)
+void chat_client_detach(void) {
+    if (win_chat_inner) delwin(win_chat_inner);
+    win_chat_inner = NULL;
+}
+
+// 백그라운드 세션을 다시 화면에 붙임: 히스토리를 다시 출력하고 unread 초기화
+void chat_client_attach(WINDOW* client_border, WINDOW* client_input) {
+    chat_setup_windows(client_border, client_input);
+    chat_client_draw_input();
+}
+
+int chat_client_unread(void) {
+    return unread;
+}
+
+void chat_client_draw_input(void) {
+    werase(g_win_input);
+    box(g_win_input, 0, 0);
+    mvwprintw(g_win_input, 1, 2, "%s> %s", g_nickname, inputbuf);
+    wnoutrefresh(g_win_input);
+}
+
+// 연결돼 있으면 보내고, 끊긴 동안이면 outbox에 모아 두었다가 다시 붙으면 보냄
+static int send_or_queue(const char* data, size_t len) {
+    if (sockfd >= 0 && handshake != HS_RESUME) {
+        send(sockfd, data, len, MSG_NOSIGNAL);
+        return 0;
+    }
+    if (!session_token || outbox_len + len > sizeof(outbox)) return -1;
+    memcpy(outbox + outbox_len, data, len);
+    outbox_len += len;
+    return 0;
+}
+
+static void show_line(const char* line);
+
+static void show_room_todos(void) {
+    char line[BUF_SIZE + 16];
+    snprintf(line, sizeof(line), "[todo] shared list: %d item%s\n",
+             room_todo_count, room_todo_count == 1 ? "" : "s");
+    notice(line);
+    for (int i = 0; i < room_todo_count; i++) {
+        snprintf(line, sizeof(line), "  %d. %s\n", i + 1, room_todos[i]);
+        notice(line);
+    }
+}
+
+/*==============================*/
+/*          파일 전송            */
+/*==============================*/
+// 전송 쓰레드의 진행 상황 → 루프 스레드에서 안내 줄로
+static void xfer_notice(void* arg) {
+    notice(arg);
+    free(arg);
+}
+
+static void xfer_report(const char* msg) {
+    char* copy = strdup(msg);
+    if (copy && render_post(xfer_notice, copy) < 0) free(copy);
+}
+
+// 전송용 연결은 채팅 소켓이 붙은 주소로 (TCP든 같은 호스트의 유닉스 소켓이든)
+static int server_addr(struct sockaddr_storage* addr, socklen_t* len) {
+    *len = sizeof(*addr);
+    if (sockfd < 0 || handshake == HS_RESUME) return -1;
+    return getpeername(sockfd, (struct sockaddr*)addr, len);
+}
+
+// "/send <경로>" ("~/"는 홈 디렉터리)
+static void start_send(const char* path) {
+    struct sockaddr_storage addr;
+    socklen_t len;
+    char full[BUF_SIZE + 256], msg[BUF_SIZE + 512];
+    const char* home = getenv("HOME");
+    while (*path == ' ') path++;
+    if (strncmp(path, "~/", 2) == 0 && home) {
+        snprintf(full, sizeof(full), "%s/%s", home, path + 2);
+        path = full;
+    }
+    if (!*path) notice("[file] usage: /send <path>\n");
+    else if (server_addr(&addr, &len) < 0) notice("[Not connected: file not sent]\n");
+    else if (xfer_send_start((struct sockaddr*)&addr, len, path, g_nickname, xfer_report) < 0) {
+        snprintf(msg, sizeof(msg), "[file] cannot send %s: %s\n", path, strerror(errno));
+        notice(msg);
+    }
+}
+
+// inputbuf가 명령 name 그 자체이거나 name 뒤에 공백과 인자가 오는지
+static int is_command(const char* in, const char* name) {
+    size_t n = strlen(name);
+    return strncmp(in, name, n) == 0 && (in[n] == '\0' || in[n] == ' ');
+}
+
+// "/get <번호>"
+static void start_get(int n) {
+    struct sockaddr_storage addr;
+    socklen_t len;
+    char msg[BUF_SIZE];
+    if (n < 1 || n > file_offer_count || n <= file_offer_count - FILE_OFFERS) {
+        notice("[file] no such file (use the number after /get in a [file] line)\n");
         return;
     }
-    freeaddrinfo(res);
-
-    // 4) 수신 스레드
-    int* psock = malloc(sizeof(int));
-    *psock = sockfd;
-    pthread_t recv_tid;
-    pthread_create(&recv_tid, NULL, chat_recv_handler_internal, psock);
-
-    // 5) 윈도우 설정
-    box(win_chat_border, 0, 0); wrefresh(win_chat_border);
-    int h, w; getmaxyx(win_chat_border, h, w);
-    win_chat_inner = derwin(win_chat_border, h - 2, w - 2, 1, 1);
-    scrollok(win_chat_inner, TRUE);
-    wrefresh(win_chat_inner);
+    const FileOffer* f = &file_offers[n % FILE_OFFERS];
+    if (server_addr(&addr, &len) < 0) notice("[Not connected: file not requested]\n");
+    else if (xfer_get_start((struct sockaddr*)&addr, len, f->id, f->size, f->name, xfer_report) < 0) {
+        snprintf(msg, sizeof(msg), "[file] cannot receive %s: %s\n", f->name,
+                 errno == EALREADY ? "already receiving it" : strerror(errno));
+        notice(msg);
+    }
+}
 
-    // 5.5) 입력창 키패드 모드 켜기
-    keypad(g_win_input, TRUE);
+int chat_client_key(int ch) {
+    // Enter 처리 ('\n' 또는 KEY_ENTER)
+    if (ch == '\n' || ch == KEY_ENTER) {
+        inputbuf[input_len] = '\0';
 
-    // 6) 입력 루프
-    char inputbuf[BUF_SIZE] = { 0 };
-    int  len = 0;
-    while (1) {
-        // (A) 리사이즈
-        if (win_resized) {
-            win_resized = 0;
-            endwin(); refresh(); clear();
-            create_windows(0);
-            win_chat_border = win_custom;
-            g_win_input = win_input;
-            getmaxyx(win_chat_border, h, w);
-            if (win_chat_inner) delwin(win_chat_inner);
-            win_chat_inner = derwin(win_chat_border, h - 2, w - 2, 1, 1);
-            scrollok(win_chat_inner, TRUE);
-            box(win_chat_border, 0, 0); wrefresh(win_chat_border);
-            wrefresh(win_chat_inner);
-            box(g_win_input, 0, 0); wrefresh(g_win_input);
-            for (int i = 0;i < history_count;i++)
-                wprintw(win_chat_inner, "%s", chat_history[i]);
-            wrefresh(win_chat_inner);
-            load_todo();
-            draw_todo(win_todo);
-            continue;
+        // 종료 명령
+        if (!strcmp(inputbuf, "/exit") || !strcmp(inputbuf, "/quit")) {
+            input_len = 0;
+            inputbuf[0] = '\0';
+            return 1;
+        }
+        // 연결 유지한 채 로비로
+        if (!strcmp(inputbuf, "/bg")) {
+            input_len = 0;
+            inputbuf[0] = '\0';
+            return 2;
         }
 
-        // (B) 입력창 그리기
-        werase(g_win_input);
-        box(g_win_input, 0, 0);
-        mvwprintw(g_win_input, 1, 2, "%s> %s", g_nickname, inputbuf);
-        wrefresh(g_win_input);
-
-        // (C) non-blocking 입력
-        wtimeout(g_win_input, 200);
-        int ch = wgetch(g_win_input);
-        if (ch == ERR) continue;
-        if (ch == KEY_RESIZE) { win_resized = 1; continue; }
-
-        // (D) Enter 처리 ('\n' 또는 KEY_ENTER)
-        if (ch == '\n' || ch == KEY_ENTER) {
-            inputbuf[len] = '\0';
-
-            // 종료 명령
-            if (!strcmp(inputbuf, "/exit") || !strcmp(inputbuf, "/quit")) {
-                break;
-            }
+        // 서버 지표 요약: 서버가 요청한 사람에게만 "[stats] ..." 줄로 답함
+        if (!strcmp(inputbuf, "/stats")) {
+            if (sockfd >= 0 && handshake != HS_RESUME) send(sockfd, "/stats\n", 7, MSG_NOSIGNAL);
+        }
+        // 공유 To-Do 목록 출력 (받아 둔 사본)
+        else if (!strcmp(inputbuf, "/list")) {
+            show_room_todos();
+        }
+        // 파일 올리기 / 알림 받은 파일 받기 (전송은 따로 연결해 백그라운드로)
+        else if (is_command(inputbuf, "/send")) {
+            start_send(inputbuf + 5);
+        }
+        else if (is_command(inputbuf, "/get")) {
+            start_get(atoi(inputbuf + 4));
+        }
+        // To-Do 명령: 서버가 공유 목록에 적용하고 모두에게 알려 줌 (내 화면도 그 알림으로 갱신)
+        // 인자가 빠지거나 틀린 줄도 그대로 보내 서버의 사용법 안내를 받음
+        else if (is_command(inputbuf, "/add") || is_command(inputbuf, "/del") ||
+                 is_command(inputbuf, "/done") || is_command(inputbuf, "/undo") ||
+                 is_command(inputbuf, "/edit")) {
+            char pkt[BUF_SIZE + 8];
+            int plen = snprintf(pkt, sizeof(pkt), "/todo %s\n", inputbuf + 1);
+            if (send_or_queue(pkt, (size_t)plen) < 0)
+                notice("[Not connected: command not sent]\n");
+        }
+        // 모르는 명령은 채팅으로 보내지 않고 안내만 (오타가 방 전체에 나가지 않도록)
+        else if (inputbuf[0] == '/') {
+            notice("[Unknown command] /add /done /undo /del /edit /list /send /get /stats /bg /quit\n");
+        }
+        // 일반 채팅
+        else if (input_len > 0) {
+            time_t now = time(NULL);
+            char ts[16];
+            strftime(ts, sizeof(ts), "%H:%M:%S", localtime(&now));
+            char sb[BUF_SIZE];
+            int wlen = snprintf(sb, sizeof(sb),
+                "[%s][%s] ", g_nickname, ts);
+            strncat(sb, inputbuf, sizeof(sb) - wlen - 2);
+            strcat(sb, "\n");
 
-            // To-Do 명령
-            if (len > 1 && inputbuf[0] == '/') {
-                char* cmd = inputbuf + 1;
-                if (strncmp(cmd, "add ", 4) == 0) {
-                    add_todo(cmd + 4);
-                }
-                else if (strncmp(cmd, "del ", 4) == 0) {
-                    del_todo(atoi(cmd + 4));
-                }
-                else if (strncmp(cmd, "done ", 5) == 0) {
-                    done_todo(atoi(cmd + 5));
-                }
-                else if (strncmp(cmd, "undo ", 5) == 0) {
-                    undo_todo(atoi(cmd + 5));
-                }
-                else if (strncmp(cmd, "edit ", 5) == 0) {
-                    int idx;
-                    char newitem[BUF_SIZE];
-                    if (sscanf(cmd + 5, "%d %[^\n]", &idx, newitem) == 2) {
-                        edit_todo(idx, newitem);
-                    }
-                }
-
-
-
-                draw_todo(win_todo);
+            if (sockfd >= 0 && handshake != HS_RESUME) {
+                // 메시지 뒤에 /ping을 붙여 한 번에 전송 → 서버가 중계를 마친 뒤 /pong으로 응답
+                char pkt[BUF_SIZE + 32];
+                unsigned id = ++ping_seq;
+                int plen = snprintf(pkt, sizeof(pkt), "%s/ping %u\n", sb, id);
+                ping_sent_ns[id % PING_SLOTS] = perf_now_ns();
+                send(sockfd, pkt, (size_t)plen, MSG_NOSIGNAL);
+                perf_rate_add(&perf_msgs_out, 1);
             }
-            // 일반 채팅
-            else if (len > 0) {
-                time_t now = time(NULL);
-                char ts[16];
-                strftime(ts, sizeof(ts), "%H:%M:%S", localtime(&now));
-                char sb[BUF_SIZE];
-                int wlen = snprintf(sb, sizeof(sb),
-                    "[%s][%s] ", g_nickname, ts);
-                strncat(sb, inputbuf, sizeof(sb) - wlen - 2);
-                strcat(sb, "\n");
-                send(sockfd, sb, strlen(sb), 0);
-                pthread_mutex_lock(&clients_lock);
-                wprintw(win_chat_inner, "%s", sb);
-                wrefresh(win_chat_inner);
-                pthread_mutex_unlock(&clients_lock);
-                add_history(sb);
+            else if (send_or_queue(sb, strlen(sb)) < 0) {
+                notice("[Not connected: message not sent]\n");
+                input_len = 0;
+                inputbuf[0] = '\0';
+                return 0;
             }
-
-            // 초기화
-            len = 0;
-            inputbuf[0] = '\0';
-            continue;
+            wprintw(win_chat_inner, "%s", sb);
+            wnoutrefresh(win_chat_inner);
+            add_history(sb);
         }
 
-        // 백스페이스
-        if (ch == KEY_BACKSPACE || ch == 127) {
-            if (len > 0) inputbuf[--len] = '\0';
+        // 초기화
+        input_len = 0;
+        inputbuf[0] = '\0';
+    }
+    // 백스페이스
+    else if (ch == KEY_BACKSPACE || ch == 127) {
+        if (input_len > 0) inputbuf[--input_len] = '\0';
+    }
+    // 일반 문자
+    else if (isprint(ch) && input_len < BUF_SIZE - 1) {
+        inputbuf[input_len++] = (char)ch;
+        inputbuf[input_len] = '\0';
+    }
+    return 0;
+}
+
+/*==============================*/
+/*      Chat 수신 처리          */
+/*==============================*/
+// 공유 목록 전체를 다시 받음 (처음 접속, 재접속, 번호가 건너뛰었을 때)
+static void request_room_todos(int show) {
+    if (room_todo_syncing || sockfd < 0) return;
+    send(sockfd, "/todo list\n", 11, MSG_NOSIGNAL);
+    room_todo_syncing = 1;
+    room_todo_show = show;
+}
+
+static void room_todos_clear(void) {
+    for (int i = 0; i < room_todo_count; i++) {
+        free(room_todos[i]);
+        room_todos[i] = NULL;
+    }
+    room_todo_count = 0;
+}
+
+// 서버와 같은 규칙으로 사본에 적용하고 한 줄 알림
+static void room_todo_apply(const char* verb, int idx, const char* text) {
+    char item[BUF_SIZE];
+    char msg[BUF_SIZE + 32];
+    msg[0] = '\0';
+    if (strcmp(verb, "add") == 0) {
+        if (room_todo_count == CHAT_TODO_MAX) return;
+        snprintf(item, sizeof(item), "%s [ ]", text);
+        room_todos[room_todo_count++] = strdup(item);
+        snprintf(msg, sizeof(msg), "[todo] #%d added: %s\n", room_todo_count, text);
+    }
+    else if (idx >= 1 && idx <= room_todo_count && room_todos[idx - 1]) {
+        char** it = &room_todos[idx - 1];
+        size_t ilen = strlen(*it);
+        if (strcmp(verb, "del") == 0) {
+            snprintf(msg, sizeof(msg), "[todo] #%d deleted: %s\n", idx, *it);
+            free(*it);
+            memmove(it, it + 1, sizeof(*it) * (size_t)(room_todo_count - idx));
+            room_todos[--room_todo_count] = NULL;
         }
-        // 일반 문자
-        else if (isprint(ch) && len < BUF_SIZE - 1) {
-            inputbuf[len++] = (char)ch;
-            inputbuf[len] = '\0';
+        else if (strcmp(verb, "edit") == 0) {
+            snprintf(item, sizeof(item), "%s [%c]", text, ilen >= 2 ? (*it)[ilen - 2] : ' ');
+            free(*it);
+            *it = strdup(item);
+            snprintf(msg, sizeof(msg), "[todo] #%d edited: %s\n", idx, text);
+        }
+        else if (ilen >= 4 && (*it)[ilen - 1] == ']') {
+            (*it)[ilen - 2] = strcmp(verb, "done") == 0 ? 'x' : ' ';
+            snprintf(msg, sizeof(msg), "[todo] #%d %s: %.*s\n", idx,
+                     strcmp(verb, "done") == 0 ? "done" : "not done", (int)ilen - 4, *it);
         }
     }
+    if (msg[0]) show_line(msg);
+}
 
-    // 7) 종료 처리
-    close(sockfd);
-    pthread_mutex_lock(&clients_lock);
-    werase(win_chat_border);
-    box(win_chat_border, 0, 0);
-    mvwprintw(win_chat_border, 1, 2, "Chat ended. Press any key to continue.");
-    wrefresh(win_chat_border);
-    if (win_chat_inner) delwin(win_chat_inner);
-    pthread_mutex_unlock(&clients_lock);
+// "/todo <seq> <verb> <args>" (서버가 붙인 번호 순서대로만 적용)
+static void handle_todo_line(char* line) {
+    line[strcspn(line, "\n")] = '\0';
+    unsigned long long seq;
+    char verb[8];
+    int n = 0, idx = 0;
+    if (sscanf(line, "%llu %7s %n", &seq, verb, &n) != 2) return;
+    char* arg = line + n;
+
+    if (strcmp(verb, "error") == 0) {
+        char msg[BUF_SIZE];
+        snprintf(msg, sizeof(msg), "[todo] %s\n", arg);
+        notice(msg);
+        return;
+    }
+    if (strcmp(verb, "list") == 0) {
+        room_todos_clear();
+        room_todo_seq = seq;
+        room_todo_items = atoi(arg);
+        room_todo_syncing = 0;
+        return;
+    }
+    if (strcmp(verb, "item") == 0) {
+        if (room_todo_items <= 0 || seq != room_todo_seq || room_todo_count == CHAT_TODO_MAX) return;
+        room_todos[room_todo_count++] = strdup(arg);
+        if (--room_todo_items == 0 && room_todo_show) show_room_todos();
+        return;
+    }
+    if (room_todo_syncing || seq <= room_todo_seq) return;  // 받을 목록에 이미 들어 있음
+    if (seq != room_todo_seq + 1) {     // 빠진 연산이 있음 (재접속 중 잃음 등)
+        request_room_todos(0);
+        return;
+    }
+    room_todo_seq = seq;
+    if (strcmp(verb, "add") == 0) room_todo_apply(verb, 0, arg);
+    else if (sscanf(arg, "%d %n", &idx, &n) == 1) room_todo_apply(verb, idx, arg + n);
+}
+// "/file <id> <size> <nick> <name>": 누군가 올린 파일, 번호를 붙여 보여 줌
+static void handle_file_line(char* line) {
+    line[strcspn(line, "\n")] = '\0';
+    char id[17], nick[64], sz[32], msg[BUF_SIZE + 128];
+    unsigned long long size;
+    int n = 0;
+    if (sscanf(line, "%16s %llu %63s %n", id, &size, nick, &n) != 3 || !line[n]) return;
+    FileOffer* f = &file_offers[++file_offer_count % FILE_OFFERS];
+    memcpy(f->id, id, sizeof(f->id));
+    f->size = size;
+    snprintf(f->name, sizeof(f->name), "%s", line + n);
+    xfer_format_size(sz, sizeof(sz), size);
+    snprintf(msg, sizeof(msg), "[file] %s shared %s (%s): /get %d\n", nick, f->name, sz, file_offer_count);
+    show_line(msg);
 }
 
-/*==============================*/
-/*  Chat 수신 스레드 핸들러     */
-/*==============================*/
-static void* chat_recv_handler_internal(void* arg) {
-    int sock = *(int*)arg; free(arg);
-    char buf[BUF_SIZE];
-    while (1) {
-        int len = recv(sock, buf, sizeof(buf) - 1, 0);
-        if (len <= 0) break;
-        buf[len] = '\0';
-        pthread_mutex_lock(&clients_lock);
-        wprintw(win_chat_inner, "%s", buf);
-        wrefresh(win_chat_inner);
-        pthread_mutex_unlock(&clients_lock);
-        add_history(buf);
+// "/pong <id>" → RTT 기록
+static void handle_pong(const char* arg) {
+    unsigned id = (unsigned)strtoul(arg, NULL, 10);
+    uint64_t sent = ping_sent_ns[id % PING_SLOTS];
+    if (id == 0 || sent == 0) return;
+    perf_ring_add(&perf_rtt_ns, perf_now_ns() - sent);
+    ping_sent_ns[id % PING_SLOTS] = 0;
+}
+
+// 재접속 응답을 기다리는 동안 모아 둔 메시지를 보냄
+static void flush_outbox(void) {
+    if (outbox_len > 0 && sockfd >= 0) {
+        send(sockfd, outbox, outbox_len, MSG_NOSIGNAL);
+    }
+    outbox_len = 0;
+}
+
+// 세션 응답 줄 처리. 세션 줄이면 1 (화면에 내지 않고 받은 바이트에도 세지 않음)
+static int handle_session_line(const char* line) {
+    unsigned long long v;
+    if (handshake != HS_NONE && sscanf(line, "/session %llx", &v) == 1 && v != 0) {
+        if (handshake == HS_RESUME)     // 유예 시간이 지나 서버가 세션을 잊음: 새 세션
+            notice("[Reconnected as a new session]\n");
+        session_token = v;
+        session_rx = 0;
+        handshake = HS_NONE;
+        flush_outbox();
+        room_todo_syncing = 0;
+        request_room_todos(room_todo_seq == 0);     // 처음 접속이면 목록을 보여 줌
+        return 1;
+    }
+    if (handshake == HS_RESUME && sscanf(line, "/resumed %llu", &v) == 1) {
+        char msg[96];
+        if (v == 0) snprintf(msg, sizeof(msg), "[Reconnected]\n");
+        else snprintf(msg, sizeof(msg), "[Reconnected: %llu bytes of messages were lost]\n", v);
+        notice(msg);
+        session_rx += v;
+        handshake = HS_NONE;
+        flush_outbox();
+        room_todo_syncing = 0;
+        if (v > 0) request_room_todos(0);     // 잃은 부분에 연산이 있었을 수 있음
+        return 1;
+    }
+    return 0;
+}
+
+// 채팅 한 줄(개행 포함) 출력: 화면이 붙어 있으면 출력, 백그라운드면 unread 증가
+static void show_line(const char* line) {
+    add_history(line);
+    perf_rate_add(&perf_msgs_in, 1);
+    if (win_chat_inner) wprintw(win_chat_inner, "%s", line);
+    else unread++;
+}
+
+int chat_client_recv(void) {
+    int len = recv(sockfd, rxbuf + rxlen, sizeof(rxbuf) - 1 - rxlen, MSG_DONTWAIT);
+    if (len < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+    if (len <= 0) {
+        notice("[Disconnected from server]\n");
+        return -1;
+    }
+    rxlen += (size_t)len;
+    rxbuf[rxlen] = '\0';
+    last_rx_ns = perf_now_ns();
+
+    // 줄 단위로 처리 (제어 줄 /pong 은 화면에 내지 않음)
+    // 세션이 있으면 처리한 줄의 바이트를 셈 (세션 응답 줄 제외, 끊기면 여기까지 받았다고 알림)
+    // 재접속 응답 전에 온 줄은 세션이 다시 보내 주므로 버림
+    char* line = rxbuf;
+    char* nl;
+    while ((nl = strchr(line, '\n')) != NULL) {
+        char saved = nl[1];
+        nl[1] = '\0';
+        if (!handle_session_line(line) && handshake != HS_RESUME) {
+            if (session_token) session_rx += (uint64_t)(nl + 1 - line);
+            if (strncmp(line, "/pong ", 6) == 0) handle_pong(line + 6);
+            else if (strncmp(line, "/todo ", 6) == 0) handle_todo_line(line + 6);
+            else if (strncmp(line, "/file ", 6) == 0) handle_file_line(line + 6);
+            else if (strncmp(line, "/ping ", 6) != 0) show_line(line);   // 구버전 서버가 중계한 ping은 무시
+        }
+        nl[1] = saved;
+        line = nl + 1;
     }
-    return NULL;
+    rxlen = strlen(line);
+    memmove(rxbuf, line, rxlen + 1);
+    // 개행 없이 버퍼가 가득 찼으면 그대로 출력
+    if (rxlen == sizeof(rxbuf) - 1) {
+        if (session_token) session_rx += rxlen;
+        show_line(rxbuf);
+        rxlen = 0;
+    }
+    if (win_chat_inner) wnoutrefresh(win_chat_inner);
+    return 0;
+}
+
+/** 메시지 없이 RTT만 측정 (하트비트, 통계 창이 열려 있는 동안은 매 초 호출) */
+void chat_client_ping(void) {
+    if (sockfd < 0 || handshake == HS_RESUME) return;
+    char pkt[32];
+    unsigned id = ++ping_seq;
+    int plen = snprintf(pkt, sizeof(pkt), "/ping %u\n", id);
+    ping_sent_ns[id % PING_SLOTS] = perf_now_ns();
+    send(sockfd, pkt, (size_t)plen, MSG_NOSIGNAL);
+}
+
+int chat_client_check_idle(int idle_timeout_sec) {
+    if (sockfd < 0 || idle_timeout_sec <= 0) return 0;
+    if (perf_now_ns() - last_rx_ns < (uint64_t)idle_timeout_sec * 1000000000ull) return 0;
+    char msg[64];
+    snprintf(msg, sizeof(msg), "[Connection lost: no reply for %ds]\n", idle_timeout_sec);
+    notice(msg);
+    return -1;
+}
+
+int chat_client_disconnect(void) {
+    if (sockfd >= 0) close(sockfd);
+    sockfd = -1;
+    rxlen = 0;      // 덜 받은 줄은 세지 않았으므로 재접속 때 처음부터 다시 옴
+    if (!session_token) return 0;
+    notice("[Connection lost, reconnecting...]\n");
+    return 1;
+}
+
+int chat_client_resume(int fd) {
+    if (sockfd >= 0 || !session_token) return -1;
+    sockfd = fd;
+    chat_tune_socket(sockfd, chat_idle_timeout_sec);
+    char line[64];
+    int n = snprintf(line, sizeof(line), "/resume %016llx %llu\n",
+                     (unsigned long long)session_token, (unsigned long long)session_rx);
+    send(sockfd, line, (size_t)n, MSG_NOSIGNAL);
+    handshake = HS_RESUME;
+    rxlen = 0;
+    last_rx_ns = perf_now_ns();
+    return 0;
+}
+
+void chat_client_stop(void) {
+    // 정상 종료: 서버가 세션을 남겨 두지 않게
+    if (sockfd >= 0 && session_token) send(sockfd, "/bye\n", 5, MSG_NOSIGNAL);
+    if (sockfd >= 0) close(sockfd);
+    sockfd = -1;
+    session_token = 0;
+    handshake = HS_NONE;
+    outbox_len = 0;
+    unread = 0;
+    rxlen = 0;
+    // 화면은 호출측이 로비로 다시 그림 (히스토리는 다음 접속 때 다시 출력)
+    if (win_chat_inner) delwin(win_chat_inner);
+    win_chat_inner = NULL;
 }
@@ -4,13 +4,38 @@
 #include <pthread.h>
 #include <ncurses.h>
 
-#define MAX_CLIENTS 5
+#define MAX_CLIENTS 1024    // 서버 전체(모든 샤드 합계) 동시 접속 한도
 #define BUF_SIZE    1024
+#define CHAT_MAX_SHARDS 32  // 서버 리액터(샤드) 최대 수
 
-/* 채팅 전역데이터 (coshell.c에 정의됨) */
-extern pthread_mutex_t clients_lock;
-extern int client_socks[MAX_CLIENTS];
-extern int client_count;
+// 연결 감시 기본값 (설정 파일 chat.heartbeat / chat.idle_timeout 으로 변경)
+#define CHAT_HEARTBEAT_SEC     5    // 클라이언트가 "/ping 0" 을 보내는 간격
+#define CHAT_IDLE_TIMEOUT_SEC  15   // 이 시간 동안 아무것도 못 받으면 상대가 죽은 것으로 봄
+#define CHAT_SENDQ_LIMIT       (256 * 1024)     // 서버: 못 보낸 중계 데이터가 이보다 쌓이면 그 클라이언트를 끊음
+
+// 재접속 세션: 서버는 세션마다 최근 송신 데이터를 남겨 두고, 끊긴 클라이언트가 받은 데까지 알려 오면 이어서 보냄
+#define CHAT_REPLAY_BYTES      (64 * 1024)      // 서버: 세션별 재전송 링 크기
+#define CHAT_RESUME_GRACE_SEC  120  // 서버: 끊긴 세션을 재접속을 기다리며 남겨 두는 시간
+#define CHAT_RECONNECT_MIN_SEC 1    // 클라이언트: 첫 재접속 시도까지 (실패할 때마다 두 배)
+#define CHAT_RECONNECT_MAX_SEC 30
+#define CHAT_CONNECT_TIMEOUT_SEC 10 // 클라이언트: 이름 풀이부터 접속까지 한도 (설정 chat.connect_timeout)
+
+// 같은 호스트 클라이언트용 추상 유닉스 소켓 이름 (맨 앞 '\0' 뒤에 붙음, %d는 포트)
+// 서버는 TCP와 함께 이 이름으로도 받고, 클라이언트는 접속 주소가 루프백이면 이쪽을 먼저 시도
+#define CHAT_LOCAL_SOCK_FMT    "coshell-chat-%d"
+
+// 채팅방 공유 ToDo 목록 (서버가 들고 /add /done /undo /del /edit 을 적용해 모두에게 중계)
+#define CHAT_TODO_MAX          100
+#define CHAT_TODO_FILE         "todo_chat.txt"  // 서버: 실행한 디렉터리에 저장
+
+/* 채팅 서버 설정 (chat_server.c에 정의됨, chat_server() 호출 전에 설정) */
+extern int chat_idle_timeout_sec;   // 서버: 클라이언트별 수신 대기 한도 (0이면 끄기)
+extern int chat_server_shards;      // 서버 리액터 수 (0이면 온라인 CPU 수, 최대 CHAT_MAX_SHARDS)
+extern int chat_server_io;          // 소켓 I/O 방식 (CHAT_IO_EPOLL 기본)
+extern int chat_server_takeover;    // 1이면 같은 포트에서 실행 중인 서버의 리스너/연결을 넘겨받아 시작
+
+#define CHAT_IO_EPOLL  0
+#define CHAT_IO_URING  1    // Linux 6.0+, 쓸 수 없으면 시작할 때 epoll로 대체
 
 // coshell.c 에서 제공하는 UI 리사이즈 함수
 extern void create_windows(int in_lobby);
@@ -24,29 +49,99 @@ extern WINDOW *win_input;
 
 /**
  * Chat 서버를 시작합니다.
- * - 지정한 포트에 바인딩(bind) 후 listen을 합니다.
+ * - 샤드(코어)마다 같은 포트에 SO_REUSEPORT 리스너와 epoll 루프를 하나씩 띄웁니다.
+ *   (샤드 0은 호출한 쓰레드에서 돌고 돌아오지 않음)
  * - 최대 MAX_CLIENTS 클라이언트를 허용합니다.
+ * - bind/listen에 실패하면 오류를 출력하고 돌아옵니다.
+ * - chat_idle_timeout_sec 동안 아무것도 보내지 않은(하트비트 포함) 클라이언트는 끊어
+ *   잠든 노트북 등 반쯤 열린 연결이 슬롯을 차지하지 않게 합니다.
+ * - "/session" 으로 시작한 클라이언트는 끊겨도 CHAT_RESUME_GRACE_SEC 동안 세션을 남겨 두고
+ *   "/resume <token> <받은 바이트>" 로 다시 붙으면 놓친 메시지를 이어서 보냅니다.
+ * - 같은 호스트 클라이언트를 위해 추상 유닉스 소켓 "@coshell-chat-<port>"로도 받습니다.
+ * - 유닉스 소켓으로 교체 요청을 기다리다가, chat_server_takeover로 시작한 새 프로세스에게
+ *   리스너와 모든 클라이언트 연결(SCM_RIGHTS)을 넘기고 종료합니다. (무중단 업그레이드)
  */
 void chat_server(int port);
 
 /**
- * Chat 클라이언트를 실행합니다.
- * - host: 접속할 서버 호스트 이름(또는 IP).
- * - port: 접속할 포트 번호.
+ * 채팅 소켓의 TCP keepalive / TCP_USER_TIMEOUT 을 idle_timeout_sec 에 맞춰 조정하고
+ * TCP_NODELAY를 켭니다. (서버/클라이언트 공용, 커널 수준에서도 죽은 상대를 몇 초 안에 감지)
+ */
+void chat_tune_socket(int sock, int idle_timeout_sec);
+
+/**
+ * 접속된 소켓으로 채팅을 시작하고 채팅 화면을 준비합니다.
+ * - fd: Chat 서버에 연결된 소켓 (dial_start()로 UI를 막지 않고 접속한 것).
  * - nickname: 사용자의 닉네임(메시지 전송 시 사용).
  * - win_chat: ncurses 상에서 채팅 메시지를 출력할 WINDOW*.
  * - win_input: ncurses 상에서 사용자 입력을 받을 WINDOW*.
  *
- * 이 함수를 호출하면 내부적으로:
- * 1) 서버에 연결(connect)하고,
- * 2) recv_handler 스레드를 생성하여 win_chat에 수신 메시지를 출력하며,
- * 3) 사용자가 win_input에서 텍스트를 입력하면 "[닉네임][HH:MM:SS] 메시지" 형식으로 전송하고
- *    동시에 자기 메시지를 win_chat에 출력합니다.
- */
-void chat_client(const char *host,
-                 int port,
-                 const char *nickname,
-                 WINDOW *win_chat,
-                 WINDOW *win_input);
+ * 반환값: fd
+ * 호출 측은 이 fd를 이벤트 루프에 등록해 읽기 가능할 때 chat_client_recv()를,
+ * 키 입력이 오면 chat_client_key()를 호출합니다. (별도 수신 스레드 없음)
+ */
+int chat_client_start(int fd,
+                      const char *nickname,
+                      WINDOW *win_chat,
+                      WINDOW *win_input);
+
+/**
+ * 키 하나를 처리합니다.
+ * - Enter 시 "[닉네임][HH:MM:SS] 메시지" 형식으로 전송하고 자기 메시지를 win_chat에 출력
+ *   (RTT 측정용 "/ping <id>" 줄을 함께 보냄, /stats 는 서버 지표 요청)
+ * - /add, /del, /done, /undo, /edit 는 서버의 채팅방 공유 ToDo 목록에 적용 (모두에게 "[todo] ..." 알림),
+ *   /list 는 받아 둔 공유 목록 출력
+ * - /send <경로> 는 파일을 서버에 올려 모두에게 알리고, 알림 옆 번호로 /get <번호> 하면 받음 (xfer.h)
+ * 반환값: /quit 또는 /exit 입력 시 1, /bg 입력 시 2(연결 유지하고 화면만 떠남), 그 외 0
+ */
+int chat_client_key(int ch);
+
+/**
+ * 소켓에 도착한 데이터를 읽어 히스토리에 쌓고, 채팅 화면이 붙어 있으면 출력합니다.
+ * 화면이 없는(백그라운드) 동안에는 받은 줄 수만큼 unread가 늘어납니다.
+ * 서버의 "/pong <id>" 응답 줄은 화면에 내지 않고 RTT로 기록합니다(perf_rtt_ns).
+ * 반환값: 0 정상, -1 연결 종료(호출 측에서 이벤트 루프 등록 해제)
+ */
+int chat_client_recv(void);
+
+/** 입력창(닉네임> 입력중인 문장)을 다시 그립니다. */
+void chat_client_draw_input(void);
+
+/** 창이 다시 만들어졌을 때 채팅창을 새 윈도우에 맞춰 재구성합니다. */
+void chat_client_resize(WINDOW *win_chat, WINDOW *win_input);
+
+/** 연결은 유지한 채 채팅 화면만 내려놓습니다(백그라운드 세션). */
+void chat_client_detach(void);
+
+/** 백그라운드 세션을 다시 화면에 붙입니다. 히스토리를 다시 출력하고 unread를 0으로. */
+void chat_client_attach(WINDOW *win_chat, WINDOW *win_input);
+
+/** 서버에 /ping 만 보내 왕복 시간(RTT)을 잽니다. (결과는 perf_rtt_ns, 하트비트 겸용) */
+void chat_client_ping(void);
+
+/**
+ * 마지막 수신 후 idle_timeout_sec 이 지났는지 검사합니다. (매 초 호출)
+ * 반환값: 0 정상, -1 응답 없음 (히스토리/화면에 안내를 남김, 호출 측에서 연결 정리)
+ */
+int chat_client_check_idle(int idle_timeout_sec);
+
+/** 백그라운드 동안 쌓인 읽지 않은 메시지 수 */
+int chat_client_unread(void);
+
+/**
+ * 끊긴 연결의 소켓만 닫습니다. (히스토리/화면은 유지)
+ * 반환값: 재접속 세션이 있어 chat_client_resume()으로 이어 받을 수 있으면 1, 아니면 0
+ */
+int chat_client_disconnect(void);
+
+/**
+ * 같은 서버에 다시 접속한 소켓 fd로 "/resume <token> <받은 바이트>"를 보내 세션을 이어 받습니다.
+ * 서버가 놓친 메시지를 다시 보내고, 끊긴 동안 입력한 메시지는 응답을 받은 뒤 보냅니다.
+ * 반환값: 0 성공, -1 이어 받을 세션 없음 (fd는 호출 측이 닫음)
+ */
+int chat_client_resume(int fd);
+
+/** 서버에 "/bye"를 보내 세션을 끝내고, 연결을 닫고 채팅 화면을 정리합니다. */
+void chat_client_stop(void);
 
 #endif // CHAT_H
@@ -0,0 +1,1991 @@
+/*
+ * chat_server.c
+ *  - Chat 서버 구현: 코어마다 epoll 리액터(샤드) 하나, 받은 메시지를 나머지 모두에게 중계
+ *  - 샤드마다 SO_REUSEPORT 리스너 / 연결 테이블 / 연결 풀을 따로 가짐 (공유 락 없음)
+ *  - 같은 호스트 클라이언트용 추상 유닉스 소켓 리스너("@coshell-chat-<port>") 하나를 모든 샤드가
+ *    함께 지켜보며 받음 (TCP 루프백보다 지연/CPU가 적음, 연결 이후 처리는 TCP와 같음)
+ *  - 다른 샤드의 클라이언트에게는 그 샤드의 lock-free 수신함(MPSC)에 넣고 eventfd로 깨움
+ *  - 소켓 I/O는 epoll(기본) 또는 io_uring(chat_server_io, multishot accept/recv +
+ *    제공 버퍼 링 + 루프 회차마다 send를 모아 한 번에 제출), io_uring을 못 쓰면 epoll
+ *  - 접속/메시지/중계 지연 지표는 metrics.c (port+1 HTTP, 채팅 중 /stats)
+ *  - 재접속 세션: 세션마다 보낸 바이트 수(시퀀스 번호)와 최근 송신 링을 두고, 끊긴 뒤
+ *    "/resume"으로 돌아오면 그 연결을 세션이 있는 샤드로 옮겨 받은 데 이후를 다시 보냄
+ *  - 무중단 교체: 새 프로세스(chat_server_takeover)가 유닉스 소켓으로 요청하면 샤드를 세우고
+ *    리스너와 클라이언트 fd(+ 덜 읽은 줄 / 못 보낸 데이터)를 SCM_RIGHTS로 넘긴 뒤 종료
+ *  - curses를 쓰지 않으므로 벤치마크(bench_chat.c)에서도 그대로 링크해 사용
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE                 // SO_REUSEPORT, struct ucred
+
+#include "chat.h"
+#include "metrics.h"
+#include "uring.h"
+#include "xfer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <netinet/tcp.h>
+#include <linux/sockios.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/random.h>
+#include <sys/time.h>
+
+#define SHARD_EVENTS   64       // epoll_wait 한 번에 꺼내는 이벤트 수
+#define SHARD_TICK_MS  1000     // idle timeout / 송신 큐 지표 점검 간격
+#define URING_ENTRIES  1024     // 샤드별 SQ 크기 (CQ는 4배)
+#define URING_BUFS     64       // 제공 버퍼 수 (2의 거듭제곱, 크기 BUF_SIZE*2), 합이 CHAT_SENDQ_LIMIT보다 작아야
+                                // send 완료 전에 멀티샷 recv가 받는 쪽 한도를 넘기지 않음
+#define URING_BATCH    64       // 완료를 이만큼 처리할 때마다 쌓인 send를 제출
+
+// io_uring user_data: 연결/샤드 포인터(8바이트 정렬) 아래 3비트에 요청 종류
+enum { UD_ACCEPT = 1, UD_WAKE, UD_TICK, UD_RECV, UD_SEND, UD_CANCEL, UD_ACCEPT_LOCAL };
+#define UD(ptr, op)   ((uint64_t)(uintptr_t)(ptr) | (uint64_t)(op))
+#define UD_OP(ud)     ((int)((ud) & 7))
+#define UD_PTR(ud)    ((void*)(uintptr_t)((ud) & ~(uint64_t)7))
+
+// 전역 변수 (chat.h 에서 extern)
+int chat_idle_timeout_sec = CHAT_IDLE_TIMEOUT_SEC;
+int chat_server_shards = 0;
+int chat_server_io = CHAT_IO_EPOLL;
+int chat_server_takeover = 0;
+
+/*==============================*/
+/*        샤드 자료구조          */
+/*==============================*/
+typedef struct Conn {
+    int          fd;
+    int          closed;        // 테이블에서 빠짐 (풀 반납 대기)
+    int          slot;          // shard->conns 인덱스
+    int          want_out;      // epoll: EPOLLOUT 등록 여부
+    uint64_t     last_rx_ns;
+    size_t       have;
+    char         rx[BUF_SIZE * 2];  // 이전 recv에서 남은 줄 조각 + 새 데이터
+    int          rx_skip;       // rx보다 긴 줄을 버리는 중 (다음 개행까지)
+    char*        out;           // 소켓이 받지 못한 송신 데이터 (io_uring: 다음에 제출할 데이터)
+    size_t       out_len;
+    size_t       out_cap;
+
+    // io_uring: 커널에 넘긴 송신 버퍼는 완료 전까지 건드리지 않도록 out과 번갈아 씀
+    char*        sending;
+    size_t       sending_len;
+    size_t       sending_off;
+    size_t       sending_cap;
+    int          send_busy;     // SEND 요청이 진행 중
+    int          inflight;      // 완료를 기다리는 요청 수 (0이 되어야 풀에 반납)
+    int          dirty;         // s->dirty 목록에 있음
+    struct Conn* next_dirty;
+    struct Conn* next_free;
+
+    // 재접속 세션 ("/session" 으로 시작, token 0이면 세션 없음)
+    uint64_t     token;         // 아래 비트는 세션이 있는 샤드 번호
+    uint64_t     stream_pos;    // 세션으로 보낸 누적 바이트 = 클라이언트가 받은 데까지 알려 오는 시퀀스 번호
+    char*        replay;        // 최근 CHAT_REPLAY_BYTES (stream_pos % CHAT_REPLAY_BYTES 위치에 이어 씀)
+    uint64_t     detached_ns;   // 0이 아니면 소켓 없이 재접속을 기다리는 중 (그동안도 replay에 쌓음)
+    int          lost;          // io_uring: 끊겨서 진행 중인 요청이 끝나야 소켓을 닫음
+    struct ResumeReq* migrate;  // 이 연결을 세션이 있는 샤드로 넘기는 중
+    char*        xfer;          // 파일 전송 연결: 전송 쓰레드(xfer.c)로 넘길 첫 줄
+    uint64_t     serial;        // 샤드 안에서 연결마다 새 번호 (풀에서 재사용된 Conn과 구분)
+} Conn;
+
+// 샤드 수신함 노드: 중계 메시지 하나에 목적지 샤드 수만큼 붙어 있음 (할당 한 번)
+typedef struct InboxNode {
+    _Atomic(struct InboxNode*) next;
+    struct RelayMsg*           msg;
+    struct ResumeReq*          resume;  // msg 대신: 세션을 이어받을 새 연결
+    struct TodoMsg*            todo;    // msg 대신: 공유 ToDo 요청(샤드 0으로) / 응답(보낸 연결의 샤드로)
+} InboxNode;
+
+// "/resume" 으로 들어온 연결을 세션이 있는 샤드로 넘기는 요청
+typedef struct ResumeReq {
+    InboxNode         node;
+    int               fd;
+    uint64_t          token;
+    uint64_t          offset;   // 클라이언트가 받은 데까지 (stream_pos 기준)
+    size_t            have;     // "/resume" 줄 뒤에 이미 받은 데이터
+    char              rx[BUF_SIZE * 2];
+    struct ResumeReq* next_pending;
+} ResumeReq;
+
+// "/todo ..." 요청은 목록의 주인인 샤드 0으로, 그 답(목록, 오류)은 보낸 연결의 샤드로
+typedef struct TodoMsg {
+    InboxNode  node;
+    int        shard;           // 보낸 연결의 샤드
+    struct Conn* conn;
+    uint64_t   serial;          // conn->serial이 같을 때만 답을 보냄 (그새 닫혔으면 버림)
+    int        reply;           // 0: 요청 (샤드 0이 처리), 1: conn에게 보낼 답
+    size_t     len;
+    char       data[];
+} TodoMsg;
+
+// 다른 샤드로 보내는 중계 데이터 (모든 목적지 샤드가 같은 버퍼를 읽고, 마지막이 해제)
+typedef struct RelayMsg {
+    atomic_int  refs;
+    uint64_t    t_recv;         // 원래 샤드가 받은 시각
+    uint64_t    t_post;         // 수신함에 넣은 시각
+    uint64_t    lines;
+    size_t      len;
+    InboxNode*  nodes;          // [nshards]
+    char        data[];
+} RelayMsg;
+
+typedef struct Shard {
+    int          id;
+    int          io;            // CHAT_IO_EPOLL / CHAT_IO_URING
+    int          listen_fd;
+    int          epfd;
+    int          wake_fd;       // eventfd: 수신함에 새 메시지
+    Conn*        conns[MAX_CLIENTS];
+    int          nconns;
+    Conn*        free_conns;    // 닫힌 연결을 재사용 (샤드 전용 풀)
+    Conn*        dead_conns;    // 이번 회차에 닫힌 연결 (회차가 끝나면 풀로)
+    uint64_t     conn_serial;
+
+    // io_uring 백엔드
+    Uring        ring;
+    UringBufRing bufs;
+    Conn*        dirty;         // 이번 회차에 송신 데이터가 쌓인 연결
+    ResumeReq*   pending_resumes;   // 이전 연결의 요청이 끝나기를 기다리는 재접속
+    int          ctl_inflight;  // accept/wake/tick 요청 중 완료 안 된 수
+    int          quiescing;     // 교체 준비: 요청을 다시 걸지 않고 모두 끝나기를 기다림
+    uint64_t     wake_buf;      // eventfd READ 대상
+    struct __kernel_timespec tick_ts;
+
+    // Vyukov 방식 intrusive MPSC 큐 (render.c 와 같은 구조)
+    _Atomic(InboxNode*) head;
+    InboxNode*          tail;
+    InboxNode           stub;
+    atomic_int          wake_pending;   // 1이면 이미 깨우는 중 → eventfd write 생략
+
+    _Atomic int64_t     sendq_max;      // 마지막 점검 때의 송신 큐 (지표용)
+    _Atomic int64_t     sendq_total;
+} Shard;
+
+static Shard*     shards;
+static int        nshards;
+static atomic_int total_clients;    // 모든 샤드의 연결 수 (MAX_CLIENTS 한도)
+static int        local_listen_fd = -1;    // 유닉스 소켓 리스너 (모든 샤드 공용, 없으면 -1)
+
+// epoll data.ptr 로 연결과 구분하는 표시
+static char tag_listen, tag_local, tag_wake;
+
+// 무중단 교체: 넘겨주는 쪽 샤드들은 HANDOFF_PAUSE 동안 멈춰 있음
+enum { HANDOFF_NONE, HANDOFF_PAUSE };
+static atomic_int      handoff_stage;
+static pthread_mutex_t handoff_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  handoff_cond = PTHREAD_COND_INITIALIZER;
+static int             handoff_parked;
+
+// 넘겨받은 연결 (새 프로세스가 샤드에 나눠 줄 때까지 보관)
+typedef struct {
+    int      fd;                // detached면 -1
+    int      detached;
+    uint64_t idle_ns;           // detached면 끊긴 뒤 지난 시간
+    uint64_t token;
+    uint64_t stream_pos;
+    size_t   rx_len;
+    size_t   out_len;
+    size_t   replay_len;
+    char*    data;              // rx_len + out_len + replay_len
+} HandoffConn;
+
+// 전방 선언
+static void* shard_main(void* arg);
+static void* shard_main_uring(void* arg);
+static void  collect_send_queues(void);
+static void  shard_adopt(Shard* s, HandoffConn* h);
+static int   session_shard(uint64_t token);
+static void  shard_park(Shard* s);
+static void  shard_post(Shard* dst, InboxNode* n);
+static void  shard_resume(Shard* s, ResumeReq* r);
+static void  todo_inbox(Shard* s, TodoMsg* m);
+static void  todo_load(void);
+static void  todo_flush(void);
+static void  conn_input(Shard* s, Conn* c, uint64_t t_recv);
+static void  uring_arm_recv(Shard* s, Conn* c);
+static void  uring_quiesce(Shard* s);
+static void  uring_resume(Shard* s);
+static int   handoff_receive(int port, int* listeners, int* nlisteners,
+                             HandoffConn** conns, int* nconns);
+static void  handoff_serve(int port);
+
+/*==============================*/
+/*      Chat 서버 구현         */
+/*==============================*/
+// family: AF_INET6이면 IPv4도 함께 받는 듀얼 스택 ([::]), IPv6를 못 쓰는 호스트면 IPv4로
+static int open_listener(int port, int family) {
+    int fd = socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0 && family == AF_INET6) return open_listener(port, AF_INET);
+    if (fd < 0) return -1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &(int){1}, sizeof(int));
+    // 샤드마다 같은 포트에 리스너를 열고, 커널이 새 연결을 샤드들에 나눠 줌
+    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &(int){1}, sizeof(int));
+    int rc;
+    if (family == AF_INET6) {
+        setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &(int){0}, sizeof(int));
+        struct sockaddr_in6 addr = {
+            .sin6_family = AF_INET6,
+            .sin6_addr = IN6ADDR_ANY_INIT,
+            .sin6_port = htons(port)
+        };
+        rc = bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+    }
+    else {
+        struct sockaddr_in addr = {
+            .sin_family = AF_INET,
+            .sin_addr.s_addr = INADDR_ANY,
+            .sin_port = htons(port)
+        };
+        rc = bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+    }
+    if (rc < 0 && family == AF_INET6 && errno != EADDRINUSE) {
+        close(fd);                      // IPv6가 꺼진 호스트
+        return open_listener(port, AF_INET);
+    }
+    if (rc < 0 || listen(fd, SOMAXCONN) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 같은 호스트 클라이언트용 추상 유닉스 소켓 (파일이 남지 않고, 이름이 이미 쓰이면 -1)
+static int open_local_listener(int port) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    int n = snprintf(addr.sun_path + 1, sizeof(addr.sun_path) - 1, CHAT_LOCAL_SOCK_FMT, port);
+    socklen_t len = (socklen_t)(offsetof(struct sockaddr_un, sun_path) + 1 + (size_t)n);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (bind(fd, (struct sockaddr*)&addr, len) < 0 || listen(fd, SOMAXCONN) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 넘겨받은 리스너와 같은 주소 체계로 (SO_REUSEPORT 그룹은 주소 체계별로 나뉨)
+static int listener_family(int fd) {
+    struct sockaddr_storage ss;
+    socklen_t len = sizeof(ss);
+    if (getsockname(fd, (struct sockaddr*)&ss, &len) < 0) return AF_INET6;
+    return ss.ss_family;
+}
+
+// io_uring 링과 제공 버퍼 링 (실패하면 이 샤드는 epoll로)
+static int shard_init_uring(Shard* s) {
+    if (uring_init(&s->ring, URING_ENTRIES, URING_ENTRIES * 4) < 0) return -1;
+    if (uring_bufring_init(&s->ring, &s->bufs, 0, URING_BUFS, BUF_SIZE * 2) < 0) {
+        uring_exit(&s->ring);
+        return -1;
+    }
+    return 0;
+}
+
+static int shard_init(Shard* s, int id, int listen_fd, int io) {
+    s->id = id;
+    s->listen_fd = listen_fd;
+    s->epfd = -1;
+    s->ring.fd = -1;
+    s->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    atomic_init(&s->head, &s->stub);
+    s->tail = &s->stub;
+    if (s->wake_fd < 0) return -1;
+
+    s->io = (io == CHAT_IO_URING && shard_init_uring(s) == 0) ? CHAT_IO_URING : CHAT_IO_EPOLL;
+    if (s->io == CHAT_IO_URING) return 0;
+    s->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (s->epfd < 0) return -1;
+
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &tag_listen };
+    if (epoll_ctl(s->epfd, EPOLL_CTL_ADD, listen_fd, &ev) < 0) return -1;
+    if (local_listen_fd >= 0) {
+        // 모든 샤드가 같은 fd를 지켜봄: 새 연결마다 한 샤드만 깨움
+        struct epoll_event lev = { .events = EPOLLIN | EPOLLEXCLUSIVE, .data.ptr = &tag_local };
+        epoll_ctl(s->epfd, EPOLL_CTL_ADD, local_listen_fd, &lev);
+    }
+    ev.data.ptr = &tag_wake;
+    return epoll_ctl(s->epfd, EPOLL_CTL_ADD, s->wake_fd, &ev);
+}
+
+static int shard_count(void) {
+    int n = chat_server_shards;
+    if (n <= 0) n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) n = 1;
+    return n > CHAT_MAX_SHARDS ? CHAT_MAX_SHARDS : n;
+}
+
+void chat_server(int port) {
+    int want = shard_count();
+    int io = chat_server_io;
+    if (io == CHAT_IO_URING && !uring_available()) {
+        fprintf(stderr, "io_uring unavailable (needs Linux 6.0+), using epoll\n");
+        io = CHAT_IO_EPOLL;
+    }
+
+    // 교체 모드: 실행 중인 서버의 리스너와 연결을 먼저 넘겨받음 (그 서버가 끝난 뒤 돌아옴)
+    int taken[CHAT_MAX_SHARDS + 1];   // + 유닉스 소켓 리스너
+    int ntaken = 0, nadopt = 0;
+    HandoffConn* adopt = NULL;
+    if (chat_server_takeover && handoff_receive(port, taken, &ntaken, &adopt, &nadopt) < 0)
+        fprintf(stderr, "No running chat server to take over on port %d, starting fresh\n", port);
+    for (int i = 0; i < ntaken; i++) {
+        if (listener_family(taken[i]) != AF_UNIX) continue;
+        local_listen_fd = taken[i];     // 유닉스 소켓 리스너는 샤드 몫이 아니라 따로
+        taken[i] = taken[--ntaken];
+        break;
+    }
+    // 직전 서버(특히 io_uring)는 종료 후에도 커널이 링의 fd를 늦게 정리해 이름이 잠깐 남아 있을 수 있어 재시도
+    for (int tries = 20; local_listen_fd < 0; usleep(50 * 1000)) {
+        local_listen_fd = open_local_listener(port);
+        if (local_listen_fd >= 0 || errno != EADDRINUSE || --tries == 0) break;
+    }
+
+    shards = calloc((size_t)want, sizeof(Shard));
+    if (!shards) {
+        perror("chat_server");
+        return;
+    }
+    for (nshards = 0; nshards < want; nshards++) {
+        int fd = nshards < ntaken ? taken[nshards]
+               : open_listener(port, ntaken > 0 ? listener_family(taken[0]) : AF_INET6);
+        if (fd < 0) {
+            if (nshards == 0) {
+                perror("chat_server");   // 포트가 이미 사용 중인 경우 등
+                free(shards);
+                return;
+            }
+            break;                      // 샤드를 덜 만들고 계속
+        }
+        if (shard_init(&shards[nshards], nshards, fd, io) < 0) {
+            perror("chat_server: epoll/eventfd");
+            close(fd);
+            if (nshards == 0) {
+                free(shards);
+                return;
+            }
+            break;
+        }
+    }
+    printf("Chat server listening on port %d... (%d shard%s, %s, idle timeout %ds)\n",
+           port, nshards, nshards > 1 ? "s" : "",
+           shards[0].io == CHAT_IO_URING ? "io_uring" : "epoll", chat_idle_timeout_sec);
+    if (local_listen_fd >= 0)
+        printf("Local clients: unix socket @" CHAT_LOCAL_SOCK_FMT "\n", port);
+    else
+        fprintf(stderr, "Unix socket @" CHAT_LOCAL_SOCK_FMT " unavailable, local clients use TCP\n", port);
+
+    // 넘겨받은 연결은 샤드에 고르게(세션은 토큰이 가리키는 샤드로), 남는 리스너는
+    // 대기 중인 연결만 받아 두고 닫음
+    if (chat_server_takeover && ntaken > 0) {
+        for (int i = 0; i < nadopt; i++) {
+            int at = adopt[i].token ? session_shard(adopt[i].token) : i % nshards;
+            shard_adopt(&shards[at], &adopt[i]);
+            free(adopt[i].data);
+        }
+        free(adopt);
+        for (int i = nshards; i < ntaken; i++) {
+            int fd;
+            while ((fd = accept(taken[i], NULL, NULL)) >= 0) {
+                HandoffConn h = { .fd = fd };
+                shard_adopt(&shards[nadopt++ % nshards], &h);
+            }
+            close(taken[i]);
+        }
+        printf("Took over %d client%s from the previous server\n", nadopt, nadopt == 1 ? "" : "s");
+    }
+
+    todo_load();    // 교체 모드면 이전 서버가 끝난 뒤라 마지막 목록을 읽음
+    metrics_set_collect_hook(collect_send_queues);
+    // 교체 직후에는 이전 서버가 프로세스를 정리하며 지표 포트를 닫는 중일 수 있어 잠깐 재시도
+    int tries = chat_server_takeover ? 20 : 1;
+    int served;
+    while ((served = metrics_serve(port + 1)) < 0 && --tries > 0) usleep(50 * 1000);
+    if (served == 0)
+        printf("Metrics: http://127.0.0.1:%d/metrics\n", port + 1);
+    else
+        fprintf(stderr, "Metrics endpoint unavailable (port %d in use?)\n", port + 1);
+    handoff_serve(port);
+    fflush(stdout);
+
+    // 샤드 0은 호출한 쓰레드에서 실행 (chat_server는 돌아오지 않음)
+    for (int i = 1; i < nshards; i++) {
+        pthread_t tid;
+        void* (*run)(void*) = shards[i].io == CHAT_IO_URING ? shard_main_uring : shard_main;
+        if (pthread_create(&tid, NULL, run, &shards[i]) == 0) pthread_detach(tid);
+    }
+    if (shards[0].io == CHAT_IO_URING) shard_main_uring(&shards[0]);
+    else shard_main(&shards[0]);
+}
+
+// keepalive: idle/3 초 조용하면 탐침, idle/6 간격으로 3번 → 대략 idle 안에 감지
+// TCP_USER_TIMEOUT: 보낸 데이터가 idle 초 동안 ACK되지 않으면 연결 종료
+// (유닉스 소켓은 상대 프로세스가 죽으면 커널이 바로 끊으므로 조정할 것이 없음)
+void chat_tune_socket(int sock, int idle_timeout_sec) {
+    struct sockaddr_storage ss;
+    socklen_t len = sizeof(ss);
+    if (getsockname(sock, (struct sockaddr*)&ss, &len) == 0 && ss.ss_family == AF_UNIX) return;
+    // 짧은 줄을 바로 내보냄: Nagle이 앞 세그먼트의 ACK(지연 ACK 최대 수십 ms)를 기다리지 않게
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &(int){1}, sizeof(int));
+    if (idle_timeout_sec <= 0) return;
+    int keepidle = idle_timeout_sec / 3 > 0 ? idle_timeout_sec / 3 : 1;
+    int keepintvl = idle_timeout_sec / 6 > 0 ? idle_timeout_sec / 6 : 1;
+    int keepcnt = 3;
+    unsigned int user_timeout = (unsigned int)idle_timeout_sec * 1000;
+    setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &(int){1}, sizeof(int));
+    setsockopt(sock, IPPROTO_TCP, TCP_KEEPIDLE, &keepidle, sizeof(keepidle));
+    setsockopt(sock, IPPROTO_TCP, TCP_KEEPINTVL, &keepintvl, sizeof(keepintvl));
+    setsockopt(sock, IPPROTO_TCP, TCP_KEEPCNT, &keepcnt, sizeof(keepcnt));
+    setsockopt(sock, IPPROTO_TCP, TCP_USER_TIMEOUT, &user_timeout, sizeof(user_timeout));
+}
+
+// 지표를 읽을 때마다: 샤드들이 매 초 점검해 둔 송신 큐 값을 합산
+static void collect_send_queues(void) {
+    int64_t max = 0, total = 0;
+    for (int i = 0; i < nshards; i++) {
+        int64_t m = atomic_load_explicit(&shards[i].sendq_max, memory_order_relaxed);
+        total += atomic_load_explicit(&shards[i].sendq_total, memory_order_relaxed);
+        if (m > max) max = m;
+    }
+    metrics_gauge_set(MET_GAUGE_SENDQ_MAX, max);
+    metrics_gauge_set(MET_GAUGE_SENDQ_TOTAL, total);
+}
+
+/*==============================*/
+/*        연결 관리 (샤드)       */
+/*==============================*/
+static void conn_watch_out(Shard* s, Conn* c, int on) {
+    if (c->want_out == on) return;
+    struct epoll_event ev = { .events = EPOLLIN | (on ? EPOLLOUT : 0), .data.ptr = c };
+    epoll_ctl(s->epfd, EPOLL_CTL_MOD, c->fd, &ev);
+    c->want_out = on;
+}
+
+static void resume_post(ResumeReq* r);
+
+// 소켓을 닫고 회차가 끝날 때 풀로 반납되도록 표시
+// (세션 샤드로 넘기는 연결은 닫지 않고 그 샤드의 수신함으로, 파일 전송 연결은 전송 쓰레드로 보냄)
+static void conn_release(Shard* s, Conn* c) {
+    if (c->migrate) {
+        if (s->io == CHAT_IO_EPOLL) epoll_ctl(s->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+        c->migrate->fd = c->fd;
+        resume_post(c->migrate);
+        c->migrate = NULL;
+    }
+    else if (c->xfer) {
+        if (s->io == CHAT_IO_EPOLL) epoll_ctl(s->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+        if (xfer_serve(c->fd, c->xfer, strlen(c->xfer)) < 0) close(c->fd);
+        free(c->xfer);
+        c->xfer = NULL;
+    }
+    else if (c->fd >= 0) close(c->fd);
+    c->fd = -1;
+    c->next_free = s->dead_conns;
+    s->dead_conns = c;
+}
+
+// 테이블에서 뺌 (닫기 / 다른 샤드로 넘기기 공용)
+static void conn_unlink(Shard* s, Conn* c) {
+    c->closed = 1;
+    Conn* last = s->conns[--s->nconns];
+    s->conns[c->slot] = last;
+    last->slot = c->slot;
+    atomic_fetch_sub(&total_clients, 1);
+    metrics_gauge_add(MET_GAUGE_CLIENTS, -1);
+}
+
+// 테이블에서 빼고 소켓을 닫음. 같은 회차의 이벤트가 아직 c를 가리킬 수 있어
+// 풀 반납은 회차가 끝난 뒤 (shard_reap)
+// io_uring: 진행 중인 recv/send가 끝나야(shutdown으로 곧 끝남) 닫고 반납
+static void conn_close(Shard* s, Conn* c) {
+    if (c->closed) return;
+    conn_unlink(s, c);
+    metrics_add(MET_CONN_CLOSED, 1);
+    if (s->io == CHAT_IO_URING && c->inflight > 0) shutdown(c->fd, SHUT_RDWR);
+    else conn_release(s, c);
+}
+
+// 세션의 소켓만 닫고 재접속을 기다림 (테이블에 남아 중계 데이터는 replay에 계속 쌓임)
+static void conn_detach(Shard* s, Conn* c) {
+    (void)s;
+    close(c->fd);
+    c->fd = -1;
+    c->lost = 0;
+    c->want_out = 0;
+    c->have = 0;
+    c->rx_skip = 0;
+    c->out_len = 0;
+    c->sending_len = c->sending_off = 0;
+    c->detached_ns = metrics_now_ns();
+}
+
+// 연결이 끊겼거나 따라오지 못함: 세션이면 재접속을 기다리고, 아니면 닫음
+static void conn_lost(Shard* s, Conn* c) {
+    if (c->closed || !c->token) {
+        conn_close(s, c);
+        return;
+    }
+    if (c->detached_ns || c->lost) return;
+    if (s->io == CHAT_IO_URING && c->inflight > 0) {
+        c->lost = 1;
+        shutdown(c->fd, SHUT_RDWR);
+    }
+    else conn_detach(s, c);
+}
+
+static void shard_reap(Shard* s) {
+    while (s->dead_conns) {
+        Conn* c = s->dead_conns;
+        s->dead_conns = c->next_free;
+        c->next_free = s->free_conns;
+        s->free_conns = c;
+    }
+}
+
+// 세션 송신 기록: replay 링에 이어 쓰고 시퀀스 번호(stream_pos)를 올림
+static void replay_record(Conn* c, const char* data, size_t len) {
+    c->stream_pos += len;
+    if (len > CHAT_REPLAY_BYTES) {
+        data += len - CHAT_REPLAY_BYTES;
+        len = CHAT_REPLAY_BYTES;
+    }
+    size_t at = (size_t)((c->stream_pos - len) % CHAT_REPLAY_BYTES);
+    size_t first = CHAT_REPLAY_BYTES - at < len ? CHAT_REPLAY_BYTES - at : len;
+    memcpy(c->replay + at, data, first);
+    memcpy(c->replay, data + first, len - first);
+}
+
+// replay 링에서 [from, stream_pos) 를 꺼냄 (호출측이 from이 링 안에 있는지 확인)
+static size_t replay_copy(const Conn* c, uint64_t from, char* out) {
+    size_t len = (size_t)(c->stream_pos - from);
+    size_t at = (size_t)(from % CHAT_REPLAY_BYTES);
+    size_t first = CHAT_REPLAY_BYTES - at < len ? CHAT_REPLAY_BYTES - at : len;
+    memcpy(out, c->replay + at, first);
+    memcpy(out + first, c->replay, len - first);
+    return len;
+}
+
+// 송신 버퍼 뒤에 붙임. 못 보낸 양이 CHAT_SENDQ_LIMIT를 넘으면 따라오지 못하는
+// 클라이언트로 보고 끊음 (세션은 재접속 때 replay로 이어받음)
+static int conn_queue(Shard* s, Conn* c, const char* data, size_t len) {
+    size_t need = c->out_len + len;
+    if (need + (c->sending_len - c->sending_off) > CHAT_SENDQ_LIMIT) {
+        metrics_add(MET_SEND_ERRORS, 1);
+        conn_lost(s, c);
+        return -1;
+    }
+    if (need > c->out_cap) {
+        size_t cap = c->out_cap ? c->out_cap : BUF_SIZE * 4;
+        while (cap < need) cap *= 2;
+        char* p = realloc(c->out, cap);
+        if (!p) {
+            conn_close(s, c);
+            return -1;
+        }
+        c->out = p;
+        c->out_cap = cap;
+    }
+    memcpy(c->out + c->out_len, data, len);
+    c->out_len = need;
+    return 0;
+}
+
+// epoll: 보낼 수 있는 만큼 바로 보내고, 나머지는 쌓아 두었다가 EPOLLOUT 때 보냄
+// io_uring: 쌓아 두고 회차 끝에 연결마다 SEND 하나로 모아 제출 (shard_submit_sends)
+// (세션 기록 없이 보냄: 세션 핸드셰이크 응답, replay 재전송)
+static int conn_send_raw(Shard* s, Conn* c, const char* data, size_t len) {
+    if (c->closed || c->detached_ns || c->lost) return -1;
+    if (s->io == CHAT_IO_URING) {
+        if (conn_queue(s, c, data, len) < 0) return -1;
+        if (!c->dirty) {
+            c->dirty = 1;
+            c->next_dirty = s->dirty;
+            s->dirty = c;
+        }
+        return 0;
+    }
+    size_t sent = 0;
+    if (c->out_len == 0) {
+        ssize_t w = send(c->fd, data, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (w < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            metrics_add(MET_SEND_ERRORS, 1);
+            conn_lost(s, c);
+            return -1;
+        }
+        if (w > 0) sent = (size_t)w;
+    }
+    if (sent < len) {
+        if (conn_queue(s, c, data + sent, len - sent) < 0) return -1;
+        conn_watch_out(s, c, 1);
+    }
+    return 0;
+}
+
+// 세션이면 replay에 남기고 보냄 (끊겨 있으면 남기기만 하고 재접속 때 보냄)
+static int conn_send(Shard* s, Conn* c, const char* data, size_t len) {
+    if (c->closed) return -1;
+    if (c->token) {
+        replay_record(c, data, len);
+        if (c->detached_ns || c->lost) return 0;
+    }
+    return conn_send_raw(s, c, data, len);
+}
+
+static void conn_flush(Shard* s, Conn* c) {
+    size_t off = 0;
+    while (off < c->out_len) {
+        ssize_t w = send(c->fd, c->out + off, c->out_len - off, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (w > 0) { off += (size_t)w; continue; }
+        if (w < 0 && errno == EINTR) continue;
+        if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        metrics_add(MET_SEND_ERRORS, 1);
+        conn_lost(s, c);
+        return;
+    }
+    memmove(c->out, c->out + off, c->out_len - off);
+    c->out_len -= off;
+    if (c->out_len == 0) conn_watch_out(s, c, 0);
+}
+
+// io_uring은 O_NONBLOCK이면 기다리지 않고 EAGAIN으로 끝내므로 epoll에서만
+// (넘겨받거나 옮겨 온 fd는 다른 방식으로 설정돼 있을 수 있어 양쪽 모두 맞춤)
+static void conn_setup_fd(Shard* s, int fd) {
+    int fl = fcntl(fd, F_GETFL);
+    fcntl(fd, F_SETFL, s->io == CHAT_IO_EPOLL ? fl | O_NONBLOCK : fl & ~O_NONBLOCK);
+    chat_tune_socket(fd, chat_idle_timeout_sec);
+}
+
+// 새 연결을 테이블에 올림 (epoll 등록 / io_uring recv 시작은 conn_register)
+// fd가 -1이면 소켓 없이 재접속을 기다리는 세션 (넘겨받은 세션)
+static Conn* conn_open(Shard* s, int fd) {
+    if (atomic_fetch_add(&total_clients, 1) >= MAX_CLIENTS) {
+        atomic_fetch_sub(&total_clients, 1);
+        if (fd >= 0) close(fd);
+        metrics_add(MET_CONN_REJECTED, 1);
+        return NULL;
+    }
+    Conn* c = s->free_conns;
+    if (c) s->free_conns = c->next_free;
+    else if (!(c = calloc(1, sizeof(Conn)))) {
+        atomic_fetch_sub(&total_clients, 1);
+        if (fd >= 0) close(fd);
+        metrics_add(MET_CONN_REJECTED, 1);
+        return NULL;
+    }
+    if (fd >= 0) conn_setup_fd(s, fd);
+    c->fd = fd;
+    c->closed = 0;
+    c->want_out = 0;
+    c->have = 0;
+    c->rx_skip = 0;
+    c->out_len = 0;
+    c->sending_len = c->sending_off = 0;
+    c->send_busy = 0;
+    c->inflight = 0;
+    c->dirty = 0;
+    c->token = 0;
+    c->stream_pos = 0;
+    c->detached_ns = 0;
+    c->lost = 0;
+    c->migrate = NULL;
+    c->xfer = NULL;
+    c->serial = ++s->conn_serial;
+    c->last_rx_ns = metrics_now_ns();
+    c->slot = s->nconns;
+    s->conns[s->nconns++] = c;
+    metrics_add(MET_CONN_ACCEPTED, 1);
+    metrics_gauge_add(MET_GAUGE_CLIENTS, 1);
+    return c;
+}
+
+// 수신 시작: epoll은 EPOLLIN 등록, io_uring은 멀티샷 recv
+static int conn_register(Shard* s, Conn* c) {
+    if (s->io == CHAT_IO_URING) {
+        uring_arm_recv(s, c);
+        return c->closed ? -1 : 0;
+    }
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = c };
+    if (epoll_ctl(s->epfd, EPOLL_CTL_ADD, c->fd, &ev) < 0) {
+        conn_close(s, c);
+        return -1;
+    }
+    return 0;
+}
+
+static void shard_accept(Shard* s, int listen_fd) {
+    while (1) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return;     // EAGAIN: 이번에 온 연결을 모두 받음
+        }
+        Conn* c = conn_open(s, fd);
+        if (c) conn_register(s, c);
+    }
+}
+
+// 세션 시작: 토큰을 정해 알려 줌 (이 줄은 시퀀스 번호에 세지 않음)
+static void session_start(Shard* s, Conn* c) {
+    if (!c->replay && !(c->replay = malloc(CHAT_REPLAY_BYTES))) return;
+    uint64_t t;
+    if (getrandom(&t, sizeof(t), 0) != (ssize_t)sizeof(t)) t = metrics_now_ns() * 0x9E3779B97F4A7C15ull;
+    // 아래 비트에 샤드 번호: 다른 샤드로 재접속해도 세션을 찾아갈 수 있게
+    c->token = (t & ~(uint64_t)(CHAT_MAX_SHARDS - 1)) | (uint64_t)s->id;
+    if (c->token == 0) c->token = CHAT_MAX_SHARDS;
+    c->stream_pos = 0;
+    char line[64];
+    int n = snprintf(line, sizeof(line), "/session %016llx\n", (unsigned long long)c->token);
+    conn_send_raw(s, c, line, (size_t)n);
+}
+
+// 세션 토큰 → 세션이 있는 샤드 (교체로 샤드 수가 바뀌어도 같은 규칙)
+static int session_shard(uint64_t token) {
+    return (int)(token % CHAT_MAX_SHARDS) % nshards;
+}
+
+// 넘겨받은 연결을 샤드에 올림 (샤드 쓰레드가 돌기 전, 덜 읽은 줄과 못 보낸 데이터,
+// 세션이면 시퀀스 번호와 replay 링까지 복원)
+static void shard_adopt(Shard* s, HandoffConn* h) {
+    Conn* c = conn_open(s, h->detached ? -1 : h->fd);
+    if (!c) return;
+    const char* rx = h->data;
+    const char* out = rx + h->rx_len;
+    const char* replay = out + h->out_len;
+    if (h->token && (c->replay || (c->replay = malloc(CHAT_REPLAY_BYTES)))) {
+        c->token = h->token;
+        c->stream_pos = h->stream_pos - h->replay_len;
+        replay_record(c, replay, h->replay_len);
+    }
+    if (h->detached) {
+        if (!c->token) conn_close(s, c);
+        else c->detached_ns = metrics_now_ns() - h->idle_ns;
+        return;
+    }
+    memcpy(c->rx, rx, h->rx_len);
+    c->have = h->rx_len;
+    c->last_rx_ns -= h->idle_ns;
+    if (conn_register(s, c) < 0) return;
+    if (h->out_len > 0) conn_send_raw(s, c, out, h->out_len);
+}
+
+// 매 초: 하트비트도 없이 idle timeout이 지난 연결 정리, 재접속 없이 유예가 지난 세션 정리,
+// 송신 큐 지표 갱신, (샤드 0) 바뀐 ToDo 목록 저장
+static void shard_tick(Shard* s, uint64_t now) {
+    if (s->id == 0) todo_flush();
+    uint64_t limit = (uint64_t)chat_idle_timeout_sec * 1000000000ull;
+    int64_t max = 0, total = 0;
+    for (int i = s->nconns - 1; i >= 0; i--) {
+        Conn* c = s->conns[i];
+        if (c->detached_ns) {
+            if (now - c->detached_ns > CHAT_RESUME_GRACE_SEC * 1000000000ull) conn_close(s, c);
+            continue;
+        }
+        if (c->lost) continue;
+        if (chat_idle_timeout_sec > 0 && now - c->last_rx_ns > limit) {
+            metrics_add(MET_CONN_TIMED_OUT, 1);
+            conn_lost(s, c);
+            continue;
+        }
+        int queued = 0;
+        ioctl(c->fd, SIOCOUTQ, &queued);
+        int64_t q = (int64_t)queued + (int64_t)c->out_len + (int64_t)(c->sending_len - c->sending_off);
+        total += q;
+        if (q > max) max = q;
+    }
+    atomic_store_explicit(&s->sendq_max, max, memory_order_relaxed);
+    atomic_store_explicit(&s->sendq_total, total, memory_order_relaxed);
+}
+
+/*==============================*/
+/*       중계 (샤드 간 전달)      */
+/*==============================*/
+static void inbox_push(Shard* s, InboxNode* n) {
+    atomic_store_explicit(&n->next, NULL, memory_order_relaxed);
+    InboxNode* prev = atomic_exchange_explicit(&s->head, n, memory_order_acq_rel);
+    atomic_store_explicit(&prev->next, n, memory_order_release);
+}
+
+// 꺼낼 것이 없거나, 생산자가 push 도중(연결 전)이면 NULL
+// (그 생산자는 push를 마친 뒤 wake_pending을 보고 다시 깨우므로 다음 회차에 꺼내짐)
+static InboxNode* inbox_pop(Shard* s) {
+    InboxNode* t = s->tail;
+    InboxNode* next = atomic_load_explicit(&t->next, memory_order_acquire);
+    if (t == &s->stub) {
+        if (!next) return NULL;
+        s->tail = t = next;
+        next = atomic_load_explicit(&t->next, memory_order_acquire);
+    }
+    if (next) {
+        s->tail = next;
+        return t;
+    }
+    if (t != atomic_load_explicit(&s->head, memory_order_acquire)) return NULL;
+    inbox_push(s, &s->stub);
+    next = atomic_load_explicit(&t->next, memory_order_acquire);
+    if (next) {
+        s->tail = next;
+        return t;
+    }
+    return NULL;
+}
+
+// 수신함에 넣고 깨움 (이미 깨우는 중이면 eventfd write 생략)
+static void shard_post(Shard* dst, InboxNode* n) {
+    inbox_push(dst, n);
+    if (atomic_exchange(&dst->wake_pending, 1) == 0) {
+        uint64_t one = 1;
+        while (write(dst->wake_fd, &one, sizeof(one)) < 0 && errno == EINTR) {}
+    }
+}
+
+// 이 샤드의 클라이언트들에게 전달 (from: 보낸 연결, 다른 샤드에서 온 메시지면 NULL)
+static void deliver_local(Shard* s, Conn* from, const char* data, size_t len,
+                          uint64_t lines, uint64_t t_recv) {
+    for (int i = s->nconns - 1; i >= 0; i--) {
+        Conn* c = s->conns[i];
+        if (c == from) continue;
+        if (conn_send(s, c, data, len) == 0) {
+            metrics_add(MET_BYTES_OUT, (uint64_t)len);
+            metrics_add(MET_MSGS_OUT, lines);
+        }
+    }
+    metrics_observe(MET_HIST_BROADCAST, metrics_now_ns() - t_recv);
+}
+
+// 받은 줄들을 나머지 클라이언트에게: 같은 샤드는 바로, 다른 샤드는 수신함으로
+static void relay(Shard* s, Conn* from, const char* data, size_t len, uint64_t lines, uint64_t t_recv) {
+    if (len == 0) return;
+    if (nshards > 1) {
+        size_t data_size = (len + 7) & ~(size_t)7;     // 뒤따르는 노드 배열 정렬
+        RelayMsg* m = malloc(sizeof(RelayMsg) + data_size + sizeof(InboxNode) * (size_t)nshards);
+        if (m) {
+            m->nodes = (InboxNode*)(m->data + data_size);
+            memcpy(m->data, data, len);
+            m->len = len;
+            m->lines = lines;
+            m->t_recv = t_recv;
+            m->t_post = metrics_now_ns();
+            atomic_init(&m->refs, nshards - 1);
+            for (int i = 0; i < nshards; i++) {
+                if (i == s->id) continue;
+                m->nodes[i].msg = m;
+                m->nodes[i].resume = NULL;
+                m->nodes[i].todo = NULL;
+                shard_post(&shards[i], &m->nodes[i]);
+            }
+        }
+        else metrics_add(MET_SEND_ERRORS, 1);
+    }
+    deliver_local(s, from, data, len, lines, t_recv);
+}
+
+// 샤드가 아닌 쓰레드(파일 전송)의 알림: 모든 샤드의 수신함으로 (보낸 연결 없음)
+void chat_server_announce(const char* data, size_t len) {
+    if (len == 0 || nshards == 0) return;
+    size_t data_size = (len + 7) & ~(size_t)7;
+    RelayMsg* m = malloc(sizeof(RelayMsg) + data_size + sizeof(InboxNode) * (size_t)nshards);
+    if (!m) {
+        metrics_add(MET_SEND_ERRORS, 1);
+        return;
+    }
+    m->nodes = (InboxNode*)(m->data + data_size);
+    memcpy(m->data, data, len);
+    m->len = len;
+    m->lines = 1;
+    m->t_recv = m->t_post = metrics_now_ns();
+    atomic_init(&m->refs, nshards);
+    for (int i = 0; i < nshards; i++) {
+        m->nodes[i].msg = m;
+        m->nodes[i].resume = NULL;
+        m->nodes[i].todo = NULL;
+        shard_post(&shards[i], &m->nodes[i]);
+    }
+}
+
+// eventfd가 readable → 수신함의 메시지를 이 샤드 클라이언트들에게 전달
+// (eventfd 카운터는 호출측이 비움: epoll은 read, io_uring은 READ 완료)
+static void shard_drain_inbox(Shard* s) {
+    atomic_store(&s->wake_pending, 0);  // 이후 push는 다시 깨움
+
+    InboxNode* n;
+    while ((n = inbox_pop(s)) != NULL) {
+        if (n->resume) {
+            shard_resume(s, n->resume);
+            continue;
+        }
+        if (n->todo) {
+            todo_inbox(s, n->todo);
+            continue;
+        }
+        RelayMsg* m = n->msg;
+        metrics_observe(MET_HIST_INBOX_WAIT, metrics_now_ns() - m->t_post);
+        deliver_local(s, NULL, m->data, m->len, m->lines, m->t_recv);
+        if (atomic_fetch_sub(&m->refs, 1) == 1) free(m);
+    }
+}
+
+/*==============================*/
+/*     재접속 세션 이어받기        */
+/*==============================*/
+static void resume_post(ResumeReq* r) {
+    r->node.msg = NULL;
+    r->node.todo = NULL;
+    r->node.resume = r;
+    shard_post(&shards[session_shard(r->token)], &r->node);
+}
+
+// 테이블에서 빼고 소켓을 넘길 준비 (넘기는 곳은 conn_release가 정함)
+// io_uring은 걸어 둔 recv가 취소되어 끝난 뒤 conn_release에서 넘김
+static void conn_hand_off(Shard* s, Conn* c) {
+    conn_unlink(s, c);
+    if (s->io == CHAT_IO_URING && c->inflight > 0) {
+        struct io_uring_sqe* sqe = uring_get_sqe(&s->ring);
+        if (sqe) {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = -1;
+            sqe->addr = UD(c, UD_RECV);
+            sqe->user_data = UD(s, UD_CANCEL);
+        }
+        else shutdown(c->fd, SHUT_RD);
+    }
+    else conn_release(s, c);
+}
+
+// 새 연결의 첫 줄이 "/resume <token> <offset>": 세션이 있는 샤드로 연결을 옮김
+static void conn_begin_resume(Shard* s, Conn* c, uint64_t token, uint64_t offset) {
+    ResumeReq* r = calloc(1, sizeof(ResumeReq));
+    if (!r) {
+        conn_close(s, c);
+        return;
+    }
+    r->token = token;
+    r->offset = offset;
+    r->have = c->have;
+    memcpy(r->rx, c->rx, c->have);
+    c->have = 0;
+    c->migrate = r;
+    conn_hand_off(s, c);
+}
+
+
+// 새 연결의 첫 줄이 "/upload ..." / "/download ...": 채팅 연결이 아니므로 전송 쓰레드로 넘김
+// (클라이언트는 응답을 받기 전에 더 보내지 않으므로 c->xfer에 담아 둔 그 줄만 넘기면 됨)
+static void conn_begin_xfer(Shard* s, Conn* c) {
+    c->have = 0;
+    conn_hand_off(s, c);
+}
+
+// 세션이 있는 샤드: 소켓을 세션에 붙이고, 클라이언트가 받은 데 이후를 replay에서 다시 보냄
+// "/resumed <lost>" (lost: 링에서 이미 밀려나 다시 보낼 수 없는 바이트 수, 보통 0)
+// 모르는(유예가 지난) 세션이면 새 세션으로 시작 ("/session <token>")
+static void shard_resume(Shard* s, ResumeReq* r) {
+    Conn* c = NULL;
+    for (int i = 0; i < s->nconns; i++) {
+        if (s->conns[i]->token == r->token) {
+            c = s->conns[i];
+            break;
+        }
+    }
+    if (c && !c->detached_ns) {
+        // 이전 연결이 아직 살아 있는 것처럼 보임(반쯤 열린 연결): 끊고 이어받음
+        conn_lost(s, c);
+        if (!c->detached_ns) {      // io_uring: 진행 중인 요청이 끝나면 다시
+            r->next_pending = s->pending_resumes;
+            s->pending_resumes = r;
+            return;
+        }
+    }
+
+    char line[64];
+    if (!c) {
+        c = conn_open(s, r->fd);
+        if (!c || conn_register(s, c) < 0) {
+            free(r);
+            return;
+        }
+        session_start(s, c);
+    }
+    else {
+        conn_setup_fd(s, r->fd);
+        c->fd = r->fd;
+        c->detached_ns = 0;
+        c->last_rx_ns = metrics_now_ns();
+        if (conn_register(s, c) < 0) {
+            free(r);
+            return;
+        }
+        uint64_t first = c->stream_pos > CHAT_REPLAY_BYTES ? c->stream_pos - CHAT_REPLAY_BYTES : 0;
+        uint64_t from = r->offset > c->stream_pos ? c->stream_pos : r->offset;
+        uint64_t lost = from < first ? first - from : 0;
+        if (from < first) from = first;
+        int n = snprintf(line, sizeof(line), "/resumed %llu\n", (unsigned long long)lost);
+        conn_send_raw(s, c, line, (size_t)n);
+        if (from < c->stream_pos) {
+            char* buf = malloc((size_t)(c->stream_pos - from));
+            if (buf) {
+                conn_send_raw(s, c, buf, replay_copy(c, from, buf));
+                free(buf);
+            }
+        }
+        metrics_add(MET_SESSIONS_RESUMED, 1);
+    }
+    if (r->have > 0 && !c->closed) {
+        memcpy(c->rx, r->rx, r->have);
+        c->have = r->have;
+        conn_input(s, c, metrics_now_ns());
+    }
+    free(r);
+}
+
+// 이전 연결의 요청이 끝나기를 기다리던 재접속을 다시 시도 (io_uring 회차마다)
+static void shard_retry_resumes(Shard* s) {
+    ResumeReq* r = s->pending_resumes;
+    s->pending_resumes = NULL;
+    while (r) {
+        ResumeReq* next = r->next_pending;
+        shard_resume(s, r);
+        r = next;
+    }
+}
+
+/*==============================*/
+/*   공유 ToDo 목록 (샤드 0 소유)  */
+/*==============================*/
+// 채팅방 전체가 보는 목록 하나: 샤드 0 쓰레드만 고치므로 잠금 없이 한 줄로 줄 세워짐
+// 바뀔 때마다 "/todo <seq> <op>" 를 모두에게 중계 (샤드 0 → 다른 샤드 수신함은 보낸 순서대로
+// 도착하므로 모든 클라이언트가 같은 순서로 받음), 목록은 CHAT_TODO_FILE에 저장 (재시작/교체 후 이어짐)
+static char*    chat_todos[CHAT_TODO_MAX];     // "text [ ]" / "text [x]"
+static int      chat_todo_count;
+static uint64_t chat_todo_seq;                 // 마지막으로 적용한 연산 번호
+static int      chat_todo_dirty;               // 마지막 저장 뒤 바뀜 (샤드 0의 tick에서 저장)
+
+static void todo_load(void) {
+    FILE* fp = fopen(CHAT_TODO_FILE, "r");
+    if (!fp) return;
+    char line[BUF_SIZE];
+    unsigned long long seq;
+    while (fgets(line, sizeof(line), fp) && chat_todo_count < CHAT_TODO_MAX) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (sscanf(line, "#seq %llu", &seq) == 1) chat_todo_seq = seq;
+        else if (line[0] && !(chat_todos[chat_todo_count++] = strdup(line))) chat_todo_count--;
+    }
+    fclose(fp);
+}
+
+// 임시 파일에 쓰고 rename (쓰는 도중 죽어도 이전 목록이 남음)
+static void todo_save(void) {
+    char tmp[sizeof(CHAT_TODO_FILE) + 8];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", CHAT_TODO_FILE);
+    FILE* fp = fopen(tmp, "w");
+    if (!fp) return;
+    fprintf(fp, "#seq %llu\n", (unsigned long long)chat_todo_seq);
+    for (int i = 0; i < chat_todo_count; i++) fprintf(fp, "%s\n", chat_todos[i]);
+    if (fclose(fp) == 0) rename(tmp, CHAT_TODO_FILE);
+}
+
+// 연산마다 파일 전체를 다시 쓰지 않도록 tick마다 한 번만 (샤드 0 또는 모든 샤드가 멈춘 교체 중에)
+static void todo_flush(void) {
+    if (!chat_todo_dirty) return;
+    chat_todo_dirty = 0;
+    todo_save();
+}
+
+// 요청한 연결에게만: 같은 샤드면 바로, 아니면 그 샤드 수신함으로
+static void todo_reply(Shard* s, int shard, Conn* c, uint64_t serial, const char* data, size_t len) {
+    if (shard == s->id) {
+        if (!c->closed && c->serial == serial) conn_send(s, c, data, len);
+        return;
+    }
+    TodoMsg* m = malloc(sizeof(TodoMsg) + len);
+    if (!m) return;
+    *m = (TodoMsg){ .shard = shard, .conn = c, .serial = serial, .reply = 1, .len = len };
+    memcpy(m->data, data, len);
+    m->node.msg = NULL;
+    m->node.resume = NULL;
+    m->node.todo = m;
+    shard_post(&shards[shard], &m->node);
+}
+
+// "/todo list": 현재 목록 전체 ("/todo <seq> list <n>" + 항목마다 "/todo <seq> item <text>")
+static void todo_send_list(Shard* s, int shard, Conn* c, uint64_t serial) {
+    char* buf = NULL;
+    size_t len = 0;
+    FILE* fp = open_memstream(&buf, &len);
+    if (!fp) return;
+    unsigned long long seq = (unsigned long long)chat_todo_seq;
+    fprintf(fp, "/todo %llu list %d\n", seq, chat_todo_count);
+    for (int i = 0; i < chat_todo_count; i++) fprintf(fp, "/todo %llu item %s\n", seq, chat_todos[i]);
+    fclose(fp);
+    todo_reply(s, shard, c, serial, buf, len);
+    free(buf);
+}
+
+static void todo_error(Shard* s, int shard, Conn* c, uint64_t serial, const char* msg) {
+    char line[128];
+    int n = snprintf(line, sizeof(line), "/todo 0 error %s\n", msg);
+    todo_reply(s, shard, c, serial, line, (size_t)n);
+}
+
+// 샤드 0: "/todo <verb> <args>" 한 줄을 목록에 적용하고 모두에게 중계
+static void todo_apply(Shard* s, int shard, Conn* c, uint64_t serial, const char* line, size_t len) {
+    char req[BUF_SIZE];
+    snprintf(req, sizeof(req), "%.*s", (int)len, line);
+    char verb[8];
+    int n = 0, idx = 0;
+    if (sscanf(req, "/todo %7s %n", verb, &n) != 1) return;
+    const char* arg = req + n;
+
+    if (strcmp(verb, "list") == 0) {
+        todo_send_list(s, shard, c, serial);
+        return;
+    }
+    int has_idx = sscanf(arg, "%d %n", &idx, &n) == 1;
+    const char* text = has_idx ? arg + n : arg;
+    char item[BUF_SIZE - 64];
+    if (strcmp(verb, "add") == 0 && *arg) {
+        if (chat_todo_count == CHAT_TODO_MAX) {
+            todo_error(s, shard, c, serial, "list is full");
+            return;
+        }
+        snprintf(item, sizeof(item), "%s [ ]", arg);
+        if (!(chat_todos[chat_todo_count] = strdup(item))) return;
+        chat_todo_count++;
+    }
+    else if (!has_idx || (strcmp(verb, "edit") == 0 && !*text) ||
+             (strcmp(verb, "done") && strcmp(verb, "undo") && strcmp(verb, "del") && strcmp(verb, "edit"))) {
+        todo_error(s, shard, c, serial, "usage: /add <item>, /done|/undo|/del <num>, /edit <num> <item>");
+        return;
+    }
+    else if (idx < 1 || idx > chat_todo_count) {
+        todo_error(s, shard, c, serial, "invalid index");
+        return;
+    }
+    else {
+        char** it = &chat_todos[idx - 1];
+        size_t ilen = strlen(*it);
+        if (strcmp(verb, "del") == 0) {
+            free(*it);
+            memmove(it, it + 1, sizeof(*it) * (size_t)(chat_todo_count - idx));
+            chat_todos[--chat_todo_count] = NULL;
+        }
+        else if (strcmp(verb, "edit") == 0) {
+            snprintf(item, sizeof(item), "%s [%c]", text, ilen >= 2 ? (*it)[ilen - 2] : ' ');
+            char* copy = strdup(item);
+            if (!copy) return;
+            free(*it);
+            *it = copy;
+        }
+        else if (ilen >= 4 && (*it)[ilen - 1] == ']') {
+            (*it)[ilen - 2] = verb[0] == 'd' ? 'x' : ' ';
+        }
+    }
+
+    // 적용한 연산을 번호와 함께 모두에게 (보낸 사람 포함: 번호를 받아야 같은 순서로 적용)
+    chat_todo_seq++;
+    chat_todo_dirty = 1;
+    // add/edit는 저장한 항목과 같은 내용(잘렸으면 잘린 대로)을 보냄
+    unsigned long long seq = (unsigned long long)chat_todo_seq;
+    char out[BUF_SIZE + 64];
+    int olen;
+    if (strcmp(verb, "add") == 0)
+        olen = snprintf(out, sizeof(out), "/todo %llu add %.*s\n", seq, (int)strlen(item) - 4, item);
+    else if (strcmp(verb, "edit") == 0)
+        olen = snprintf(out, sizeof(out), "/todo %llu edit %d %.*s\n", seq, idx, (int)strlen(item) - 4, item);
+    else
+        olen = snprintf(out, sizeof(out), "/todo %llu %s %d\n", seq, verb, idx);
+    relay(s, NULL, out, (size_t)olen, 1, metrics_now_ns());
+}
+
+// 보낸 연결의 샤드에서: 샤드 0이면 바로 적용, 아니면 샤드 0 수신함으로
+static void todo_request(Shard* s, Conn* c, const char* line, size_t len) {
+    if (s->id == 0) {
+        todo_apply(s, s->id, c, c->serial, line, len);
+        return;
+    }
+    TodoMsg* m = malloc(sizeof(TodoMsg) + len);
+    if (!m) return;
+    *m = (TodoMsg){ .shard = s->id, .conn = c, .serial = c->serial, .len = len };
+    memcpy(m->data, line, len);
+    m->node.msg = NULL;
+    m->node.resume = NULL;
+    m->node.todo = m;
+    shard_post(&shards[0], &m->node);
+}
+
+static void todo_inbox(Shard* s, TodoMsg* m) {
+    if (!m->reply) todo_apply(s, m->shard, m->conn, m->serial, m->data, m->len);
+    else if (!m->conn->closed && m->conn->serial == m->serial) conn_send(s, m->conn, m->data, m->len);
+    free(m);
+}
+
+/*==============================*/
+/*        수신 처리 (샤드)       */
+/*==============================*/
+// 클라이언트에서 온 한 줄이 서버 제어 명령인지 (중계하지 않고 보낸 사람에게만 응답)
+//  - "/stats"      : 지표 요약
+//  - "/ping <id>"  : 앞선 메시지의 중계가 끝난 뒤 "/pong <id>" (클라이언트 RTT 측정, id 0은 하트비트)
+//                    다른 샤드로는 수신함에 넣은 시점까지
+//  - "/session"    : 재접속 세션 시작, "/session <token>" 응답 (이후 보내는 바이트가 시퀀스 번호)
+//  - "/resume <token> <offset>" : 새 연결의 첫 줄, 세션을 이어받고 offset 이후를 다시 받음
+//  - "/bye"        : 정상 종료, 끊겨도 세션을 남기지 않음
+//  - "/todo <verb> <args>" : 공유 ToDo 목록 연산 (샤드 0이 적용하고 모두에게 "/todo <seq> ..." 중계)
+//  - "/upload ..." / "/download ..." : 새 연결의 첫 줄, 파일 전송 연결 (xfer.h)
+// 클라이언트의 채팅 줄은 "[닉][시각] ..." 이므로 '/'로 시작하는 줄은 위 제어 줄뿐이고, 그 밖의 '/' 줄은
+// 중계하지 않고 버림 (서버만 보내는 "/file", "/pong", "/session", "/resumed", "/todo <seq>" 를 흉내 내지 못하게)
+static int is_control_line(const char* line, size_t len) {
+    return (len == 6 && strncmp(line, "/stats", 6) == 0) ||
+           (len > 6 && strncmp(line, "/todo ", 6) == 0) ||
+           (len > 8 && strncmp(line, "/upload ", 8) == 0) ||
+           (len > 10 && strncmp(line, "/download ", 10) == 0) ||
+           (len > 6 && strncmp(line, "/ping ", 6) == 0) ||
+           (len == 8 && strncmp(line, "/session", 8) == 0) ||
+           (len > 8 && strncmp(line, "/resume ", 8) == 0) ||
+           (len == 4 && strncmp(line, "/bye", 4) == 0);
+}
+
+// c->rx에 모인 바이트를 줄 단위로 나눠, 완성된 줄만 중계 (제어 줄은 걸러 내고 응답)
+static void conn_input(Shard* s, Conn* c, uint64_t t_recv) {
+    char out[BUF_SIZE * 2];     // 이번에 중계할 줄들
+    char reply[BUF_SIZE];
+    char* buf = c->rx;
+    size_t out_len = 0, reply_len = 0, start = 0;
+    uint64_t lines = 0;
+    unsigned long long resume_token = 0, resume_offset = 0;
+    for (size_t i = 0; i < c->have; i++) {
+        if (buf[i] != '\n') continue;
+        const char* line = buf + start;
+        size_t line_len = i - start;
+        if (c->rx_skip) {
+            c->rx_skip = 0;             // 버리던 긴 줄의 끝
+        }
+        else if (is_control_line(line, line_len)) {
+            if (line[1] == 'p') {
+                if (reply_len + line_len + 1 < sizeof(reply))
+                    reply_len += (size_t)snprintf(reply + reply_len, sizeof(reply) - reply_len,
+                                                  "/pong %.*s\n", (int)(line_len - 6), line + 6);
+            }
+            else if (line[1] == 'b') c->token = 0;
+            else if (line[1] == 't') todo_request(s, c, line, line_len);
+            else if (line[1] == 'u' || line[1] == 'd') {
+                // 채팅을 시작하지 않은 연결만 (뒤따르는 바이트는 전송 쓰레드가 읽음)
+                if (!c->token && start == 0 && (c->xfer = strndup(line, line_len)) != NULL) {
+                    start = i + 1;
+                    break;
+                }
+            }
+            else if (line[1] == 'r') {
+                // 뒤따르는 줄은 세션을 이어받은 샤드가 처리
+                buf[i] = '\0';
+                if (!c->token && sscanf(line + 8, "%llx %llu", &resume_token, &resume_offset) == 2 &&
+                    resume_token != 0) {
+                    start = i + 1;
+                    break;
+                }
+                resume_token = 0;
+            }
+            else if (line[2] == 'e') {
+                if (!c->token) session_start(s, c);
+            }
+            else reply_len += metrics_format_summary(reply + reply_len, sizeof(reply) - reply_len);
+        }
+        else if (line_len > 0 && line[0] == '/') {
+            // 모르는 명령이나 서버 전용 줄: 버림
+        }
+        else {
+            memcpy(out + out_len, line, line_len + 1);
+            out_len += line_len + 1;
+            lines++;
+        }
+        start = i + 1;
+    }
+    // 개행 없이 버퍼가 가득 찬 긴 줄은 다음 개행까지 버림 (클라이언트는 이렇게 긴 줄을 보내지 않고,
+    // 조각으로 흘려 보내면 받는 쪽에서 다른 줄 뒤에 붙은 나머지 조각이 '/' 줄처럼 보일 수 있음)
+    if (start == 0 && c->have == sizeof(c->rx)) {
+        c->rx_skip = 1;
+        start = c->have;
+    }
+    memmove(buf, buf + start, c->have - start);
+    c->have -= start;
+
+    metrics_add(MET_MSGS_IN, lines);
+    relay(s, c, out, out_len, lines, t_recv);
+    if (reply_len > 0) conn_send(s, c, reply, reply_len);
+    if (resume_token) conn_begin_resume(s, c, resume_token, resume_offset);
+    else if (c->xfer) conn_begin_xfer(s, c);
+}
+
+static void conn_read(Shard* s, Conn* c) {
+    while (!c->closed && c->fd >= 0) {
+        ssize_t len = recv(c->fd, c->rx + c->have, sizeof(c->rx) - c->have, MSG_DONTWAIT);
+        if (len < 0 && errno == EINTR) continue;
+        if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (len <= 0) {
+            conn_lost(s, c);
+            return;
+        }
+        uint64_t t_recv = metrics_now_ns();
+        c->last_rx_ns = t_recv;
+        metrics_add(MET_BYTES_IN, (uint64_t)len);
+        c->have += (size_t)len;
+        conn_input(s, c, t_recv);
+    }
+}
+
+static void* shard_main(void* arg) {
+    Shard* s = arg;
+    struct epoll_event evs[SHARD_EVENTS];
+    uint64_t next_tick = metrics_now_ns() + SHARD_TICK_MS * 1000000ull;
+    while (1) {
+        int n = epoll_wait(s->epfd, evs, SHARD_EVENTS, SHARD_TICK_MS);
+        for (int i = 0; i < n; i++) {
+            void* p = evs[i].data.ptr;
+            if (p == &tag_listen) shard_accept(s, s->listen_fd);
+            else if (p == &tag_local) shard_accept(s, local_listen_fd);
+            else if (p == &tag_wake) {
+                uint64_t cnt;
+                while (read(s->wake_fd, &cnt, sizeof(cnt)) > 0) {}
+                shard_drain_inbox(s);
+            }
+            else {
+                Conn* c = p;
+                if (!c->closed && (evs[i].events & EPOLLOUT)) conn_flush(s, c);
+                if (!c->closed && (evs[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) conn_read(s, c);
+            }
+        }
+        uint64_t now = metrics_now_ns();
+        if (now >= next_tick) {
+            shard_tick(s, now);
+            next_tick = now + SHARD_TICK_MS * 1000000ull;
+        }
+        shard_reap(s);
+        if (atomic_load_explicit(&handoff_stage, memory_order_acquire) != HANDOFF_NONE)
+            shard_park(s);
+    }
+    return NULL;
+}
+
+/*==============================*/
+/*      io_uring 백엔드 (샤드)    */
+/*==============================*/
+static struct io_uring_sqe* shard_sqe(Shard* s, int op, int fd, uint64_t user_data) {
+    struct io_uring_sqe* sqe = uring_get_sqe(&s->ring);
+    if (!sqe) return NULL;
+    sqe->opcode = (uint8_t)op;
+    sqe->fd = fd;
+    sqe->user_data = user_data;
+    return sqe;
+}
+
+// 연결이 살아 있는 동안 한 번 걸어 두면 도착할 때마다 완료가 옴 (버퍼는 커널이 링에서 고름)
+static void uring_arm_recv(Shard* s, Conn* c) {
+    struct io_uring_sqe* sqe = shard_sqe(s, IORING_OP_RECV, c->fd, UD(c, UD_RECV));
+    if (!sqe) {
+        conn_close(s, c);
+        return;
+    }
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = s->bufs.bgid;
+    c->inflight++;
+}
+
+static void uring_arm_accept(Shard* s, int local) {
+    int fd = local ? local_listen_fd : s->listen_fd;
+    if (fd < 0) return;
+    struct io_uring_sqe* sqe = shard_sqe(s, IORING_OP_ACCEPT, fd, UD(s, local ? UD_ACCEPT_LOCAL : UD_ACCEPT));
+    if (!sqe) return;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    s->ctl_inflight++;
+}
+
+static void uring_arm_wake(Shard* s) {
+    struct io_uring_sqe* sqe = shard_sqe(s, IORING_OP_READ, s->wake_fd, UD(s, UD_WAKE));
+    if (!sqe) return;
+    sqe->addr = (uint64_t)(uintptr_t)&s->wake_buf;
+    sqe->len = sizeof(s->wake_buf);
+    s->ctl_inflight++;
+}
+
+static void uring_arm_tick(Shard* s) {
+    s->tick_ts.tv_sec = SHARD_TICK_MS / 1000;
+    s->tick_ts.tv_nsec = (SHARD_TICK_MS % 1000) * 1000000ll;
+    struct io_uring_sqe* sqe = shard_sqe(s, IORING_OP_TIMEOUT, -1, UD(s, UD_TICK));
+    if (!sqe) return;
+    sqe->addr = (uint64_t)(uintptr_t)&s->tick_ts;
+    sqe->len = 1;
+    s->ctl_inflight++;
+}
+
+static void uring_send_pending(Shard* s, Conn* c) {
+    struct io_uring_sqe* sqe = shard_sqe(s, IORING_OP_SEND, c->fd, UD(c, UD_SEND));
+    if (!sqe) {
+        conn_close(s, c);
+        return;
+    }
+    sqe->addr = (uint64_t)(uintptr_t)(c->sending + c->sending_off);
+    sqe->len = (uint32_t)(c->sending_len - c->sending_off);
+    sqe->msg_flags = MSG_NOSIGNAL;
+    c->send_busy = 1;
+    c->inflight++;
+}
+
+// 회차 끝: 쌓인 송신 데이터를 연결마다 SEND 하나로 (보내는 중이면 완료 후에)
+static void shard_submit_sends(Shard* s) {
+    while (s->dirty) {
+        Conn* c = s->dirty;
+        s->dirty = c->next_dirty;
+        c->dirty = 0;
+        if (c->closed || c->lost || c->send_busy || c->out_len == 0) continue;
+        // out ↔ sending 교체: 커널이 읽는 동안 새 데이터는 다른 버퍼에 쌓임
+        char* buf = c->sending;
+        size_t cap = c->sending_cap;
+        c->sending = c->out;
+        c->sending_cap = c->out_cap;
+        c->sending_len = c->out_len;
+        c->sending_off = 0;
+        c->out = buf;
+        c->out_cap = cap;
+        c->out_len = 0;
+        uring_send_pending(s, c);
+    }
+}
+
+// 요청 하나가 끝남: 닫힌 연결이면 마지막 완료에서 반납, 끊긴 세션이면 소켓만 닫음
+static void conn_op_done(Shard* s, Conn* c) {
+    if (--c->inflight > 0) return;
+    if (c->closed) conn_release(s, c);
+    else if (c->lost) conn_detach(s, c);
+}
+
+static void uring_on_recv(Shard* s, Conn* c, int res, unsigned flags) {
+    if (res > 0 && (flags & IORING_CQE_F_BUFFER)) {
+        unsigned bid = flags >> IORING_CQE_BUFFER_SHIFT;
+        const char* data = uring_buf(&s->bufs, bid);
+        if (!c->closed && !c->lost) {
+            uint64_t t_recv = metrics_now_ns();
+            c->last_rx_ns = t_recv;
+            metrics_add(MET_BYTES_IN, (uint64_t)res);
+            // rx에 들어가는 만큼씩 넣고 줄 단위 처리 (conn_input이 rx를 비워 줌)
+            size_t off = 0;
+            while (off < (size_t)res && !c->closed && !c->lost) {
+                size_t n = sizeof(c->rx) - c->have;
+                if (n > (size_t)res - off) n = (size_t)res - off;
+                memcpy(c->rx + c->have, data + off, n);
+                c->have += n;
+                off += n;
+                conn_input(s, c, t_recv);
+            }
+        }
+        uring_bufring_recycle(&s->bufs, bid);
+    }
+    if (flags & IORING_CQE_F_MORE) return;
+
+    // 멀티샷이 끝남: 버퍼가 모자랐거나(ENOBUFS) 데이터 뒤 종료면 다시 걸고, EOF/오류면 닫음
+    // (교체 준비 중이면 취소된 것이므로 다시 걸지 않음, 커널에 남은 데이터는 다음 서버가 읽음)
+    if (!c->closed && !c->lost && (res > 0 || res == -ENOBUFS || res == -ECANCELED)) {
+        c->inflight--;
+        if (!s->quiescing) uring_arm_recv(s, c);
+        return;
+    }
+    conn_lost(s, c);
+    conn_op_done(s, c);
+}
+
+static void uring_on_send(Shard* s, Conn* c, int res) {
+    c->send_busy = 0;
+    if (!c->closed && !c->lost) {
+        if (res == -ECANCELED && s->quiescing) {
+            // 교체 준비로 취소됨: 한 바이트도 안 나갔으므로 남은 데이터는 그대로 넘김
+        }
+        else if (res < 0) {
+            metrics_add(MET_SEND_ERRORS, 1);
+            conn_lost(s, c);
+        }
+        else {
+            c->sending_off += (size_t)res;
+            if (c->sending_off < c->sending_len) {
+                // 일부만 나감: 나머지 이어서 (교체 준비 중이면 다음 서버가 보냄)
+                if (!s->quiescing) {
+                    c->inflight--;
+                    uring_send_pending(s, c);
+                    return;
+                }
+            }
+            else {
+                c->sending_len = c->sending_off = 0;
+                if (c->out_len > 0 && !c->dirty) {  // 보내는 동안 쌓인 데이터
+                    c->dirty = 1;
+                    c->next_dirty = s->dirty;
+                    s->dirty = c;
+                }
+            }
+        }
+    }
+    conn_op_done(s, c);
+}
+
+// 쌓인 완료를 모두 처리 (교체 준비 중이면 끝난 요청을 다시 걸지 않고, 중간 send 제출도 안 함)
+static void uring_reap(Shard* s) {
+    struct io_uring_cqe* cqe;
+    int handled = 0;
+    while ((cqe = uring_peek_cqe(&s->ring)) != NULL) {
+        uint64_t ud = cqe->user_data;
+        int res = cqe->res;
+        unsigned flags = cqe->flags;
+        uring_cqe_seen(&s->ring);
+
+        switch (UD_OP(ud)) {
+        case UD_ACCEPT:
+        case UD_ACCEPT_LOCAL:
+            if (res >= 0) {
+                Conn* c = conn_open(s, res);
+                if (c && !s->quiescing) uring_arm_recv(s, c);
+            }
+            if (!(flags & IORING_CQE_F_MORE)) {
+                s->ctl_inflight--;
+                if (!s->quiescing) uring_arm_accept(s, UD_OP(ud) == UD_ACCEPT_LOCAL);
+            }
+            break;
+        case UD_WAKE:
+            s->ctl_inflight--;
+            shard_drain_inbox(s);
+            if (!s->quiescing) uring_arm_wake(s);
+            break;
+        case UD_TICK:
+            s->ctl_inflight--;
+            if (s->quiescing) break;
+            shard_tick(s, metrics_now_ns());
+            uring_arm_tick(s);
+            break;
+        case UD_RECV:
+            uring_on_recv(s, UD_PTR(ud), res, flags);
+            break;
+        case UD_SEND:
+            uring_on_send(s, UD_PTR(ud), res);
+            break;
+        }
+        // 완료가 많이 몰려도 받는 쪽 버퍼가 한도까지 쌓이기 전에 중간중간 내보냄
+        if (!s->quiescing && ++handled % URING_BATCH == 0) {
+            shard_submit_sends(s);
+            uring_submit(&s->ring, 0);
+        }
+    }
+}
+
+static void* shard_main_uring(void* arg) {
+    Shard* s = arg;
+    uring_arm_accept(s, 0);
+    uring_arm_accept(s, 1);
+    uring_arm_wake(s);
+    uring_arm_tick(s);
+    while (1) {
+        // 지난 회차에 쌓인 요청(recv 재등록, send 묶음)을 한 번에 제출하고 완료를 기다림
+        if (uring_submit(&s->ring, 1) < 0 && errno != EBUSY && errno != EAGAIN) {
+            perror("chat_server: io_uring_enter");
+            return NULL;
+        }
+        uring_reap(s);
+        if (s->pending_resumes) shard_retry_resumes(s);
+        shard_submit_sends(s);
+        shard_reap(s);
+        if (atomic_load_explicit(&handoff_stage, memory_order_acquire) != HANDOFF_NONE)
+            shard_park(s);
+    }
+    return NULL;
+}
+
+// 교체 준비: 걸어 둔 요청을 모두 취소하고 끝날 때까지 기다림
+// (recv로 이미 받은 데이터는 처리되어 rx/out에 남고, 커널 버퍼의 나머지는 다음 서버가 읽음)
+static void uring_quiesce(Shard* s) {
+    s->quiescing = 1;
+    struct io_uring_sqe* sqe = shard_sqe(s, IORING_OP_ASYNC_CANCEL, -1, UD(s, UD_CANCEL));
+    if (sqe) sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+    while (1) {
+        int busy = s->ctl_inflight;
+        for (int i = 0; i < s->nconns; i++) busy += s->conns[i]->inflight;
+        if (busy == 0) break;
+        if (uring_submit(&s->ring, 1) < 0 && errno != EINTR && errno != EBUSY && errno != EAGAIN) break;
+        uring_reap(s);
+    }
+    shard_reap(s);
+}
+
+// 교체가 취소됨: 요청을 다시 걸고, 멈춘 동안 쌓인 송신 데이터를 내보냄
+static void uring_resume(Shard* s) {
+    s->quiescing = 0;
+    uring_arm_accept(s, 0);
+    uring_arm_accept(s, 1);
+    uring_arm_wake(s);
+    uring_arm_tick(s);
+    for (int i = 0; i < s->nconns; i++) {
+        Conn* c = s->conns[i];
+        if (c->detached_ns) continue;
+        uring_arm_recv(s, c);
+        if (c->sending_off < c->sending_len) uring_send_pending(s, c);
+        else if (c->out_len > 0 && !c->dirty) {
+            c->dirty = 1;
+            c->next_dirty = s->dirty;
+            s->dirty = c;
+        }
+    }
+}
+
+/*==============================*/
+/*   무중단 교체 (소켓 핸드오프)   */
+/*==============================*/
+/*
+ * 새 빌드를 "coshell server --upgrade"로 띄우면:
+ *  1) 새 프로세스가 <런타임 디렉터리>/coshell-chat-<port>.sock 에 접속해 요청
+ *  2) 실행 중인 서버는 샤드를 모두 세우고(io_uring은 요청 취소 후) 수신함을 비운 뒤
+ *     리스너와 연결 fd를 SCM_RIGHTS로, 연결마다 덜 읽은 줄과 못 보낸 데이터를 함께 보냄
+ *     (세션은 토큰/시퀀스 번호/replay 링까지, 끊긴 채 재접속을 기다리는 세션은 fd 없이)
+ *  3) 새 프로세스가 다 받았다고 답하면 이전 서버는 종료, 연결은 끊기지 않음
+ * 도중에 실패하면 이전 서버는 샤드를 다시 돌리고 그대로 서비스합니다.
+ * 커널 소켓 버퍼에 남은 데이터는 그대로이므로 클라이언트는 잠깐 느려질 뿐입니다.
+ */
+#define HANDOFF_MAGIC   0x43534832u     // "CSH2" (세션 필드 추가)
+#define HANDOFF_TIMEOUT_SEC 10
+
+enum { HO_REQUEST = 1, HO_LISTENER, HO_CONN, HO_END, HO_ACK };
+
+typedef struct {
+    uint32_t magic;
+    uint32_t kind;
+    uint32_t rx_len;            // HO_CONN: 줄 조각 길이 (뒤따르는 데이터)
+    uint32_t out_len;           // HO_CONN: 못 보낸 송신 데이터 길이
+    uint64_t idle_ns;           // HO_CONN: 마지막 수신 후 지난 시간 (detached면 끊긴 뒤 지난 시간)
+    uint64_t token;             // HO_CONN: 세션 토큰 (0이면 세션 없음)
+    uint64_t stream_pos;        // HO_CONN: 세션 시작 후 보낸 바이트
+    uint32_t replay_len;        // HO_CONN: replay 링 데이터 길이 (out 뒤에 따라옴)
+    uint32_t detached;          // HO_CONN: 1이면 fd 없이 재접속을 기다리는 세션
+} HandoffRec;
+
+// 교체용 소켓 경로: XDG_RUNTIME_DIR(사용자 전용) 아래, 없으면 /tmp 아래 내 0700 디렉터리 안
+// (다른 사용자가 먼저 만들어 둔 디렉터리면 쓰지 않음). 반환값: 0 성공, -1 안전한 경로 없음
+static int handoff_path(int port, char* buf, size_t size) {
+    const char* dir = getenv("XDG_RUNTIME_DIR");
+    if (dir && *dir) {
+        snprintf(buf, size, "%s/coshell-chat-%d.sock", dir, port);
+        return 0;
+    }
+    char priv[64];
+    struct stat st;
+    snprintf(priv, sizeof(priv), "/tmp/coshell-%u", (unsigned)getuid());
+    if (mkdir(priv, 0700) < 0 && errno != EEXIST) return -1;
+    if (lstat(priv, &st) < 0 || !S_ISDIR(st.st_mode) || st.st_uid != getuid() || (st.st_mode & 077))
+        return -1;
+    snprintf(buf, size, "%s/chat-%d.sock", priv, port);
+    return 0;
+}
+
+// 상대가 같은 사용자의 프로세스인지 (넘겨주는 쪽, 넘겨받는 쪽 모두 확인)
+static int handoff_peer_ok(int sock) {
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    return getsockopt(sock, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 && cred.uid == getuid();
+}
+
+static int write_all(int fd, const void* buf, size_t len) {
+    const char* p = buf;
+    while (len > 0) {
+        ssize_t w = send(fd, p, len, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return -1;
+        p += w;
+        len -= (size_t)w;
+    }
+    return 0;
+}
+
+static int read_all(int fd, void* buf, size_t len) {
+    char* p = buf;
+    while (len > 0) {
+        ssize_t r = recv(fd, p, len, 0);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return -1;
+        p += r;
+        len -= (size_t)r;
+    }
+    return 0;
+}
+
+// 레코드 하나 (pass_fd >= 0 이면 fd를 함께 보냄)
+static int handoff_send_rec(int sock, const HandoffRec* rec, int pass_fd) {
+    struct iovec iov = { .iov_base = (void*)rec, .iov_len = sizeof(*rec) };
+    union {
+        char           buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } ctl;
+    struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1 };
+    if (pass_fd >= 0) {
+        memset(&ctl, 0, sizeof(ctl));
+        msg.msg_control = ctl.buf;
+        msg.msg_controllen = sizeof(ctl.buf);
+        struct cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+        cm->cmsg_level = SOL_SOCKET;
+        cm->cmsg_type = SCM_RIGHTS;
+        cm->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cm), &pass_fd, sizeof(int));
+    }
+    ssize_t w;
+    do w = sendmsg(sock, &msg, MSG_NOSIGNAL); while (w < 0 && errno == EINTR);
+    return w == (ssize_t)sizeof(*rec) ? 0 : -1;
+}
+
+// 레코드 하나를 받음 (*fd: 함께 온 fd, 없으면 -1)
+static int handoff_recv_rec(int sock, HandoffRec* rec, int* fd) {
+    struct iovec iov = { .iov_base = rec, .iov_len = sizeof(*rec) };
+    union {
+        char           buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } ctl;
+    struct msghdr msg = {
+        .msg_iov = &iov, .msg_iovlen = 1,
+        .msg_control = ctl.buf, .msg_controllen = sizeof(ctl.buf)
+    };
+    *fd = -1;
+    ssize_t r;
+    do r = recvmsg(sock, &msg, MSG_WAITALL | MSG_CMSG_CLOEXEC); while (r < 0 && errno == EINTR);
+    for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm))
+        if (cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_RIGHTS)
+            memcpy(fd, CMSG_DATA(cm), sizeof(int));
+    if (r != (ssize_t)sizeof(*rec) || rec->magic != HANDOFF_MAGIC) {
+        if (*fd >= 0) close(*fd);
+        *fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+static void set_timeouts(int sock, int sec) {
+    struct timeval tv = { .tv_sec = sec };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+// 샤드 쓰레드: 교체 요청이 오면 멈춰서 결과를 기다림 (성공하면 프로세스가 끝나 돌아오지 않음)
+static void shard_park(Shard* s) {
+    if (s->io == CHAT_IO_URING) uring_quiesce(s);
+    pthread_mutex_lock(&handoff_lock);
+    handoff_parked++;
+    pthread_cond_broadcast(&handoff_cond);
+    while (atomic_load(&handoff_stage) != HANDOFF_NONE)
+        pthread_cond_wait(&handoff_cond, &handoff_lock);
+    handoff_parked--;
+    pthread_mutex_unlock(&handoff_lock);
+    if (s->io == CHAT_IO_URING) uring_resume(s);
+}
+
+// 모든 샤드가 멈춘 상태에서 리스너와 연결을 보냄
+static int handoff_send_all(int sock, int* nsent) {
+    HandoffRec rec = { .magic = HANDOFF_MAGIC, .kind = HO_LISTENER };
+    for (int i = 0; i < nshards; i++)
+        if (handoff_send_rec(sock, &rec, shards[i].listen_fd) < 0) return -1;
+    if (local_listen_fd >= 0 && handoff_send_rec(sock, &rec, local_listen_fd) < 0) return -1;
+
+    char* replay = malloc(CHAT_REPLAY_BYTES);
+    if (!replay) return -1;
+    uint64_t now = metrics_now_ns();
+    *nsent = 0;
+    for (int i = 0; i < nshards; i++) {
+        Shard* s = &shards[i];
+        for (int j = 0; j < s->nconns; j++) {
+            Conn* c = s->conns[j];
+            int detached = c->detached_ns || c->lost;
+            if (detached && !c->token) continue;
+            size_t pending = detached ? 0 : c->sending_len - c->sending_off;
+            size_t out_len = detached ? 0 : c->out_len;
+            size_t replay_len = 0;
+            if (c->token) {
+                uint64_t from = c->stream_pos > CHAT_REPLAY_BYTES ? c->stream_pos - CHAT_REPLAY_BYTES : 0;
+                replay_len = replay_copy(c, from, replay);
+            }
+            rec.kind = HO_CONN;
+            rec.rx_len = detached ? 0 : (uint32_t)c->have;
+            rec.out_len = (uint32_t)(pending + out_len);
+            rec.idle_ns = now - (c->detached_ns ? c->detached_ns : c->last_rx_ns);
+            rec.token = c->token;
+            rec.stream_pos = c->stream_pos;
+            rec.replay_len = (uint32_t)replay_len;
+            rec.detached = (uint32_t)detached;
+            if (handoff_send_rec(sock, &rec, detached ? -1 : c->fd) < 0 ||
+                write_all(sock, c->rx, rec.rx_len) < 0 ||
+                write_all(sock, c->sending + c->sending_off, pending) < 0 ||
+                write_all(sock, c->out, out_len) < 0 ||
+                write_all(sock, replay, replay_len) < 0) {
+                free(replay);
+                return -1;
+            }
+            (*nsent)++;
+        }
+    }
+    free(replay);
+    rec.kind = HO_END;
+    return handoff_send_rec(sock, &rec, -1);
+}
+
+// 교체 요청 하나를 처리. 성공하면 프로세스를 끝내고, 실패하면 샤드를 다시 돌림
+static void handoff_run(int sock) {
+    HandoffRec rec;
+    int fd;
+    set_timeouts(sock, HANDOFF_TIMEOUT_SEC);
+    if (handoff_recv_rec(sock, &rec, &fd) < 0 || rec.kind != HO_REQUEST) return;
+
+    // 모든 샤드를 깨워 멈추게 함 (수신함 깨우기와 같은 eventfd)
+    pthread_mutex_lock(&handoff_lock);
+    atomic_store(&handoff_stage, HANDOFF_PAUSE);
+    for (int i = 0; i < nshards; i++) {
+        uint64_t one = 1;
+        while (write(shards[i].wake_fd, &one, sizeof(one)) < 0 && errno == EINTR) {}
+    }
+    while (handoff_parked < nshards) pthread_cond_wait(&handoff_cond, &handoff_lock);
+    pthread_mutex_unlock(&handoff_lock);
+
+    // 샤드 사이에 오가던 중계 메시지를 각 연결의 송신 데이터로 옮김
+    for (int i = 0; i < nshards; i++) shard_drain_inbox(&shards[i]);
+
+    todo_flush();   // 새 서버가 읽을 목록 파일을 넘기기 전에 최신으로
+
+    int nsent = 0;
+    if (handoff_send_all(sock, &nsent) == 0 &&
+        handoff_recv_rec(sock, &rec, &fd) == 0 && rec.kind == HO_ACK) {
+        printf("Handed %d client%s over to the new server, exiting\n", nsent, nsent == 1 ? "" : "s");
+        fflush(stdout);
+        _exit(0);   // 넘긴 소켓은 새 프로세스가 열고 있으므로 닫혀도 연결은 유지됨
+    }
+
+    fprintf(stderr, "chat_server: handoff failed, resuming\n");
+    pthread_mutex_lock(&handoff_lock);
+    atomic_store(&handoff_stage, HANDOFF_NONE);
+    pthread_cond_broadcast(&handoff_cond);
+    pthread_mutex_unlock(&handoff_lock);
+}
+
+static void* handoff_thread(void* arg) {
+    int lsock = (int)(intptr_t)arg;
+    while (1) {
+        int sock = accept(lsock, NULL, NULL);
+        if (sock < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            return NULL;
+        }
+        // 같은 사용자의 프로세스에게만 넘김
+        if (handoff_peer_ok(sock)) handoff_run(sock);
+        close(sock);
+    }
+    return NULL;
+}
+
+// 다음 교체 요청을 받을 유닉스 소켓을 열고 전용 쓰레드에서 기다림
+static void handoff_serve(int port) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (handoff_path(port, addr.sun_path, sizeof(addr.sun_path)) < 0) {
+        fprintf(stderr, "Hot restart unavailable (/tmp/coshell-%u is not a private directory)\n",
+                (unsigned)getuid());
+        return;
+    }
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0) return;
+    unlink(addr.sun_path);      // 이전 서버가 남긴 경로 (그 서버는 이미 끝남)
+    pthread_t tid;
+    if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(sock, 1) < 0 ||
+        pthread_create(&tid, NULL, handoff_thread, (void*)(intptr_t)sock) != 0) {
+        fprintf(stderr, "Hot restart unavailable (%s)\n", addr.sun_path);
+        close(sock);
+        return;
+    }
+    pthread_detach(tid);
+}
+
+// 새 프로세스: 실행 중인 서버에게서 리스너와 연결을 받고, 그 서버가 끝날 때까지 기다림
+static int handoff_receive(int port, int* listeners, int* nlisteners,
+                           HandoffConn** conns, int* nconns) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (handoff_path(port, addr.sun_path, sizeof(addr.sun_path)) < 0) return -1;
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0) return -1;
+    // 다른 사용자가 만든 소켓이면 리스너와 연결을 받지 않음
+    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0 || !handoff_peer_ok(sock)) {
+        close(sock);
+        return -1;
+    }
+    set_timeouts(sock, HANDOFF_TIMEOUT_SEC);
+
+    HandoffRec rec = { .magic = HANDOFF_MAGIC, .kind = HO_REQUEST };
+    HandoffConn* list = NULL;
+    int n = 0, cap = 0, nl = 0, fd, ok = 0;
+    if (handoff_send_rec(sock, &rec, -1) < 0) goto fail;
+    while (handoff_recv_rec(sock, &rec, &fd) == 0) {
+        if (rec.kind == HO_END) {
+            ok = 1;
+            break;
+        }
+        if (rec.kind == HO_LISTENER && fd >= 0 && nl < CHAT_MAX_SHARDS + 1) {
+            listeners[nl++] = fd;
+            continue;
+        }
+        if (rec.kind != HO_CONN || (fd < 0) != (rec.detached != 0) || rec.rx_len > BUF_SIZE * 2 ||
+            rec.out_len > CHAT_SENDQ_LIMIT || rec.replay_len > CHAT_REPLAY_BYTES ||
+            rec.replay_len > rec.stream_pos || (rec.detached && !rec.token)) {
+            if (fd >= 0) close(fd);
+            break;
+        }
+        if (n == cap) {
+            cap = cap ? cap * 2 : 64;
+            HandoffConn* p = realloc(list, sizeof(HandoffConn) * (size_t)cap);
+            if (!p) {
+                close(fd);
+                break;
+            }
+            list = p;
+        }
+        HandoffConn* h = &list[n];
+        h->fd = fd;
+        h->detached = rec.detached != 0;
+        h->idle_ns = rec.idle_ns;
+        h->token = rec.token;
+        h->stream_pos = rec.stream_pos;
+        h->rx_len = rec.rx_len;
+        h->out_len = rec.out_len;
+        h->replay_len = rec.replay_len;
+        size_t len = h->rx_len + h->out_len + h->replay_len;
+        h->data = malloc(len + 1);
+        n++;
+        if (!h->data || read_all(sock, h->data, len) < 0) break;
+    }
+
+    // 다 받았다고 알린 뒤, 이전 서버가 끝나(연결이 닫혀) 포트+1 지표와 소켓 경로가 풀릴 때까지
+    rec.kind = HO_ACK;
+    if (ok && nl > 0 && handoff_send_rec(sock, &rec, -1) == 0) {
+        char c;
+        while (recv(sock, &c, 1, 0) > 0) {}
+        close(sock);
+        *nlisteners = nl;
+        *conns = list;
+        *nconns = n;
+        return 0;
+    }
+
+fail:
+    fprintf(stderr, "chat_server: takeover failed\n");
+    for (int i = 0; i < nl; i++) close(listeners[i]);
+    for (int i = 0; i < n; i++) {
+        if (list[i].fd >= 0) close(list[i].fd);
+        free(list[i].data);
+    }
+    free(list);
+    close(sock);
+    return -1;
+}
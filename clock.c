@@ -0,0 +1,571 @@
+/*========================================*/
+/*            시계/타임존 모듈              */
+/*  - TZif(v1~v4) 파일 파싱                */
+/*  - POSIX TZ 규칙(footer)으로 이후 연도의 */
+/*    DST 전환 시각을 미리 계산             */
+/*  - 시계 문자열 캐시 (바뀐 글자만 갱신)    */
+/*========================================*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define CLOCK_RULE_LAST_YEAR 2100   // footer 규칙으로 전환 시각을 펼쳐 둘 마지막 연도
+
+// 하나의 오프셋이 적용되는 구간: [start, 다음 구간의 start)
+typedef struct {
+    int64_t start;
+    int32_t utoff;
+    char    abbr[CLOCK_ABBR_LEN];
+} ClockPeriod;
+
+struct ClockZone {
+    char         name[64];
+    ClockPeriod* periods;          // start 오름차순, periods[0].start = INT64_MIN
+    int          nperiods;
+    struct ClockZone* next;        // 캐시 연결 리스트
+};
+
+static ClockZone* zone_cache = NULL;
+
+/*==============================*/
+/*        날짜 계산 헬퍼         */
+/*==============================*/
+
+// 그레고리력 날짜 → 1970-01-01부터의 일 수 (H. Hinnant의 days_from_civil)
+static int64_t days_from_civil(int64_t y, int m, int d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yoe = y - era * 400;
+    int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// 일 수 → 그레고리력 날짜
+static void civil_from_days(int64_t z, int* y, int* m, int* d) {
+    z += 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    int64_t doe = z - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+    *d = (int)(doy - (153 * mp + 2) / 5 + 1);
+    *m = (int)(mp < 10 ? mp + 3 : mp - 9);
+    *y = (int)(yoe + era * 400 + (*m <= 2));
+}
+
+static int is_leap(int y) {
+    return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+}
+
+static int64_t floor_div(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+/*==============================*/
+/*      POSIX TZ 규칙 파싱       */
+/*==============================*/
+
+// 전환 날짜: Jn(윤일 제외 1~365), n(윤일 포함 0~365), Mm.w.d(m월 w번째 d요일)
+typedef struct {
+    char kind;          // 'J', 'N', 'M'
+    int  n, m, w, d;
+    int32_t time;       // 그 날 현지 시각(초), 기본 02:00:00, 음수/24시간 초과 가능
+} TzRuleDate;
+
+typedef struct {
+    char    std_abbr[CLOCK_ABBR_LEN], dst_abbr[CLOCK_ABBR_LEN];
+    int32_t std_utoff, dst_utoff;
+    int     has_dst;
+    TzRuleDate start, end;
+} TzRule;
+
+static const char* parse_abbr(const char* p, char* out) {
+    size_t n = 0;
+    if (*p == '<') {
+        p++;
+        while (*p && *p != '>') {
+            if (n < CLOCK_ABBR_LEN - 1) out[n++] = *p;
+            p++;
+        }
+        if (*p != '>') return NULL;
+        p++;
+    }
+    else {
+        while (isalpha((unsigned char)*p)) {
+            if (n < CLOCK_ABBR_LEN - 1) out[n++] = *p;
+            p++;
+        }
+    }
+    out[n] = '\0';
+    return n >= 3 ? p : NULL;
+}
+
+// [+-]hh[:mm[:ss]] → 초
+static const char* parse_hms(const char* p, int32_t* out) {
+    int sign = 1;
+    if (*p == '+' || *p == '-') sign = (*p++ == '-') ? -1 : 1;
+    if (!isdigit((unsigned char)*p)) return NULL;
+    int32_t h = 0, m = 0, s = 0;
+    while (isdigit((unsigned char)*p)) h = h * 10 + (*p++ - '0');
+    if (*p == ':') {
+        p++;
+        while (isdigit((unsigned char)*p)) m = m * 10 + (*p++ - '0');
+        if (*p == ':') {
+            p++;
+            while (isdigit((unsigned char)*p)) s = s * 10 + (*p++ - '0');
+        }
+    }
+    *out = sign * (h * 3600 + m * 60 + s);
+    return p;
+}
+
+static const char* parse_rule_date(const char* p, TzRuleDate* r) {
+    if (*p == 'M') {
+        r->kind = 'M';
+        if (sscanf(p + 1, "%d.%d.%d", &r->m, &r->w, &r->d) != 3) return NULL;
+        p++;
+        while (isdigit((unsigned char)*p) || *p == '.') p++;
+    }
+    else {
+        r->kind = 'N';
+        if (*p == 'J') { r->kind = 'J'; p++; }
+        if (!isdigit((unsigned char)*p)) return NULL;
+        r->n = 0;
+        while (isdigit((unsigned char)*p)) r->n = r->n * 10 + (*p++ - '0');
+    }
+    r->time = 2 * 3600;
+    if (*p == '/') p = parse_hms(p + 1, &r->time);
+    return p;
+}
+
+// 예: "EST5EDT,M3.2.0,M11.1.0", "<+0530>-5:30", "IST-1GMT0,M10.5.0,M3.5.0/1"
+static int parse_tz_rule(const char* p, TzRule* r) {
+    int32_t off;
+    memset(r, 0, sizeof(*r));
+    if (!(p = parse_abbr(p, r->std_abbr))) return -1;
+    if (!(p = parse_hms(p, &off))) return -1;
+    r->std_utoff = -off;            // POSIX는 서쪽이 양수
+    if (*p == '\0') return 0;
+
+    if (!(p = parse_abbr(p, r->dst_abbr))) return -1;
+    r->has_dst = 1;
+    r->dst_utoff = r->std_utoff + 3600;
+    if (*p && *p != ',') {
+        if (!(p = parse_hms(p, &off))) return -1;
+        r->dst_utoff = -off;
+    }
+    // 규칙이 없으면 POSIX 기본값(미국 규칙)
+    if (*p != ',') p = ",M3.2.0,M11.1.0";
+    if (!(p = parse_rule_date(p + 1, &r->start)) || *p != ',') return -1;
+    if (!(p = parse_rule_date(p + 1, &r->end))) return -1;
+    return 0;
+}
+
+// year년 규칙 날짜의 현지 자정 (1970-01-01부터의 일 수)
+static int64_t rule_day(const TzRuleDate* r, int year) {
+    int64_t jan1 = days_from_civil(year, 1, 1);
+    if (r->kind == 'J') return jan1 + r->n - 1 + (is_leap(year) && r->n >= 60);
+    if (r->kind == 'N') return jan1 + r->n;
+
+    static const int mdays[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    int64_t first = days_from_civil(year, r->m, 1);
+    int wday = (int)((first % 7 + 7 + 4) % 7);           // 1970-01-01은 목요일(4)
+    int day = (r->d - wday + 7) % 7 + (r->w - 1) * 7;
+    int mlen = mdays[r->m - 1] + (r->m == 2 && is_leap(year));
+    while (day >= mlen) day -= 7;                       // w=5: 마지막 d요일
+    return first + day;
+}
+
+/*==============================*/
+/*         TZif 파싱             */
+/*==============================*/
+
+static int add_period(ClockZone* z, int* cap, int64_t start, int32_t utoff, const char* abbr) {
+    if (z->nperiods > 0) {
+        ClockPeriod* last = &z->periods[z->nperiods - 1];
+        if (start <= last->start) return 0;
+        if (last->utoff == utoff && strcmp(last->abbr, abbr) == 0) return 0;   // 변화 없음
+    }
+    if (z->nperiods == *cap) {
+        int ncap = *cap ? *cap * 2 : 64;
+        ClockPeriod* np = realloc(z->periods, sizeof(ClockPeriod) * ncap);
+        if (!np) return -1;
+        z->periods = np;
+        *cap = ncap;
+    }
+    ClockPeriod* p = &z->periods[z->nperiods++];
+    p->start = start;
+    p->utoff = utoff;
+    snprintf(p->abbr, sizeof(p->abbr), "%s", abbr);
+    return 0;
+}
+
+// 마지막 명시적 전환 이후를 footer 규칙으로 CLOCK_RULE_LAST_YEAR까지 펼침
+static int extend_with_rule(ClockZone* z, int* cap, const TzRule* r) {
+    if (z->nperiods == 0) {
+        return add_period(z, cap, INT64_MIN, r->std_utoff, r->std_abbr);
+    }
+    if (!r->has_dst) return 0;     // 마지막 전환 이후 고정 오프셋 (이미 마지막 구간과 같음)
+
+    int y, m, d;
+    int64_t last = z->periods[z->nperiods - 1].start;
+    civil_from_days(floor_div(last == INT64_MIN ? 0 : last, 86400), &y, &m, &d);
+    for (; y <= CLOCK_RULE_LAST_YEAR; y++) {
+        // 시작 시각은 표준시 기준, 종료 시각은 DST 기준 현지 시각
+        int64_t on  = rule_day(&r->start, y) * 86400 + r->start.time - r->std_utoff;
+        int64_t off = rule_day(&r->end, y)   * 86400 + r->end.time   - r->dst_utoff;
+        if (on < off) {
+            if (add_period(z, cap, on,  r->dst_utoff, r->dst_abbr) < 0) return -1;
+            if (add_period(z, cap, off, r->std_utoff, r->std_abbr) < 0) return -1;
+        }
+        else {  // 남반구: 연초에 DST가 끝나고 연말에 시작
+            if (add_period(z, cap, off, r->std_utoff, r->std_abbr) < 0) return -1;
+            if (add_period(z, cap, on,  r->dst_utoff, r->dst_abbr) < 0) return -1;
+        }
+    }
+    return 0;
+}
+
+static int64_t be32(const unsigned char* p) {
+    return (int32_t)((uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3]);
+}
+
+static int64_t be64(const unsigned char* p) {
+    return (int64_t)((uint64_t)(uint32_t)be32(p) << 32 | (uint32_t)be32(p + 4));
+}
+
+// TZif 파일 내용(buf)을 구간 목록으로 변환
+static int parse_tzif(ClockZone* z, const unsigned char* buf, size_t len) {
+    if (len < 44 || memcmp(buf, "TZif", 4) != 0) return -1;
+
+    int version = buf[4];
+    const unsigned char* h = buf;
+    int tsize = 4;
+    size_t cnt[6];
+    for (int i = 0; i < 6; i++) cnt[i] = (size_t)be32(h + 20 + i * 4);
+    size_t isutcnt = cnt[0], isstdcnt = cnt[1], leapcnt = cnt[2];
+    size_t timecnt = cnt[3], typecnt = cnt[4], charcnt = cnt[5];
+    size_t block = timecnt * 4 + timecnt + typecnt * 6 + charcnt + leapcnt * 8 + isstdcnt + isutcnt;
+
+    // v2 이상이면 v1 블록을 건너뛰고 64비트 블록 사용
+    if (version >= '2') {
+        if (44 + block + 44 > len) return -1;
+        h = buf + 44 + block;
+        if (memcmp(h, "TZif", 4) != 0) return -1;
+        for (int i = 0; i < 6; i++) cnt[i] = (size_t)be32(h + 20 + i * 4);
+        isutcnt = cnt[0]; isstdcnt = cnt[1]; leapcnt = cnt[2];
+        timecnt = cnt[3]; typecnt = cnt[4]; charcnt = cnt[5];
+        tsize = 8;
+        block = timecnt * 8 + timecnt + typecnt * 6 + charcnt + leapcnt * 12 + isstdcnt + isutcnt;
+    }
+    const unsigned char* data = h + 44;
+    if (typecnt == 0 || data + block > buf + len) return -1;
+
+    const unsigned char* times = data;
+    const unsigned char* idxs  = times + timecnt * tsize;
+    const unsigned char* types = idxs + timecnt;
+    const char*          chars = (const char*)(types + typecnt * 6);
+
+    int cap = 0;
+    #define TYPE_UTOFF(i) ((int32_t)be32(types + (i) * 6))
+    #define TYPE_ABBR(i)  (types[(i) * 6 + 5] < charcnt ? chars + types[(i) * 6 + 5] : "")
+
+    // 첫 전환 이전에는 타입 0 적용
+    if (add_period(z, &cap, INT64_MIN, TYPE_UTOFF(0), TYPE_ABBR(0)) < 0) return -1;
+    for (size_t i = 0; i < timecnt; i++) {
+        int64_t at = (tsize == 8) ? be64(times + i * 8) : be32(times + i * 4);
+        size_t  ti = idxs[i];
+        if (ti >= typecnt) return -1;
+        if (add_period(z, &cap, at, TYPE_UTOFF(ti), TYPE_ABBR(ti)) < 0) return -1;
+    }
+    #undef TYPE_UTOFF
+    #undef TYPE_ABBR
+
+    // footer: "\n<POSIX TZ>\n"
+    const char* foot = (const char*)(data + block);
+    const char* end = (const char*)buf + len;
+    if (version >= '2' && foot < end && *foot == '\n') {
+        char rule_str[128];
+        size_t n = 0;
+        for (foot++; foot < end && *foot != '\n' && n < sizeof(rule_str) - 1; foot++) {
+            rule_str[n++] = *foot;
+        }
+        rule_str[n] = '\0';
+        TzRule rule;
+        if (n > 0 && parse_tz_rule(rule_str, &rule) == 0) {
+            if (extend_with_rule(z, &cap, &rule) < 0) return -1;
+        }
+    }
+    return 0;
+}
+
+static ClockZone* load_tzif_file(const char* path) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return NULL;
+    unsigned char* buf = NULL;
+    size_t len = 0, cap = 0, n;
+    do {
+        if (len == cap) {
+            cap = cap ? cap * 2 : 4096;
+            unsigned char* nb = realloc(buf, cap);
+            if (!nb) { free(buf); fclose(fp); return NULL; }
+            buf = nb;
+        }
+        n = fread(buf + len, 1, cap - len, fp);
+        len += n;
+    } while (n > 0);
+    fclose(fp);
+
+    ClockZone* z = calloc(1, sizeof(*z));
+    if (z && parse_tzif(z, buf, len) != 0) {
+        free(z->periods);
+        free(z);
+        z = NULL;
+    }
+    free(buf);
+    return z;
+}
+
+// 파일 없이 POSIX TZ 문자열만으로 존 만들기 (예: TZ="KST-9")
+static ClockZone* load_tz_string(const char* s) {
+    TzRule rule;
+    if (parse_tz_rule(s, &rule) != 0) return NULL;
+    ClockZone* z = calloc(1, sizeof(*z));
+    int cap = 0;
+    if (!z) return NULL;
+    if (add_period(z, &cap, INT64_MIN, rule.std_utoff, rule.std_abbr) < 0 ||
+        (rule.has_dst && extend_with_rule(z, &cap, &rule) < 0)) {
+        free(z->periods);
+        free(z);
+        return NULL;
+    }
+    return z;
+}
+
+const ClockZone* clock_zone_load(const char* name) {
+    char key[64];
+    const char* tz = NULL;
+    if (name) {
+        snprintf(key, sizeof(key), "%s", name);
+    }
+    else {
+        tz = getenv("TZ");
+        if (tz && *tz == ':') tz++;
+        snprintf(key, sizeof(key), "%s", (tz && *tz) ? tz : "localtime");
+    }
+
+    for (ClockZone* z = zone_cache; z; z = z->next) {
+        if (strcmp(z->name, key) == 0) return z;
+    }
+
+    ClockZone* z = NULL;
+    char path[512];
+    if (name) {
+        // 경로 탈출 방지: 상대 이름만 허용
+        if (name[0] == '\0' || name[0] == '/' || strstr(name, "..")) return NULL;
+        snprintf(path, sizeof(path), "%s/%s", CLOCK_ZONEINFO_DIR, name);
+        z = load_tzif_file(path);
+    }
+    else if (tz && *tz) {
+        if (tz[0] == '/') {
+            z = load_tzif_file(tz);
+        }
+        else {
+            snprintf(path, sizeof(path), "%s/%s", CLOCK_ZONEINFO_DIR, tz);
+            z = load_tzif_file(path);
+        }
+        if (!z) z = load_tz_string(tz);
+    }
+    else {
+        z = load_tzif_file("/etc/localtime");
+    }
+    if (!z && !name) z = load_tz_string("UTC0");    // 로컬은 실패해도 UTC로 동작
+    if (!z) return NULL;
+
+    snprintf(z->name, sizeof(z->name), "%s", key);
+    z->next = zone_cache;
+    zone_cache = z;
+    return z;
+}
+
+const char* clock_zone_name(const ClockZone* zone) {
+    return zone->name;
+}
+
+// t 이하인 마지막 start를 이분 탐색
+static int find_period(const ClockZone* zone, int64_t t) {
+    int lo = 0, hi = zone->nperiods - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (zone->periods[mid].start <= t) lo = mid;
+        else hi = mid - 1;
+    }
+    return lo;
+}
+
+int32_t clock_zone_offset(const ClockZone* zone, int64_t t, const char** abbr, int64_t* until) {
+    int i = find_period(zone, t);
+    if (abbr) *abbr = zone->periods[i].abbr;
+    if (until) *until = (i + 1 < zone->nperiods) ? zone->periods[i + 1].start : INT64_MAX;
+    return zone->periods[i].utoff;
+}
+
+/*==============================*/
+/*       타임존 이름 색인         */
+/*==============================*/
+
+static char** zone_names = NULL;    // 정렬된 IANA 이름
+static char** zone_keys = NULL;     // 검색용: 소문자 + '_' → ' '
+static int    zone_name_count = -1;
+
+static int cmp_str(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+static void make_search_key(char* dst, const char* src, size_t cap) {
+    size_t n = 0;
+    for (; *src && n < cap - 1; src++) {
+        dst[n++] = (*src == '_') ? ' ' : (char)tolower((unsigned char)*src);
+    }
+    dst[n] = '\0';
+}
+
+// zone1970.tab: "국가코드<TAB>좌표<TAB>TZ<TAB>설명"
+static void load_zone_names(void) {
+    int cap = 0;
+    zone_name_count = 0;
+    FILE* fp = fopen(CLOCK_ZONEINFO_DIR "/zone1970.tab", "r");
+    if (!fp) fp = fopen(CLOCK_ZONEINFO_DIR "/zone.tab", "r");
+
+    char line[512];
+    while (fp && fgets(line, sizeof(line), fp)) {
+        if (line[0] == '#') continue;
+        char* save = NULL;
+        strtok_r(line, "\t\n", &save);
+        strtok_r(NULL, "\t\n", &save);
+        char* tz = strtok_r(NULL, "\t\n", &save);
+        if (!tz) continue;
+        if (zone_name_count + 1 >= cap) {
+            cap = cap ? cap * 2 : 512;
+            char** nn = realloc(zone_names, sizeof(char*) * cap);
+            if (!nn) break;
+            zone_names = nn;
+        }
+        zone_names[zone_name_count++] = strdup(tz);
+    }
+    if (fp) fclose(fp);
+
+    // 표에는 지역 존만 있으므로 UTC를 직접 추가
+    if (zone_name_count + 1 > cap) {
+        char** nn = realloc(zone_names, sizeof(char*) * (zone_name_count + 1));
+        if (!nn) return;
+        zone_names = nn;
+    }
+    zone_names[zone_name_count++] = strdup("UTC");
+    qsort(zone_names, zone_name_count, sizeof(char*), cmp_str);
+
+    zone_keys = malloc(sizeof(char*) * zone_name_count);
+    for (int i = 0; zone_keys && i < zone_name_count; i++) {
+        char key[128];
+        make_search_key(key, zone_names[i], sizeof(key));
+        zone_keys[i] = strdup(key);
+    }
+}
+
+int clock_zone_names(const char* const** names) {
+    if (zone_name_count < 0) load_zone_names();
+    *names = (const char* const*)zone_names;
+    return zone_name_count;
+}
+
+int clock_zone_search(const char* query, int* idx, int max) {
+    if (zone_name_count < 0) load_zone_names();
+    if (!zone_keys) return 0;
+
+    char key[128];
+    make_search_key(key, query, sizeof(key));
+    int found = 0;
+    for (int i = 0; i < zone_name_count; i++) {
+        if (key[0] && !strstr(zone_keys[i], key)) continue;
+        if (found < max) idx[found] = i;
+        found++;
+    }
+    return found;
+}
+
+/*==============================*/
+/*        시계 문자열 캐시        */
+/*==============================*/
+
+void clock_face_init(ClockFace* face, const ClockZone* zone) {
+    memset(face, 0, sizeof(*face));
+    face->zone = zone;
+}
+
+static void put2(char* p, int v) {
+    p[0] = (char)('0' + v / 10);
+    p[1] = (char)('0' + v % 10);
+}
+
+int clock_face_tick(ClockFace* face, time_t now) {
+    // 형식: "YYYY-MM-DD HH:MM:SS ABBR    "
+    //        0         1         2
+    //        0123456789012345678901234567
+    int first = -1;
+    int64_t t = (int64_t)now;
+
+    // (1) 현재 구간을 벗어났을 때(DST 전환, 시계를 뒤로 맞춤)만 오프셋/약어 다시 찾기
+    if (!face->valid || t >= face->until || t < face->since) {
+        const ClockZone* z = face->zone;
+        int i = find_period(z, t);
+        const char* abbr = z->periods[i].abbr;
+        face->utoff = z->periods[i].utoff;
+        face->since = z->periods[i].start;
+        face->until = (i + 1 < z->nperiods) ? z->periods[i + 1].start : INT64_MAX;
+        char tail[CLOCK_TEXT_LEN - 19];
+        snprintf(tail, sizeof(tail), " %-*s", CLOCK_ABBR_LEN - 1, abbr);
+        if (!face->valid || memcmp(face->text + 19, tail, strlen(tail)) != 0) {
+            memcpy(face->text + 19, tail, strlen(tail) + 1);
+            first = 19;
+        }
+    }
+
+    int64_t local = t + face->utoff;
+    int64_t day = floor_div(local, 86400);
+    int secs = (int)(local - day * 86400);
+
+    // (2) 날짜는 날이 바뀔 때만
+    if (!face->valid || day != face->day) {
+        int y, m, d;
+        civil_from_days(day, &y, &m, &d);
+        char date[16];
+        snprintf(date, sizeof(date), "%04d-%02d-%02d ", y % 10000, m, d);
+        memcpy(face->text, date, 11);
+        face->day = day;
+        first = 0;
+    }
+
+    // (3) 시:분:초는 직접 찍고 처음 달라진 자리 찾기
+    char hms[8];
+    put2(hms, secs / 3600);
+    hms[2] = ':';
+    put2(hms + 3, secs / 60 % 60);
+    hms[5] = ':';
+    put2(hms + 6, secs % 60);
+    for (int i = 0; i < 8; i++) {
+        if (!face->valid || face->text[11 + i] != hms[i]) {
+            if (first < 0 || 11 + i < first) first = 11 + i;
+            memcpy(face->text + 11 + i, hms + i, 8 - i);
+            break;
+        }
+    }
+    face->valid = 1;
+    return first;
+}
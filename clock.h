@@ -0,0 +1,77 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <stdint.h>
+#include <time.h>
+
+/*==============================*/
+/*   IANA 타임존 기반 시계 모듈   */
+/*==============================*/
+/*
+ * 시스템 tzdata(/usr/share/zoneinfo)의 TZif 파일을 읽어
+ * 서머타임(DST) 전환 시각을 미리 계산해 두고, 매 초 시계 문자열을 싸게 갱신합니다.
+ */
+
+#define CLOCK_ZONEINFO_DIR  "/usr/share/zoneinfo"
+#define CLOCK_ABBR_LEN      8      // 약어 최대 길이 (EST, CEST, +0530 ...)
+#define CLOCK_TEXT_LEN      32     // "YYYY-MM-DD HH:MM:SS ABBR...." + NUL
+
+typedef struct ClockZone ClockZone;
+
+/**
+ * 타임존을 읽어 옵니다. 한 번 읽은 존은 이름으로 캐시되어 다시 파싱하지 않습니다.
+ * - name: "Asia/Seoul" 같은 IANA 이름. NULL이면 로컬 타임존(TZ 환경변수 → /etc/localtime)
+ * 반환값: 존 (찾지 못하면 NULL, 로컬은 실패 시 UTC)
+ */
+const ClockZone* clock_zone_load(const char* name);
+
+/**
+ * 시각 t(UTC 기준 초)에 적용되는 UTC 오프셋(초)을 돌려줍니다.
+ * - abbr: NULL이 아니면 약어 문자열을 돌려줌
+ * - until: NULL이 아니면 이 오프셋이 유지되는 마지막 시각+1 (다음 전환 시각)
+ */
+int32_t clock_zone_offset(const ClockZone* zone, int64_t t,
+                          const char** abbr, int64_t* until);
+
+/** 존 이름 ("Europe/London", 로컬이면 "localtime" 또는 TZ 값) */
+const char* clock_zone_name(const ClockZone* zone);
+
+/**
+ * tzdata에 있는 타임존 이름 목록(zone1970.tab, 없으면 zone.tab)을 정렬해 돌려줍니다.
+ * 처음 호출할 때 한 번만 읽고 이후에는 캐시를 돌려줍니다.
+ * 반환값: 이름 개수 (*names에 배열)
+ */
+int clock_zone_names(const char* const** names);
+
+/**
+ * 타임존 이름을 검색합니다. 대소문자 무시 부분 일치이며 공백은 '_'와 같게 취급
+ * ("new york" → America/New_York). 빈 문자열이면 전체.
+ * - idx: clock_zone_names() 배열의 인덱스를 최대 max개 채움
+ * 반환값: 일치한 전체 개수 (max보다 클 수 있음)
+ */
+int clock_zone_search(const char* query, int* idx, int max);
+
+/**
+ * 화면에 찍을 시계 하나: 마지막으로 만든 문자열과 유효 구간을 기억해 두고
+ * 바뀐 글자만 다시 만듭니다.
+ * - 날짜(YYYY-MM-DD)는 날이 바뀔 때만, 오프셋/약어는 DST 전환 시각을 지날 때만 다시 계산
+ */
+typedef struct {
+    const ClockZone* zone;
+    char    text[CLOCK_TEXT_LEN];   // "YYYY-MM-DD HH:MM:SS ABBR" (약어는 공백으로 고정 폭)
+    int64_t day;                    // text에 찍힌 날짜 (1970-01-01부터의 일 수)
+    int64_t since, until;           // utoff가 유효한 구간 [since, until)
+    int32_t utoff;
+    int     valid;                  // 0이면 다음 tick에서 전부 다시 만듦
+} ClockFace;
+
+/** 시계를 zone으로 초기화합니다. (다음 clock_face_tick에서 전체 문자열 생성) */
+void clock_face_init(ClockFace* face, const ClockZone* zone);
+
+/**
+ * now 시각으로 문자열을 갱신합니다.
+ * 반환값: 처음으로 바뀐 글자 위치 (text + 반환값부터 다시 그리면 됨), 바뀐 것이 없으면 -1
+ */
+int clock_face_tick(ClockFace* face, time_t now);
+
+#endif // CLOCK_H
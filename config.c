@@ -0,0 +1,248 @@
+/*========================================*/
+/*             설정 파일 모듈              */
+/*  - key = value 텍스트 파싱/저장         */
+/*  - 파싱 결과를 바이너리 스냅샷으로 캐시   */
+/*========================================*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#define CONFIG_SNAP_MAGIC   0x43534843u   // "CSHC"
+#define CONFIG_SNAP_VERSION 1
+
+// 스냅샷 헤더: 원본 텍스트의 mtime/크기가 같을 때만 유효
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t struct_size;       // sizeof(CoConfig)가 바뀌면(필드 추가 등) 무효
+    uint32_t reserved;
+    int64_t  src_mtime_sec;
+    int64_t  src_mtime_nsec;
+    int64_t  src_size;
+} ConfigSnapHeader;
+
+// 설정 디렉터리 경로: $XDG_CONFIG_HOME/coshell 또는 ~/.config/coshell
+static int config_dir(char* buf, size_t size) {
+    const char* xdg = getenv("XDG_CONFIG_HOME");
+    const char* home = getenv("HOME");
+    int n;
+    if (xdg && *xdg) n = snprintf(buf, size, "%s/coshell", xdg);
+    else if (home && *home) n = snprintf(buf, size, "%s/.config/coshell", home);
+    else return -1;
+    return (n > 0 && (size_t)n < size) ? 0 : -1;
+}
+
+static int config_path(char* buf, size_t size, const char* file) {
+    char dir[448];
+    if (config_dir(dir, sizeof(dir)) < 0) return -1;
+    int n = snprintf(buf, size, "%s/%s", dir, file);
+    return (n > 0 && (size_t)n < size) ? 0 : -1;
+}
+
+// 앞뒤 공백 제거
+static char* trim(char* s) {
+    while (isspace((unsigned char)*s)) s++;
+    char* e = s + strlen(s);
+    while (e > s && isspace((unsigned char)e[-1])) *--e = '\0';
+    return s;
+}
+
+static void parse_line(CoConfig* cfg, char* line) {
+    char* hash = strchr(line, '#');
+    if (hash) *hash = '\0';
+    char* eq = strchr(line, '=');
+    if (!eq) return;
+    *eq = '\0';
+    char* key = trim(line);
+    char* val = trim(eq + 1);
+
+    if (strcmp(key, "nickname") == 0) {
+        // 닉네임은 공백 없이 (Chat 입력 규칙과 동일)
+        val[strcspn(val, " \t")] = '\0';
+        snprintf(cfg->nickname, sizeof(cfg->nickname), "%s", val);
+    }
+    else if (strcmp(key, "chat.host") == 0) {
+        snprintf(cfg->chat_host, sizeof(cfg->chat_host), "%s", val);
+    }
+    else if (strcmp(key, "chat.port") == 0) {
+        int port = atoi(val);
+        cfg->chat_port = (port > 0 && port < 65536) ? port : 0;
+    }
+    else if (strcmp(key, "chat.heartbeat") == 0) {
+        int sec = atoi(val);
+        cfg->heartbeat_sec = sec > 0 ? sec : 0;
+    }
+    else if (strcmp(key, "chat.idle_timeout") == 0) {
+        int sec = atoi(val);
+        cfg->idle_timeout_sec = sec > 0 ? sec : 0;
+    }
+    else if (strcmp(key, "chat.connect_timeout") == 0) {
+        int sec = atoi(val);
+        cfg->connect_timeout_sec = sec > 0 ? sec : 0;
+    }
+    else if (strcmp(key, "server.io") == 0) {
+        cfg->server_uring = (strcmp(val, "uring") == 0);
+    }
+    else if (strcmp(key, "todo.mode") == 0) {
+        cfg->todo_team = (strcmp(val, "team") == 0);
+    }
+    else if (strcmp(key, "clock") == 0) {
+        cfg->clocks_set = 1;
+        if (*val && cfg->nclocks < CONFIG_MAX_CLOCKS) {
+            snprintf(cfg->clocks[cfg->nclocks++], CONFIG_ZONE_LEN, "%s", val);
+        }
+    }
+}
+
+static int parse_text(CoConfig* cfg, FILE* fp) {
+    char line[512];
+    memset(cfg, 0, sizeof(*cfg));
+    while (fgets(line, sizeof(line), fp)) parse_line(cfg, line);
+    return 0;
+}
+
+// 임시 파일에 쓰고 rename → 읽는 쪽이 반쯤 쓴 파일을 보지 않음
+static int write_atomic(const char* path, const void* data, size_t len) {
+    char tmp[520];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) return -1;
+    const char* p = data;
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = write(fd, p + done, len - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) { close(fd); unlink(tmp); return -1; }
+        done += (size_t)n;
+    }
+    if (close(fd) < 0 || rename(tmp, path) < 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+static void write_snapshot(const CoConfig* cfg, const struct stat* src) {
+    char path[512];
+    if (config_path(path, sizeof(path), "config.bin") < 0) return;
+
+    struct {
+        ConfigSnapHeader hdr;
+        CoConfig cfg;
+    } snap;
+    memset(&snap, 0, sizeof(snap));
+    snap.hdr.magic = CONFIG_SNAP_MAGIC;
+    snap.hdr.version = CONFIG_SNAP_VERSION;
+    snap.hdr.struct_size = sizeof(CoConfig);
+    snap.hdr.src_mtime_sec = src->st_mtim.tv_sec;
+    snap.hdr.src_mtime_nsec = src->st_mtim.tv_nsec;
+    snap.hdr.src_size = src->st_size;
+    snap.cfg = *cfg;
+    write_atomic(path, &snap, sizeof(snap));
+}
+
+// 스냅샷이 원본과 일치하면 그대로 읽음 (read 한 번)
+static int read_snapshot(CoConfig* cfg, const struct stat* src) {
+    char path[512];
+    if (config_path(path, sizeof(path), "config.bin") < 0) return -1;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    struct {
+        ConfigSnapHeader hdr;
+        CoConfig cfg;
+    } snap;
+    ssize_t n = read(fd, &snap, sizeof(snap));
+    close(fd);
+    if (n != (ssize_t)sizeof(snap) ||
+        snap.hdr.magic != CONFIG_SNAP_MAGIC ||
+        snap.hdr.version != CONFIG_SNAP_VERSION ||
+        snap.hdr.struct_size != sizeof(CoConfig) ||
+        snap.hdr.src_mtime_sec != (int64_t)src->st_mtim.tv_sec ||
+        snap.hdr.src_mtime_nsec != (int64_t)src->st_mtim.tv_nsec ||
+        snap.hdr.src_size != (int64_t)src->st_size) {
+        return -1;
+    }
+
+    // 문자열 필드는 NUL로 끝나도록 보정 (손상된 스냅샷 대비)
+    snap.cfg.nickname[sizeof(snap.cfg.nickname) - 1] = '\0';
+    snap.cfg.chat_host[sizeof(snap.cfg.chat_host) - 1] = '\0';
+    if (snap.cfg.nclocks < 0 || snap.cfg.nclocks > CONFIG_MAX_CLOCKS) return -1;
+    for (int i = 0; i < snap.cfg.nclocks; i++) snap.cfg.clocks[i][CONFIG_ZONE_LEN - 1] = '\0';
+
+    *cfg = snap.cfg;
+    return 0;
+}
+
+int config_load(CoConfig* cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    char path[512];
+    struct stat st;
+    if (config_path(path, sizeof(path), "config") < 0 || stat(path, &st) < 0) return -1;
+
+    if (read_snapshot(cfg, &st) == 0) return 0;
+
+    FILE* fp = fopen(path, "r");
+    if (!fp) return -1;
+    parse_text(cfg, fp);
+    fclose(fp);
+    write_snapshot(cfg, &st);
+    return 1;
+}
+
+int config_save(const CoConfig* cfg) {
+    char dir[448], path[512];
+    if (config_dir(dir, sizeof(dir)) < 0) return -1;
+
+    // ~/.config 가 없을 수도 있으므로 한 단계씩 생성
+    char* slash = dir;
+    while ((slash = strchr(slash + 1, '/')) != NULL) {
+        *slash = '\0';
+        mkdir(dir, 0700);
+        *slash = '/';
+    }
+    if (mkdir(dir, 0700) < 0 && errno != EEXIST) return -1;
+    if (config_path(path, sizeof(path), "config") < 0) return -1;
+
+    char text[4096];
+    int n = snprintf(text, sizeof(text), "# CoShell 설정 (UI에서 바뀐 값이 자동 저장됨)\n");
+    if (cfg->nickname[0])
+        n += snprintf(text + n, sizeof(text) - n, "nickname = %s\n", cfg->nickname);
+    if (cfg->chat_host[0])
+        n += snprintf(text + n, sizeof(text) - n, "chat.host = %s\n", cfg->chat_host);
+    if (cfg->chat_port > 0)
+        n += snprintf(text + n, sizeof(text) - n, "chat.port = %d\n", cfg->chat_port);
+    if (cfg->heartbeat_sec > 0)
+        n += snprintf(text + n, sizeof(text) - n, "chat.heartbeat = %d\n", cfg->heartbeat_sec);
+    if (cfg->idle_timeout_sec > 0)
+        n += snprintf(text + n, sizeof(text) - n, "chat.idle_timeout = %d\n", cfg->idle_timeout_sec);
+    if (cfg->connect_timeout_sec > 0)
+        n += snprintf(text + n, sizeof(text) - n, "chat.connect_timeout = %d\n", cfg->connect_timeout_sec);
+    if (cfg->server_uring)
+        n += snprintf(text + n, sizeof(text) - n, "server.io = uring\n");
+    n += snprintf(text + n, sizeof(text) - n, "todo.mode = %s\n", cfg->todo_team ? "team" : "user");
+    if (cfg->clocks_set && cfg->nclocks == 0)
+        n += snprintf(text + n, sizeof(text) - n, "clock =\n");     // 세계 시계 없음
+    for (int i = 0; i < cfg->nclocks; i++)
+        n += snprintf(text + n, sizeof(text) - n, "clock = %s\n", cfg->clocks[i]);
+
+    if (write_atomic(path, text, (size_t)n) < 0) return -1;
+
+    struct stat st;
+    if (stat(path, &st) == 0) write_snapshot(cfg, &st);
+    return 0;
+}
+
+int config_has_chat(const CoConfig* cfg) {
+    return cfg->nickname[0] && cfg->chat_host[0] && cfg->chat_port > 0;
+}
@@ -0,0 +1,58 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+/*==============================*/
+/*       사용자 설정 파일        */
+/*==============================*/
+/*
+ * ~/.config/coshell/config (XDG_CONFIG_HOME 우선) 에 "key = value" 형식으로 저장.
+ *
+ *   # CoShell 설정
+ *   nickname  = alice
+ *   chat.host = 127.0.0.1
+ *   chat.port = 12345
+ *   chat.heartbeat    = 5    # 조용할 때 하트비트 간격(초)
+ *   chat.idle_timeout = 15   # 이 시간 동안 아무것도 못 받으면 연결 끊김(초)
+ *   chat.connect_timeout = 10 # 이름 풀이부터 접속까지 한도(초)
+ *   server.io = uring         # Chat 서버 소켓 I/O: epoll(기본) 또는 uring
+ *   todo.mode = team          # user 또는 team
+ *   clock     = America/New_York
+ *   clock     = Europe/London  # 여러 번 쓰면 시계 여러 개
+ *
+ * 처음 읽을 때 파싱한 구조체를 같은 디렉터리의 config.bin 스냅샷으로 저장해 두고,
+ * 텍스트 파일의 mtime/크기가 그대로면 다음 실행부터는 스냅샷을 그대로 읽습니다.
+ */
+
+#define CONFIG_MAX_CLOCKS 11    // 로컬을 제외한 세계 시계 수
+#define CONFIG_ZONE_LEN   64
+
+typedef struct {
+    char nickname[64];
+    char chat_host[128];
+    int  chat_port;             // 0이면 미설정
+    int  heartbeat_sec;         // 0이면 기본값 (CHAT_HEARTBEAT_SEC)
+    int  idle_timeout_sec;      // 0이면 기본값 (CHAT_IDLE_TIMEOUT_SEC)
+    int  connect_timeout_sec;   // 0이면 기본값 (CHAT_CONNECT_TIMEOUT_SEC)
+    int  server_uring;          // 1이면 Chat 서버가 io_uring 사용
+    int  todo_team;             // 1이면 시작할 때 team ToDo 모드
+    int  clocks_set;            // 0이면 clock 항목이 없음 (기본 시계 사용)
+    int  nclocks;
+    char clocks[CONFIG_MAX_CLOCKS][CONFIG_ZONE_LEN];
+} CoConfig;
+
+/**
+ * 설정을 읽습니다. 파일이 없으면 빈 설정(모두 0)으로 채우고 -1을 돌려줍니다.
+ * 반환값: 0 스냅샷에서 읽음, 1 텍스트를 파싱함, -1 설정 파일 없음
+ */
+int config_load(CoConfig* cfg);
+
+/**
+ * 설정을 텍스트 파일로 저장하고 스냅샷도 함께 갱신합니다. (디렉터리가 없으면 생성)
+ * 반환값: 0 성공, -1 실패
+ */
+int config_save(const CoConfig* cfg);
+
+/** Chat에 바로 접속할 수 있을 만큼(host, port, nickname) 채워졌는지 */
+int config_has_chat(const CoConfig* cfg);
+
+#endif // CONFIG_H
@@ -5,9 +5,11 @@
  *    2) 실시간 채팅 서버/클라이언트
  *    3) 파일 전송용 QR 코드 생성 & 화면 출력 (전체화면 모드, 분리된 qr.c/qr.h 사용)
  *    4) ncurses UI: 분할 창, 버튼, 로비 → ToDo/Chat/QR 전환
+ *    5) 이벤트 루프(event.c): 키 입력/소켓/시계/리사이즈를 poll 하나로 처리
+ *       curses는 루프 스레드만 사용하고, 다른 스레드는 렌더 큐(render.c)로 그리기 요청
  *
  * 빌드 예시:
- *   gcc coshell.c chat.c todo_core.c todo_client.c qr.c -o coshell -Wall -O2 -std=c11 -lncursesw -lpthread
+ *   gcc coshell.c chat.c chat_server.c clock.c config.c dial.c event.c metrics.c perf.c render.c todo_core.c todo_client.c todo_crdt.c todo_daemon.c team_server.c qr.c uring.c xfer.c -o coshell -Wall -O2 -std=c11 -lncursesw -lpthread
  *
  * 사용 패키지 (Ubuntu/Debian):
  *   sudo apt update
@@ -16,6 +18,8 @@
  * 실행 방식:
  *   ./coshell                      # 메뉴/CLI/UI 모드 선택
  *   ./coshell server               # Chat 서버 (Serveo 터널링 포함)
+ *   ./coshell daemon [stop|status] # 이 디렉터리의 ToDo 데몬 (있으면 CLI/UI가 소켓으로 사용)
+ *   ./coshell team                 # 팀 ToDo 서버 (team 모드 UI들이 복제본을 동기화)
  *   ./coshell add  <item>          # CLI 모드: ToDo 추가
  *   ./coshell done <index>         # CLI 모드: ToDo done
  *   ./coshell undo <index>         # CLI 모드: ToDo undo
@@ -23,6 +27,10 @@
  *   ./coshell edit <index> <item>  # CLI 모드: ToDo 수정
  *   ./coshell list                 # CLI 모드: ToDo 목록 출력
  *   ./coshell qr   <filepath>      # CLI 모드: ASCII QR 출력
+ *   ./coshell qrbatch [-o dir] [-j N] <file|dir>...  # CLI 모드: QR 일괄 내보내기
+ *
+ * 설정 파일: ~/.config/coshell/config (config.h 참고)
+ *   Chat 접속 정보, ToDo 모드, 세계 시계 목록을 기억해 두고 UI에서 바뀌면 자동 저장
  */
 
 #define _POSIX_C_SOURCE 200809L
@@ -34,6 +42,7 @@
 #include <signal.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
 #include <pthread.h>
 #include <sys/socket.h>
 #include <arpa/inet.h>
@@ -43,8 +52,15 @@
 #include "chat.h"
 #include "todo.h"
 #include "qr.h"
+#include "event.h"
+#include "render.h"
+#include "dial.h"
+#include "todo_daemon.h"
+#include "team_server.h"
+#include "clock.h"
+#include "config.h"
+#include "perf.h"
 
-#define MAX_CLIENTS   5
 #define BUF_SIZE      1024
 #define INPUT_HEIGHT  3
 #define MAX_CMD_LEN   255
@@ -65,42 +81,38 @@ WINDOW* win_time = NULL;    // 왼쪽 상단: 시간 표시
 WINDOW* win_custom = NULL;  // 왼쪽 중간/하단: 로비·Chat·QR
 WINDOW* win_todo = NULL;    // 오른쪽 전체: ToDo 목록
 WINDOW* win_input = NULL;   // 맨 아래: 커맨드 입력창
+static WINDOW* win_stats = NULL;   // F2: 성능 통계 오버레이 (ToDo 창 오른쪽 아래에 겹쳐 그림)
+static int     stats_visible = 0;
 
-volatile sig_atomic_t resized = 0;   // 터미널 리사이즈 감지 플래그
-volatile int chat_running = 0;       // 채팅 모드 활성화 플래그
+#define STATS_HEIGHT  6
+#define STATS_WIDTH   46
 
 /* ───────── TimeZone 설정용 자료구조 ────────── */
+#define TZ_MATCH_MAX 512   // 검색 결과 최대 개수 (zone1970.tab 전체보다 큼)
+
 typedef struct {
-    char buf[16];
+    char buf[64];           // 입력 중인 검색어 또는 명령
     int  len;
+    char query[64];         // 마지막 검색어 (목록에 보이는 결과의 기준)
+    char msg[96];           // 마지막 명령 결과
+    int  matches[TZ_MATCH_MAX];   // clock_zone_names() 인덱스
+    int  total;             // 일치한 개수
 } TzState;
 
-typedef struct {
-    const char *code;   // internal key (안 써도 무방)
-    const char *label;  // 화면에 찍을 이름
-    int        offset;  // UTC로부터의 초 단위 오프셋
-} TZOption;
-
-static const TZOption tzOptions[] = {
-    { "USA_PT", "USA PT",  -8*3600 },
-    { "USA_ET", "USA ET",  -5*3600 },
-    { "UK_GMT", "UK GMT",   0      },
-    { "FR_CET", "FR CET",  +1*3600 },
-    { "RU_MSK", "RU MSK",  +3*3600 },
-    { "UAE_GST","UAE GST", +4*3600 },
-    { "IN_IST", "IN IST",   5*3600 + 30*60 },
-    { "CN_CST", "CN CST",  +8*3600 },
-    { "JP_JST", "JP JST",  +9*3600 },
-    { "AU_AEST","AU AEST", +10*3600 }
-};
-static const int tzOptionCount = sizeof(tzOptions)/sizeof(tzOptions[0]);
+/* ───────── Time 창 시계 ────────── */
+#define CLOCK_MAX 12        // 로컬 포함 최대 시계 수
 
-// 기본값: 첫 번째(USA ET), 두 번째(UK GMT)
-static int  tz1_offset = tzOptions[1].offset;
-static int  tz2_offset = tzOptions[2].offset;
-static char tz1_label[16] = "USA ET";
-static char tz2_label[16] = "UK GMT";
+static ClockFace clocks[CLOCK_MAX];             // [0]은 항상 로컬
+static char      clock_labels[CLOCK_MAX][24];
+static int       clock_count = 0;               // 0이면 아직 초기화 전
+static int       clocks_full_redraw = 1;        // 창이 새로 만들어지면 라벨까지 전부 다시 그림
+static const char* clock_default_zones[] = { "America/New_York", "Europe/London" };
 
+/* ───────── 사용자 설정 ────────── */
+static CoConfig config;     // ui_main 시작 시 한 번 읽고, 바뀔 때마다 save_config()
+static int      heartbeat_ticks = 0;    // 마지막 /ping 이후 지난 초
+static int      todo_watch_fd = -1;     // ToDo 데몬의 목록 변경 알림 (데몬이 없으면 -1)
+static int      team_sync_ticks = 0;    // 마지막 team 동기화 이후 지난 초
 
 // 로비 텍스트
 static const char *lobby_text[] = {
@@ -110,7 +122,7 @@ static const char *lobby_text[] = {
     "Enter a command below to start collaborating:",
     "",
     "1. To-Do List Management",
-    "2. Chat",
+    "2. Chat (returns to a running background chat)",
     "3. QR Code",
     "4. Time Setting",
     "",
@@ -128,11 +140,17 @@ typedef struct {
 } TodoState;
 
 typedef struct {
-    int step; // 0: host, 1: port, 2: nickname, 3: chat running
+    int step; // 0: host, 1: port, 2: nickname, 3: chat running, 4: connecting
     char host[128];
     char port_str[16];
     char nickname[64];
     int port;
+    int sock;  // 채팅 중인 소켓 (이벤트 루프에 등록됨, 끊겨 재접속을 기다리면 -1)
+    int retry_in;   // 다음 재접속 시도까지 남은 초 (0이면 재접속 중 아님)
+    int backoff;    // 재접속 간격 (실패할 때마다 두 배, 최대 CHAT_RECONNECT_MAX_SEC)
+    Dial* dial;     // 진행 중인 접속/재접속 (없으면 NULL)
+    uint64_t dial_start_ns;
+    char status[160];   // 접속 중 진행 상황 ("Connecting to ... (IPv6)...")
 } ChatState;
 
 typedef struct {
@@ -140,6 +158,66 @@ typedef struct {
     char pathbuf[MAX_PATH_LEN + 1];
 } QRInputState;
 
+// 패널별 dirty 플래그: 바뀐 패널만 다시 그리고 doupdate()는 이벤트당 한 번
+#define PANE_TIME     0x01
+#define PANE_CUSTOM   0x02
+#define PANE_TODO     0x04
+#define PANE_INPUT    0x08
+#define PANE_TITLE    0x10
+#define PANE_ALL      (PANE_TIME | PANE_CUSTOM | PANE_TODO | PANE_INPUT | PANE_TITLE)
+
+static int dirty_panes = PANE_ALL;                    // 다음 ui_render에서 그릴 패널
+static unsigned long todo_drawn = (unsigned long)-1;  // 마지막으로 그린 todo_version
+static int title_drawn = -2;                          // 마지막으로 그린 백그라운드 채팅 상태
+
+static void mark_dirty(int panes) { dirty_panes |= panes; }
+
+/* ───────── 잠깐 보여 주는 안내 ────────── */
+// napms로 멈추면 채팅 소켓, 하트비트, 시계까지 모두 멈추므로: 안내 패널에 겹쳐 그리고
+// 시간이 지나면 시계 tick이 지워 원래 안내로 돌아감
+static char     notice_text[1024];      // 여러 줄이면 '\n'으로 구분
+static int      notice_row;             // 1이면 패널을 비우고 처음부터, 그 밖에는 모드 안내 위 그 줄부터
+static int      notice_mode = -1;       // 띄운 모드 (-1: 없음, 그 모드를 떠나면 사라짐)
+static uint64_t notice_until_ns;
+
+static void show_notice(int mode, int row, int ms, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(notice_text, sizeof(notice_text), fmt, args);
+    va_end(args);
+    notice_row = row;
+    notice_mode = mode;
+    notice_until_ns = perf_now_ns() + (uint64_t)ms * 1000000ull;
+    mark_dirty(PANE_CUSTOM);
+}
+
+static void draw_notice(void) {
+    if (notice_row <= 1) {
+        werase(win_custom);
+        box(win_custom, 0, 0);
+    }
+    int row = notice_row;
+    for (const char* p = notice_text; ; row++) {
+        const char* nl = strchr(p, '\n');
+        mvwprintw(win_custom, row, 2, "%.*s", nl ? (int)(nl - p) : (int)strlen(p), p);
+        if (!nl) break;
+        p = nl + 1;
+    }
+    wnoutrefresh(win_custom);
+}
+
+// UI 전체 상태 (이벤트 콜백에 전달)
+typedef struct {
+    int mode;
+    int running;
+    char cmdbuf[MAX_CMD_LEN + 1];   // 로비 Command 입력
+    int cmdlen;
+    TodoState todo;
+    ChatState chat;
+    QRInputState qr;
+    TzState tz;
+} UIState;
+
 
 /*==============================*/
 /*        함수 전방 선언        */
@@ -150,18 +228,48 @@ static void cleanup_ncurses(void);
 void create_windows(int in_lobby);
 static void print_wrapped_lines(WINDOW* win, int start_y, int max_lines, int max_cols,
     const char* lines[], int n);
-static void get_time_strings(char* local_buf, int len1,
-    char* us_buf, int len2,
-    char* uk_buf, int len3);
-static void* timer_thread_fn(void* arg);
+static void init_clocks(void);
+static void save_config(void);
+static void apply_chat_config(void);
+static int  add_clock(const char* zone_name);
 void update_time(WINDOW* w);
 
-// 모드 처리
-static void handle_todo_mode(TodoState* state, int* mode);
-static void handle_chat_mode(ChatState* state, int* mode);
-static void handle_qr_input_mode(QRInputState* qr_state, int* mode);
+// 이벤트 루프 콜백
+static void on_stdin(int fd, short revents, void* arg);
+static void on_clock_tick(int fd, short revents, void* arg);
+static void on_winch(int fd, short revents, void* arg);
+static void on_chat_readable(int fd, short revents, void* arg);
+static void on_todo_pushed(int fd, short revents, void* arg);
+static void todo_watch_start(UIState* ui);
+static void on_todo_saved(void);
+static void on_todo_notice(int ms, const char* msg);
+static void chat_connection_lost(UIState* ui);
+static void chat_reconnect(UIState* ui);
+static void chat_retry_later(ChatState* state);
+static void ui_resize(UIState* ui);
+static void dispatch_key(UIState* ui, int ch);
+static void draw_mode(UIState* ui, int panes);
+static void ui_render(UIState* ui);
+static void ui_render_cb(void* arg);
+static void draw_lobby_text(WINDOW* win);
+static void draw_title(int chat_state);
+static void draw_stats_overlay(UIState* ui);
+static void toggle_stats_overlay(void);
+static void draw_input_line(const char* prefix, const char* text, int len);
+
+// 모드 처리 (draw_*: 화면 그리기, handle_*: 키 하나 처리)
+static void handle_lobby_mode(UIState* ui, int ch);
+static void draw_todo_mode(TodoState* state, int panes);
+static void handle_todo_mode(TodoState* state, int ch, int* mode);
+static void draw_chat_mode(ChatState* state, int panes);
+static void handle_chat_mode(UIState* ui, int ch);
+static void reset_chat_state(ChatState* state);
+static void start_chat(UIState* ui);
+static void draw_qr_input_mode(QRInputState* qr_state, int panes);
+static void handle_qr_input_mode(QRInputState* qr_state, int ch, int* mode);
 static void handle_qr_full_mode(QRInputState* qr_state, int* mode);
-static void handle_tz_mode(TzState* state, int* mode);
+static void draw_tz_mode(TzState* state, int panes);
+static void handle_tz_mode(TzState* state, int ch, int* mode);
 // 메인/UI/CLI 로직
 static void show_main_menu(void);
 static void cli_main(int argc, char* argv[]);
@@ -186,23 +294,37 @@ int main(int argc, char* argv[]) {
         strcmp(argv[1], "del") == 0 ||	
         strcmp(argv[1], "edit") == 0 ||
         strcmp(argv[1], "list") == 0 ||
-        strcmp(argv[1], "qr") == 0)
+        strcmp(argv[1], "qr") == 0 ||
+        strcmp(argv[1], "qrbatch") == 0)
     {
         cli_main(argc - 1, &argv[1]);
     }
     else if (strcmp(argv[1], "ui") == 0) {
         ui_main();
     }
+    else if (strcmp(argv[1], "daemon") == 0) {
+        return todo_daemon_main(argc - 2, &argv[2]);
+    }
+    else if (strcmp(argv[1], "team") == 0) {
+        return team_server_main(argc - 2, &argv[2]);
+    }
     else if (strcmp(argv[1], "server") == 0) {
-        printf(">> Serveo.net: Chat 서버 원격 포트 요청 중...\n");
-        int remote_port = setup_serveo_tunnel(LOCAL_PORT);
-        if (remote_port < 0) {
-            fprintf(stderr, "Serveo 터널 실패. 로컬 Chat 서버만 실행.\n");
-        }
-        else {
-            printf(">> Serveo Chat 주소: serveo.net:%d → 내부 %d 포트\n", remote_port, LOCAL_PORT);
+        // --upgrade: 실행 중인 서버의 연결을 넘겨받음 (Serveo 터널은 이전 서버의 ssh가 계속 유지)
+        int upgrade = argc > 2 && strcmp(argv[2], "--upgrade") == 0;
+        if (!upgrade) {
+            printf(">> Serveo.net: Chat 서버 원격 포트 요청 중...\n");
+            int remote_port = setup_serveo_tunnel(LOCAL_PORT);
+            if (remote_port < 0) {
+                fprintf(stderr, "Serveo 터널 실패. 로컬 Chat 서버만 실행.\n");
+            }
+            else {
+                printf(">> Serveo Chat 주소: serveo.net:%d → 내부 %d 포트\n", remote_port, LOCAL_PORT);
+            }
         }
 
+        config_load(&config);
+        apply_chat_config();
+        chat_server_takeover = upgrade;
         chat_server(LOCAL_PORT);
     }
     else {
@@ -243,6 +365,8 @@ static void show_main_menu(void) {
                 printf(">> Serveo Chat 주소: serveo.net:%d\n", remote_port);
             }
 
+            config_load(&config);
+            apply_chat_config();
             chat_server(LOCAL_PORT);
             break;
         }
@@ -266,70 +390,63 @@ static void show_main_menu(void) {
 /*==============================*/
 static void cli_main(int argc, char* argv[]) {
     if (argc == 0) return;
-    load_todo();
 
-    if (strcmp(argv[0], "add") == 0 && argc >= 2) {
-        char buf[512] = { 0 };
-        for (int i = 1;i < argc;i++) {
-            strcat(buf, argv[i]);
-            if (i < argc - 1) strcat(buf, " ");
-        }
-        add_todo(buf);
-        printf("Added: %s\n", buf);
-    }
-    else if (strcmp(argv[0], "done") == 0 && argc == 2) {
-        int idx = atoi(argv[1]);
-        done_todo(idx);
-        printf("Marked todo #%d as done.\n", idx);
-    }
-    else if (strcmp(argv[0], "undo") == 0 && argc == 2) {
-        int idx = atoi(argv[1]);
-        undo_todo(idx);
-        printf("Marked todo #%d as not done.\n", idx);
-    }
-    else if (strcmp(argv[0], "del") == 0 && argc == 2) {
-        int idx = atoi(argv[1]) - 1;
-        if (idx < 0 || idx >= todo_count) {
-            printf("Invalid index.\n");
-            return;
-        }
-        pthread_mutex_lock(&todo_lock);
-        free(todos[idx]);
-        for (int i = idx;i < todo_count - 1;i++) {
-            todos[i] = todos[i + 1];
-        }
-        todo_count--;
-        FILE* fp = fopen(USER_TODO_FILE, "w");
-        if (fp) {
-            for (int i = 0;i < todo_count;i++) {
-                fprintf(fp, "%s\n", todos[i]);
+    // qrbatch는 ToDo 파일이 필요 없으므로 먼저 처리
+    if (strcmp(argv[0], "qrbatch") == 0) {
+        const char* outdir = "qr_out";
+        int jobs = 0;
+        int i = 1;
+        int bad = 0;
+        for (; i < argc; i += 2) {
+            if (strcmp(argv[i], "-o") != 0 && strcmp(argv[i], "-j") != 0) break;
+            if (i + 1 == argc) {
+                // 값이 빠진 맨 끝 -o/-j를 입력 경로로 받지 않음
+                fprintf(stderr, "qrbatch: %s needs a value\n", argv[i]);
+                bad = 1;
+                break;
             }
-            fclose(fp);
+            if (argv[i][1] == 'o') outdir = argv[i + 1];
+            else jobs = atoi(argv[i + 1]);
         }
-        pthread_mutex_unlock(&todo_lock);
-        printf("Deleted todo #%d\n", idx + 1);
-    }
-    else if (strcmp(argv[0], "edit") == 0 && argc >= 3) {
-        int idx = atoi(argv[1]);
-        char new_content[512] = { 0 };
-        for (int i = 2; i < argc; i++) {
-            strcat(new_content, argv[i]);
-            if (i < argc - 1) strcat(new_content, " ");
+        for (int k = i; !bad && k < argc; k++) {
+            if (strcmp(argv[k], "-o") == 0 || strcmp(argv[k], "-j") == 0) {
+                fprintf(stderr, "qrbatch: %s must come before the inputs\n", argv[k]);
+                bad = 1;
+            }
         }
-        edit_todo(idx, new_content);
-        printf("Edited todo #%d: %s\n", idx, new_content);
-    }	
-    else if (strcmp(argv[0], "list") == 0) {
-        for (int i = 0;i < todo_count;i++) {
-            printf("%d. %s\n", i + 1, todos[i]);
+        if (bad || i >= argc) {
+            fprintf(stderr, "Usage: coshell qrbatch [-o outdir] [-j jobs] <file|dir>...\n");
+            exit(1);
         }
+        int failed = qr_batch_export(outdir, &argv[i], argc - i, jobs);
+        exit(failed == 0 ? 0 : 1);
     }
-    else if (strcmp(argv[0], "qr") == 0 && argc == 2) {
+
+    if (strcmp(argv[0], "qr") == 0 && argc == 2) {
         show_qr_cli(argv[1]);
+        return;
     }
-    else {
+
+    // ToDo 명령: 인자를 "add <item>" 같은 한 줄로 모아 실행
+    int ok = (strcmp(argv[0], "add") == 0 && argc >= 2) ||
+             ((strcmp(argv[0], "done") == 0 || strcmp(argv[0], "undo") == 0 ||
+               strcmp(argv[0], "del") == 0) && argc == 2) ||
+             (strcmp(argv[0], "edit") == 0 && argc >= 3) ||
+             strcmp(argv[0], "list") == 0;
+    if (!ok) {
         fprintf(stderr, "Unknown CLI command.\n");
+        return;
     }
+    char line[1000];
+    size_t len = 0;
+    int nwords = strcmp(argv[0], "list") == 0 ? 1 : argc;
+    for (int i = 0; i < nwords && len < sizeof(line) - 1; i++)
+        len += (size_t)snprintf(line + len, sizeof(line) - len, i ? " %s" : "%s", argv[i]);
+
+    // 데몬이 있으면 소켓 왕복 한 번 (파일은 데몬이 들고 있음), 없으면 파일을 직접
+    if (todo_daemon_request(line, stdout) == 0) return;
+    load_todo();
+    todo_exec(line, stdout);
 }
 
 /*==============================*/
@@ -340,7 +457,11 @@ static void ui_main(void) {
     atexit(cleanup_ncurses);
     signal(SIGINT, SIG_IGN);
     signal(SIGTSTP, SIG_IGN);
-    signal(SIGWINCH, SIG_IGN);
+    signal(SIGPIPE, SIG_IGN);   // 끊긴 소켓에 send 해도 종료되지 않도록
+
+    // 설정은 창을 만들기 전에 읽어야 시계 목록이 반영됨 (스냅샷이 있으면 read 한 번)
+    config_load(&config);
+    apply_chat_config();
 
     initscr();
     cbreak();
@@ -350,290 +471,488 @@ static void ui_main(void) {
 
     // 첫 화면: 로비
     create_windows(1);
-    load_todo();
-    draw_todo(win_todo);
 
     // State initialization
-    TodoState todo_state = { .len = 0 };
-    memset(todo_state.buf, 0, sizeof(todo_state.buf));
-    ChatState chat_state = { .step = 0, .port = 0 };
-    memset(chat_state.host, 0, sizeof(chat_state.host));
-    memset(chat_state.port_str, 0, sizeof(chat_state.port_str));
-    memset(chat_state.nickname, 0, sizeof(chat_state.nickname));
-    QRInputState qr_state = { .pathlen = 0 };
-    memset(qr_state.pathbuf, 0, sizeof(qr_state.pathbuf));
-    TzState   tz_state = { .len = 0 };
-
-    char cmdbuf[MAX_CMD_LEN + 1] = { 0 };
-    int cmdlen = 0;
-    time_t last_time = 0;
-    int mode = MODE_LOBBY;  // 0 = 로비, 1 = ToDo, 2 = Chat, 3 = QR 입력, 4 = QR 전체화면
+    UIState ui;
+    memset(&ui, 0, sizeof(ui));
+    ui.mode = MODE_LOBBY;  // 0 = 로비, 1 = ToDo, 2 = Chat, 3 = QR 입력, 4 = QR 전체화면
+    ui.running = 1;
+    ui.chat.sock = -1;
+
+    // 이벤트 소스 등록: 창 크기 변경(signalfd), 시계(timerfd), 키 입력(stdin)
+    if (ev_add_signal(SIGWINCH, on_winch, &ui) < 0 ||
+        ev_add_timer(1000, on_clock_tick, &ui) < 0 ||
+        ev_add_fd(STDIN_FILENO, POLLIN, on_stdin, &ui) < 0 ||
+        render_init(ui_render_cb, &ui) < 0) {
+        cleanup_ncurses();
+        fprintf(stderr, "Failed to set up event loop.\n");
+        return;
+    }
+    todo_set_saved_hook(on_todo_saved);
+    todo_set_notice_hook(on_todo_notice);
+    set_todo_mode(config.todo_team);    // team 서버에 닿지 않아도 로컬 복제본으로 team 모드 시작 (동기화는 render 큐로)
+    todo_watch_start(&ui);
+    ui_render(&ui);
+
+    // 이벤트가 올 때까지 poll에서 잠들어 있으므로 유휴 시 CPU를 쓰지 않음
+    while (ui.running) {
+        if (ev_run_once(-1) < 0) break;
+    }
+    ev_cleanup();
+    render_cleanup();
 
-    while (1) {
-        // (1) 매초 시간 업데이트
-        time_t now = time(NULL);
-        if (now != last_time) {
-            last_time = now;
-            update_time(win_time);
-        }
+    endwin();  // ncurses 종료
+    endwin();
+    echo();
+    nocbreak();
+    curs_set(1);
+}
 
-        // (2) KEY_RESIZE 체크
-        wtimeout(win_input, 0);
-        int tch = wgetch(win_input);
-        if (tch == KEY_RESIZE) {
-            resized = 1;
-        }
-        // ─────────────────────────────────────────────────
-        // (3) 리사이즈 플래그가 세워지면 즉시 화면을 재구성
-        // ─────────────────────────────────────────────────
-        if (resized) {
-            resized = 0;
-            endwin();
-            refresh();
-            clear();
-
-            // ncurses 내부 윈도우를 모두 삭제하고 새로운 크기를 감지
-            create_windows(mode == MODE_LOBBY);
-            if (mode == MODE_LOBBY) {
-                load_todo();
-                draw_todo(win_todo);
-            }
-            else if (mode == MODE_TODO) {
-                // ToDo 모드: redraw ToDo list
-                load_todo();
-                draw_todo(win_todo);
-            }
-            else if (mode == MODE_CHAT) {
-                // Chat 모드: 안내 메시지 다시 그려줌
-                werase(win_custom);
-                box(win_custom, 0, 0);
-                mvwprintw(win_custom, 1, 2, "Type '/quit' to end chat and return to main UI.");
-                wrefresh(win_custom);
-
-                load_todo();
-                draw_todo(win_todo);
-            }
-            else if (mode == MODE_QR_INPUT) {
-                // QR 모드(경로 입력) 재진입: pathbuf 내용까지 다시 그려줌
-                werase(win_custom);
-                box(win_custom, 0, 0);
-                mvwprintw(win_custom, 1, 2, "Enter path for QR code (or 'q' to cancel):");
-                mvwprintw(win_custom, 2, 2, "%s", qr_state.pathbuf);
-                wrefresh(win_custom);
-
-                werase(win_input);
-                box(win_input, 0, 0);
-                mvwprintw(win_input, 1, 2, "%s", qr_state.pathbuf);
-                wmove(win_input, 1, 2 + qr_state.pathlen);
-                wrefresh(win_input);
-
-                load_todo();
-                draw_todo(win_todo);
-            }
-            continue;
-        }
+/*==============================*/
+/*       이벤트 루프 콜백        */
+/*==============================*/
 
-        // ─────────────────────────────────────────────────
-        // (A) QR 경로 입력 모드 (mode == 3)
-        // ─────────────────────────────────────────────────
-        if (mode == MODE_QR_INPUT) {
-            handle_qr_input_mode(&qr_state, &mode);
-            continue;
-        }
+// 터미널 입력: 쌓여 있는 키를 모두 꺼내 현재 모드에 전달한 뒤 한 번만 다시 그림
+static void on_stdin(int fd, short revents, void* arg) {
+    (void)fd;
+    UIState* ui = arg;
+    int handled = 0;
+    int ch;
+    while (ui->running && (ch = wgetch(win_input)) != ERR) {
+        dispatch_key(ui, ch);
+        handled = 1;
+    }
+    if (!handled && (revents & (POLLHUP | POLLERR))) {
+        ui->running = 0;    // 터미널이 닫힘
+        return;
+    }
+    if (ui->running) ui_render(ui);
+}
 
-        // ─────────────────────────────────────────────────
-        // (B) QR 전체화면 모드 (mode == 4)
-        // ─────────────────────────────────────────────────
-        if (mode == MODE_QR_FULL) {
-            handle_qr_full_mode(&qr_state, &mode);
-            continue;
+// 매 초(timerfd): 시계 갱신, 다른 곳(CLI 등)에서 ToDo 파일이 바뀌었으면 다시 로딩
+// (ToDo 데몬에 붙어 있으면 바뀔 때마다 데몬이 알려 주므로 파일을 보지 않음)
+// team 모드면 TEAM_SYNC_SEC마다 팀 서버와 동기화 (오프라인 동안의 편집도 이때 올라감)
+static void on_clock_tick(int fd, short revents, void* arg) {
+    (void)fd; (void)revents;
+    UIState* ui = arg;
+    if (todo_watch_fd < 0) {
+        reload_todo_if_changed();
+        todo_watch_start(ui);           // 나중에 뜬 데몬에도 붙음
+    }
+    if (strcmp(current_todo_file, TEAM_TODO_FILE) == 0 && ++team_sync_ticks >= TEAM_SYNC_SEC) {
+        team_sync_start(NULL, 0, 0);    // 워커 쓰레드에서 (루프를 막지 않음)
+        team_sync_ticks = 0;
+    }
+    if (ui->chat.step == 3 && ui->chat.sock >= 0) {
+        // 통계 창이 열려 있으면 매 초, 아니면 heartbeat 간격마다 /ping (RTT 갱신 겸 하트비트)
+        int heartbeat = config.heartbeat_sec > 0 ? config.heartbeat_sec : CHAT_HEARTBEAT_SEC;
+        if (stats_visible || ++heartbeat_ticks >= heartbeat) {
+            chat_client_ping();
+            heartbeat_ticks = 0;
         }
+        // /pong 조차 오지 않으면 상대(또는 경로)가 죽은 것: 잠든 노트북, 끊긴 Wi-Fi 등
+        if (chat_client_check_idle(chat_idle_timeout_sec) < 0) chat_connection_lost(ui);
+    }
+    else if (ui->chat.step == 3 && ui->chat.retry_in > 0 && --ui->chat.retry_in == 0) {
+        chat_reconnect(ui);
+    }
+    if (ui->chat.step == 4) mark_dirty(PANE_CUSTOM);     // 접속 중 경과 시간
+    if (notice_mode >= 0 && perf_now_ns() >= notice_until_ns) {
+        notice_mode = -1;
+        mark_dirty(PANE_CUSTOM);
+    }
+    mark_dirty(PANE_TIME);
+    ui_render(ui);
+}
 
-        // ─────────────────────────────────────────────────
-        // (C) ToDo 모드
-        // ─────────────────────────────────────────────────
-        if (mode == MODE_TODO) {
-            handle_todo_mode(&todo_state, &mode);
-            continue;
-        }
+// To-Do 모듈의 안내 (모드 전환, 오류): To-Do 안내 패널에 잠깐
+static void on_todo_notice(int ms, const char* msg) {
+    show_notice(MODE_TODO, 1, ms, "%s", msg);
+}
 
-        // ─────────────────────────────────────────────────
-        // (D) Chat 모드 (호스트/포트/닉네임 입력 및 실행)
-        // ─────────────────────────────────────────────────
-        if (mode == MODE_CHAT) {
-            handle_chat_mode(&chat_state, &mode);
-            continue;
-        }
-        if (mode == MODE_TZ) {
-            handle_tz_mode(&tz_state, &mode);
-            continue;
-        }
+// ToDo 데몬이 보낸 목록 (CLI나 다른 UI가 바꾼 내용), 데몬이 끝나면 매 초 파일 감시로
+static void on_todo_pushed(int fd, short revents, void* arg) {
+    (void)revents;
+    if (todo_daemon_read(fd) < 0) {
+        ev_del_fd(fd);
+        close(fd);
+        todo_watch_fd = -1;
+    }
+    ui_render(arg);
+}
 
-        // ─────────────────────────────────────────────────
-        // (E) 나머지 모드: 로비 (mode == 0)
-        // ─────────────────────────────────────────────────
-
-        // (E-1) 입력창(Command) 그리기
-        werase(win_input);
-        box(win_input, 0, 0);
-        mvwprintw(win_input, 1, 2, "Command: %.*s", cmdlen, cmdbuf);
-        wmove(win_input, 1, 11 + cmdlen);
-        wrefresh(win_input);
-
-        // (E-2) 비차단으로 키 입력 받기 (200ms 대기)
-        wtimeout(win_input, 200);
-        int ch = wgetch(win_input);
-        if (ch == KEY_RESIZE) {
-            resized = 1;
-            continue;
-        }
+static void todo_watch_start(UIState* ui) {
+    int fd = todo_daemon_watch();
+    if (fd < 0) return;
+    if (ev_add_fd(fd, POLLIN, on_todo_pushed, ui) < 0) {
+        close(fd);
+        return;
+    }
+    todo_watch_fd = fd;
+}
 
-        if (ch != ERR) {
-            // 백스페이스
-            if (ch == KEY_BACKSPACE || ch == 127) {
-                if (cmdlen > 0) {
-                    cmdlen--;
-                    cmdbuf[cmdlen] = '\0';
-                }
-            }
-            // Enter 입력
-            else if (ch == '\n' || ch == KEY_ENTER) {
-                cmdbuf[cmdlen] = '\0';
+// 이 UI가 user 파일을 고침: 데몬이 다시 읽어 다른 UI에 바로 전달하도록
+static void on_todo_saved(void) {
+    if (todo_watch_fd >= 0 && strcmp(current_todo_file, USER_TODO_FILE) == 0)
+        todo_daemon_sync(todo_watch_fd);
+}
 
-                // exit → 프로그램 종료
-                if (strcmp(cmdbuf, "exit") == 0) {
-                    break;
-                }
-                // 1 → To-Do 모드 진입
-                else if (cmdlen > 0 && cmdbuf[0] == '1') {
-                    mode = MODE_TODO;
-                    todo_state.len = 0;
-                    memset(todo_state.buf, 0, sizeof(todo_state.buf));
-                    cmdlen = 0;
-                    memset(cmdbuf, 0, sizeof(cmdbuf));
-                    continue;
-                }
-                // 2 → Chat 모드 진입
-                else if (cmdlen > 0 && cmdbuf[0] == '2') {
-                    mode = MODE_CHAT;
-                    chat_state.step = 0;
-                    chat_state.port = 0;
-                    memset(chat_state.host, 0, sizeof(chat_state.host));
-                    memset(chat_state.port_str, 0, sizeof(chat_state.port_str));
-                    memset(chat_state.nickname, 0, sizeof(chat_state.nickname));
-                    cmdlen = 0;
-                    memset(cmdbuf, 0, sizeof(cmdbuf));
-                    continue;
-                }
-                // 3 → QR 경로 입력 모드 진입
-                else if (cmdlen > 0 && cmdbuf[0] == '3') {
-                    mode = MODE_QR_INPUT;
-                    qr_state.pathlen = 0;
-                    memset(qr_state.pathbuf, 0, sizeof(qr_state.pathbuf));
-                    cmdlen = 0;
-                    memset(cmdbuf, 0, sizeof(cmdbuf));
-                    continue;
-                }
-                else if (cmdlen > 0 && cmdbuf[0] == '4') {
-                    mode = MODE_TZ;
-                    tz_state.len = 0;
-                    memset(tz_state.buf, 0, sizeof(tz_state.buf));
-                    cmdlen = 0;
-                    memset(cmdbuf, 0, sizeof(cmdbuf));
-                    continue;
-                }
+// SIGWINCH(signalfd)
+static void on_winch(int fd, short revents, void* arg) {
+    (void)fd; (void)revents;
+    ui_resize(arg);
+    ui_render(arg);
+}
 
-                // a <item> → ToDo 항목 추가 (비대화형 모드)
-                else if (cmdlen > 2 && cmdbuf[0] == 'a' && cmdbuf[1] == ' ') {
-                    const char* item = cmdbuf + 2;
-                    add_todo(item);
-                    draw_todo(win_todo);
-                }
-                // f <filepath> → QR 전체화면 모드 바로 실행
-                else if (cmdlen > 2 && cmdbuf[0] == 'f' && cmdbuf[1] == ' ') {
-                    const char* filepath = cmdbuf + 2;
-                    process_and_show_file(win_custom, filepath);
-                    create_windows(1);
-                    load_todo();
-                    draw_todo(win_todo);
-                }
-                else {
-                    /*==============================*/
-                    /*    Unknown command 처리      */
-                    /*==============================*/
-                    werase(win_custom);
-                    box(win_custom, 0, 0);
-                    mvwprintw(win_custom, 1, 2, "Unknown command: %s", cmdbuf);
-                    mvwprintw(win_custom, 3, 2, "Available commands in main UI:");
-                    mvwprintw(win_custom, 4, 4, "1             : Enter To-Do mode");
-                    mvwprintw(win_custom, 5, 4, "2             : Enter Chat mode");
-                    mvwprintw(win_custom, 6, 4, "3             : Enter QR mode");
-                    mvwprintw(win_custom, 7, 4, "a <item>      : Add To-Do (non-interactive)");
-                    mvwprintw(win_custom, 8, 4, "f <filepath>  : Show QR for <filepath>");
-                    mvwprintw(win_custom, 9, 4, "exit          : Exit program");
-                    wrefresh(win_custom);
-                    napms(3000);  // 3초간 표시한 뒤 자동으로 로비로 돌아감
-
-                    mode = MODE_LOBBY;
-                    werase(win_custom);
-                    box(win_custom, 0, 0);
-                    int maxy, maxx;
-                    getmaxyx(win_custom, maxy, maxx);
-                    int inner_lines = maxy - 2;
-                    int inner_cols = maxx - 4;
-                    print_wrapped_lines(win_custom, 1, inner_lines, inner_cols,
-                        lobby_text, lobby_lines);
-                    wrefresh(win_custom);
-                }
+// Chat 소켓: 수신 메시지 출력(백그라운드면 unread만 증가), 연결이 끊기면 루프에서 제거
+static void on_chat_readable(int fd, short revents, void* arg) {
+    (void)revents;
+    UIState* ui = arg;
+    (void)fd;
+    if (chat_client_recv() < 0) chat_connection_lost(ui);
+    ui_render(ui);
+}
 
-                // 입력 버퍼 초기화
-                cmdlen = 0;
-                memset(cmdbuf, 0, sizeof(cmdbuf));
-            }
-            else if (ch >= 32 && ch <= 126) {
-                if (cmdlen < MAX_CMD_LEN) {
-                    cmdbuf[cmdlen++] = (char)ch;
-                }
-            }
-        }
+// 연결이 끊겼거나(recv 0) 응답이 없을 때(idle timeout): 루프에서 제거
+// 재접속 세션이 있으면 (백그라운드여도) 잠시 뒤 다시 붙어서 놓친 메시지를 이어 받음
+static void chat_connection_lost(UIState* ui) {
+    ev_del_fd(ui->chat.sock);
+    ui->chat.sock = -1;     // 하트비트/감시 중지
+    if (chat_client_disconnect()) {
+        ui->chat.backoff = CHAT_RECONNECT_MIN_SEC;
+        ui->chat.retry_in = CHAT_RECONNECT_MIN_SEC;
+        return;
+    }
+    // 채팅 화면이 떠 있으면 사용자가 /quit 할 때까지 메시지를 남겨 둠
+    if (ui->mode != MODE_CHAT) {
+        chat_client_stop();
+        reset_chat_state(&ui->chat);
     }
+}
 
-    endwin();  // ncurses 종료
-    endwin();
-    echo();
-    nocbreak();
-    curs_set(1);
+// chat.connect_timeout (밀리초)
+static int chat_connect_timeout_ms(void) {
+    return (config.connect_timeout_sec > 0 ? config.connect_timeout_sec : CHAT_CONNECT_TIMEOUT_SEC) * 1000;
 }
 
-/* Handle ToDo mode input */
-static void handle_todo_mode(TodoState* state, int* mode) {
-    // (1) 매 프레임: 도움말과 ToDo 리스트 다시 그리기
-    werase(win_custom);
-    box(win_custom, 0, 0);
-    draw_custom_help(win_custom);      // todo.c에 정의된 도움말 함수
-    werase(win_todo);
-    box(win_todo, 0, 0);
-    load_todo();                       // 파일 → 메모리 로드
-    draw_todo(win_todo);               // 메모리 → 화면 출력
-    wrefresh(win_custom);
-    wrefresh(win_todo);
+// 재접속 결과: 붙었으면 세션을 이어 받고, 아니면 간격을 늘려 다시
+static void on_chat_redialed(int fd, const char* err, void* arg) {
+    (void)err;
+    UIState* ui = arg;
+    ChatState* state = &ui->chat;
+    state->dial = NULL;
+    if (fd >= 0 && chat_client_resume(fd) == 0) {
+        state->sock = fd;
+        ev_add_fd(state->sock, POLLIN, on_chat_readable, ui);
+        heartbeat_ticks = 0;
+        ui_render(ui);
+        return;
+    }
+    if (fd >= 0) close(fd);
+    chat_retry_later(state);
+}
 
-    // (2) 입력창 그리기
-    werase(win_input);
-    box(win_input, 0, 0);
-    mvwprintw(win_input, 1, 2, "%s", state->buf);
-    wmove(win_input, 1, 2 + state->len);
-    wrefresh(win_input);
+// 재접속 시도 (UI를 막지 않고 dial.c로, 같은 호스트면 유닉스 소켓 먼저)
+static void chat_reconnect(UIState* ui) {
+    ChatState* state = &ui->chat;
+    char local[64];
+    snprintf(local, sizeof(local), CHAT_LOCAL_SOCK_FMT, state->port);
+    state->dial = dial_start(state->host, state->port, local, chat_connect_timeout_ms(),
+                             on_chat_redialed, NULL, ui);
+    if (!state->dial) chat_retry_later(state);
+}
+
+// 실패하면 간격을 두 배로 늘리고, 서버가 다시 뜰 때 클라이언트들이
+// 한꺼번에 몰리지 않게 간격의 절반~전체 사이에서 흔듦
+static void chat_retry_later(ChatState* state) {
+    state->backoff *= 2;
+    if (state->backoff > CHAT_RECONNECT_MAX_SEC) state->backoff = CHAT_RECONNECT_MAX_SEC;
+    int half = state->backoff / 2;
+    state->retry_in = state->backoff - half + (int)(perf_now_ns() / 1000 % (uint64_t)(half + 1));
+}
 
-    // (3) 입력 처리
-    wtimeout(win_input, 200);
-    int ch = wgetch(win_input);
+// 리사이즈 플래그 대신: 창 크기 변경 시 즉시 화면을 재구성
+static void ui_resize(UIState* ui) {
+    ev_sync_term_size();
+    clear();
+
+    // ncurses 내부 윈도우를 모두 삭제하고 새로운 크기로 다시 생성 (모든 패널 dirty)
+    create_windows(ui->mode == MODE_LOBBY);
+    if (ui->mode == MODE_CHAT && ui->chat.step == 3) {
+        chat_client_resize(win_custom, win_input);
+    }
+}
+
+static void dispatch_key(UIState* ui, int ch) {
     if (ch == KEY_RESIZE) {
-        resized = 1;
+        ui_resize(ui);
+        return;
+    }
+    if (ch == KEY_F(2)) {
+        toggle_stats_overlay();
         return;
     }
-    if (ch == ERR) return;
 
+    int old_mode = ui->mode;
+    switch (ui->mode) {
+    case MODE_TODO:     handle_todo_mode(&ui->todo, ch, &ui->mode);    break;
+    case MODE_CHAT:     handle_chat_mode(ui, ch);                      break;
+    case MODE_QR_INPUT: handle_qr_input_mode(&ui->qr, ch, &ui->mode);  break;
+    case MODE_TZ:       handle_tz_mode(&ui->tz, ch, &ui->mode);        break;
+    default:            handle_lobby_mode(ui, ch);                     break;
+    }
+
+    // 떠난 모드의 안내는 버림 (돌아왔을 때 다시 보이지 않게)
+    if (ui->mode != old_mode && notice_mode == old_mode) notice_mode = -1;
+
+    // 키 입력은 입력창만 바꿈. Enter(명령 실행, 안내 메시지)나 모드 전환은 안내 패널도,
+    // QR 경로/TimeZone 입력은 안내 패널에 입력 내용을 같이 보여주므로 함께 갱신
+    mark_dirty(PANE_INPUT);
+    if (ch == '\n' || ch == KEY_ENTER || ui->mode != old_mode ||
+        ui->mode == MODE_QR_INPUT || ui->mode == MODE_TZ) {
+        mark_dirty(PANE_CUSTOM);
+    }
+
+    // QR 전체화면은 입력 없이 바로 띄우는 모달 화면
+    if (ui->mode == MODE_QR_FULL) {
+        handle_qr_full_mode(&ui->qr, &ui->mode);
+    }
+}
+
+// 현재 모드의 안내 패널(PANE_CUSTOM)/입력창(PANE_INPUT) 중 요청된 것만 그림
+static void draw_mode(UIState* ui, int panes) {
+    switch (ui->mode) {
+    case MODE_TODO:     draw_todo_mode(&ui->todo, panes);    break;
+    case MODE_CHAT:     draw_chat_mode(&ui->chat, panes);    break;
+    case MODE_QR_INPUT: draw_qr_input_mode(&ui->qr, panes);  break;
+    case MODE_TZ:       draw_tz_mode(&ui->tz, panes);        break;
+    default:
+        if (panes & PANE_CUSTOM) draw_lobby_text(win_custom);
+        if (panes & PANE_INPUT)  draw_input_line("Command: ", ui->cmdbuf, ui->cmdlen);
+        break;
+    }
+    // 채팅 중에는 안내 패널을 chat.c가 그림
+    if ((panes & PANE_CUSTOM) && notice_mode == ui->mode && !(ui->mode == MODE_CHAT && ui->chat.step == 3))
+        draw_notice();
+}
+
+/*==============================*/
+/*   dirty 패널만 다시 그리기    */
+/*==============================*/
+static void ui_render(UIState* ui) {
+    uint64_t frame_start = perf_now_ns();
+
+    // ToDo 목록은 내용이 바뀐 경우(todo_version 변경)에만 다시 그림
+    if (todo_version != todo_drawn) dirty_panes |= PANE_TODO;
+
+    // 타이틀: 백그라운드 채팅이 있으면 읽지 않은 메시지 수 (-1: 백그라운드 채팅 없음)
+    int chat_state = (ui->chat.step == 3 && ui->mode != MODE_CHAT) ? chat_client_unread() : -1;
+    if (chat_state != title_drawn) dirty_panes |= PANE_TITLE;
+    if (dirty_panes & PANE_TITLE) {
+        draw_title(chat_state);
+        title_drawn = chat_state;
+    }
+
+    if (dirty_panes & PANE_TIME) update_time(win_time);
+    if (dirty_panes & PANE_TODO) {
+        draw_todo(win_todo);
+        todo_drawn = todo_version;
+    }
+    draw_stats_overlay(ui);     // ToDo 창 위에 겹치므로 ToDo 다음에
+    draw_mode(ui, dirty_panes & (PANE_CUSTOM | PANE_INPUT));
+
+    // 커서가 입력창에 남도록 입력창을 마지막에 올리고 한 번에 출력
+    if (!(dirty_panes & PANE_INPUT)) wnoutrefresh(win_input);
+    dirty_panes = 0;
+    doupdate();
+    perf_ring_add(&perf_frame_ns, perf_now_ns() - frame_start);
+}
+
+// F2: 통계 창 켜기/끄기 (끌 때는 가려졌던 ToDo 창을 다시 그림)
+static void toggle_stats_overlay(void) {
+    stats_visible = !stats_visible;
+    if (!stats_visible) {
+        if (win_stats) delwin(win_stats);
+        win_stats = NULL;
+        todo_drawn = (unsigned long)-1;
+    }
+}
+
+// 통계 창: 채팅 RTT(/ping→/pong), 초당 채팅 메시지, 화면 갱신(프레임) 시간
+static void draw_stats_overlay(UIState* ui) {
+    if (!stats_visible) return;
+    int rows, cols;
+    getmaxyx(stdscr, rows, cols);
+    if (rows < STATS_HEIGHT + INPUT_HEIGHT + 2 || cols < STATS_WIDTH * 2) return;
+    if (!win_stats)
+        win_stats = newwin(STATS_HEIGHT, STATS_WIDTH, rows - INPUT_HEIGHT - STATS_HEIGHT - 1,
+                           cols - STATS_WIDTH - 1);
+
+    werase(win_stats);
+    box(win_stats, 0, 0);
+    mvwprintw(win_stats, 0, 2, " Stats (F2) ");
+    if (ui->chat.step == 3 && perf_rtt_ns.n > 0) {
+        mvwprintw(win_stats, 1, 2, "RTT   last %.2f  p50 %.2f  p99 %.2f ms",
+            perf_ring_last(&perf_rtt_ns) / 1e6,
+            perf_ring_quantile(&perf_rtt_ns, 0.50) / 1e6,
+            perf_ring_quantile(&perf_rtt_ns, 0.99) / 1e6);
+    }
+    else {
+        mvwprintw(win_stats, 1, 2, "RTT   - %s", ui->chat.step == 3 ? "(waiting)" : "(no chat)");
+    }
+    mvwprintw(win_stats, 2, 2, "Chat  in %.1f/s  out %.1f/s",
+        perf_rate_get(&perf_msgs_in), perf_rate_get(&perf_msgs_out));
+    mvwprintw(win_stats, 3, 2, "Frame p50 %.2f  p99 %.2f  max %.2f ms",
+        perf_ring_quantile(&perf_frame_ns, 0.50) / 1e6,
+        perf_ring_quantile(&perf_frame_ns, 0.99) / 1e6,
+        perf_ring_quantile(&perf_frame_ns, 1.0) / 1e6);
+    mvwprintw(win_stats, 4, 2, "Frames %llu (last %d)",
+        (unsigned long long)perf_frame_ns.total, perf_frame_ns.n);
+    wnoutrefresh(win_stats);
+}
+
+// 상단 타이틀 줄 (chat_state >= 0 이면 백그라운드 채팅 표시)
+static void draw_title(int chat_state) {
+    mvprintw(0, 0, "<< CoShell >>");
+    if (chat_state > 0) printw("   [Chat: %d unread]", chat_state);
+    else if (chat_state == 0) printw("   [Chat]");
+    clrtoeol();
+    wnoutrefresh(stdscr);
+}
+
+// 렌더 큐(render_post)로 들어온 명령들을 실행한 뒤 호출됨
+static void ui_render_cb(void* arg) {
+    ui_render(arg);
+}
+
+// 입력창: 테두리 + "prefix + 입력 중인 문자열", 커서는 문자열 끝
+static void draw_input_line(const char* prefix, const char* text, int len) {
+    werase(win_input);
+    box(win_input, 0, 0);
+    mvwprintw(win_input, 1, 2, "%s%.*s", prefix, len, text);
+    wmove(win_input, 1, 2 + (int)strlen(prefix) + len);
+    wnoutrefresh(win_input);
+}
+
+// 로비 안내문
+static void draw_lobby_text(WINDOW* win) {
+    werase(win);
+    box(win, 0, 0);
+    int maxy, maxx;
+    getmaxyx(win, maxy, maxx);
+    print_wrapped_lines(win, 1, maxy - 2, maxx - 4, lobby_text, lobby_lines);
+    wnoutrefresh(win);
+}
+
+/* Handle lobby command input */
+static void handle_lobby_mode(UIState* ui, int ch) {
+    // 백스페이스
+    if (ch == KEY_BACKSPACE || ch == 127) {
+        if (ui->cmdlen > 0) {
+            ui->cmdlen--;
+            ui->cmdbuf[ui->cmdlen] = '\0';
+        }
+    }
+    // Enter 입력
+    else if (ch == '\n' || ch == KEY_ENTER) {
+        ui->cmdbuf[ui->cmdlen] = '\0';
+        const char* cmdbuf = ui->cmdbuf;
+        int cmdlen = ui->cmdlen;
+
+        // exit → 프로그램 종료
+        if (strcmp(cmdbuf, "exit") == 0) {
+            ui->running = 0;
+            return;
+        }
+        // 1 → To-Do 모드 진입
+        else if (cmdlen > 0 && cmdbuf[0] == '1') {
+            ui->mode = MODE_TODO;
+            ui->todo.len = 0;
+            memset(ui->todo.buf, 0, sizeof(ui->todo.buf));
+        }
+        // 2 → Chat 모드 진입 (백그라운드 세션이 있으면 재접속 없이 바로 복귀)
+        else if (cmdlen > 0 && cmdbuf[0] == '2' && ui->chat.step == 3) {
+            ui->mode = MODE_CHAT;
+            chat_client_attach(win_custom, win_input);
+        }
+        // 2 → 저장된 접속 정보가 있으면 바로 접속, "2 edit"는 저장된 값으로 채운 입력 화면
+        else if (cmdlen > 0 && cmdbuf[0] == '2') {
+            int edit = (strcmp(cmdbuf, "2 edit") == 0);
+            ui->mode = MODE_CHAT;
+            reset_chat_state(&ui->chat);
+            ui->chat.port = 0;
+            if (edit || config_has_chat(&config)) {
+                snprintf(ui->chat.host, sizeof(ui->chat.host), "%s", config.chat_host);
+                if (config.chat_port > 0)
+                    snprintf(ui->chat.port_str, sizeof(ui->chat.port_str), "%d", config.chat_port);
+                snprintf(ui->chat.nickname, sizeof(ui->chat.nickname), "%s", config.nickname);
+            }
+            if (!edit && config_has_chat(&config)) {
+                ui->chat.port = config.chat_port;
+                start_chat(ui);
+            }
+        }
+        // 3 → QR 경로 입력 모드 진입
+        else if (cmdlen > 0 && cmdbuf[0] == '3') {
+            ui->mode = MODE_QR_INPUT;
+            ui->qr.pathlen = 0;
+            memset(ui->qr.pathbuf, 0, sizeof(ui->qr.pathbuf));
+        }
+        else if (cmdlen > 0 && cmdbuf[0] == '4') {
+            ui->mode = MODE_TZ;
+            memset(&ui->tz, 0, sizeof(ui->tz));
+            ui->tz.total = clock_zone_search("", ui->tz.matches, TZ_MATCH_MAX);
+        }
+
+        // a <item> → ToDo 항목 추가 (비대화형 모드)
+        else if (cmdlen > 2 && cmdbuf[0] == 'a' && cmdbuf[1] == ' ') {
+            const char* item = cmdbuf + 2;
+            add_todo(item);
+        }
+        // f <filepath> → QR 전체화면 모드 바로 실행
+        else if (cmdlen > 2 && cmdbuf[0] == 'f' && cmdbuf[1] == ' ') {
+            const char* filepath = cmdbuf + 2;
+            process_and_show_file(win_custom, filepath);
+            create_windows(1);
+        }
+        else {
+            /*==============================*/
+            /*    Unknown command 처리      */
+            /*==============================*/
+            // 3초간 표시한 뒤 시계 tick이 로비 안내문으로 되돌림
+            show_notice(MODE_LOBBY, 1, 3000,
+                "Unknown command: %s\n"
+                "\n"
+                "Available commands in main UI:\n"
+                "  1             : Enter To-Do mode\n"
+                "  2             : Enter Chat mode\n"
+                "  2 edit        : Change saved chat host/port/nickname\n"
+                "  3             : Enter QR mode\n"
+                "  4             : World clocks (time zones)\n"
+                "  a <item>      : Add To-Do (non-interactive)\n"
+                "  f <filepath>  : Show QR for <filepath>\n"
+                "  exit          : Exit program", cmdbuf);
+        }
+
+        // 입력 버퍼 초기화
+        ui->cmdlen = 0;
+        memset(ui->cmdbuf, 0, sizeof(ui->cmdbuf));
+    }
+    else if (ch >= 32 && ch <= 126) {
+        if (ui->cmdlen < MAX_CMD_LEN) {
+            ui->cmdbuf[ui->cmdlen++] = (char)ch;
+        }
+    }
+}
+
+/* Draw ToDo mode screen (목록은 ui_render가 todo_version을 보고 그림) */
+static void draw_todo_mode(TodoState* state, int panes) {
+    if (panes & PANE_CUSTOM) draw_custom_help(win_custom);   // todo.c에 정의된 도움말 함수
+    if (panes & PANE_INPUT)  draw_input_line("", state->buf, state->len);
+}
+
+/* Handle ToDo mode input */
+static void handle_todo_mode(TodoState* state, int ch, int* mode) {
     if (ch == KEY_BACKSPACE || ch == 127) {
         if (state->len > 0) {
             state->buf[--state->len] = '\0';
@@ -647,15 +966,20 @@ static void handle_todo_mode(TodoState* state, int* mode) {
             // 로비로 돌아가기
             *mode = MODE_LOBBY;
             create_windows(1);
-            load_todo();
-            draw_todo(win_todo);
             return;  // 여기서 즉시 리턴하여 메인 UI 초기화 화면 유지
         }
         else if (strcmp(cmd, "team") == 0) {
-            switch_to_team_mode(win_custom, win_todo);
+            if (switch_to_team_mode() == 0 && !config.todo_team) {
+                config.todo_team = 1;
+                save_config();
+            }
         }
         else if (strcmp(cmd, "user") == 0) {
-            switch_to_user_mode(win_custom, win_todo);
+            switch_to_user_mode();
+            if (config.todo_team) {
+                config.todo_team = 0;
+                save_config();
+            }
         }
         else if (strncmp(cmd, "add ", 4) == 0) {
             add_todo(cmd + 4);
@@ -681,28 +1005,14 @@ static void handle_todo_mode(TodoState* state, int* mode) {
                 edit_todo(idx, text);
             }
             else {
-                mvwprintw(win_custom, 8, 2, "Usage: edt <num> <new text>");
-                wrefresh(win_custom);
-                napms(1000);
+                show_notice(MODE_TODO, 8, 1000, "Usage: edit <num> <new text>");
             }
         }
         else {
-            mvwprintw(win_custom, 8, 2, "Unknown: %s", cmd);
-            wrefresh(win_custom);
-            napms(1000);
+            show_notice(MODE_TODO, 8, 1000, "Unknown: %s", cmd);
         }
 
-        // (4) 변경 후 다시 그리기
-        werase(win_custom);
-        box(win_custom, 0, 0);
-        draw_custom_help(win_custom);
-        load_todo();
-        draw_todo(win_todo);
-        werase(win_input);
-        box(win_input, 0, 0);
-        wrefresh(win_input);
-
-        // 입력 버퍼 초기화
+        // 입력 버퍼 초기화 (다시 그리기는 ui_render에서)
         state->len = 0;
         memset(state->buf, 0, sizeof(state->buf));
     }
@@ -713,201 +1023,225 @@ static void handle_todo_mode(TodoState* state, int* mode) {
     }
 }
 
-/* Handle Chat mode (host/port/nickname and run) */
-static void handle_chat_mode(ChatState* state, int* mode) {
-    // Step 0: Host
-    if (state->step == 0) {
+// Chat 입력 단계별 버퍼 (0: host, 1: port, 2: nickname)
+static char* chat_step_buf(ChatState* state, int* cap) {
+    if (state->step == 0) { *cap = sizeof(state->host);     return state->host; }
+    if (state->step == 1) { *cap = sizeof(state->port_str); return state->port_str; }
+    *cap = sizeof(state->nickname);
+    return state->nickname;
+}
+
+/* Draw Chat mode screen (host/port/nickname prompts) */
+static void draw_chat_mode(ChatState* state, int panes) {
+    static const char* prompts[] = {
+        "Enter Chat host:",
+        "Enter Chat port (or 'q' to cancel):",
+        "Enter Nickname (no spaces):",
+    };
+    // 채팅 중에는 메시지 창을 chat.c가 직접 관리
+    if (state->step == 3) {
+        if (panes & PANE_INPUT) chat_client_draw_input();
+        return;
+    }
+    // 접속 중: 진행 상황과 경과 시간 (키 입력은 취소만)
+    if (state->step == 4) {
+        if (panes & PANE_CUSTOM) {
+            werase(win_custom);
+            box(win_custom, 0, 0);
+            mvwprintw(win_custom, 1, 2, "Connecting to %s:%d... %ds ('q' to cancel)", state->host, state->port,
+                (int)((perf_now_ns() - state->dial_start_ns) / 1000000000ull));
+            mvwprintw(win_custom, 2, 2, "%s", state->status);
+            wnoutrefresh(win_custom);
+        }
+        if (panes & PANE_INPUT) draw_input_line("", "", 0);
+        return;
+    }
+
+    int cap;
+    const char* buf = chat_step_buf(state, &cap);
+    if (panes & PANE_CUSTOM) {
         werase(win_custom);
         box(win_custom, 0, 0);
-        mvwprintw(win_custom, 1, 2, "Enter Chat host:");
-        wrefresh(win_custom);
-
-        werase(win_input);
-        box(win_input, 0, 0);
-        mvwprintw(win_input, 1, 2, "%s", state->host);
-        wmove(win_input, 1, 2 + strlen(state->host));
-        wrefresh(win_input);
-
-        wtimeout(win_input, 200);
-        int ch = wgetch(win_input);
-        if (ch == KEY_RESIZE) { resized = 1; return; }
-        if (ch == ERR) return;
-
-        if (ch == KEY_BACKSPACE || ch == 127) {
-            int len = strlen(state->host);
-            if (len > 0) {
-                state->host[len - 1] = '\0';
-            }
+        mvwprintw(win_custom, 1, 2, "%s", prompts[state->step]);
+        wnoutrefresh(win_custom);
+    }
+    if (panes & PANE_INPUT) draw_input_line("", buf, strlen(buf));
+}
+
+// 채팅 상태 초기화 후 로비로 복귀
+static void reset_chat_state(ChatState* state) {
+    dial_cancel(state->dial);
+    state->dial = NULL;
+    state->step = 0;
+    state->sock = -1;
+    state->retry_in = 0;
+    state->backoff = 0;
+    memset(state->host, 0, sizeof(state->host));
+    memset(state->port_str, 0, sizeof(state->port_str));
+    memset(state->nickname, 0, sizeof(state->nickname));
+}
+
+// dial.c 진행 상황 → 접속 화면 둘째 줄
+static void on_chat_dial_progress(const char* msg, void* arg) {
+    UIState* ui = arg;
+    snprintf(ui->chat.status, sizeof(ui->chat.status), "%s", msg);
+    mark_dirty(PANE_CUSTOM);
+    ui_render(ui);
+}
+
+// 접속 결과: 성공하면 채팅을 시작하고 소켓을 이벤트 루프에 등록, 실패하면 이유를 보이고 로비로
+static void on_chat_dialed(int fd, const char* err, void* arg) {
+    UIState* ui = arg;
+    ChatState* state = &ui->chat;
+    state->dial = NULL;
+    if (fd < 0) {
+        show_notice(MODE_LOBBY, 1, 1500, "Cannot connect to %s:%d (%s).", state->host, state->port, err);
+        reset_chat_state(state);
+        ui->mode = MODE_LOBBY;
+        create_windows(1);
+        ui_render(ui);
+        return;
+    }
+
+    werase(win_custom);
+    box(win_custom, 0, 0);
+    mvwprintw(win_custom, 1, 2, "Type '/quit' to end chat, '/bg' to keep it running in background.");
+    wrefresh(win_custom);
+
+    state->sock = chat_client_start(fd, state->nickname, win_custom, win_input);
+    state->step = 3;
+    ev_add_fd(state->sock, POLLIN, on_chat_readable, ui);
+
+    // 접속에 성공한 정보는 다음 실행에서 "2" 한 번으로 재접속할 수 있게 저장
+    if (strcmp(config.chat_host, state->host) != 0 || config.chat_port != state->port ||
+        strcmp(config.nickname, state->nickname) != 0) {
+        snprintf(config.chat_host, sizeof(config.chat_host), "%s", state->host);
+        snprintf(config.nickname, sizeof(config.nickname), "%s", state->nickname);
+        config.chat_port = state->port;
+        save_config();
+    }
+    ui_render(ui);
+}
+
+// Step 2 완료: Chat 서버에 접속 시작 (이름 풀이와 connect는 UI를 막지 않음, 결과는 on_chat_dialed)
+static void start_chat(UIState* ui) {
+    ChatState* state = &ui->chat;
+    state->step = 4;
+    state->status[0] = '\0';
+    state->dial_start_ns = perf_now_ns();
+    mark_dirty(PANE_CUSTOM | PANE_INPUT);
+    char local[64];
+    snprintf(local, sizeof(local), CHAT_LOCAL_SOCK_FMT, state->port);
+    state->dial = dial_start(state->host, state->port, local, chat_connect_timeout_ms(),
+                             on_chat_dialed, on_chat_dial_progress, ui);
+    if (!state->dial) on_chat_dialed(-1, "out of resources", ui);
+}
+
+/* Handle Chat mode (host/port/nickname and run) */
+static void handle_chat_mode(UIState* ui, int ch) {
+    ChatState* state = &ui->chat;
+    // Step 3: 채팅 중 → 키 입력을 chat 클라이언트에 전달
+    if (state->step == 3) {
+        int r = chat_client_key(ch);
+        if (r == 0) return;
+
+        // /bg: 연결과 이벤트 루프 등록은 유지하고 화면만 로비로
+        if (r == 2) {
+            chat_client_detach();
+            ui->mode = MODE_LOBBY;
+            create_windows(1);
+            return;
         }
-        else if (ch == '\n' || ch == KEY_ENTER) {
-            if (strlen(state->host) == 0) {
-                mvwprintw(win_custom, 2, 2, "Host cannot be empty. Try again.");
-                wrefresh(win_custom);
-                napms(1000);
-            }
-            else {
-                state->step = 1;
-            }
+
+        if (state->sock >= 0) ev_del_fd(state->sock);
+        chat_client_stop();
+
+        // 채팅 모드 종료 후 → 같은 프로세스에서 메인 UI로 복귀
+        // (ToDo/TimeZone 상태와 채팅 히스토리는 그대로 유지)
+        reset_chat_state(state);
+        ui->mode = MODE_LOBBY;
+        create_windows(1);
+        return;
+    }
+    // Step 4: 접속 중 → 'q' / Esc로 취소
+    if (state->step == 4) {
+        if (ch == 'q' || ch == 'Q' || ch == 27) {
+            reset_chat_state(state);
+            ui->mode = MODE_LOBBY;
+            create_windows(1);
         }
-        else if (ch >= 32 && ch <= 126) {
-            int len = strlen(state->host);
-            if (len < (int)sizeof(state->host) - 1) {
-                state->host[len] = (char)ch;
-                state->host[len + 1] = '\0';
-            }
+        return;
+    }
+
+    // Step 0~2: host / port / nickname 입력
+    int cap;
+    char* buf = chat_step_buf(state, &cap);
+    int len = strlen(buf);
+
+    if (ch == KEY_BACKSPACE || ch == 127) {
+        if (len > 0) {
+            buf[len - 1] = '\0';
         }
     }
-    // Step 1: Port
-    else if (state->step == 1) {
-        werase(win_custom);
-        box(win_custom, 0, 0);
-        mvwprintw(win_custom, 1, 2, "Enter Chat port (or 'q' to cancel):");
-        wrefresh(win_custom);
-
-        werase(win_input);
-        box(win_input, 0, 0);
-        mvwprintw(win_input, 1, 2, "%s", state->port_str);
-        wmove(win_input, 1, 2 + strlen(state->port_str));
-        wrefresh(win_input);
-
-        wtimeout(win_input, 200);
-        int ch = wgetch(win_input);
-        if (ch == KEY_RESIZE) { resized = 1; return; }
-        if (ch == ERR) return;
-
-        if (ch == KEY_BACKSPACE || ch == 127) {
-            int len = strlen(state->port_str);
-            if (len > 0) {
-                state->port_str[len - 1] = '\0';
+    else if (ch >= 32 && ch <= 126) {
+        if (len < cap - 1) {
+            buf[len] = (char)ch;
+            buf[len + 1] = '\0';
+        }
+    }
+    else if (ch == '\n' || ch == KEY_ENTER) {
+        if (state->step == 0) {
+            if (len == 0) {
+                show_notice(MODE_CHAT, 2, 1000, "Host cannot be empty. Try again.");
+            }
+            else {
+                state->step = 1;
             }
         }
-        else if (ch == '\n' || ch == KEY_ENTER) {
-            if (strlen(state->port_str) == 0) {
-                mvwprintw(win_custom, 2, 2, "Port cannot be empty. Try again.");
-                wrefresh(win_custom);
-                napms(1000);
+        else if (state->step == 1) {
+            if (len == 0) {
+                show_notice(MODE_CHAT, 2, 1000, "Port cannot be empty. Try again.");
             }
             else if (strcmp(state->port_str, "q") == 0 || strcmp(state->port_str, "Q") == 0) {
-                werase(win_custom);
-                box(win_custom, 0, 0);
-                mvwprintw(win_custom, 1, 2, "Cancelled Chat. Returning to main UI...");
-                wrefresh(win_custom);
-                napms(1000);
-                *mode = MODE_LOBBY;
+                ui->mode = MODE_LOBBY;
                 create_windows(1);
-                load_todo();
-                draw_todo(win_todo);
+                show_notice(MODE_LOBBY, 1, 1000, "Cancelled Chat.");
             }
             else {
                 state->port = atoi(state->port_str);
                 if (state->port <= 0 || state->port > 65535) {
-                    mvwprintw(win_custom, 2, 2, "Invalid port. Try again (or 'q').");
-                    wrefresh(win_custom);
-                    napms(1000);
+                    show_notice(MODE_CHAT, 2, 1000, "Invalid port. Try again (or 'q').");
                 }
                 else {
                     state->step = 2;
                 }
             }
         }
-        else if (ch >= 32 && ch <= 126) {
-            int len = strlen(state->port_str);
-            if (len < (int)sizeof(state->port_str) - 1) {
-                state->port_str[len] = (char)ch;
-                state->port_str[len + 1] = '\0';
-            }
-        }
-    }
-    // Step 2: Nickname
-    else if (state->step == 2) {
-        werase(win_custom);
-        box(win_custom, 0, 0);
-        mvwprintw(win_custom, 1, 2, "Enter Nickname (no spaces):");
-        wrefresh(win_custom);
-
-        werase(win_input);
-        box(win_input, 0, 0);
-        mvwprintw(win_input, 1, 2, "%s", state->nickname);
-        wmove(win_input, 1, 2 + strlen(state->nickname));
-        wrefresh(win_input);
-
-        wtimeout(win_input, 200);
-        int ch = wgetch(win_input);
-        if (ch == KEY_RESIZE) { resized = 1; return; }
-        if (ch == ERR) return;
-
-        if (ch == KEY_BACKSPACE || ch == 127) {
-            int len = strlen(state->nickname);
-            if (len > 0) {
-                state->nickname[len - 1] = '\0';
-            }
-        }
-        else if (ch == '\n' || ch == KEY_ENTER) {
-            if (strlen(state->nickname) == 0) {
-                mvwprintw(win_custom, 2, 2, "Nickname cannot be empty. Try again.");
-                wrefresh(win_custom);
-                napms(1000);
+        else if (state->step == 2) {
+            if (len == 0) {
+                show_notice(MODE_CHAT, 2, 1000, "Nickname cannot be empty. Try again.");
             }
             else {
-                state->step = 3;
-            }
-        }
-        else if (ch >= 32 && ch <= 126) {
-            int len = strlen(state->nickname);
-            if (len < (int)sizeof(state->nickname) - 1) {
-                state->nickname[len] = (char)ch;
-                state->nickname[len + 1] = '\0';
+                start_chat(ui);
             }
         }
     }
-    // Step 3: Start chat client
-    else if (state->step == 3) {
+}
+
+/* Draw QR path input screen */
+static void draw_qr_input_mode(QRInputState* qr_state, int panes) {
+    if (panes & PANE_CUSTOM) {
         werase(win_custom);
         box(win_custom, 0, 0);
-        mvwprintw(win_custom, 1, 2, "Type '/quit' to end chat and return to main UI.");
-        wrefresh(win_custom);
-
-        pthread_t timer_thread_id;
-        chat_running = 1;
-        if (pthread_create(&timer_thread_id, NULL, timer_thread_fn, NULL) != 0) {
-            // 실패해도 무시
-        }
-        chat_client(state->host, state->port, state->nickname, win_custom, win_input);
-        chat_running = 0;
-        pthread_join(timer_thread_id, NULL);
-
-        // 채팅 모드 종료 후 → 메인 UI로 복귀
-        state->step = 0;
-        memset(state->host, 0, sizeof(state->host));
-        memset(state->port_str, 0, sizeof(state->port_str));
-        memset(state->nickname, 0, sizeof(state->nickname));
-        
-	// argv[0]부터 프로그램 전체를 execvp로 덮어쓴다
-        cleanup_ncurses();
-        char* argv_new[] = { "./coshell", "ui", NULL };
-        execvp(argv_new[0], argv_new);
+        mvwprintw(win_custom, 1, 2, "Enter path for QR code (or 'q' to cancel):");
+        mvwprintw(win_custom, 2, 2, "%s", qr_state->pathbuf);
+        wnoutrefresh(win_custom);
     }
+    if (panes & PANE_INPUT) draw_input_line("", qr_state->pathbuf, qr_state->pathlen);
 }
 
 /* Handle QR path input mode */
-static void handle_qr_input_mode(QRInputState* qr_state, int* mode) {
-    werase(win_custom);
-    box(win_custom, 0, 0);
-    mvwprintw(win_custom, 1, 2, "Enter path for QR code (or 'q' to cancel):");
-    mvwprintw(win_custom, 2, 2, "%s", qr_state->pathbuf);
-    wrefresh(win_custom);
-
-    werase(win_input);
-    box(win_input, 0, 0);
-    mvwprintw(win_input, 1, 2, "%s", qr_state->pathbuf);
-    wmove(win_input, 1, 2 + qr_state->pathlen);
-    wrefresh(win_input);
-
-    wtimeout(win_input, 200);
-    int ch = wgetch(win_input);
-    if (ch == KEY_RESIZE) { resized = 1; return; }
-    if (ch == ERR) return;
-
+static void handle_qr_input_mode(QRInputState* qr_state, int ch, int* mode) {
     if (ch == KEY_BACKSPACE || ch == 127) {
         if (qr_state->pathlen > 0) {
             qr_state->pathlen--;
@@ -925,8 +1259,6 @@ static void handle_qr_input_mode(QRInputState* qr_state, int* mode) {
     else if (ch == 'q' || ch == 'Q') {
         *mode = MODE_LOBBY;
         create_windows(1);
-        load_todo();
-        draw_todo(win_todo);
     }
     else if (ch >= 32 && ch <= 126) {
         if (qr_state->pathlen < MAX_PATH_LEN) {
@@ -940,16 +1272,11 @@ static void handle_qr_full_mode(QRInputState* qr_state, int* mode) {
     // 1) curses 기반으로 전체화면 QR 그리기 (내부에서 'q'를 기다렸다가 리턴)
     process_and_show_file(win_custom, qr_state->pathbuf);
 
-    // 2) ncurses 윈도우/모드 정리
-    cleanup_ncurses();
-
-    // 3) execvp로 UI 다시 실행 (로비)
-    char* argv_new[] = { "./coshell", "ui", NULL };
-    execvp(argv_new[0], argv_new);
-
-    // execvp 실패 시
-    perror("execvp failed");
-    exit(1);
+    // 2) 입력 경로 초기화 후 로비 화면을 다시 만들어 복귀
+    qr_state->pathlen = 0;
+    qr_state->pathbuf[0] = '\0';
+    *mode = MODE_LOBBY;
+    create_windows(1);
 }
 
 
@@ -961,65 +1288,117 @@ static void cleanup_ncurses(void) {
     if (win_custom) { delwin(win_custom); win_custom = NULL; }
     if (win_todo) { delwin(win_todo);   win_todo = NULL; }
     if (win_input) { delwin(win_input);  win_input = NULL; }
+    if (win_stats) { delwin(win_stats);  win_stats = NULL; }     // 다음 렌더에서 새 위치에 생성
     endwin();
 }
 
 /*==============================*/
-/*   Time 문자열 생성 함수     */
+/*        Time 창 시계 갱신       */
 /*==============================*/
-static void get_time_strings(char* local_buf, int len1,
-    char* tz1_buf, int len2,
-    char* tz2_buf, int len3)
-{
-    time_t t = time(NULL);
-
-    // 1) 로컬
-    struct tm tm_local = *localtime(&t);
-    strftime(local_buf, len1, "%Y-%m-%d %H:%M:%S", &tm_local);
-
-    // 2) 첫 번째 원격 타임존
-    time_t t1 = t + tz1_offset;
-    struct tm tm1 = *gmtime(&t1);
-    snprintf(tz1_buf, len2,
-        "%04d-%02d-%02d %02d:%02d:%02d (%s)",
-        tm1.tm_year + 1900, tm1.tm_mon + 1, tm1.tm_mday,
-        tm1.tm_hour, tm1.tm_min, tm1.tm_sec,
-        tz1_label);
-
-    // 3) 두 번째 원격 타임존
-    time_t t2 = t + tz2_offset;
-    struct tm tm2 = *gmtime(&t2);
-    snprintf(tz2_buf, len3,
-        "%04d-%02d-%02d %02d:%02d:%02d (%s)",
-        tm2.tm_year + 1900, tm2.tm_mon + 1, tm2.tm_mday,
-        tm2.tm_hour, tm2.tm_min, tm2.tm_sec,
-        tz2_label);
+// 존 이름에서 라벨 만들기: "America/New_York" → "New York" (NULL이면 Local)
+static void clock_label_from_zone(char* dst, size_t cap, const char* zone_name) {
+    const char* city = zone_name ? strrchr(zone_name, '/') : NULL;
+    city = city ? city + 1 : (zone_name ? zone_name : "Local");
+    size_t n = 0;
+    for (; *city && n < cap - 1; city++) dst[n++] = (*city == '_') ? ' ' : *city;
+    dst[n] = '\0';
 }
 
+// slot 시계를 zone_name으로 설정 (tzdata에 없으면 -1)
+static int set_clock(int slot, const char* zone_name) {
+    const ClockZone* zone = clock_zone_load(zone_name);
+    if (!zone) return -1;
+    clock_face_init(&clocks[slot], zone);
+    clock_label_from_zone(clock_labels[slot], sizeof(clock_labels[slot]), zone_name);
+    clocks_full_redraw = 1;
+    return 0;
+}
 
-void update_time(WINDOW* w) {
-    char local_buf[32], tz1_buf[128], tz2_buf[128];
-    get_time_strings(local_buf, sizeof(local_buf),
-        tz1_buf, sizeof(tz1_buf),
-        tz2_buf, sizeof(tz2_buf));
-
-    werase(w);
-    box(w, 0, 0);
-    mvwprintw(w, 0, 2, " Time ");
-    mvwprintw(w, 1, 2, "Local: %s", local_buf);
-    mvwprintw(w, 2, 2, "%s: %s", tz1_label, tz1_buf);
-    mvwprintw(w, 3, 2, "%s: %s", tz2_label, tz2_buf);
-    wrefresh(w);
+// 시계 추가: 성공 시 슬롯 번호, 가득 찼거나 존이 없으면 -1
+static int add_clock(const char* zone_name) {
+    if (clock_count >= CLOCK_MAX || set_clock(clock_count, zone_name) < 0) return -1;
+    return clock_count++;
+}
+
+// 슬롯 제거 (로컬[0]은 제거 불가)
+static int remove_clock(int slot) {
+    if (slot < 1 || slot >= clock_count) return -1;
+    memmove(&clocks[slot], &clocks[slot + 1], sizeof(clocks[0]) * (clock_count - slot - 1));
+    memmove(clock_labels[slot], clock_labels[slot + 1], sizeof(clock_labels[0]) * (clock_count - slot - 1));
+    clock_count--;
+    clocks_full_redraw = 1;
+    return 0;
+}
+
+static void init_clocks(void) {
+    if (clock_count > 0) return;
+    set_clock(0, NULL);
+    clock_count = 1;
+    // 설정 파일에 clock 항목이 있으면 그 목록을, 없으면 기본 시계를 사용
+    if (config.clocks_set) {
+        for (int i = 0; i < config.nclocks; i++) add_clock(config.clocks[i]);
+        return;
+    }
+    for (size_t i = 0; i < sizeof(clock_default_zones) / sizeof(clock_default_zones[0]); i++) {
+        add_clock(clock_default_zones[i]);
+    }
+}
+
+// 설정 저장 실패(읽기 전용 홈 등)는 UI를 막지 않고 무시
+static void save_config(void) {
+    config_save(&config);
+}
+
+// chat.idle_timeout: 서버는 클라이언트 수신 대기, 클라이언트는 응답 감시에 같은 값을 씀
+static void apply_chat_config(void) {
+    if (config.idle_timeout_sec > 0) chat_idle_timeout_sec = config.idle_timeout_sec;
+    chat_server_io = config.server_uring ? CHAT_IO_URING : CHAT_IO_EPOLL;
+}
+
+// 현재 시계 목록을 설정에 반영하고 저장
+static void save_clocks_config(void) {
+    config.clocks_set = 1;
+    config.nclocks = 0;
+    for (int i = 1; i < clock_count && config.nclocks < CONFIG_MAX_CLOCKS; i++) {
+        snprintf(config.clocks[config.nclocks++], CONFIG_ZONE_LEN, "%s",
+            clock_zone_name(clocks[i].zone));
+    }
+    save_config();
 }
 
-// 매초 윈도우의 시간을 업데이트해 주는 스레드 함수 (Chat 모드에서만 사용)
-static void* timer_thread_fn(void* arg) {
-    (void)arg;
-    while (chat_running) {
-        update_time(win_time);
-        sleep(1);
+// 매 초 호출: 시계 문자열 중 바뀐 글자(보통 초 자리 한두 개)만 다시 씀
+void update_time(WINDOW* w) {
+    init_clocks();
+
+    time_t now = time(NULL);
+    int maxy, maxx;
+    getmaxyx(w, maxy, maxx);
+
+    // 라벨 폭을 맞춰 시계 열을 정렬
+    int label_w = 0;
+    for (int i = 0; i < clock_count; i++) {
+        int n = (int)strlen(clock_labels[i]);
+        if (n > label_w) label_w = n;
     }
-    return NULL;
+
+    if (clocks_full_redraw) {
+        werase(w);
+        box(w, 0, 0);
+        mvwprintw(w, 0, 2, " Time ");
+    }
+    for (int i = 0; i < clock_count && 1 + i < maxy - 1; i++) {
+        int col = 2 + label_w + 2;
+        if (clocks_full_redraw) {
+            mvwprintw(w, 1 + i, 2, "%-*s: ", label_w, clock_labels[i]);
+            clocks[i].valid = 0;
+        }
+        int first = clock_face_tick(&clocks[i], now);
+        if (first >= 0 && col + first < maxx - 1) {
+            mvwaddnstr(w, 1 + i, col + first, clocks[i].text + first, maxx - 1 - (col + first));
+        }
+    }
+    clocks_full_redraw = 0;
+    wnoutrefresh(w);
 }
 
 // 주어진 문자열 배열(lines)를 max_cols 폭에 맞춰 win에 출력
@@ -1061,14 +1440,16 @@ void create_windows(int in_lobby) {
     int right_width = cols - left_width;
     int left_height = rows - INPUT_HEIGHT;
     int title_height = 1;
-    int time_height = 5;    // border(2) + 라벨(1) + 시간 3줄 = 5
+    init_clocks();
+    int time_height = clock_count + 2;      // border(2) + 시계 한 줄씩
+    if (time_height > left_height / 2) time_height = left_height / 2;
     int custom_y = title_height + time_height;
     int custom_height = left_height - custom_y;
     if (custom_height < 1) custom_height = 1;
 
-    // (3) 상단 타이틀
+    // (3) 상단 타이틀 (백그라운드 채팅 표시는 ui_render가 덧붙임)
     mvprintw(0, 0, "<< CoShell >>");
-    refresh();
+    wnoutrefresh(stdscr);
 
     // (4) 왼쪽 상단: Time 표시 창
     win_time = newwin(time_height, left_width, title_height, 0);
@@ -1084,35 +1465,37 @@ void create_windows(int in_lobby) {
     scrollok(win_custom, TRUE);
     scrollok(win_todo, TRUE);
 
-    // (9) Time 창 초기화
+    // (9) Time 창 초기화 (시계 내용은 ui_render → update_time이 채움)
     box(win_time, 0, 0);
     mvwprintw(win_time, 0, 2, " Time ");
-    mvwprintw(win_time, 1, 2, "Local:    --:--:--");
-    mvwprintw(win_time, 2, 2, "USA  :    --:--:--");
-    mvwprintw(win_time, 3, 2, "UK   :    --:--:--");
-    wrefresh(win_time);
+    wnoutrefresh(win_time);
+    clocks_full_redraw = 1;
 
     // (10) Custom 창(로비 또는 모드)
-    box(win_custom, 0, 0);
     if (in_lobby) {
-        int maxy, maxx;
-        getmaxyx(win_custom, maxy, maxx);
-        int inner_lines = maxy - 2;
-        int inner_cols = maxx - 4;
-        print_wrapped_lines(win_custom, 1, inner_lines, inner_cols,
-            lobby_text, lobby_lines);
+        draw_lobby_text(win_custom);
+    }
+    else {
+        box(win_custom, 0, 0);
+        wnoutrefresh(win_custom);
     }
-    wrefresh(win_custom);
 
     // (11) ToDoList 창 초기화
     box(win_todo, 0, 0);
     mvwprintw(win_todo, 1, 2, "=== ToDo List ===");
-    wrefresh(win_todo);
+    wnoutrefresh(win_todo);
 
-    // (12) 입력창 초기화
+    // (12) 입력창 초기화 (이벤트 루프가 읽으므로 non-blocking)
+    keypad(win_input, TRUE);
+    nodelay(win_input, TRUE);
     box(win_input, 0, 0);
     mvwprintw(win_input, 1, 2, "Command: ");
-    wrefresh(win_input);
+    wnoutrefresh(win_input);
+
+    // (13) 새 윈도우이므로 다음 ui_render에서 모든 패널을 다시 그림
+    dirty_panes = PANE_ALL;
+    todo_drawn = (unsigned long)-1;
+    title_drawn = -2;
 }
 
 /*==============================*/
@@ -1161,79 +1544,120 @@ static int setup_serveo_tunnel(int local_port) {
 }
 
 
-static void handle_tz_mode(TzState* state, int* mode) {
-    int row = 1;
-    werase(win_custom);
-    box(win_custom, 0, 0);
-    mvwprintw(win_custom, row++, 2, "4. Setting TimeZone");
-    mvwprintw(win_custom, row++, 2, "Usage: <slot> <option#>  (slot:1 or 2)");
-    mvwprintw(win_custom, row++, 2, "or 'q' to cancel");
-    mvwprintw(win_custom, row++, 2, "Available options:");
-    for (int i = 0; i < tzOptionCount; i++) {
-        mvwprintw(win_custom, row++, 2, "%2d. %s", i + 1, tzOptions[i].label);
-    }
-    mvwprintw(win_custom, row++, 2, "%s", state->buf);
-    wrefresh(win_custom);
+/* Draw TimeZone setting screen */
+static void draw_tz_mode(TzState* state, int panes) {
+    if (panes & PANE_CUSTOM) {
+        int maxy, maxx;
+        getmaxyx(win_custom, maxy, maxx);
+        int row = 1;
+        werase(win_custom);
+        box(win_custom, 0, 0);
+        mvwprintw(win_custom, row++, 2, "4. World Clocks (%d/%d)", clock_count - 1, CLOCK_MAX - 1);
+        mvwprintw(win_custom, row++, 2, "Type to search, +<#> add, <slot> <#> replace,");
+        mvwprintw(win_custom, row++, 2, "-<slot> remove, q = back");
+
+        // 현재 슬롯 목록 (Time 창의 로컬 아래부터 1번)
+        wmove(win_custom, row++, 2);
+        wprintw(win_custom, "Slots:");
+        for (int i = 1; i < clock_count; i++) {
+            if (getcurx(win_custom) + (int)strlen(clock_labels[i]) + 5 >= maxx - 1) break;
+            wprintw(win_custom, " %d.%s", i, clock_labels[i]);
+        }
+        mvwprintw(win_custom, row++, 2, "%.*s", maxx - 4,
+            state->msg[0] ? state->msg : "");
+        mvwprintw(win_custom, row++, 2, "Search \"%s\": %d zone(s)", state->query, state->total);
+
+        // 검색 결과: 창 폭에 맞춰 여러 열로
+        const char* const* names;
+        clock_zone_names(&names);
+        int colw = 30;
+        int ncols = (maxx - 4) / colw;
+        if (ncols < 1) { ncols = 1; colw = maxx - 4; }
+        int nrows = maxy - 1 - row;
+        int shown = state->total < TZ_MATCH_MAX ? state->total : TZ_MATCH_MAX;
+        for (int i = 0; i < shown && nrows > 0 && i < nrows * ncols; i++) {
+            mvwprintw(win_custom, row + i % nrows, 2 + (i / nrows) * colw, "%3d. %.*s",
+                i + 1, colw - 6, names[state->matches[i]]);
+        }
+        wnoutrefresh(win_custom);
+    }
 
     // 입력창
-    werase(win_input);
-    box(win_input, 0, 0);
-    mvwprintw(win_input, 1, 2, "%s", state->buf);
-    wmove(win_input, 1, 2 + state->len);
-    wrefresh(win_input);
+    if (panes & PANE_INPUT) draw_input_line("", state->buf, state->len);
+}
+
+// 명령(+N, -S, S N, q)이 아니면 검색어로 취급
+static int tz_is_command(const char* buf) {
+    return buf[0] == '+' || buf[0] == '-' || (buf[0] >= '0' && buf[0] <= '9') ||
+        strcmp(buf, "q") == 0 || strcmp(buf, "Q") == 0;
+}
 
-    wtimeout(win_input, 200);
-    int ch = wgetch(win_input);
-    if (ch == KEY_RESIZE) { resized = 1; return; }
-    if (ch == ERR)        return;
+static void tz_search(TzState* state) {
+    snprintf(state->query, sizeof(state->query), "%s", state->buf);
+    state->total = clock_zone_search(state->query, state->matches, TZ_MATCH_MAX);
+}
+
+// 검색 결과 번호(1부터) → 존 이름, 범위 밖이면 NULL
+static const char* tz_match_name(TzState* state, int n) {
+    const char* const* names;
+    clock_zone_names(&names);
+    if (n < 1 || n > state->total || n > TZ_MATCH_MAX) return NULL;
+    return names[state->matches[n - 1]];
+}
 
+static void handle_tz_mode(TzState* state, int ch, int* mode) {
     if (ch == KEY_BACKSPACE || ch == 127) {
         if (state->len > 0) state->buf[--state->len] = '\0';
+        if (!tz_is_command(state->buf)) tz_search(state);
     }
     else if (ch == '\n' || ch == KEY_ENTER) {
         if (state->len == 0) return;
-        if (state->buf[0] == 'q' || state->buf[0] == 'Q') {
+        if (strcmp(state->buf, "q") == 0 || strcmp(state->buf, "Q") == 0) {
             *mode = MODE_LOBBY;
             create_windows(1);
-            load_todo(); draw_todo(win_todo);
             return;
         }
-        // tokenizing
-        char tmp[16];
-        strcpy(tmp, state->buf);
-        int slot, opt;
-        if (sscanf(tmp, "%d %d", &slot, &opt) == 2
-            && (slot == 1 || slot == 2) && opt >= 1 && opt <= tzOptionCount) {
-            // 적용
-            if (slot == 1) {
-                tz1_offset = tzOptions[opt - 1].offset;
-                snprintf(tz1_label, sizeof(tz1_label), "%s", tzOptions[opt - 1].label);
 
+        int n, slot, before = clock_count;
+        int changed = 1;
+        const char* zone = NULL;
+        if (sscanf(state->buf, "+%d", &n) == 1 && (zone = tz_match_name(state, n))) {
+            if (add_clock(zone) >= 0) {
+                snprintf(state->msg, sizeof(state->msg), "Added %s as slot %d", zone, clock_count - 1);
             }
             else {
-                tz2_offset = tzOptions[opt - 1].offset;
-                snprintf(tz2_label, sizeof(tz2_label), "%s", tzOptions[opt - 1].label);
-
+                snprintf(state->msg, sizeof(state->msg), "Cannot add %s (max %d clocks)", zone, CLOCK_MAX - 1);
+                changed = 0;
             }
-            mvwprintw(win_custom, row + 1, 2, "Slot %d set to %s", slot, tzOptions[opt - 1].label);
-            wrefresh(win_custom);
-            napms(1000);
-            *mode = MODE_LOBBY;
-            create_windows(1);
-            load_todo(); draw_todo(win_todo);
+        }
+        else if (sscanf(state->buf, "-%d", &slot) == 1 && remove_clock(slot) == 0) {
+            snprintf(state->msg, sizeof(state->msg), "Removed slot %d", slot);
+        }
+        else if (sscanf(state->buf, "%d %d", &slot, &n) == 2 && slot >= 1 && slot < clock_count &&
+            (zone = tz_match_name(state, n)) && set_clock(slot, zone) == 0) {
+            snprintf(state->msg, sizeof(state->msg), "Slot %d set to %s", slot, zone);
+        }
+        else if (!tz_is_command(state->buf) && state->total == 1 &&
+            (zone = tz_match_name(state, 1)) && add_clock(zone) >= 0) {
+            // 검색 결과가 하나뿐이면 Enter로 바로 추가
+            snprintf(state->msg, sizeof(state->msg), "Added %s as slot %d", zone, clock_count - 1);
         }
         else {
-            mvwprintw(win_custom, row + 1, 2, "Invalid input. Try again.");
-            wrefresh(win_custom);
-            napms(1000);
-            state->len = 0;
-            state->buf[0] = '\0';
+            snprintf(state->msg, sizeof(state->msg), "Invalid input: %s", state->buf);
+            changed = 0;
         }
+        state->len = 0;
+        state->buf[0] = '\0';
+        if (changed) save_clocks_config();
+
+        // 시계 개수가 바뀌면 Time 창 높이가 달라지므로 다시 배치
+        if (clock_count != before) create_windows(0);
     }
     else if (ch >= 32 && ch <= 126) {
         if (state->len < (int)sizeof(state->buf) - 1) {
             state->buf[state->len++] = (char)ch;
             state->buf[state->len] = '\0';
         }
+        if (!tz_is_command(state->buf)) tz_search(state);
     }
 }
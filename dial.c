@@ -0,0 +1,307 @@
+/*========================================*/
+/*         비동기 TCP 접속 모듈            */
+/*  - 워커 쓰레드 이름 풀이 + render_post  */
+/*  - non-blocking connect, Happy Eyeballs */
+/*    (IPv6/IPv4 번갈아 250ms 간격 경주)   */
+/*  - 루프백이면 유닉스 소켓을 먼저 시도  */
+/*========================================*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "dial.h"
+#include "event.h"
+#include "render.h"
+#include "perf.h"               // perf_now_ns()
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/timerfd.h>
+
+#define DIAL_MAX_ADDRS 16
+
+struct Dial {
+    char             host[256];
+    char             port[8];
+    char             local[64];     // 추상 유닉스 소켓 이름 (""이면 TCP만)
+    dial_done_cb     done;
+    dial_progress_cb progress;
+    void*            arg;
+
+    // 워커 쓰레드가 채우고, render_post 이후에만 루프 스레드가 읽음
+    int              gai_err;
+    int              naddrs;
+    struct sockaddr_storage addrs[DIAL_MAX_ADDRS];
+    socklen_t        addr_lens[DIAL_MAX_ADDRS];
+
+    // 루프 스레드 전용
+    int              resolving;     // 워커가 결과를 넘기기 전 (그동안 끝나도 해제는 결과가 온 뒤)
+    int              finished;      // 콜백을 불렀거나 취소됨
+    int              next;          // 다음에 시도할 주소
+    int              pending;       // 진행 중인 connect 수
+    int              socks[DIAL_MAX_ADDRS];     // 주소별 진행 중인 소켓 (-1 없음)
+    int              tfd;           // 다음 시도 / 전체 한도용 timerfd
+    uint64_t         deadline_ns;
+    uint64_t         next_attempt_ns;   // 0이면 예약 없음
+    int              last_err;
+};
+
+static void dial_attempt(Dial* d);
+static void dial_resolved(void* arg);
+
+// timerfd를 다음 시도와 전체 한도 중 이른 시각에 맞춤 (perf_now_ns와 같은 CLOCK_MONOTONIC)
+static void dial_arm(Dial* d) {
+    uint64_t at = d->deadline_ns;
+    if (d->next_attempt_ns && d->next_attempt_ns < at) at = d->next_attempt_ns;
+    struct itimerspec its = {
+        .it_value = { (time_t)(at / 1000000000ull), (long)(at % 1000000000ull) },
+    };
+    timerfd_settime(d->tfd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+// 남은 소켓과 타이머를 정리 (keep_fd는 돌려줄 소켓이라 닫지 않음)
+static void dial_close_all(Dial* d, int keep_fd) {
+    for (int i = 0; i < DIAL_MAX_ADDRS; i++) {
+        if (d->socks[i] < 0) continue;
+        ev_del_fd(d->socks[i]);
+        if (d->socks[i] != keep_fd) close(d->socks[i]);
+        d->socks[i] = -1;
+    }
+    ev_del_fd(d->tfd);
+    close(d->tfd);
+    d->tfd = -1;
+    d->finished = 1;
+}
+
+static void dial_finish(Dial* d, int fd, const char* err) {
+    dial_close_all(d, fd);
+    if (fd >= 0) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+    dial_done_cb done = d->done;
+    void* arg = d->arg;
+    if (!d->resolving) free(d);
+    done(fd, err, arg);
+}
+
+void dial_cancel(Dial* d) {
+    if (!d || d->finished) return;
+    dial_close_all(d, -1);
+    if (!d->resolving) free(d);
+}
+
+/*==============================*/
+/*      이름 풀이 (워커 쓰레드)    */
+/*==============================*/
+// 결과를 IPv6/IPv4 번갈아 늘어놓음 (첫 주소의 주소 체계부터, RFC 8305 4절)
+static void* dial_resolve_thread(void* p) {
+    Dial* d = p;
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM }, * res;
+    d->gai_err = getaddrinfo(d->host, d->port, &hints, &res);
+    if (d->gai_err == 0) {
+        const struct addrinfo* lists[2] = { res, res };
+        int fam[2] = { res->ai_family, res->ai_family == AF_INET6 ? AF_INET : AF_INET6 };
+        for (int turn = 0; d->naddrs < DIAL_MAX_ADDRS; turn ^= 1) {
+            const struct addrinfo* a = lists[turn];
+            while (a && a->ai_family != fam[turn]) a = a->ai_next;
+            lists[turn] = a;
+            if (!a) {
+                // 이 주소 체계는 다 씀: 다른 쪽이 남아 있으면 계속
+                const struct addrinfo* b = lists[turn ^ 1];
+                while (b && b->ai_family != fam[turn ^ 1]) b = b->ai_next;
+                if (!b) break;
+                continue;
+            }
+            memcpy(&d->addrs[d->naddrs], a->ai_addr, a->ai_addrlen);
+            d->addr_lens[d->naddrs++] = a->ai_addrlen;
+            lists[turn] = a->ai_next;
+        }
+        freeaddrinfo(res);
+    }
+    // 루프에 넘기지 못하면(메모리 부족) 전체 한도에서 실패로 끝남
+    render_post(dial_resolved, d);
+    return NULL;
+}
+
+/*==============================*/
+/*     접속 경주 (루프 스레드)     */
+/*==============================*/
+static void dial_report(Dial* d, const struct sockaddr* sa) {
+    if (!d->progress) return;
+    char ip[INET6_ADDRSTRLEN] = "?";
+    char msg[160];
+    if (sa->sa_family == AF_INET6) {
+        inet_ntop(AF_INET6, &((const struct sockaddr_in6*)sa)->sin6_addr, ip, sizeof(ip));
+        snprintf(msg, sizeof(msg), "Connecting to [%s]:%s (IPv6)...", ip, d->port);
+    }
+    else {
+        inet_ntop(AF_INET, &((const struct sockaddr_in*)sa)->sin_addr, ip, sizeof(ip));
+        snprintf(msg, sizeof(msg), "Connecting to %s:%s (IPv4)...", ip, d->port);
+    }
+    d->progress(msg, d->arg);
+}
+
+static void dial_on_ready(int fd, short revents, void* arg) {
+    (void)revents;
+    Dial* d = arg;
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0) err = errno;
+    for (int i = 0; i < DIAL_MAX_ADDRS; i++)
+        if (d->socks[i] == fd) d->socks[i] = -1;
+    ev_del_fd(fd);
+    d->pending--;
+    if (err == 0) {
+        dial_finish(d, fd, NULL);
+        return;
+    }
+    close(fd);
+    d->last_err = err;
+    dial_attempt(d);        // 실패는 기다리지 않고 바로 다음 주소
+}
+
+static void dial_on_timer(int fd, short revents, void* arg) {
+    (void)revents;
+    Dial* d = arg;
+    uint64_t expirations;
+    while (read(fd, &expirations, sizeof(expirations)) > 0) {}
+    uint64_t now = perf_now_ns();
+    if (now >= d->deadline_ns) dial_finish(d, -1, "timed out");
+    else if (d->next_attempt_ns && now >= d->next_attempt_ns) dial_attempt(d);
+    else dial_arm(d);
+}
+
+// 다음 주소로 connect를 하나 더 시작
+static void dial_attempt(Dial* d) {
+    d->next_attempt_ns = 0;
+    while (d->next < d->naddrs) {
+        int i = d->next++;
+        const struct sockaddr* sa = (const struct sockaddr*)&d->addrs[i];
+        dial_report(d, sa);
+        int fd = socket(sa->sa_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            d->last_err = errno;
+            continue;
+        }
+        if (connect(fd, sa, d->addr_lens[i]) == 0) {
+            dial_finish(d, fd, NULL);
+            return;
+        }
+        if (errno != EINPROGRESS) {
+            d->last_err = errno;
+            close(fd);
+            continue;
+        }
+        if (ev_add_fd(fd, POLLOUT, dial_on_ready, d) < 0) {
+            d->last_err = EMFILE;
+            close(fd);
+            continue;
+        }
+        d->socks[i] = fd;
+        d->pending++;
+        if (d->next < d->naddrs) d->next_attempt_ns = perf_now_ns() + DIAL_ATTEMPT_DELAY_MS * 1000000ull;
+        dial_arm(d);
+        return;
+    }
+    // 더 시도할 주소가 없음: 진행 중인 시도가 없으면 실패
+    if (d->pending == 0) dial_finish(d, -1, strerror(d->last_err ? d->last_err : EADDRNOTAVAIL));
+    else dial_arm(d);
+}
+
+static int dial_is_loopback(const struct sockaddr* sa) {
+    if (sa->sa_family == AF_INET)
+        return (ntohl(((const struct sockaddr_in*)sa)->sin_addr.s_addr) >> 24) == 127;
+    if (sa->sa_family == AF_INET6) {
+        const struct in6_addr* a = &((const struct sockaddr_in6*)sa)->sin6_addr;
+        return IN6_IS_ADDR_LOOPBACK(a) ||
+               (IN6_IS_ADDR_V4MAPPED(a) && a->s6_addr[12] == 127);
+    }
+    return 0;
+}
+
+// 같은 호스트: 서버의 추상 유닉스 소켓에 바로 접속 (connect가 기다리지 않으므로 경주 없이)
+// 실패하면(다른 네트워크 네임스페이스, 이전 버전 서버 등) -1 → TCP로
+static int dial_local(Dial* d) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    int n = snprintf(addr.sun_path + 1, sizeof(addr.sun_path) - 1, "%s", d->local);
+    socklen_t len = (socklen_t)(offsetof(struct sockaddr_un, sun_path) + 1 + (size_t)n);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr*)&addr, len) < 0) {     // 백로그가 차면 EAGAIN
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 이름 풀이 결과 (render_post로 루프 스레드에서)
+static void dial_resolved(void* arg) {
+    Dial* d = arg;
+    d->resolving = 0;
+    if (d->finished) {      // 이름 풀이 중에 취소되었거나 한도가 지남
+        free(d);
+        return;
+    }
+    if (d->gai_err) {
+        dial_finish(d, -1, gai_strerror(d->gai_err));
+        return;
+    }
+    if (d->local[0] && d->naddrs > 0 && dial_is_loopback((const struct sockaddr*)&d->addrs[0])) {
+        int fd = dial_local(d);
+        if (fd >= 0) {
+            dial_finish(d, fd, NULL);
+            return;
+        }
+    }
+    dial_attempt(d);
+}
+
+Dial* dial_start(const char* host, int port, const char* local, int timeout_ms,
+                 dial_done_cb done, dial_progress_cb progress, void* arg) {
+    Dial* d = calloc(1, sizeof(Dial));
+    if (!d) return NULL;
+    snprintf(d->host, sizeof(d->host), "%s", host);
+    snprintf(d->port, sizeof(d->port), "%d", port);
+    snprintf(d->local, sizeof(d->local), "%s", local ? local : "");
+    d->done = done;
+    d->progress = progress;
+    d->arg = arg;
+    for (int i = 0; i < DIAL_MAX_ADDRS; i++) d->socks[i] = -1;
+
+    d->tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (d->tfd < 0) {
+        free(d);
+        return NULL;
+    }
+    if (ev_add_fd(d->tfd, POLLIN, dial_on_timer, d) < 0) {
+        close(d->tfd);
+        free(d);
+        return NULL;
+    }
+    d->deadline_ns = perf_now_ns() + (uint64_t)timeout_ms * 1000000ull;
+    dial_arm(d);
+
+    d->resolving = 1;
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, dial_resolve_thread, d) != 0) {
+        d->resolving = 0;
+        dial_close_all(d, -1);
+        free(d);
+        return NULL;
+    }
+    pthread_detach(tid);
+    if (progress) {
+        char msg[300];
+        snprintf(msg, sizeof(msg), "Resolving %s...", d->host);
+        progress(msg, arg);
+    }
+    return d;
+}
@@ -0,0 +1,44 @@
+#ifndef DIAL_H
+#define DIAL_H
+
+/*==============================*/
+/*   비동기 TCP 접속 (dial)      */
+/*==============================*/
+/*
+ * UI 스레드를 막지 않고 host:port에 접속합니다.
+ * - 이름 풀이(getaddrinfo)는 워커 쓰레드에서, 결과는 render_post()로 루프 스레드에 전달
+ * - IPv4/IPv6 주소를 번갈아 늘어놓고 non-blocking connect를 DIAL_ATTEMPT_DELAY_MS 간격으로
+ *   하나씩 더 시작해 먼저 붙는 쪽을 씀 (Happy Eyeballs, RFC 8305)
+ * - 주소가 루프백이고 local 이름이 있으면 같은 호스트의 추상 유닉스 소켓("@local")에 먼저 접속
+ *   (실패하면 TCP로 계속)
+ * - 소켓과 타이머는 event.c 루프에 등록되므로 콜백은 모두 루프 스레드에서 호출됩니다.
+ */
+
+#define DIAL_ATTEMPT_DELAY_MS 250   // 앞선 시도가 끝나지 않으면 다음 주소를 시작하기까지
+
+typedef struct Dial Dial;
+
+/**
+ * 접속 결과 (한 번만 호출, 그 뒤 Dial은 해제됨)
+ * - fd: 접속된 소켓 (blocking 모드로 돌려놓음), 실패 시 -1
+ * - err: 실패 이유 (fd >= 0 이면 NULL)
+ */
+typedef void (*dial_done_cb)(int fd, const char* err, void* arg);
+
+/** 진행 상황 한 줄 ("Resolving ...", "Connecting to ... (IPv6)") */
+typedef void (*dial_progress_cb)(const char* msg, void* arg);
+
+/**
+ * 접속을 시작합니다. (루프 스레드에서 호출, render_init 이후)
+ * - local: 같은 호스트일 때 쓸 추상 유닉스 소켓 이름 (맨 앞 '\0' 제외), NULL이면 TCP만
+ * - timeout_ms: 이름 풀이부터 접속까지 전체 한도
+ * - progress: NULL이면 진행 상황을 알리지 않음
+ * 반환값: 진행 중인 접속 (dial_cancel로 취소), 시작하지 못하면 NULL
+ */
+Dial* dial_start(const char* host, int port, const char* local, int timeout_ms,
+                 dial_done_cb done, dial_progress_cb progress, void* arg);
+
+/** 진행 중인 접속을 취소합니다. 이후 콜백은 호출되지 않습니다. */
+void dial_cancel(Dial* d);
+
+#endif // DIAL_H
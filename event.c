@@ -0,0 +1,187 @@
+/*========================================*/
+/*          이벤트 루프 모듈               */
+/*   - poll()로 터미널/소켓/타이머/시그널   */
+/*     fd를 한 스레드에서 다중화           */
+/*========================================*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "event.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+
+#define EV_KIND_FD     0
+#define EV_KIND_TIMER  1
+#define EV_KIND_SIGNAL 2
+
+typedef struct {
+    int    fd;          // -1이면 삭제 예정 슬롯
+    short  events;
+    int    kind;
+    ev_cb  cb;
+    void*  arg;
+} EvSlot;
+
+static EvSlot slots[EV_MAX_FDS];
+static int    slot_count = 0;
+static int    winch_fd = -1;    // ev_wait_key에서 쓰는 SIGWINCH signalfd
+
+static int ev_add_slot(int fd, short events, int kind, ev_cb cb, void* arg) {
+    if (slot_count >= EV_MAX_FDS) return -1;
+    slots[slot_count++] = (EvSlot){ fd, events, kind, cb, arg };
+    return 0;
+}
+
+int ev_add_fd(int fd, short events, ev_cb cb, void* arg) {
+    return ev_add_slot(fd, events, EV_KIND_FD, cb, arg);
+}
+
+void ev_del_fd(int fd) {
+    // 콜백 실행 중일 수 있으므로 표시만 하고, 실제 정리는 ev_run_once 끝에서
+    for (int i = 0; i < slot_count; i++) {
+        if (slots[i].fd == fd) slots[i].fd = -1;
+    }
+}
+
+int ev_add_timer(int interval_ms, ev_cb cb, void* arg) {
+    int tfd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (tfd < 0) return -1;
+
+    // 첫 만료를 다음 interval 경계(예: 다음 정각 초)에 맞춤
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    int64_t step = (int64_t)interval_ms * 1000000;
+    int64_t ns = (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+    ns = (ns / step + 1) * step;
+
+    struct itimerspec its = {
+        .it_interval = { interval_ms / 1000, (long)(interval_ms % 1000) * 1000000 },
+        .it_value    = { (time_t)(ns / 1000000000), (long)(ns % 1000000000) },
+    };
+    if (timerfd_settime(tfd, TFD_TIMER_ABSTIME, &its, NULL) < 0 ||
+        ev_add_slot(tfd, POLLIN, EV_KIND_TIMER, cb, arg) < 0) {
+        close(tfd);
+        return -1;
+    }
+    return tfd;
+}
+
+int ev_add_signal(int signo, ev_cb cb, void* arg) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, signo);
+
+    // SIG_IGN 상태면 시그널이 버려지므로 기본 동작으로 되돌린 뒤 블록
+    signal(signo, SIG_DFL);
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) < 0) return -1;
+
+    int sfd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (sfd < 0) return -1;
+    if (ev_add_slot(sfd, POLLIN, EV_KIND_SIGNAL, cb, arg) < 0) {
+        close(sfd);
+        return -1;
+    }
+    if (signo == SIGWINCH) winch_fd = sfd;
+    return sfd;
+}
+
+// timerfd/signalfd는 콜백 전에 내부 카운터를 비워 둠 (안 비우면 계속 readable)
+static void ev_drain(const EvSlot* s) {
+    if (s->kind == EV_KIND_TIMER) {
+        uint64_t expirations;
+        while (read(s->fd, &expirations, sizeof(expirations)) > 0) {}
+    }
+    else if (s->kind == EV_KIND_SIGNAL) {
+        struct signalfd_siginfo si;
+        while (read(s->fd, &si, sizeof(si)) > 0) {}
+    }
+}
+
+int ev_run_once(int timeout_ms) {
+    struct pollfd pfds[EV_MAX_FDS];
+    int n = slot_count;
+    for (int i = 0; i < n; i++) {
+        pfds[i].fd = slots[i].fd;
+        pfds[i].events = slots[i].events;
+        pfds[i].revents = 0;
+    }
+
+    int ready = poll(pfds, n, timeout_ms);
+    if (ready < 0) return (errno == EINTR) ? 0 : -1;
+
+    // 콜백 안에서 새로 추가된 슬롯은 이번 회차에 처리하지 않음
+    for (int i = 0; i < n && ready > 0; i++) {
+        if (!pfds[i].revents) continue;
+        ready--;
+        EvSlot s = slots[i];
+        if (s.fd < 0) continue;     // 앞선 콜백에서 제거됨
+        ev_drain(&s);
+        s.cb(s.fd, pfds[i].revents, s.arg);
+    }
+
+    // 삭제 표시된 슬롯 정리
+    int w = 0;
+    for (int i = 0; i < slot_count; i++) {
+        if (slots[i].fd >= 0) slots[w++] = slots[i];
+    }
+    slot_count = w;
+    return n;
+}
+
+void ev_cleanup(void) {
+    for (int i = 0; i < slot_count; i++) {
+        if (slots[i].kind != EV_KIND_FD && slots[i].fd >= 0) close(slots[i].fd);
+    }
+    slot_count = 0;
+    winch_fd = -1;
+}
+
+/*==============================*/
+/*       터미널 관련 헬퍼        */
+/*==============================*/
+void ev_sync_term_size(void) {
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 0 && ws.ws_col > 0) {
+        // resizeterm()은 KEY_RESIZE를 입력 큐에 다시 넣으므로(크기가 같아도)
+        // 리사이즈 처리 → KEY_RESIZE → 리사이즈 ... 반복을 피하려고 resize_term() 사용
+        resize_term(ws.ws_row, ws.ws_col);
+        clearok(curscr, TRUE);
+    }
+}
+
+int ev_wait_key(WINDOW* w) {
+    nodelay(w, TRUE);
+    while (1) {
+        int ch = wgetch(w);
+        if (ch != ERR) {
+            nodelay(w, FALSE);
+            return ch;
+        }
+
+        struct pollfd p[2] = {
+            { .fd = STDIN_FILENO, .events = POLLIN },
+            { .fd = winch_fd,     .events = POLLIN },
+        };
+        int n = (winch_fd >= 0) ? 2 : 1;
+        int r = poll(p, n, -1);
+        if ((r < 0 && errno != EINTR) || (p[0].revents & (POLLHUP | POLLERR))) {
+            nodelay(w, FALSE);
+            return ERR;     // 터미널이 닫힘
+        }
+        if (n == 2 && (p[1].revents & POLLIN)) {
+            struct signalfd_siginfo si;
+            while (read(winch_fd, &si, sizeof(si)) > 0) {}
+            ev_sync_term_size();
+            nodelay(w, FALSE);
+            return KEY_RESIZE;
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef EVENT_H
+#define EVENT_H
+
+#include <poll.h>
+#include <ncurses.h>
+
+#define EV_MAX_FDS 32
+
+/**
+ * 이벤트 콜백
+ * - fd: 준비된 파일 디스크립터
+ * - revents: poll()이 돌려준 이벤트 (POLLIN, POLLHUP ...)
+ * - arg: 등록 시 넘긴 사용자 데이터
+ */
+typedef void (*ev_cb)(int fd, short revents, void* arg);
+
+/*==============================*/
+/*     poll 기반 이벤트 루프     */
+/*==============================*/
+
+/**
+ * 일반 fd(터미널 입력, 소켓 등)를 루프에 등록합니다.
+ * - events: 관심 이벤트 (보통 POLLIN)
+ * 반환값: 0 성공, -1 실패(테이블 가득 참)
+ */
+int ev_add_fd(int fd, short events, ev_cb cb, void* arg);
+
+/**
+ * 등록된 fd를 루프에서 제거합니다. (fd를 close하지는 않음)
+ * 콜백 안에서 호출해도 안전합니다.
+ */
+void ev_del_fd(int fd);
+
+/**
+ * timerfd 기반 주기 타이머를 등록합니다.
+ * - interval_ms 경계(벽시계 기준)에 맞춰 깨어나므로 1000이면 매 초가 바뀌는 순간 호출
+ * 반환값: 타이머 fd, 실패 시 -1
+ */
+int ev_add_timer(int interval_ms, ev_cb cb, void* arg);
+
+/**
+ * signalfd 기반 시그널 이벤트를 등록합니다.
+ * - 해당 시그널은 프로세스 전체에서 블록되며, 핸들러 대신 루프에서 cb가 호출됨
+ * 반환값: signalfd, 실패 시 -1
+ */
+int ev_add_signal(int signo, ev_cb cb, void* arg);
+
+/**
+ * poll을 한 번 수행하고 준비된 fd의 콜백을 호출합니다.
+ * - timeout_ms: -1이면 이벤트가 올 때까지 대기 (유휴 시 CPU 사용 없음)
+ * 반환값: 처리한 이벤트 수, 오류 시 -1
+ */
+int ev_run_once(int timeout_ms);
+
+/**
+ * 등록된 타이머/시그널 fd를 모두 닫고 테이블을 비웁니다.
+ */
+void ev_cleanup(void);
+
+/*==============================*/
+/*       터미널 관련 헬퍼        */
+/*==============================*/
+
+/**
+ * 실제 터미널 크기(TIOCGWINSZ)를 읽어 ncurses 화면 크기를 맞춥니다.
+ */
+void ev_sync_term_size(void);
+
+/**
+ * 모달 화면(QR 전체화면 등)에서 키 하나를 기다립니다.
+ * - 입력이 올 때까지 poll로 대기하며, 그 사이 SIGWINCH가 오면
+ *   화면 크기를 맞춘 뒤 KEY_RESIZE를 돌려줍니다.
+ */
+int ev_wait_key(WINDOW* w);
+
+#endif // EVENT_H
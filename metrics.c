@@ -0,0 +1,291 @@
+/*========================================*/
+/*        Chat 서버 런타임 지표 모듈        */
+/*  - 쓰레드별 카운터/히스토그램 슬롯       */
+/*  - Prometheus 텍스트 HTTP 엔드포인트     */
+/*========================================*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "metrics.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#define METRICS_MAX_SLOTS 64    // 동시에 도는 쓰레드 수보다 넉넉하게 (모자라면 공유 슬롯)
+
+typedef struct {
+    _Atomic uint64_t bucket[METRICS_HIST_BUCKETS + 1];   // 마지막은 +Inf
+    _Atomic uint64_t count;
+    _Atomic uint64_t sum_ns;
+} HistSlot;
+
+// 쓰레드 하나가 쓰는 슬롯. 캐시 라인을 나눠 다른 쓰레드와 부딪히지 않게 정렬
+typedef struct {
+    _Alignas(64) atomic_int in_use;
+    _Atomic uint64_t counter[MET_COUNTER_COUNT];
+    HistSlot         hist[MET_HIST_COUNT];
+} MetricsSlot;
+
+static MetricsSlot   slots[METRICS_MAX_SLOTS + 1];  // [MAX]은 슬롯이 모자랄 때 공유
+static _Atomic int64_t gauges[MET_GAUGE_COUNT];
+static void        (*collect_hook)(void);
+static uint64_t      started_ns;
+
+static _Thread_local MetricsSlot* my_slot;
+
+static const char* counter_names[MET_COUNTER_COUNT][2] = {
+    { "coshell_chat_connections_accepted_total", "Accepted client connections" },
+    { "coshell_chat_connections_rejected_total", "Connections rejected because the server was full" },
+    { "coshell_chat_connections_closed_total",   "Client connections that ended" },
+    { "coshell_chat_connections_timed_out_total", "Connections dropped after the idle timeout" },
+    { "coshell_chat_sessions_resumed_total",     "Reconnects that resumed a chat session" },
+    { "coshell_chat_bytes_in_total",             "Bytes received from clients" },
+    { "coshell_chat_bytes_out_total",            "Bytes relayed to clients" },
+    { "coshell_chat_messages_in_total",          "Chat lines received" },
+    { "coshell_chat_messages_out_total",         "Chat lines relayed (one per recipient)" },
+    { "coshell_chat_send_errors_total",          "Failed relay sends" },
+};
+
+static const char* gauge_names[MET_GAUGE_COUNT][2] = {
+    { "coshell_chat_clients",                "Currently connected clients" },
+    { "coshell_chat_send_queue_max_bytes",   "Largest unsent send queue (kernel + server buffer) among clients" },
+    { "coshell_chat_send_queue_bytes",       "Unsent bytes queued to all clients" },
+};
+
+static const char* hist_names[MET_HIST_COUNT][2] = {
+    { "coshell_chat_broadcast_seconds",  "Time from receiving a message to relaying it to the clients of one shard" },
+    { "coshell_chat_inbox_wait_seconds", "Time a relayed message waited in another shard's inbox" },
+};
+
+uint64_t metrics_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// 처음 기록할 때 빈 슬롯을 하나 차지
+static MetricsSlot* slot(void) {
+    if (my_slot) return my_slot;
+    for (int i = 0; i < METRICS_MAX_SLOTS; i++) {
+        int expected = 0;
+        if (atomic_compare_exchange_strong(&slots[i].in_use, &expected, 1)) {
+            my_slot = &slots[i];
+            return my_slot;
+        }
+    }
+    my_slot = &slots[METRICS_MAX_SLOTS];
+    return my_slot;
+}
+
+void metrics_thread_exit(void) {
+    if (my_slot && my_slot != &slots[METRICS_MAX_SLOTS])
+        atomic_store_explicit(&my_slot->in_use, 0, memory_order_release);
+    my_slot = NULL;
+}
+
+void metrics_add(MetricCounter c, uint64_t n) {
+    atomic_fetch_add_explicit(&slot()->counter[c], n, memory_order_relaxed);
+}
+
+void metrics_gauge_set(MetricGauge g, int64_t v) {
+    atomic_store_explicit(&gauges[g], v, memory_order_relaxed);
+}
+
+void metrics_gauge_add(MetricGauge g, int64_t d) {
+    atomic_fetch_add_explicit(&gauges[g], d, memory_order_relaxed);
+}
+
+// 1us * 2^i 이하인 첫 구간
+static int hist_bucket(uint64_t ns) {
+    uint64_t us = (ns + 999) / 1000;
+    int b = 0;
+    while (b < METRICS_HIST_BUCKETS && (1ull << b) < us) b++;
+    return b;
+}
+
+void metrics_observe(MetricHist h, uint64_t ns) {
+    HistSlot* hs = &slot()->hist[h];
+    atomic_fetch_add_explicit(&hs->bucket[hist_bucket(ns)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&hs->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&hs->sum_ns, ns, memory_order_relaxed);
+}
+
+void metrics_set_collect_hook(void (*hook)(void)) {
+    collect_hook = hook;
+}
+
+/*==============================*/
+/*            읽기              */
+/*==============================*/
+typedef struct {
+    uint64_t bucket[METRICS_HIST_BUCKETS + 1];
+    uint64_t count;
+    uint64_t sum_ns;
+} HistSnapshot;
+
+static uint64_t sum_counter(MetricCounter c) {
+    uint64_t v = 0;
+    for (int i = 0; i <= METRICS_MAX_SLOTS; i++)
+        v += atomic_load_explicit(&slots[i].counter[c], memory_order_relaxed);
+    return v;
+}
+
+static void sum_hist(MetricHist h, HistSnapshot* out) {
+    memset(out, 0, sizeof(*out));
+    for (int i = 0; i <= METRICS_MAX_SLOTS; i++) {
+        HistSlot* hs = &slots[i].hist[h];
+        for (int b = 0; b <= METRICS_HIST_BUCKETS; b++)
+            out->bucket[b] += atomic_load_explicit(&hs->bucket[b], memory_order_relaxed);
+        out->count += atomic_load_explicit(&hs->count, memory_order_relaxed);
+        out->sum_ns += atomic_load_explicit(&hs->sum_ns, memory_order_relaxed);
+    }
+}
+
+// 구간 상한으로 근사한 분위수 (us)
+static uint64_t hist_quantile_us(const HistSnapshot* hs, double q) {
+    uint64_t total = 0;
+    for (int b = 0; b <= METRICS_HIST_BUCKETS; b++) total += hs->bucket[b];
+    if (total == 0) return 0;
+    uint64_t rank = (uint64_t)(q * (double)total), seen = 0;
+    for (int b = 0; b <= METRICS_HIST_BUCKETS; b++) {
+        seen += hs->bucket[b];
+        if (seen > rank) return 1ull << (b < METRICS_HIST_BUCKETS ? b : METRICS_HIST_BUCKETS);
+    }
+    return 1ull << METRICS_HIST_BUCKETS;
+}
+
+#define APPEND(...) do { \
+        int n_ = snprintf(buf + len, len < cap ? cap - len : 0, __VA_ARGS__); \
+        if (n_ > 0) len += (size_t)n_; \
+    } while (0)
+
+size_t metrics_format_prometheus(char* buf, size_t cap) {
+    size_t len = 0;
+    if (collect_hook) collect_hook();
+
+    for (int c = 0; c < MET_COUNTER_COUNT; c++) {
+        APPEND("# HELP %s %s\n# TYPE %s counter\n%s %llu\n",
+               counter_names[c][0], counter_names[c][1], counter_names[c][0],
+               counter_names[c][0], (unsigned long long)sum_counter(c));
+    }
+    for (int g = 0; g < MET_GAUGE_COUNT; g++) {
+        APPEND("# HELP %s %s\n# TYPE %s gauge\n%s %lld\n",
+               gauge_names[g][0], gauge_names[g][1], gauge_names[g][0],
+               gauge_names[g][0], (long long)atomic_load(&gauges[g]));
+    }
+    for (int h = 0; h < MET_HIST_COUNT; h++) {
+        HistSnapshot hs;
+        sum_hist(h, &hs);
+        const char* name = hist_names[h][0];
+        APPEND("# HELP %s %s\n# TYPE %s histogram\n", name, hist_names[h][1], name);
+        uint64_t cum = 0;
+        for (int b = 0; b < METRICS_HIST_BUCKETS; b++) {
+            cum += hs.bucket[b];
+            APPEND("%s_bucket{le=\"%g\"} %llu\n", name, (double)(1ull << b) / 1e6,
+                   (unsigned long long)cum);
+        }
+        cum += hs.bucket[METRICS_HIST_BUCKETS];
+        APPEND("%s_bucket{le=\"+Inf\"} %llu\n%s_sum %.9f\n%s_count %llu\n",
+               name, (unsigned long long)cum, name, (double)hs.sum_ns / 1e9,
+               name, (unsigned long long)hs.count);
+    }
+    APPEND("# HELP coshell_chat_uptime_seconds Seconds since the server started\n"
+           "# TYPE coshell_chat_uptime_seconds gauge\ncoshell_chat_uptime_seconds %.0f\n",
+           started_ns ? (double)(metrics_now_ns() - started_ns) / 1e9 : 0.0);
+    return len < cap ? len : cap - 1;
+}
+
+size_t metrics_format_summary(char* buf, size_t cap) {
+    size_t len = 0;
+    if (collect_hook) collect_hook();
+
+    HistSnapshot bc, iw;
+    sum_hist(MET_HIST_BROADCAST, &bc);
+    sum_hist(MET_HIST_INBOX_WAIT, &iw);
+    double up = started_ns ? (double)(metrics_now_ns() - started_ns) / 1e9 : 0.0;
+    uint64_t msgs_in = sum_counter(MET_MSGS_IN);
+
+    APPEND("[stats] up %.0fs, clients %lld, accepted %llu, rejected %llu, closed %llu (timed out %llu), resumed %llu\n",
+           up, (long long)atomic_load(&gauges[MET_GAUGE_CLIENTS]),
+           (unsigned long long)sum_counter(MET_CONN_ACCEPTED),
+           (unsigned long long)sum_counter(MET_CONN_REJECTED),
+           (unsigned long long)sum_counter(MET_CONN_CLOSED),
+           (unsigned long long)sum_counter(MET_CONN_TIMED_OUT),
+           (unsigned long long)sum_counter(MET_SESSIONS_RESUMED));
+    APPEND("[stats] msgs in %llu (%.1f/s), out %llu, bytes in %llu, out %llu, send errors %llu\n",
+           (unsigned long long)msgs_in, up > 0 ? (double)msgs_in / up : 0.0,
+           (unsigned long long)sum_counter(MET_MSGS_OUT),
+           (unsigned long long)sum_counter(MET_BYTES_IN),
+           (unsigned long long)sum_counter(MET_BYTES_OUT),
+           (unsigned long long)sum_counter(MET_SEND_ERRORS));
+    APPEND("[stats] broadcast p50 <=%lluus p99 <=%lluus, inbox wait p99 <=%lluus, send queue max %lldB\n",
+           (unsigned long long)hist_quantile_us(&bc, 0.50),
+           (unsigned long long)hist_quantile_us(&bc, 0.99),
+           (unsigned long long)hist_quantile_us(&iw, 0.99),
+           (long long)atomic_load(&gauges[MET_GAUGE_SENDQ_MAX]));
+    return len < cap ? len : cap - 1;
+}
+
+/*==============================*/
+/*      HTTP 엔드포인트 쓰레드    */
+/*==============================*/
+static void* metrics_http_thread(void* arg) {
+    int listen_sock = (int)(intptr_t)arg;
+    static char body[16384];
+    char head[160], req[1024];
+
+    while (1) {
+        int sock = accept(listen_sock, NULL, NULL);
+        if (sock < 0) {
+            // fd 고갈(EMFILE/ENFILE) 등은 곧바로 다시 실패하므로 잠깐 쉬었다가 (쓰레드가 돌지 않도록)
+            if (errno != EINTR && errno != ECONNABORTED) poll(NULL, 0, 100);
+            continue;
+        }
+        // 요청 내용은 보지 않음: 어떤 경로든 지표를 돌려줌 (GET /metrics)
+        struct timeval tv = { 1, 0 };
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        if (recv(sock, req, sizeof(req), 0) >= 0) {
+            size_t blen = metrics_format_prometheus(body, sizeof(body));
+            int hlen = snprintf(head, sizeof(head),
+                "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                "Content-Length: %zu\r\nConnection: close\r\n\r\n", blen);
+            send(sock, head, (size_t)hlen, MSG_NOSIGNAL);
+            send(sock, body, blen, MSG_NOSIGNAL);
+        }
+        close(sock);
+    }
+    return NULL;
+}
+
+int metrics_serve(int port) {
+    started_ns = metrics_now_ns();
+
+    int sock = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0) return -1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &(int){1}, sizeof(int));
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),   // 외부에는 열지 않음
+        .sin_port = htons(port)
+    };
+    if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(sock, 8) < 0) {
+        close(sock);
+        return -1;
+    }
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, metrics_http_thread, (void*)(intptr_t)sock) != 0) {
+        close(sock);
+        return -1;
+    }
+    pthread_detach(tid);
+    return 0;
+}
@@ -0,0 +1,76 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*==============================*/
+/*     Chat 서버 런타임 지표     */
+/*==============================*/
+/*
+ * 쓰레드마다 자기 카운터 슬롯에만 더하고(락 없음), 읽는 쪽이 모든 슬롯을 합산합니다.
+ * - Prometheus 텍스트: metrics_serve()가 연 127.0.0.1 HTTP 포트 (GET /metrics)
+ * - 채팅 중 /stats 명령: metrics_format_summary() 결과를 요청한 클라이언트에게만 전송
+ */
+
+typedef enum {
+    MET_CONN_ACCEPTED,      // 받아들인 접속
+    MET_CONN_REJECTED,      // MAX_CLIENTS 초과로 거절한 접속
+    MET_CONN_CLOSED,        // 끊긴 접속
+    MET_CONN_TIMED_OUT,     // idle timeout(하트비트 없음)으로 끊은 접속
+    MET_SESSIONS_RESUMED,   // 재접속해 세션을 이어받은 횟수
+    MET_BYTES_IN,
+    MET_BYTES_OUT,
+    MET_MSGS_IN,            // 받은 줄 수
+    MET_MSGS_OUT,           // 중계한 줄 수 (받는 클라이언트마다 1)
+    MET_SEND_ERRORS,        // 중계 send 실패
+    MET_COUNTER_COUNT
+} MetricCounter;
+
+typedef enum {
+    MET_GAUGE_CLIENTS,      // 현재 접속 수
+    MET_GAUGE_SENDQ_MAX,    // 클라이언트별 못 보낸 바이트(커널 송신 큐 + 서버 버퍼) 최댓값
+    MET_GAUGE_SENDQ_TOTAL,  // 송신 큐 합계
+    MET_GAUGE_COUNT
+} MetricGauge;
+
+typedef enum {
+    MET_HIST_BROADCAST,     // 메시지 수신 → 한 샤드의 클라이언트들에 send 완료까지 (샤드마다 1)
+    MET_HIST_INBOX_WAIT,    // 다른 샤드 수신함에 들어가 꺼내질 때까지
+    MET_HIST_COUNT
+} MetricHist;
+
+#define METRICS_HIST_BUCKETS 23     // 1us, 2us, 4us ... 약 4.2s (+Inf 별도)
+
+/** 카운터에 n을 더합니다. (호출한 쓰레드의 슬롯, lock-free) */
+void metrics_add(MetricCounter c, uint64_t n);
+
+/** 게이지 값을 설정/증감합니다. */
+void metrics_gauge_set(MetricGauge g, int64_t v);
+void metrics_gauge_add(MetricGauge g, int64_t d);
+
+/** 히스토그램에 소요 시간(ns)을 기록합니다. */
+void metrics_observe(MetricHist h, uint64_t ns);
+
+/** 쓰레드가 끝날 때 슬롯을 반납합니다. (누적 값은 그대로 남아 다음 쓰레드가 이어 씀) */
+void metrics_thread_exit(void);
+
+/** 읽기 직전에 게이지를 갱신할 함수 (예: 소켓 송신 큐 조회) */
+void metrics_set_collect_hook(void (*hook)(void));
+
+/** Prometheus 텍스트 형식으로 씁니다. 반환값: 쓴 길이 */
+size_t metrics_format_prometheus(char* buf, size_t cap);
+
+/** /stats 용 요약 (여러 줄, 각 줄 "[stats] ..." 형식). 반환값: 쓴 길이 */
+size_t metrics_format_summary(char* buf, size_t cap);
+
+/**
+ * 127.0.0.1:port 에서 지표 HTTP 엔드포인트를 백그라운드 쓰레드로 엽니다.
+ * 반환값: 0 성공, -1 실패 (서버는 지표 없이 계속 동작)
+ */
+int metrics_serve(int port);
+
+/** CLOCK_MONOTONIC 나노초 */
+uint64_t metrics_now_ns(void);
+
+#endif // METRICS_H
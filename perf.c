@@ -0,0 +1,73 @@
+/*========================================*/
+/*       클라이언트 성능 측정 모듈          */
+/*  - 프레임 시간 / 채팅 RTT 샘플 링        */
+/*  - 초당 메시지 수                        */
+/*========================================*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "perf.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+PerfRing perf_frame_ns;
+PerfRing perf_rtt_ns;
+PerfRate perf_msgs_in;
+PerfRate perf_msgs_out;
+
+uint64_t perf_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void perf_ring_add(PerfRing* r, uint64_t v) {
+    r->v[r->next] = v;
+    r->next = (r->next + 1) % PERF_SAMPLES;
+    if (r->n < PERF_SAMPLES) r->n++;
+    r->total++;
+}
+
+static int cmp_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+uint64_t perf_ring_quantile(const PerfRing* r, double q) {
+    if (r->n == 0) return 0;
+    uint64_t sorted[PERF_SAMPLES];
+    memcpy(sorted, r->v, sizeof(uint64_t) * (size_t)r->n);
+    qsort(sorted, (size_t)r->n, sizeof(uint64_t), cmp_u64);
+    int idx = (int)(q * (double)r->n);
+    if (idx >= r->n) idx = r->n - 1;
+    return sorted[idx];
+}
+
+uint64_t perf_ring_last(const PerfRing* r) {
+    if (r->n == 0) return 0;
+    return r->v[(r->next + PERF_SAMPLES - 1) % PERF_SAMPLES];
+}
+
+// 1초가 지났으면 창을 넘기고 직전 창의 값을 rate로 확정
+static void perf_rate_roll(PerfRate* r, uint64_t now) {
+    if (r->window_start == 0) {
+        r->window_start = now;
+        return;
+    }
+    uint64_t elapsed = now - r->window_start;
+    if (elapsed < 1000000000ull) return;
+    r->rate = (double)r->count * 1e9 / (double)elapsed;
+    r->count = 0;
+    r->window_start = now;
+}
+
+void perf_rate_add(PerfRate* r, uint64_t n) {
+    perf_rate_roll(r, perf_now_ns());
+    r->count += n;
+}
+
+double perf_rate_get(PerfRate* r) {
+    perf_rate_roll(r, perf_now_ns());
+    return r->rate;
+}
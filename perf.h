@@ -0,0 +1,48 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include <stdint.h>
+
+/*==============================*/
+/*    클라이언트 성능 측정 값     */
+/*==============================*/
+/*
+ * UI 이벤트 루프 스레드에서만 갱신/조회하므로 락이 없습니다.
+ * - 최근 PERF_SAMPLES개 샘플로 분위수를 계산 (프레임 시간, 채팅 RTT)
+ * - 초당 메시지 수는 1초 단위 창으로 계산
+ */
+
+#define PERF_SAMPLES 256
+
+typedef struct {
+    uint64_t v[PERF_SAMPLES];
+    int      n;         // 채워진 개수 (최대 PERF_SAMPLES)
+    int      next;      // 다음에 쓸 위치
+    uint64_t total;     // 지금까지 넣은 샘플 수
+} PerfRing;
+
+typedef struct {
+    uint64_t window_start;  // 현재 1초 창의 시작 (ns)
+    uint64_t count;         // 현재 창에서 센 수
+    double   rate;          // 직전 창의 초당 수
+} PerfRate;
+
+extern PerfRing perf_frame_ns;     // ui_render 한 번 (그리기 + doupdate)
+extern PerfRing perf_rtt_ns;       // 채팅 /ping → /pong 왕복
+extern PerfRate perf_msgs_in;      // 받은 채팅 줄
+extern PerfRate perf_msgs_out;     // 보낸 채팅 줄
+
+/** CLOCK_MONOTONIC 나노초 */
+uint64_t perf_now_ns(void);
+
+void     perf_ring_add(PerfRing* r, uint64_t v);
+/** 최근 샘플의 q 분위수 (샘플이 없으면 0) */
+uint64_t perf_ring_quantile(const PerfRing* r, double q);
+/** 가장 최근 샘플 (없으면 0) */
+uint64_t perf_ring_last(const PerfRing* r);
+
+void     perf_rate_add(PerfRate* r, uint64_t n);
+/** 초당 수 (1초가 지나지 않았으면 직전 창 값) */
+double   perf_rate_get(PerfRate* r);
+
+#endif // PERF_H
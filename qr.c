@@ -1,6 +1,7 @@
 #define _POSIX_C_SOURCE 200809L
 
 #include "qr.h"
+#include "event.h"
 
 #include <ncurses.h>
 #include <sys/stat.h>
@@ -9,116 +10,303 @@
 #include <string.h>
 #include <signal.h>
 #include <unistd.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <time.h>
+#include <sys/wait.h>
 
-#define MAX_QR_BYTES 700
+#define MAX_QR_BYTES (16 * 1024)   // 화면에 안 들어가면 여러 장으로 나눠 표시
+#define QR_MAX_CAPACITY 2953   // QR v40 + 오류정정 L, 8bit 모드 최대 바이트
+#define QR_PATH_LEN     1024
 
-// 내부 헬퍼: 터미널 화면 크기에 맞춰서 QR 버전을 자동 계산
-static int pick_version_for_module(int max_module) {
+extern char** environ;
+
+/*==============================*/
+/*     전체화면 QR 페이지 뷰어    */
+/*==============================*/
+
+// QR 버전별 8bit 모드 최대 바이트 수 (오류정정 L)
+static const int qr_capacity_l[40] = {
+      17,   32,   53,   78,  106,  134,  154,  192,  230,  271,
+     321,  367,  425,  458,  520,  586,  644,  718,  792,  858,
+     929, 1003, 1091, 1171, 1273, 1367, 1465, 1528, 1628, 1732,
+    1840, 1952, 2068, 2188, 2303, 2431, 2563, 2699, 2809, 2953
+};
+
+#define QR_PAGE_HDR_MAX 12     // "[9999/9999] " 페이지 머리말 최대 길이
+
+typedef struct {
+    size_t off, len;           // 파일 내용 중 이 페이지가 담는 구간
+    char** lines;              // qrencode UTF8 출력 (처음 볼 때 인코딩)
+    int    nlines;
+} QRPage;
+
+typedef struct {
+    char    path[QR_PATH_LEN];
+    struct timespec mtime;     // 캐시 유효성 확인용 (path + mtime + size)
+    char*   data;              // 파일 전체 내용
+    size_t  size;
+    int     rows, cols;        // 마지막 레이아웃 기준 화면 크기
+    int     version;           // 현재 터미널 크기에 맞는 버전 (0이면 너무 작음)
+    QRPage* pages;
+    int     npages;
+    int     cur;
+    int     failed;            // qrencode 실행 실패 여부
+} QRPager;
+
+// 마지막으로 본 파일의 페이지/인코딩 결과 (같은 파일을 다시 열면 qrencode 생략)
+static QRPager qr_last;
+
+// 화면(rows x cols)에 통째로 들어가는 가장 큰 버전 계산
+// UTF8 출력은 문자 1칸 = 가로 1모듈, 세로 2모듈(반블록)
+static int qr_fit_version(int rows, int cols) {
+    int version = 0;
     for (int v = 1; v <= 40; v++) {
         int module_size = 17 + 4 * v;
-        if (module_size > max_module) {
-            return v - 1;
-        }
+        if ((module_size + 1) / 2 > rows || module_size > cols) break;
+        version = v;
     }
-    return 40;
+    return version;
 }
 
-// 전체화면에서 실제로 QR을 그리는 함수
-static void show_qrcode_fullscreen(const char* path) {
-    // SIGWINCH(창 크기 변경) 신호는 무시한 채, QR 창만 wrefresh만 수행하도록 설정
-    void (*old_winch)(int) = signal(SIGWINCH, SIG_IGN);
+static void qr_pager_free_pages(QRPager* p) {
+    for (int i = 0; i < p->npages; i++) {
+        for (int j = 0; j < p->pages[i].nlines; j++) free(p->pages[i].lines[j]);
+        free(p->pages[i].lines);
+    }
+    free(p->pages);
+    p->pages = NULL;
+    p->npages = 0;
+}
 
-    int rows, cols;
-    getmaxyx(stdscr, rows, cols);
-    werase(stdscr);
-    wrefresh(stdscr);
-
-    // (1) 안전하게 그릴 수 있는 행/열 계산
-    int safe_rows = rows - 2;         // 상하 여백 1줄씩
-    int safe_cols_mod = cols / 2;     // 가로는 모듈 하나당 2칸 사용
-
-    if (safe_rows < 1 || safe_cols_mod < 1) {
-        // 너무 작은 터미널
-        clear();
-        mvprintw(rows/2, (cols-18)/2, "Terminal too small!");
-        mvprintw(rows/2+1, (cols-28)/2, "Press any key to return");
-        refresh();
-        getch();
-        signal(SIGWINCH, old_winch);
-        return;
+// off부터 한 페이지에 담을 길이 (UTF-8 문자 중간에서 자르지 않도록 뒤로 물림)
+static size_t qr_page_len(const QRPager* p, size_t off, size_t cap) {
+    size_t len = p->size - off;
+    if (len > cap) {
+        len = cap;
+        while (len > 1 && ((unsigned char)p->data[off + len] & 0xC0) == 0x80) len--;
     }
+    return len;
+}
 
-    // (2) 버전 자동 계산
-    int max_module = (safe_rows < safe_cols_mod ? safe_rows : safe_cols_mod);
-    int version = pick_version_for_module(max_module);
-    if (version < 1) version = 1;
+// 현재 크기에 맞춰 버전을 다시 고르고, 내용을 페이지로 나눔
+static void qr_pager_layout(QRPager* p, int rows, int cols) {
+    size_t keep_off = (p->npages > 0) ? p->pages[p->cur].off : 0;
+    qr_pager_free_pages(p);
+    p->cur = 0;
+    p->rows = rows;
+    p->cols = cols;
 
-    // (3) QR 전용 창 생성 (전체 화면 덮음)
-    WINDOW *qrwin = newwin(rows, cols, 0, 0);
-    scrollok(qrwin, FALSE);
-    werase(qrwin);
+    p->version = qr_fit_version(rows - 2, cols);   // 상단 안내 + 하단 안내 한 줄씩
+    if (p->version < 1) return;
 
-    // 상단 안내
-    mvwprintw(qrwin, 0, 0, "Press 'q' to return (QR v%d)", version);
-    wrefresh(qrwin);
+    size_t cap = (size_t)qr_capacity_l[p->version - 1];
+    if (p->size > cap) cap = (cap > QR_PAGE_HDR_MAX) ? cap - QR_PAGE_HDR_MAX : 1;
 
-    // (4) qrencode 실행 → 라인 단위로 읽어와서 qrwin에 출력
-    char cmd[1024];
-    snprintf(cmd, sizeof(cmd),
-             "cat \"%s\" | qrencode -t UTF8 -l L -m 0 -v %d 2>/dev/null",
-             path, version);
+    // 물림 때문에 ceil(size/cap)보다 많아질 수 있으므로 같은 규칙으로 먼저 셈
+    int npages = 0;
+    size_t off = 0;
+    do {
+        off += qr_page_len(p, off, cap);
+        npages++;
+    } while (off < p->size);
+    p->pages = calloc((size_t)npages, sizeof(QRPage));
+    if (!p->pages) return;
 
-    FILE *fp = popen(cmd, "r");
-    if (!fp) {
-        mvwprintw(qrwin, 2, 0, "Failed to run qrencode on %s", path);
-        mvwprintw(qrwin, rows-1, 0, "Press 'q' to return");
-        wrefresh(qrwin);
+    off = 0;
+    do {
+        size_t len = qr_page_len(p, off, cap);
+        QRPage* pg = &p->pages[p->npages++];
+        pg->off = off;
+        pg->len = len;
+        if (pg->off <= keep_off && keep_off < off + len) p->cur = p->npages - 1;
+        off += len;
+    } while (off < p->size);
+}
 
-        keypad(qrwin, TRUE);
-        nodelay(qrwin, FALSE);
-        int c;
-        while ((c = wgetch(qrwin)) != 'q' && c != 'Q') {
-            // 무시
+// 페이지 하나를 qrencode로 인코딩하여 출력 줄을 저장
+static int qr_pager_encode(QRPager* p, QRPage* pg) {
+    char payload[QR_MAX_CAPACITY + QR_PAGE_HDR_MAX + 1];
+    int  hdr = 0;
+    if (p->npages > 1) {
+        hdr = snprintf(payload, sizeof(payload), "[%d/%d] ",
+            (int)(pg - p->pages) + 1, p->npages);
+    }
+    memcpy(payload + hdr, p->data + pg->off, pg->len);
+    size_t total = hdr + pg->len;
+
+    int in[2], out[2];
+    if (pipe(in) < 0) return -1;
+    if (pipe(out) < 0) { close(in[0]); close(in[1]); return -1; }
+
+    char vbuf[8];
+    snprintf(vbuf, sizeof(vbuf), "%d", p->version);
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(in[0]); close(in[1]); close(out[0]); close(out[1]);
+        return -1;
+    }
+    if (pid == 0) {
+        dup2(in[0], STDIN_FILENO);
+        dup2(out[1], STDOUT_FILENO);
+        int devnull = open("/dev/null", O_WRONLY);
+        if (devnull >= 0) dup2(devnull, STDERR_FILENO);
+        close(in[0]); close(in[1]); close(out[0]); close(out[1]);
+        execlp("qrencode", "qrencode", "-8", "-t", "UTF8", "-l", "L",
+            "-m", "0", "-v", vbuf, (char*)NULL);
+        _exit(127);
+    }
+    close(in[0]);
+    close(out[1]);
+
+    // 페이로드는 최대 3KB 정도라 파이프 버퍼에 한 번에 들어감
+    void (*old_pipe)(int) = signal(SIGPIPE, SIG_IGN);
+    size_t done = 0;
+    while (done < total) {
+        ssize_t n = write(in[1], payload + done, total - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        done += (size_t)n;
+    }
+    close(in[1]);
+    signal(SIGPIPE, old_pipe);
+
+    FILE* fp = fdopen(out[0], "r");
+    if (!fp) { close(out[0]); waitpid(pid, NULL, 0); return -1; }
+    char*  line = NULL;
+    size_t lcap = 0;
+    ssize_t n;
+    int cap = 0;
+    while ((n = getline(&line, &lcap, fp)) >= 0) {
+        if (n > 0 && line[n - 1] == '\n') line[n - 1] = '\0';
+        if (pg->nlines == cap) {
+            cap = cap ? cap * 2 : 64;
+            char** nl = realloc(pg->lines, sizeof(char*) * cap);
+            if (!nl) break;
+            pg->lines = nl;
         }
-        delwin(qrwin);
-        signal(SIGWINCH, old_winch);
+        pg->lines[pg->nlines++] = strdup(line);
+    }
+    free(line);
+    fclose(fp);
+
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+    return (WIFEXITED(status) && WEXITSTATUS(status) == 0 && pg->nlines > 0) ? 0 : -1;
+}
+
+static void qr_pager_draw(QRPager* p, WINDOW* w) {
+    int rows, cols;
+    getmaxyx(w, rows, cols);
+    werase(w);
+
+    if (p->version < 1 || p->npages == 0) {
+        mvwprintw(w, rows / 2, 0, "Terminal too small! Enlarge the window or press 'q'.");
+        wrefresh(w);
         return;
     }
 
-    char linebuf[1024];
-    int row = 1;
-    while (fgets(linebuf, sizeof(linebuf), fp) != NULL) {
-        int len = (int)strlen(linebuf);
-        if (len > 0 && (linebuf[len-1] == '\n' || linebuf[len-1] == '\r'))
-            linebuf[len-1] = '\0';
-        if (row >= safe_rows) break;
-        mvwprintw(qrwin, row++, 0, "%s", linebuf);
-        wrefresh(qrwin);
+    QRPage* pg = &p->pages[p->cur];
+    if (!pg->lines && !p->failed && qr_pager_encode(p, pg) != 0) {
+        p->failed = 1;
     }
-    pclose(fp);
+    mvwprintw(w, 0, 0, "QR %d/%d (v%d, %zu bytes)", p->cur + 1, p->npages, p->version, pg->len);
 
-    // (5) 하단 안내: QR 보다가 'q' 누르면 종료
-    mvwprintw(qrwin, rows-1, 0, "Press 'q' to return");
-    wrefresh(qrwin);
+    if (p->failed) {
+        mvwprintw(w, 2, 0, "Failed to run qrencode on %s", p->path);
+    }
+    else {
+        int width = 17 + 4 * p->version;
+        int x = (cols - width) / 2;
+        if (x < 0) x = 0;
+        for (int i = 0; i < pg->nlines && 1 + i < rows - 1; i++) {
+            mvwaddstr(w, 1 + i, x, pg->lines[i]);
+        }
+    }
+
+    mvwprintw(w, rows - 1, 0, p->npages > 1
+        ? "<-/-> : prev/next page   q : return"
+        : "Press 'q' to return");
+    wrefresh(w);
+}
+
+// 파일 내용을 pager에 읽어 옴. 같은 파일이 바뀌지 않았으면 이전 결과를 그대로 사용
+static int qr_pager_load(QRPager* p, const char* path) {
+    struct stat st;
+    if (stat(path, &st) < 0) return -1;
+    if (p->data && strcmp(p->path, path) == 0 && (size_t)st.st_size == p->size &&
+        st.st_mtim.tv_sec == p->mtime.tv_sec && st.st_mtim.tv_nsec == p->mtime.tv_nsec) {
+        return 0;
+    }
 
+    qr_pager_free_pages(p);
+    free(p->data);
+    memset(p, 0, sizeof(*p));
+
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return -1;
+    if (fstat(fileno(fp), &st) == 0 && (p->data = malloc(st.st_size + 1)) != NULL) {
+        p->size = fread(p->data, 1, st.st_size, fp);
+        p->mtime = st.st_mtim;
+        snprintf(p->path, sizeof(p->path), "%s", path);
+    }
+    fclose(fp);
+    return p->data ? 0 : -1;
+}
+
+// 전체화면에서 QR을 페이지 단위로 보여주는 함수
+static void show_qrcode_fullscreen(const char* path) {
+    QRPager* pager = &qr_last;
+
+    // (1) 파일 내용 읽기 (캐시 적중 시 생략)
+    if (qr_pager_load(pager, path) != 0) return;
+
+    // (2) 전체화면 창 생성 (창 크기 변경은 ev_wait_key가 KEY_RESIZE로 알려줌)
+    int rows, cols;
+    getmaxyx(stdscr, rows, cols);
+    WINDOW* qrwin = newwin(rows, cols, 0, 0);
+    scrollok(qrwin, FALSE);
     keypad(qrwin, TRUE);
     nodelay(qrwin, FALSE);
-    int ch;
+
+    // 화면 크기가 같고 지난번 인코딩이 성공했으면 페이지를 그대로 재사용
+    if (pager->npages == 0 || pager->failed || pager->rows != rows || pager->cols != cols) {
+        qr_pager_layout(pager, rows, cols);
+        pager->failed = 0;
+    }
+    pager->cur = 0;
+    qr_pager_draw(pager, qrwin);
+
+    // (3) 키 입력: 화살표로 페이지 이동, 'q'로 종료
     while (1) {
-        ch = wgetch(qrwin);
+        int ch = ev_wait_key(qrwin);
+        if (ch == ERR) break;
         if (ch == KEY_RESIZE) {
-            // 리사이즈 시: 화면 재출력만
-            wrefresh(qrwin);
+            getmaxyx(stdscr, rows, cols);
+            wresize(qrwin, rows, cols);
+            qr_pager_layout(pager, rows, cols);
+            pager->failed = 0;
+            qr_pager_draw(pager, qrwin);
             continue;
         }
-        if (ch == 'q' || ch == 'Q') {
-            break;
+        if (ch == 'q' || ch == 'Q') break;
+
+        int cur = pager->cur;
+        if (ch == KEY_RIGHT || ch == KEY_DOWN || ch == KEY_NPAGE || ch == ' ' || ch == 'n') {
+            if (pager->cur < pager->npages - 1) pager->cur++;
         }
-        // 그 외 키 무시
+        else if (ch == KEY_LEFT || ch == KEY_UP || ch == KEY_PPAGE || ch == 'p') {
+            if (pager->cur > 0) pager->cur--;
+        }
+        else if (ch == KEY_HOME) pager->cur = 0;
+        else if (ch == KEY_END && pager->npages > 0) pager->cur = pager->npages - 1;
+        if (pager->cur != cur) qr_pager_draw(pager, qrwin);
     }
 
     delwin(qrwin);
-    signal(SIGWINCH, old_winch);
 }
 
 // 터미널 UI 모드(전체화면)에서 호출되는 진입점
@@ -192,3 +380,215 @@ void show_qr_cli(const char *filename) {
     }
     pclose(fp);
 }
+
+
+/*==============================*/
+/*     QR 일괄 내보내기 (CLI)    */
+/*==============================*/
+
+typedef struct {
+    char        src[QR_PATH_LEN];   // 입력 파일 경로
+    char        name[256];          // 출력 파일 기본 이름 (예: 0001-main.c)
+    long        bytes;              // 입력 크기
+    const char* status;             // NULL이면 아직 처리 전
+} QRBatchItem;
+
+typedef struct {
+    QRBatchItem*    items;
+    int             count;
+    int             cap;
+    int             next;           // 워커가 다음에 가져갈 인덱스
+    int             dropped;        // 메모리가 모자라 큐에 넣지 못한 입력 (실패로 셈)
+    const char*     outdir;
+    pthread_mutex_t lock;
+} QRBatchQueue;
+
+// 작업 큐에 항목 하나 추가 (status가 NULL이 아니면 인코딩 없이 manifest에만 기록)
+// 큐를 늘리지 못하면 그 입력은 실패로 세고 알림 (조용히 빠지면 종료 코드가 0이 됨)
+static void batch_push(QRBatchQueue* q, const char* src, long bytes, const char* status) {
+    if (q->count == q->cap) {
+        int ncap = q->cap ? q->cap * 2 : 64;
+        QRBatchItem* n = realloc(q->items, sizeof(QRBatchItem) * ncap);
+        if (!n) {
+            fprintf(stderr, "  skip %s (out-of-memory)\n", src);
+            q->dropped++;
+            return;
+        }
+        q->items = n;
+        q->cap = ncap;
+    }
+    QRBatchItem* it = &q->items[q->count++];
+    snprintf(it->src, sizeof(it->src), "%s", src);
+    const char* base = strrchr(src, '/');
+    base = base ? base + 1 : src;
+    snprintf(it->name, sizeof(it->name), "%04d-%s", q->count, base);
+    it->bytes = bytes;
+    it->status = status;
+}
+
+// 파일이면 그대로, 디렉터리면 바로 아래의 일반 파일들을 이름순으로 큐에 추가
+static void batch_collect(QRBatchQueue* q, const char* path) {
+    struct stat st;
+    if (stat(path, &st) < 0) {
+        batch_push(q, path, 0, "not-found");
+        return;
+    }
+    if (S_ISREG(st.st_mode)) {
+        batch_push(q, path, (long)st.st_size, NULL);
+        return;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        batch_push(q, path, 0, "not-regular");
+        return;
+    }
+
+    struct dirent** list;
+    int n = scandir(path, &list, NULL, alphasort);
+    if (n < 0) {
+        batch_push(q, path, 0, "unreadable");
+        return;
+    }
+    for (int i = 0; i < n; i++) {
+        char full[QR_PATH_LEN];
+        const char* sep = path[strlen(path) - 1] == '/' ? "" : "/";
+        snprintf(full, sizeof(full), "%s%s%s", path, sep, list[i]->d_name);
+        if (list[i]->d_name[0] != '.' &&
+            stat(full, &st) == 0 && S_ISREG(st.st_mode)) {
+            batch_push(q, full, (long)st.st_size, NULL);
+        }
+        free(list[i]);
+    }
+    free(list);
+}
+
+// qrencode 한 번 실행: src 파일 → type 형식으로 out에 저장
+static int run_qrencode(const char* src, const char* type, const char* out) {
+    char* argv[] = {
+        "qrencode", "-8", "-l", "L", "-t", (char*)type,
+        "-r", (char*)src, "-o", (char*)out, NULL
+    };
+    posix_spawn_file_actions_t fa;
+    posix_spawn_file_actions_init(&fa);
+    posix_spawn_file_actions_addopen(&fa, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+    pid_t pid;
+    int rc = posix_spawnp(&pid, "qrencode", &fa, NULL, argv, environ);
+    posix_spawn_file_actions_destroy(&fa);
+    if (rc != 0) return -1;
+
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) return -1;
+    }
+    return (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : -1;
+}
+
+// 워커 스레드: 큐가 빌 때까지 항목을 하나씩 꺼내 3가지 형식으로 인코딩
+static void* qr_batch_worker(void* arg) {
+    static const struct { const char* type; const char* ext; } formats[] = {
+        { "PNG",  "png" },
+        { "SVG",  "svg" },
+        { "UTF8", "txt" },
+    };
+    QRBatchQueue* q = arg;
+
+    while (1) {
+        pthread_mutex_lock(&q->lock);
+        int i = (q->next < q->count) ? q->next++ : -1;
+        pthread_mutex_unlock(&q->lock);
+        if (i < 0) break;
+
+        QRBatchItem* it = &q->items[i];
+        if (it->status) continue;
+        if (it->bytes > QR_MAX_CAPACITY) {
+            it->status = "too-large";
+            continue;
+        }
+
+        it->status = "ok";
+        for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+            char out[QR_PATH_LEN + 300];
+            snprintf(out, sizeof(out), "%s/%s.%s", q->outdir, it->name, formats[f].ext);
+            if (run_qrencode(it->src, formats[f].type, out) != 0) {
+                it->status = "encode-failed";
+                break;
+            }
+        }
+    }
+    return NULL;
+}
+
+int qr_batch_export(const char* outdir, char* const paths[], int npaths, int jobs) {
+    if (mkdir(outdir, 0755) < 0 && errno != EEXIST) {
+        fprintf(stderr, "Cannot create %s: %s\n", outdir, strerror(errno));
+        return -1;
+    }
+
+    QRBatchQueue q = { .outdir = outdir };
+    pthread_mutex_init(&q.lock, NULL);
+    for (int i = 0; i < npaths; i++) {
+        batch_collect(&q, paths[i]);
+    }
+    if (q.count == 0) {
+        if (!q.dropped) fprintf(stderr, "No input files.\n");
+        pthread_mutex_destroy(&q.lock);
+        return q.dropped;
+    }
+
+    // (1) 워커 스레드 실행 (파일 수보다 많이 띄우지 않음)
+    if (jobs <= 0) jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (jobs < 1) jobs = 1;
+    if (jobs > q.count) jobs = q.count;
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    pthread_t* tids = malloc(sizeof(pthread_t) * jobs);
+    int started = 0;
+    for (int i = 0; tids && i < jobs; i++) {
+        if (pthread_create(&tids[started], NULL, qr_batch_worker, &q) == 0) started++;
+    }
+    if (started == 0) qr_batch_worker(&q);   // 스레드 생성 실패 시 현재 스레드에서 처리
+    for (int i = 0; i < started; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    free(tids);
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+    // (2) manifest 기록
+    char mpath[QR_PATH_LEN];
+    snprintf(mpath, sizeof(mpath), "%s/manifest.tsv", outdir);
+    FILE* mf = fopen(mpath, "w");
+    if (mf) fprintf(mf, "index\tsource\tbytes\tstatus\tpng\tsvg\ttxt\n");
+
+    int failed = q.dropped;
+    for (int i = 0; i < q.count; i++) {
+        QRBatchItem* it = &q.items[i];
+        int ok = strcmp(it->status, "ok") == 0;
+        if (!ok) {
+            failed++;
+            fprintf(stderr, "  skip %s (%s)\n", it->src, it->status);
+        }
+        if (mf) {
+            if (ok) {
+                fprintf(mf, "%d\t%s\t%ld\t%s\t%s.png\t%s.svg\t%s.txt\n",
+                    i + 1, it->src, it->bytes, it->status, it->name, it->name, it->name);
+            }
+            else {
+                fprintf(mf, "%d\t%s\t%ld\t%s\t-\t-\t-\n",
+                    i + 1, it->src, it->bytes, it->status);
+            }
+        }
+    }
+    if (mf) fclose(mf);
+
+    printf("Exported %d/%d QR codes to %s (%d jobs, %.2fs)\n",
+        q.count + q.dropped - failed, q.count + q.dropped, outdir, started ? started : 1, secs);
+    if (!mf) fprintf(stderr, "Failed to write %s\n", mpath);
+
+    free(q.items);
+    pthread_mutex_destroy(&q.lock);
+    return failed;
+}
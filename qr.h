@@ -10,8 +10,11 @@
  *
  * 내부적으로:
  *  1) 파일 존재 여부와 확장자(.c/.txt) 체크
- *  2) 크기(MAX_QR_BYTES=800 바이트) 초과 시 오류 메시지 후 return
+ *  2) 크기(MAX_QR_BYTES=16KB) 초과 시 오류 메시지 후 return
  *  3) ‘Press any key to view QR…’ 메시지 후 전체화면 QR 창(show_qrcode_fullscreen) 호출
+ *     - 현재 터미널에 들어가는 가장 큰 버전으로 내용을 여러 장으로 나누고
+ *       ←/→ 키로 페이지 이동, 창 크기가 바뀌면 다시 나눠서 표시
+ *     - 마지막으로 본 파일의 인코딩 결과는 캐시하여, 파일과 화면 크기가 그대로면 재사용
  */
 void process_and_show_file(WINDOW* custom, const char* path);
 
@@ -24,4 +27,19 @@ void process_and_show_file(WINDOW* custom, const char* path);
  */
 void show_qr_cli(const char* filename);
 
+/**
+ * CLI 모드에서, 여러 파일(또는 디렉터리)을 한 번에 QR 이미지로 내보냅니다.
+ * - outdir: 결과물을 저장할 디렉터리(없으면 생성)
+ * - paths/npaths: 파일 또는 디렉터리 경로 목록 (디렉터리는 바로 아래의 일반 파일 전체)
+ * - jobs: 인코딩 워커 스레드 수 (0 이하이면 CPU 코어 수)
+ *
+ * 내부적으로:
+ *  1) 입력 목록을 펼쳐 작업 큐를 만들고
+ *  2) 워커 스레드들이 큐에서 하나씩 꺼내 qrencode로 PNG/SVG/UTF-8(txt)을 생성
+ *  3) outdir/manifest.tsv 에 항목별 결과를 기록
+ *
+ * 반환값: 실패하거나 건너뛴 항목 수 (0이면 전부 성공)
+ */
+int qr_batch_export(const char* outdir, char* const paths[], int npaths, int jobs);
+
 #endif // QR_H
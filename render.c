@@ -0,0 +1,120 @@
+/*========================================*/
+/*            렌더 큐 모듈                 */
+/*  - lock-free MPSC 큐 + eventfd로       */
+/*    다른 스레드의 그리기 요청을          */
+/*    이벤트 루프 스레드에 전달            */
+/*========================================*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "render.h"
+#include "event.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+typedef struct RenderCmd {
+    _Atomic(struct RenderCmd*) next;
+    render_fn fn;
+    void*     arg;
+} RenderCmd;
+
+// Vyukov 방식 intrusive MPSC 큐
+// - 생산자: head를 atomic_exchange로 바꾸고 이전 노드의 next를 연결 (대기 없음)
+// - 소비자(루프 스레드): tail에서 하나씩 꺼냄. stub 노드로 빈 큐를 표현
+static RenderCmd             stub;
+static _Atomic(RenderCmd*)   head = &stub;
+static RenderCmd*            tail = &stub;
+static int                   wake_fd = -1;
+
+static void (*flush_cb)(void*);
+static void* flush_arg;
+
+static void queue_push(RenderCmd* n) {
+    atomic_store_explicit(&n->next, NULL, memory_order_relaxed);
+    RenderCmd* prev = atomic_exchange_explicit(&head, n, memory_order_acq_rel);
+    atomic_store_explicit(&prev->next, n, memory_order_release);
+}
+
+// 꺼낼 것이 없거나, 생산자가 push 도중(연결 전)이면 NULL
+// (그 생산자는 push를 마친 뒤 eventfd로 다시 깨우므로 다음 회차에 꺼내짐)
+static RenderCmd* queue_pop(void) {
+    RenderCmd* t = tail;
+    RenderCmd* next = atomic_load_explicit(&t->next, memory_order_acquire);
+    if (t == &stub) {
+        if (!next) return NULL;
+        tail = t = next;
+        next = atomic_load_explicit(&t->next, memory_order_acquire);
+    }
+    if (next) {
+        tail = next;
+        return t;
+    }
+    if (t != atomic_load_explicit(&head, memory_order_acquire)) return NULL;
+
+    // 마지막 노드: stub을 다시 넣어 t를 떼어 냄
+    queue_push(&stub);
+    next = atomic_load_explicit(&t->next, memory_order_acquire);
+    if (next) {
+        tail = next;
+        return t;
+    }
+    return NULL;
+}
+
+// eventfd가 readable → 쌓인 명령 실행 후 한 번만 화면 갱신
+static void on_render_wake(int fd, short revents, void* arg) {
+    (void)revents; (void)arg;
+    uint64_t cnt;
+    while (read(fd, &cnt, sizeof(cnt)) > 0) {}
+
+    int ran = 0;
+    RenderCmd* c;
+    while ((c = queue_pop()) != NULL) {
+        c->fn(c->arg);
+        free(c);
+        ran++;
+    }
+    if (ran && flush_cb) flush_cb(flush_arg);
+}
+
+int render_init(void (*flush)(void* arg), void* arg) {
+    flush_cb = flush;
+    flush_arg = arg;
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd < 0) return -1;
+    if (ev_add_fd(wake_fd, POLLIN, on_render_wake, NULL) < 0) {
+        close(wake_fd);
+        wake_fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+int render_post(render_fn fn, void* arg) {
+    if (wake_fd < 0) return -1;
+    RenderCmd* c = malloc(sizeof(*c));
+    if (!c) return -1;
+    c->fn = fn;
+    c->arg = arg;
+    queue_push(c);
+
+    // eventfd 카운터 증가만 하므로 막히지 않음 (EAGAIN은 이미 깨울 예정이라는 뜻)
+    uint64_t one = 1;
+    while (write(wake_fd, &one, sizeof(one)) < 0 && errno == EINTR) {}
+    return 0;
+}
+
+void render_cleanup(void) {
+    if (wake_fd < 0) return;
+    ev_del_fd(wake_fd);
+    close(wake_fd);
+    wake_fd = -1;
+
+    // 실행되지 못한 명령은 버림 (루프가 끝났으므로 그릴 곳이 없음, 프로세스 종료 직전)
+    RenderCmd* c;
+    while ((c = queue_pop()) != NULL) free(c);
+}
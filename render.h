@@ -0,0 +1,37 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+/*==============================*/
+/*   렌더 큐 (curses 단일 소유)   */
+/*==============================*/
+/*
+ * ncurses는 스레드 안전하지 않으므로 curses 호출은 이벤트 루프 스레드만 합니다.
+ * 다른 스레드(워커, 서버 스레드 등)는 화면을 직접 건드리지 않고
+ * render_post()로 그리기 명령을 넣으면, 루프 스레드가 꺼내 실행한 뒤 화면을 갱신합니다.
+ * 큐는 lock-free MPSC(생산자 여럿, 소비자 하나)라 생산자는 락을 기다리지 않습니다.
+ */
+
+/**
+ * 그리기 명령: 루프 스레드에서 arg와 함께 호출됨 (arg 해제는 명령 쪽 책임)
+ */
+typedef void (*render_fn)(void* arg);
+
+/**
+ * 큐를 만들고 eventfd를 이벤트 루프에 등록합니다. (루프 스레드에서 한 번)
+ * - flush: 한 번 깨어날 때 쌓인 명령을 모두 실행한 뒤 호출됨 (보통 ui_render)
+ * 반환값: 0 성공, -1 실패
+ */
+int render_init(void (*flush)(void* arg), void* flush_arg);
+
+/**
+ * 그리기 명령을 큐에 넣고 루프를 깨웁니다. 어느 스레드에서나 호출 가능.
+ * 반환값: 0 성공, -1 실패(메모리 부족 또는 render_init 전)
+ */
+int render_post(render_fn fn, void* arg);
+
+/**
+ * 큐에 남은 명령을 버리고 eventfd를 닫습니다. (루프 종료 후)
+ */
+void render_cleanup(void);
+
+#endif // RENDER_H
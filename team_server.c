@@ -0,0 +1,250 @@
+/*========================================*/
+/*           팀 ToDo 서버 모듈             */
+/*  - team 목록 복제본을 들고 클라이언트와 */
+/*    델타 동기화 (요청 하나에 응답 하나)  */
+/*========================================*/
+
+#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE                 // accept4
+
+#include "team_server.h"
+#include "todo.h"
+#include "todo_crdt.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+typedef struct {
+    int    fd;
+    int    dead;
+    char*  buf;
+    size_t have, cap;
+} TeamConn;
+
+static TeamConn conns[TEAM_SERVER_MAX_CLIENTS];
+static int      nconns;
+static Crdt     replica;
+
+static void conn_close(TeamConn* c) {
+    if (c->dead) return;
+    close(c->fd);
+    free(c->buf);
+    c->buf = NULL;
+    c->dead = 1;
+}
+
+static void conns_reap(void) {
+    for (int i = nconns - 1; i >= 0; i--)
+        if (conns[i].dead) conns[i] = conns[--nconns];
+}
+
+/*==============================*/
+/*          요청 처리            */
+/*==============================*/
+// "list": 예전 클라이언트(parse_todo_list)가 읽는 형식
+static void write_list(FILE* out) {
+    int n = crdt_count(&replica);
+    for (int i = 0; i < n; i++) {
+        const CrdtItem* it = crdt_item(&replica, i);
+        fprintf(out, "%s [%c]\n", it->text, it->done ? 'x' : ' ');
+    }
+}
+
+// "sync": V 줄로 상대 버전 벡터를 모으고, 연산 줄은 합친 뒤, 내 버전 벡터와 상대에게 없는 연산만 돌려줌
+// (상대가 방금 보낸 연산은 상대 버전 벡터에 이미 있으므로 되돌아가지 않음)
+static void handle_sync(char* body, FILE* out) {
+    CrdtSeen* seen = NULL;
+    int nseen = 0, cap = 0;
+    int added = 0;
+    char* save = NULL;
+    for (char* line = strtok_r(body, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+        CrdtOp op;
+        if (line[0] == 'V') {
+            if (nseen == cap) {
+                cap = cap ? cap * 2 : 16;
+                CrdtSeen* p = realloc(seen, sizeof(*seen) * (size_t)cap);
+                if (!p) break;
+                seen = p;
+            }
+            if (sscanf(line, "V %" SCNx64 " %" SCNu64, &seen[nseen].replica, &seen[nseen].seen) == 2) nseen++;
+        }
+        else if (crdt_parse_op(line, &op) == 0) {
+            added += crdt_apply(&replica, &op);
+            crdt_op_free(&op);
+        }
+    }
+    crdt_flush(&replica);       // "synced" 를 보내기 전에 저장
+    fprintf(out, "synced\n");
+    // 적용한 연산만 담긴 버전 벡터: 빠졌거나 대상이 없어 미룬 연산은 클라이언트가 다시 올림
+    crdt_write_seen(out, &replica);
+    int sent = crdt_write_delta(out, &replica, seen, nseen);
+    free(seen);
+    if (added || sent) printf(">> sync: +%d op%s in, %d op%s out, %d item%s\n",
+                              added, added == 1 ? "" : "s", sent, sent == 1 ? "" : "s",
+                              crdt_count(&replica), crdt_count(&replica) == 1 ? "" : "s");
+}
+
+static int send_all(int fd, const char* p, size_t len) {
+    while (len > 0) {
+        ssize_t w = send(fd, p, len, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return -1;
+        p += w;
+        len -= (size_t)w;
+    }
+    return 0;
+}
+
+// 요청이 다 왔으면 응답하고 1 (연결을 닫음), 아직이면 0
+static int handle_request(TeamConn* c) {
+    char* nl = memchr(c->buf, '\n', c->have);
+    if (!nl) return 0;
+    int sync = (size_t)(nl - c->buf) == 4 && memcmp(c->buf, "sync", 4) == 0;
+    // sync 요청은 "." 한 줄로 끝남
+    if (sync && !(c->have >= 3 && memcmp(c->buf + c->have - 3, "\n.\n", 3) == 0)) return 0;
+    c->buf[c->have] = '\0';
+
+    char* reply = NULL;
+    size_t len = 0;
+    FILE* out = open_memstream(&reply, &len);
+    if (!out) return 1;
+    if (sync) handle_sync(nl + 1, out);
+    else {
+        *nl = '\0';
+        if (nl > c->buf && nl[-1] == '\r') nl[-1] = '\0';
+        if (strcmp(c->buf, "list") == 0) write_list(out);
+        else fprintf(out, "ERROR: unknown command\n");
+    }
+    fclose(out);
+
+    // 응답은 한 번에 보내고 닫음: 블로킹으로 돌리되 멈춘 상대는 제한 시간에 끊김
+    struct timeval tv = { .tv_sec = TEAM_TIMEOUT_SEC };
+    fcntl(c->fd, F_SETFL, fcntl(c->fd, F_GETFL) & ~O_NONBLOCK);
+    setsockopt(c->fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    send_all(c->fd, reply, len);
+    free(reply);
+    return 1;
+}
+
+// 반환값: 1 이 연결을 닫음, 0 계속
+static int conn_read(TeamConn* c) {
+    if (c->cap - c->have < 4096 + 1) {
+        size_t cap = c->cap ? c->cap * 2 : 8192;
+        if (cap > TEAM_SERVER_MAX_REQ + 1) return 1;    // 너무 큰 요청
+        char* p = realloc(c->buf, cap);
+        if (!p) return 1;
+        c->buf = p;
+        c->cap = cap;
+    }
+    ssize_t r = recv(c->fd, c->buf + c->have, c->cap - 1 - c->have, 0);
+    if (r < 0 && (errno == EAGAIN || errno == EINTR)) return 0;
+    if (r <= 0) return 1;
+    c->have += (size_t)r;
+    return handle_request(c);
+}
+
+/*==============================*/
+/*        소켓 열기 / 루프        */
+/*==============================*/
+static int listen_tcp(void) {
+    // IPv6 + IPv4 둘 다 (IPv6가 없는 호스트면 IPv4만)
+    int fd = socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int one = 1, zero = 0;
+    if (fd >= 0) {
+        struct sockaddr_in6 a6 = { .sin6_family = AF_INET6, .sin6_port = htons(TEAM_PORT), .sin6_addr = in6addr_any };
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));
+        if (bind(fd, (struct sockaddr*)&a6, sizeof(a6)) == 0 && listen(fd, SOMAXCONN) == 0) return fd;
+        close(fd);
+    }
+    fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    struct sockaddr_in a4 = { .sin_family = AF_INET, .sin_port = htons(TEAM_PORT), .sin_addr.s_addr = htonl(INADDR_ANY) };
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, (struct sockaddr*)&a4, sizeof(a4)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 같은 호스트의 클라이언트(todo_client.c connect_team_local)가 먼저 시도하는 소켓
+static int listen_local(void) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    int n = snprintf(addr.sun_path + 1, sizeof(addr.sun_path) - 1, TEAM_LOCAL_SOCK_FMT, TEAM_PORT);
+    socklen_t len = (socklen_t)(offsetof(struct sockaddr_un, sun_path) + 1 + (size_t)n);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (bind(fd, (struct sockaddr*)&addr, len) < 0 || listen(fd, SOMAXCONN) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void team_accept(int lfd) {
+    int fd;
+    while ((fd = accept4(lfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        if (nconns == TEAM_SERVER_MAX_CLIENTS) {
+            close(fd);
+            continue;
+        }
+        conns[nconns++] = (TeamConn){ .fd = fd };
+    }
+}
+
+int team_server_main(int argc, char* argv[]) {
+    (void)argv;
+    if (argc != 0) {
+        fprintf(stderr, "Usage: coshell team\n");
+        return 2;
+    }
+    int lfds[2] = { listen_tcp(), listen_local() };
+    if (lfds[0] < 0) {
+        fprintf(stderr, "team server: port %d: %s\n", TEAM_PORT, strerror(errno));
+        if (lfds[1] >= 0) close(lfds[1]);
+        return 1;
+    }
+    int opened = crdt_open(&replica, TEAM_SERVER_FILE);
+    if (opened != 0) {
+        fprintf(stderr, "team server: %s: %s\n", TEAM_SERVER_FILE,
+                opened > 0 ? "in use by another team server" : strerror(errno));
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    printf(">> Team ToDo server on port %d%s: %s (%d item%s, %d op%s)\n", TEAM_PORT,
+           lfds[1] >= 0 ? " + local socket" : "", TEAM_SERVER_FILE,
+           crdt_count(&replica), crdt_count(&replica) == 1 ? "" : "s",
+           replica.nlog, replica.nlog == 1 ? "" : "s");
+
+    struct pollfd pfds[TEAM_SERVER_MAX_CLIENTS + 2];
+    while (1) {
+        pfds[0] = (struct pollfd){ .fd = lfds[0], .events = POLLIN };
+        pfds[1] = (struct pollfd){ .fd = lfds[1], .events = POLLIN };   // -1이면 poll이 건너뜀
+        for (int i = 0; i < nconns; i++) pfds[i + 2] = (struct pollfd){ .fd = conns[i].fd, .events = POLLIN };
+        int n = nconns;
+        int ready = poll(pfds, (nfds_t)n + 2, -1);
+        if (ready < 0 && errno != EINTR) break;
+        for (int i = 0; i < n && ready > 0; i++) {
+            if (!pfds[i + 2].revents || conns[i].dead) continue;
+            if (conn_read(&conns[i])) conn_close(&conns[i]);
+        }
+        conns_reap();
+        for (int i = 0; i < 2 && ready > 0; i++)
+            if (pfds[i].revents) team_accept(lfds[i]);
+    }
+    crdt_close(&replica);
+    return 1;
+}
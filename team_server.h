@@ -0,0 +1,21 @@
+#ifndef TEAM_SERVER_H
+#define TEAM_SERVER_H
+
+/*==============================*/
+/*        팀 ToDo 서버           */
+/*==============================*/
+/*
+ * "./coshell team" 으로 띄우면 TEAM_PORT(TCP)와 같은 호스트용 추상 유닉스 소켓에서
+ * team 목록 복제본(todo_crdt.h)을 들고 클라이언트와 델타 동기화를 합니다.
+ * - "sync": 클라이언트의 버전 벡터와 새 연산을 받아 합치고, 클라이언트에게 없는 연산만 돌려줌
+ * - "list": 예전 클라이언트용 전체 목록 (항목마다 "text [ ]" 한 줄)
+ * - 받은 연산은 실행한 디렉터리의 TEAM_SERVER_FILE 에 덧붙여 재시작해도 유지
+ */
+
+#define TEAM_SERVER_MAX_CLIENTS 64
+#define TEAM_SERVER_MAX_REQ     (1 << 20)   // 요청 하나의 최대 크기 (오래 오프라인이던 편집 포함)
+
+/** 포그라운드로 실행. 반환값: 프로세스 종료 코드 */
+int team_server_main(int argc, char* argv[]);
+
+#endif // TEAM_SERVER_H
@@ -4,19 +4,27 @@
 #include <pthread.h>
 #include <ncurses.h>
 
+// 벤치마크(bench_todo.c)는 큰 목록을 재려고 -DMAX_TODO=... 로 한도를 올려 빌드
+#ifndef MAX_TODO
 #define MAX_TODO     100
+#endif
 
 //========================
 //     파일 경로 상수
 //========================
 #define USER_TODO_FILE  "todo_user.txt"
-#define TEAM_TODO_FILE  "todo_team.txt"
+#define TEAM_TODO_FILE  "todo_team.txt"     // team 목록의 사람이 읽는 사본 (기준은 아래 복제본)
+#define TEAM_CRDT_FILE  "todo_team.crdt"    // team 목록 복제본: 연산 로그 (오프라인 편집 보관)
+#define TEAM_SERVER_FILE "todo_team_server.crdt"    // 팀 서버(./coshell team)의 복제본
 
 //========================
 //     서버 기본 정보
 //========================
 #define TEAM_IP      "127.0.0.1"
 #define TEAM_PORT    56789
+#define TEAM_LOCAL_SOCK_FMT "coshell-todo-%d"   // 같은 호스트면 먼저 시도할 추상 유닉스 소켓 (%d는 포트)
+#define TEAM_SYNC_SEC    5  // team 모드에서 다른 사람의 편집을 받아 오는 간격
+#define TEAM_TIMEOUT_SEC 2  // 동기화 한 번의 송수신 제한 (멈춘 서버 때문에 다음 동기화가 밀리지 않게)
 
 //========================
 //    전역 ToDo 데이터
@@ -25,27 +33,33 @@ extern pthread_mutex_t todo_lock;
 extern char current_todo_file[256];
 extern char *todos[MAX_TODO];
 extern int todo_count;
+extern unsigned long todo_version;   // 목록 변경 카운터
 
 //========================
 //   UI 관련 함수 선언
 //========================
 void draw_todo(WINDOW *win_todo);
 void draw_custom_help(WINDOW *custom);
-void show_error(WINDOW *custom, const char *fmt, ...);
-int  switch_to_team_mode(WINDOW *custom, WINDOW *todo);
-void switch_to_user_mode(WINDOW *custom, WINDOW *todo);
+void show_error(const char *fmt, ...);     // 안내 hook으로 2초간 "[Error] ..." 표시
+int  switch_to_team_mode(void);
+void switch_to_user_mode(void);
 
 //========================
 //   Core 기능 함수 선언
 //========================
 void load_todo();
+int  reload_todo_if_changed();
 void add_todo(const char *item);
 void done_todo(int index);
 void undo_todo(int index);
 void del_todo(int index);
 void edit_todo(int index, const char *new_item);
 void save_todo_to_file();
-void set_todo_mode(int is_team_mode);
+int  set_todo_mode(int is_team_mode);   // 0 성공, team 복제본을 열 수 없으면 -1 (user 모드 유지)
+int  todo_exec(const char *line, FILE *out);   // CLI 명령 한 줄 실행, 모르는 명령이면 -1
+void todo_set_saved_hook(void (*hook)(void));  // 파일에 저장할 때마다 호출 (NULL이면 끔)
+void todo_set_notice_hook(void (*hook)(int ms, const char *msg));  // 잠깐 보여 줄 안내 (UI가 ms 동안 표시)
+void todo_notice(int ms, const char *msg);     // 안내 hook 호출 (없으면 무시)
 
 //========================
 //  서버 통신 함수 선언
@@ -54,6 +68,11 @@ int connect_todo_server(const char *ip, int port);
 void disconnect_todo_server();
 int send_todo_command(const char *cmd, char *response, size_t size);
 void parse_todo_list(const char *response);
+// 복제본을 바로 보여 주고 서버와의 동기화를 워커 쓰레드에서 시작 (결과는 render_post로 루프에서 적용)
+// announce: 끝났을 때 서버에 닿지 않았으면 오프라인 안내. 이미 진행 중이면 끝난 뒤 한 번 더
+// 반환값: 0 시작함, -1 시작하지 못함(복제본으로 계속), -2 복제본 파일 오류
+int  team_sync_start(char *err, size_t size, int announce);
+int  team_edit(const char *verb, int index, const char *text);  // team 모드 add/done/undo/del/edit
 
 #endif // TODO_H
 
@@ -1,41 +1,76 @@
 /*========================================*/
 /*          ToDo 클라이언트 모듈          */
 /*     - 서버 연결 및 명령 전송 처리      */
+/*  - team 목록 복제본(CRDT) 편집/동기화  */
 /*========================================*/
 
 #define _POSIX_C_SOURCE 200809L
 
 #include "todo.h"
+#include "todo_crdt.h"
+#include "render.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <stddef.h>
+#include <inttypes.h>
+#include <stdatomic.h>
 #include <arpa/inet.h>
+#include <sys/un.h>
+#include <sys/time.h>
 #include <errno.h>
 
 /*==============================================*/
-/*   ToDo 명령 전송 → 서버 응답 받아오기 함수   */
-/*     - 팀 서버에 명령어 전송 후 응답 저장     */
+/*   팀 서버 연결 (같은 호스트면 유닉스 소켓)   */
+/*  - TEAM_IP가 루프백이면 추상 유닉스 소켓을   */
+/*    먼저 시도하고, 없으면 TCP로               */
 /*==============================================*/
-int send_todo_command(const char* cmd, char* response, size_t size) {
-    // 1) 새 소켓 열기
-    int sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock < 0) {
-        snprintf(response, size, "ERROR: socket failed: %s", strerror(errno));
+static int connect_team_local(void) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    int n = snprintf(addr.sun_path + 1, sizeof(addr.sun_path) - 1, TEAM_LOCAL_SOCK_FMT, TEAM_PORT);
+    socklen_t len = (socklen_t)(offsetof(struct sockaddr_un, sun_path) + 1 + (size_t)n);
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) return -1;
+    if (connect(sock, (struct sockaddr*)&addr, len) < 0) {
+        close(sock);
         return -1;
     }
+    return sock;
+}
 
-    // 2) 서버에 연결
+static int connect_team(char* response, size_t size) {
     struct sockaddr_in addr = {
         .sin_family = AF_INET,
         .sin_port = htons(TEAM_PORT), // todo.h 에 정의된 포트
     };
     inet_pton(AF_INET, TEAM_IP, &addr.sin_addr);
+    if ((ntohl(addr.sin_addr.s_addr) >> 24) == 127) {
+        int sock = connect_team_local();
+        if (sock >= 0) return sock;
+    }
+
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) {
+        snprintf(response, size, "ERROR: socket failed: %s", strerror(errno));
+        return -1;
+    }
     if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
         snprintf(response, size, "ERROR: connect failed: %s", strerror(errno));
         close(sock);
         return -1;
     }
+    return sock;
+}
+
+/*==============================================*/
+/*   ToDo 명령 전송 → 서버 응답 받아오기 함수   */
+/*     - 팀 서버에 명령어 전송 후 응답 저장     */
+/*==============================================*/
+int send_todo_command(const char* cmd, char* response, size_t size) {
+    // 1~2) 새 소켓으로 서버에 연결
+    int sock = connect_team(response, size);
+    if (sock < 0) return -1;
 
     // 3) 명령 전송 (cmd + '\n')
     if (write(sock, cmd, strlen(cmd)) < 0 ||
@@ -66,12 +101,13 @@ int send_todo_command(const char* cmd, char* response, size_t size) {
 void parse_todo_list(const char* response) {
     pthread_mutex_lock(&todo_lock);
 
-    // 1) 기존 ToDo 항목 모두 해제
-    for (int i = 0; i < MAX_TODO; i++) {
+    // 1) 기존 ToDo 항목 모두 해제 (todo_count 뒤 슬롯은 비어 있음)
+    for (int i = 0; i < todo_count; i++) {
         free(todos[i]);
         todos[i] = NULL;
     }
     todo_count = 0;
+    todo_version++;
 	
     // 2) 응답이 비어 있으면 바로 종료
     if (response == NULL || *response == '\0') {
@@ -93,3 +129,280 @@ void parse_todo_list(const char* response) {
     pthread_mutex_unlock(&todo_lock);
 }
 
+
+
+/*==============================================*/
+/*        team 목록 복제본 (CRDT) 동기화        */
+/*  - 편집은 항상 로컬 복제본에 먼저 기록       */
+/*    (서버가 없어도 바로 반영, 파일에 보관)    */
+/*  - 동기화: 내 버전 벡터를 보내 서버의 버전  */
+/*    벡터와 내게 없는 연산을 받고, 서버에 없는 */
+/*    연산이 있으면 그것만 한 번 더 올림        */
+/*  - 송수신은 워커 쓰레드, 적용은 루프 스레드  */
+/*==============================================*/
+static Crdt team;
+static int  team_opened;
+static int  team_shown_nlog = -1;      // 마지막으로 todos[]에 반영한 로그 길이
+static unsigned long team_shown_version;    // 그때의 todo_version (그 뒤 user 목록을 읽었으면 다시 반영)
+
+static Crdt* team_replica(void) {
+    if (!team_opened) {
+        if (crdt_open(&team, TEAM_CRDT_FILE) < 0) {
+            crdt_close(&team);
+            return NULL;
+        }
+        team_opened = 1;
+    }
+    return &team;
+}
+
+// 복제본의 화면 순서를 todos[]와 TEAM_TODO_FILE에 반영 (바뀐 게 없으면 그대로)
+static void team_publish(Crdt* c) {
+    if ((c->nlog == team_shown_nlog && todo_version == team_shown_version) ||
+        strcmp(current_todo_file, TEAM_TODO_FILE) != 0) return;
+    team_shown_nlog = c->nlog;
+
+    pthread_mutex_lock(&todo_lock);
+    for (int i = 0; i < todo_count; i++) {
+        free(todos[i]);
+        todos[i] = NULL;
+    }
+    todo_count = 0;
+    int n = crdt_count(c);
+    for (int i = 0; i < n && todo_count < MAX_TODO; i++) {
+        const CrdtItem* it = crdt_item(c, i);
+        char formatted[256];
+        snprintf(formatted, sizeof(formatted), "%s [%c]", it->text, it->done ? 'x' : ' ');
+        todos[todo_count++] = strdup(formatted);
+    }
+    save_todo_to_file();        // 사람이 읽는 사본 (todo_version도 여기서 증가)
+    team_shown_version = todo_version;
+    pthread_mutex_unlock(&todo_lock);
+}
+
+static int send_all(int sock, const char* p, size_t len) {
+    while (len > 0) {
+        ssize_t w = send(sock, p, len, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return -1;
+        p += w;
+        len -= (size_t)w;
+    }
+    return 0;
+}
+
+// 동기화 한 번: 요청을 만들고 응답을 적용하는 일은 루프 스레드가, 송수신만 워커 쓰레드가
+// (접속과 송수신이 몇 초씩 걸려도 UI가 멈추지 않게)
+typedef struct {
+    char*  req;         // "sync" / V 줄들 / 보낼 연산들 / "."
+    size_t len;
+    char*  resp;        // "synced" / 서버의 V 줄들 / 받을 연산들 (EOF까지)
+    size_t rlen;
+    int    ret;         // 송수신 결과 (0 응답 받음, -1 접속/전송 실패)
+    int    rerr;        // 응답을 받다 난 오류 (errno, 없으면 0)
+    int    upload;      // 0: 서버 버전 벡터 받아 오기, 1: 서버에 없는 연산 올리기
+    int    announce;    // 끝났을 때 오프라인이면 안내 (team 모드로 막 바꾼 경우)
+    char   err[256];
+} TeamJob;
+
+static atomic_int team_busy;    // 동기화 진행 중 (워커가 루프에 넘기지 못하면 워커가 풂)
+static int team_again;          // 진행 중에 다시 요청됨: 1 끝나면 한 번 더, 2 그 결과도 안내
+
+static void team_job_free(TeamJob* j) {
+    free(j->req);
+    free(j->resp);
+    free(j);
+}
+
+// nserver가 -1이면 연산 없이 (서버 버전 벡터를 받아 오기만), 아니면 server 버전 벡터에 없는 연산을 모두 넣음
+static int team_request(Crdt* c, const CrdtSeen* server, int nserver, TeamJob* j) {
+    FILE* fp = open_memstream(&j->req, &j->len);
+    if (!fp) {
+        snprintf(j->err, sizeof(j->err), "ERROR: out of memory");
+        return -1;
+    }
+    fprintf(fp, "sync\n");
+    crdt_write_seen(fp, c);
+    if (nserver >= 0) crdt_write_delta(fp, c, server, nserver);
+    fprintf(fp, ".\n");
+    fclose(fp);
+    return 0;
+}
+
+// 워커 쓰레드: 요청을 보내고 응답을 EOF까지 받음 (복제본은 건드리지 않음)
+static int team_roundtrip(TeamJob* j) {
+    int sock = connect_team(j->err, sizeof(j->err));
+    if (sock < 0) return -1;
+    // 멈춘 서버에 오래 붙잡혀 다음 동기화가 밀리지 않게
+    struct timeval tv = { .tv_sec = TEAM_TIMEOUT_SEC };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    if (send_all(sock, j->req, j->len) < 0) {
+        snprintf(j->err, sizeof(j->err), "ERROR: write failed: %s", strerror(errno));
+        close(sock);
+        return -1;
+    }
+    shutdown(sock, SHUT_WR);
+
+    FILE* fp = open_memstream(&j->resp, &j->rlen);
+    if (!fp) {
+        close(sock);
+        snprintf(j->err, sizeof(j->err), "ERROR: out of memory");
+        return -1;
+    }
+    char buf[4096];
+    ssize_t r;
+    while ((r = recv(sock, buf, sizeof(buf), 0)) > 0 || (r < 0 && errno == EINTR))
+        if (r > 0) fwrite(buf, 1, (size_t)r, fp);
+    j->rerr = r < 0 ? errno : 0;
+    fclose(fp);
+    close(sock);
+    return 0;
+}
+
+// 루프 스레드: 응답의 연산을 복제본에 적용하고 서버 버전 벡터를 돌려줌
+static int team_absorb(Crdt* c, TeamJob* j, CrdtSeen** seen_out, int* nseen_out) {
+    *seen_out = NULL;
+    *nseen_out = 0;
+
+    // 응답이 끊겨도 완성된 줄은 모두 유효한 연산 (인과 순서로 오므로 앞부분만 적용해도 됨)
+    char* resp = j->resp;
+    size_t rlen = j->rlen;
+    char* line = resp;
+    char* nl = memchr(resp, '\n', rlen);
+    if (!nl || strncmp(line, "synced", 6) != 0) {
+        if (j->rerr) snprintf(j->err, sizeof(j->err), "ERROR: no response: %s", strerror(j->rerr));
+        else snprintf(j->err, sizeof(j->err), "ERROR: team server does not support sync");
+        return -1;
+    }
+    int cap = 0;
+    while ((nl = memchr(line, '\n', rlen - (size_t)(line - resp))) != NULL) {
+        *nl = '\0';
+        CrdtOp op;
+        if (line[0] == 'V') {
+            if (*nseen_out == cap) {
+                CrdtSeen* p = realloc(*seen_out, sizeof(CrdtSeen) * (size_t)(cap = cap ? cap * 2 : 16));
+                if (!p) break;
+                *seen_out = p;
+            }
+            CrdtSeen* v = &(*seen_out)[*nseen_out];
+            if (sscanf(line, "V %" SCNx64 " %" SCNu64, &v->replica, &v->seen) == 2) ++*nseen_out;
+        }
+        else if (line != resp && crdt_parse_op(line, &op) == 0) {
+            crdt_apply(c, &op);
+            crdt_op_free(&op);
+        }
+        line = nl + 1;
+    }
+    crdt_flush(c);
+    return 0;
+}
+
+// 서버 버전 벡터에 내가 가진 연산이 빠져 있음 (새 편집, 또는 서버 파일을 지웠거나 예전 백업으로 되돌림)
+static int team_server_behind(const Crdt* c, const CrdtSeen* server, int nserver) {
+    for (int i = 0; i < c->nseen; i++)
+        if (c->seen[i].seen > crdt_seen_in(server, nserver, c->seen[i].replica)) return 1;
+    return 0;
+}
+
+static void team_sync_done(void* arg);
+
+static void* team_sync_thread(void* arg) {
+    TeamJob* j = arg;
+    j->ret = team_roundtrip(j);
+    // 루프에 넘기지 못하면(메모리 부족) 이번 결과는 버리고 다음 동기화 때 다시
+    if (render_post(team_sync_done, j) < 0) {
+        team_job_free(j);
+        atomic_store(&team_busy, 0);
+    }
+    return NULL;
+}
+
+static int team_spawn(TeamJob* j) {
+    pthread_t tid;
+    int e = pthread_create(&tid, NULL, team_sync_thread, j);
+    if (e != 0) {
+        snprintf(j->err, sizeof(j->err), "ERROR: cannot start sync: %s", strerror(e));
+        return -1;
+    }
+    pthread_detach(tid);
+    return 0;
+}
+
+// 워커가 받아 온 응답 (render_post로 루프 스레드에서)
+static void team_sync_done(void* arg) {
+    TeamJob* j = arg;
+    Crdt* c = &team;
+    CrdtSeen* server = NULL;
+    int nserver = 0;
+    int r = j->ret == 0 ? team_absorb(c, j, &server, &nserver) : -1;
+    // 먼저 서버의 버전 벡터를 받아 온 뒤, 서버에 없는 연산을 빠짐없이 골라 올림 (다른 사람의 연산 포함)
+    // (내 연산만 골라 올리면 서버가 잃은 앞부분이 빠진 채 버전 벡터만 앞서 갈 수 있음)
+    if (r == 0 && !j->upload && team_server_behind(c, server, nserver)) {
+        free(j->req);
+        free(j->resp);
+        j->req = j->resp = NULL;
+        j->upload = 1;
+        r = team_request(c, server, nserver, j) == 0 ? team_spawn(j) : -1;
+        free(server);
+        team_publish(c);
+        if (r == 0) return;     // 올린 결과가 오면 다시 여기로
+    }
+    else {
+        free(server);
+        team_publish(c);        // 오프라인이어도 로컬 복제본 그대로 보여 줌
+    }
+    if (r < 0 && j->announce)
+        todo_notice(2000, "Switched to [team] mode\n(offline: edits sync when the server is back)");
+    team_job_free(j);
+    atomic_store(&team_busy, 0);
+    if (team_again) team_sync_start(NULL, 0, team_again == 2);
+}
+
+int team_sync_start(char* err, size_t size, int announce) {
+    char dummy[256];
+    if (!err) {
+        err = dummy;
+        size = sizeof(dummy);
+    }
+    Crdt* c = team_replica();
+    if (!c) {
+        snprintf(err, size, "ERROR: cannot open %s: %s", TEAM_CRDT_FILE, strerror(errno));
+        return -2;
+    }
+    team_publish(c);            // 서버를 기다리지 않고 로컬 복제본부터 보여 줌
+    if (atomic_load(&team_busy)) {
+        // 진행 중인 요청에는 새 편집이 빠졌을 수 있으므로 끝난 뒤 한 번 더
+        if (team_again < 1 + announce) team_again = 1 + announce;
+        return 0;
+    }
+    team_again = 0;
+    TeamJob* j = calloc(1, sizeof(*j));
+    if (!j) {
+        snprintf(err, size, "ERROR: out of memory");
+        return -1;
+    }
+    j->announce = announce;
+    atomic_store(&team_busy, 1);
+    if (team_request(c, NULL, -1, j) < 0 || team_spawn(j) < 0) {
+        snprintf(err, size, "%s", j->err);
+        team_job_free(j);
+        atomic_store(&team_busy, 0);
+        return -1;
+    }
+    return 0;
+}
+
+int team_edit(const char* verb, int index, const char* text) {
+    Crdt* c = team_replica();
+    if (!c) return -1;
+    int ret = -1;
+    if (strcmp(verb, "add") == 0) ret = crdt_add(c, text);
+    else if (strcmp(verb, "done") == 0) ret = crdt_set_done(c, index, 1);
+    else if (strcmp(verb, "undo") == 0) ret = crdt_set_done(c, index, 0);
+    else if (strcmp(verb, "del") == 0) ret = crdt_delete(c, index);
+    else if (strcmp(verb, "edit") == 0) ret = crdt_set_text(c, index, text);
+    if (ret == 0) team_sync_start(NULL, 0, 0);  // 바로 보여 주고, 서버가 없으면 다음 동기화 때 보냄
+    return ret;
+}
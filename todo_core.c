@@ -15,29 +15,48 @@
 #include <stdarg.h>
 #include <ncurses.h>
 #include <pthread.h>
+#include <sys/stat.h>
 
 /* 전역 변수 */
 char current_todo_file[256] = USER_TODO_FILE;
 char *todos[MAX_TODO];
 int   todo_count = 0;
 pthread_mutex_t todo_lock = PTHREAD_MUTEX_INITIALIZER;
+unsigned long todo_version = 0;     // 목록이 바뀔 때마다 증가 (UI 다시 그리기 판단용)
+
+/* 저장할 때마다 부르는 함수 (UI: 데몬에 알림, 없으면 NULL) */
+static void (*todo_saved_hook)(void);
+
+/* 잠깐 보여 줄 안내를 넘기는 함수 (UI: 안내 패널, 없으면 NULL) */
+static void (*todo_notice_hook)(int ms, const char *msg);
+
+/* 마지막으로 읽거나 쓴 ToDo 파일의 상태 (외부 변경 감지용) */
+static struct timespec todo_file_mtime;
+static off_t todo_file_size = -1;
+
+static void stamp_todo_file(void) {
+    struct stat st;
+    if (stat(current_todo_file, &st) == 0) {
+        todo_file_mtime = st.st_mtim;
+        todo_file_size = st.st_size;
+    }
+    else {
+        todo_file_size = -1;
+    }
+}
 
 /*==============================*/
 /*    오류 메시지 출력 함수     */
 /*==============================*/
-void show_error(WINDOW *custom, const char *fmt, ...) {
+// 이벤트 루프를 멈추지 않도록 직접 기다리지 않고, UI가 2초간 보여 준 뒤 도움말로 돌아감
+void show_error(const char *fmt, ...) {
+    char msg[512];
     va_list args;
     va_start(args, fmt);
-
-    werase(custom);
-    box(custom, 0, 0);
-    mvwprintw(custom, 1, 2, "[Error] ");
-    vw_printw(custom, fmt, args);
+    int n = snprintf(msg, sizeof(msg), "[Error] ");
+    vsnprintf(msg + n, sizeof(msg) - n, fmt, args);
     va_end(args);
-
-    wrefresh(custom);
-    napms(2000);
-    draw_custom_help(custom);
+    todo_notice(2000, msg);
 }
 
 /*==============================*/
@@ -56,7 +75,7 @@ void draw_custom_help(WINDOW *custom) {
     mvwprintw(custom, 6, 2, "del  <num>");
     mvwprintw(custom, 7, 2, "edit <num> <new item>");
     mvwprintw(custom, 8, 2, "q = quit");
-    wrefresh(custom);
+    wnoutrefresh(custom);
 }
 
 /*==============================*/
@@ -71,57 +90,60 @@ void draw_todo(WINDOW *win_todo) {
         mvwprintw(win_todo, i+1, 2, "%d. %s", i+1, todos[i]);
     }
     pthread_mutex_unlock(&todo_lock);
-    wrefresh(win_todo);
+    wnoutrefresh(win_todo);
 }
 
 /*==============================*/
 /*     team 모드 전환 함수      */
 /*==============================*/
-int switch_to_team_mode(WINDOW *custom, WINDOW *todo_win) {
+int switch_to_team_mode(void) {
     char response[BUF_SIZE];
 
     // 1. 모드 설정
     strcpy(current_todo_file, TEAM_TODO_FILE);
 
-    // 2. 서버에 list 요청 → 응답 파싱
-    if (send_todo_command("list", response, sizeof(response)) != 0) {
-        show_error(custom, "%s", response);
+    // 2. 복제본을 열어 바로 보여 주고, 서버와의 동기화는 뒤에서
+    //    (서버가 없으면 복제본만으로 계속 = 오프라인 편집, 끝났을 때 안내)
+    int r = team_sync_start(response, sizeof(response), 1);
+    if (r == -2) {
+        show_error("%s", response);
         strcpy(current_todo_file, USER_TODO_FILE);
         return -1;
     }
 
-    // 3. 파싱 및 화면 갱신
-    parse_todo_list(response);
-    draw_todo(todo_win);
-
-    // 4. 사용자 안내
-    werase(custom);
-    box(custom,0,0);
-    mvwprintw(custom,1,2,"Switched to [team] mode");
-    wrefresh(custom);
-    napms(1000);
-    draw_custom_help(custom);
+    // 3. 사용자 안내
+    if (r < 0) todo_notice(2000, "Switched to [team] mode\n(offline: edits sync when the server is back)");
+    else todo_notice(1000, "Switched to [team] mode");
     return 0;
 }
 
+/*==============================*/
+/*  시작 시 모드 설정 (메시지 없음) */
+/*==============================*/
+// 설정 파일의 todo.mode 적용용: 서버가 없어도 team 복제본으로 시작,
+// 복제본 파일을 열 수 없을 때만 user 모드로 남고 -1
+int set_todo_mode(int is_team_mode) {
+    if (is_team_mode) {
+        strcpy(current_todo_file, TEAM_TODO_FILE);
+        if (team_sync_start(NULL, 0, 0) != -2) return 0;
+    }
+    strcpy(current_todo_file, USER_TODO_FILE);
+    load_todo();
+    return is_team_mode ? -1 : 0;
+}
+
 /*==============================*/
 /*      user 모드 전환 함수     */
 /*==============================*/
-void switch_to_user_mode(WINDOW *custom, WINDOW *todo_win) {
+void switch_to_user_mode(void) {
     // 1. 모드 설정
     strcpy(current_todo_file, USER_TODO_FILE);
 
-    // 2. 로컬 파일 로딩 및 화면 갱신
+    // 2. 로컬 파일 로딩 (목록 창은 todo_version을 보고 UI가 다시 그림)
     load_todo();
-    draw_todo(todo_win);
 
     // 3. 사용자 안내
-    werase(custom);
-    box(custom,0,0);
-    mvwprintw(custom,1,2,"Switched to [user] mode");
-    wrefresh(custom);
-    napms(1000);
-    draw_custom_help(custom);
+    todo_notice(1000, "Switched to [user] mode");
 }
 
 /*==============================*/
@@ -140,8 +162,29 @@ void load_todo() {
         line[strcspn(line, "\r\n")] = '\0';
         todos[todo_count++] = strdup(line);
     }
+    todo_version++;
     pthread_mutex_unlock(&todo_lock);
     fclose(fp);
+    stamp_todo_file();
+}
+
+/*==============================*/
+/*  파일이 바뀐 경우에만 재로딩  */
+/*==============================*/
+// CLI(./coshell add ...) 등 다른 프로세스가 user 파일을 고친 경우를 감지.
+// team 모드 목록은 복제본(todo_team.crdt)이 기준이므로 건드리지 않음
+int reload_todo_if_changed() {
+    if (strcmp(current_todo_file, USER_TODO_FILE) != 0) return 0;
+
+    struct stat st;
+    if (stat(current_todo_file, &st) != 0) return 0;
+    if (st.st_size == todo_file_size &&
+        st.st_mtim.tv_sec == todo_file_mtime.tv_sec &&
+        st.st_mtim.tv_nsec == todo_file_mtime.tv_nsec) {
+        return 0;
+    }
+    load_todo();
+    return 1;
 }
 
 /*==============================*/
@@ -152,12 +195,36 @@ void save_todo_to_file() {
     if (!fp) return;
     for (int i = 0; i < todo_count; i++) fprintf(fp, "%s\n", todos[i]);
     fclose(fp);
+    todo_version++;         // add/done/undo/del/edit 모두 여기서 저장됨
+    stamp_todo_file();
+    if (todo_saved_hook) todo_saved_hook();
+}
+
+void todo_set_saved_hook(void (*hook)(void)) {
+    todo_saved_hook = hook;
+}
+
+void todo_set_notice_hook(void (*hook)(int ms, const char *msg)) {
+    todo_notice_hook = hook;
+}
+
+void todo_notice(int ms, const char *msg) {
+    if (todo_notice_hook) todo_notice_hook(ms, msg);
+}
+
+// team 모드 편집은 todos[]를 직접 고치지 않고 복제본 연산으로 (todo_client.c)
+static int team_mode(void) {
+    return strcmp(current_todo_file, TEAM_TODO_FILE) == 0;
 }
 
 /*==============================*/
 /*        ToDo 추가 함수        */
 /*==============================*/
 void add_todo(const char *item) {
+    if (team_mode()) {
+        team_edit("add", 0, item);
+        return;
+    }
     pthread_mutex_lock(&todo_lock);
     if (todo_count < MAX_TODO) {
         char formatted[256];
@@ -172,6 +239,10 @@ void add_todo(const char *item) {
 /*      ToDo 완료 처리 함수     */
 /*==============================*/
 void done_todo(int index) {
+    if (team_mode()) {
+        team_edit("done", index, NULL);
+        return;
+    }
     pthread_mutex_lock(&todo_lock);
     if (index>=1 && index<=todo_count) {
         int i = index-1;
@@ -187,6 +258,10 @@ void done_todo(int index) {
 /*     ToDo 완료 취소 함수      */
 /*==============================*/
 void undo_todo(int index) {
+    if (team_mode()) {
+        team_edit("undo", index, NULL);
+        return;
+    }
     pthread_mutex_lock(&todo_lock);
     if (index>=1 && index<=todo_count) {
         int i = index-1;
@@ -202,12 +277,16 @@ void undo_todo(int index) {
 /*        ToDo 삭제 함수        */
 /*==============================*/
 void del_todo(int index) {
+    if (team_mode()) {
+        team_edit("del", index, NULL);
+        return;
+    }
     pthread_mutex_lock(&todo_lock);
     if (index>=1 && index<=todo_count) {
         int i = index-1;
         free(todos[i]);
         for (int j=i; j<todo_count-1; j++) todos[j] = todos[j+1];
-        todo_count--;
+        todos[--todo_count] = NULL;     // 당겨진 마지막 슬롯이 같은 포인터를 가리키지 않도록
         save_todo_to_file();
     }
     pthread_mutex_unlock(&todo_lock);
@@ -217,6 +296,10 @@ void del_todo(int index) {
 /*        ToDo 수정 함수        */
 /*==============================*/
 void edit_todo(int index, const char *new_item) {
+    if (team_mode()) {
+        team_edit("edit", index, new_item);
+        return;
+    }
     pthread_mutex_lock(&todo_lock);
     if (index>=1 && index<=todo_count) {
         int i = index-1;
@@ -230,3 +313,48 @@ void edit_todo(int index, const char *new_item) {
     pthread_mutex_unlock(&todo_lock);
 }
 
+/*==============================*/
+/*     명령 한 줄 실행 (CLI)     */
+/*==============================*/
+// "add <item>", "done <n>", "undo <n>", "del <n>", "edit <n> <item>", "list"
+// CLI가 직접 실행할 때와 데몬이 대신 실행할 때 같은 결과를 out에 씀
+int todo_exec(const char *line, FILE *out) {
+    char verb[8];
+    int n = 0, idx;
+    if (sscanf(line, "%7s %n", verb, &n) != 1) return -1;
+    const char *arg = line + n;
+
+    if (strcmp(verb, "add") == 0 && *arg) {
+        add_todo(arg);
+        fprintf(out, "Added: %s\n", arg);
+    }
+    else if (strcmp(verb, "done") == 0 && sscanf(arg, "%d", &idx) == 1) {
+        done_todo(idx);
+        fprintf(out, "Marked todo #%d as done.\n", idx);
+    }
+    else if (strcmp(verb, "undo") == 0 && sscanf(arg, "%d", &idx) == 1) {
+        undo_todo(idx);
+        fprintf(out, "Marked todo #%d as not done.\n", idx);
+    }
+    else if (strcmp(verb, "del") == 0 && sscanf(arg, "%d", &idx) == 1) {
+        if (idx < 1 || idx > todo_count) {
+            fprintf(out, "Invalid index.\n");
+            return 0;
+        }
+        del_todo(idx);
+        fprintf(out, "Deleted todo #%d\n", idx);
+    }
+    else if (strcmp(verb, "edit") == 0 && sscanf(arg, "%d %n", &idx, &n) == 1 && arg[n]) {
+        edit_todo(idx, arg + n);
+        fprintf(out, "Edited todo #%d: %s\n", idx, arg + n);
+    }
+    else if (strcmp(verb, "list") == 0) {
+        pthread_mutex_lock(&todo_lock);
+        for (int i = 0; i < todo_count; i++) fprintf(out, "%d. %s\n", i + 1, todos[i]);
+        pthread_mutex_unlock(&todo_lock);
+    }
+    else {
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,386 @@
+/*========================================*/
+/*          팀 ToDo CRDT 모듈              */
+/*  - RGA 순서 + LWW 레지스터 + 묘비       */
+/*  - 연산 로그 파일 / 버전 벡터 델타      */
+/*  (소켓을 쓰지 않음: 클라이언트와        */
+/*   팀 서버가 같이 사용)                  */
+/*========================================*/
+
+#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE                 // flock
+
+#include "todo_crdt.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/random.h>
+#include <time.h>
+
+static const CrdtId crdt_head = { 0, 0 };    // 맨 앞 (origin 없음)
+
+// id 순서: 시계가 크면 나중, 같으면 복제본 번호로 (모든 복제본에서 같은 결과)
+static int id_cmp(CrdtId a, CrdtId b) {
+    if (a.lamport != b.lamport) return a.lamport < b.lamport ? -1 : 1;
+    if (a.replica != b.replica) return a.replica < b.replica ? -1 : 1;
+    return 0;
+}
+
+static int grow(void** p, int* cap, int need, size_t elem) {
+    if (need <= *cap) return 0;
+    int n = *cap ? *cap * 2 : 64;
+    while (n < need) n *= 2;
+    void* q = realloc(*p, elem * (size_t)n);
+    if (!q) return -1;
+    *p = q;
+    *cap = n;
+    return 0;
+}
+
+static CrdtItem* find_item(Crdt* c, CrdtId id) {
+    // 최근 항목을 가장 자주 고치므로 뒤에서부터
+    for (int i = c->nitems - 1; i >= 0; i--)
+        if (id_cmp(c->items[i].id, id) == 0) return &c->items[i];
+    return NULL;
+}
+
+/*==============================*/
+/*         버전 벡터             */
+/*==============================*/
+uint64_t crdt_seen_in(const CrdtSeen* seen, int nseen, uint64_t replica) {
+    for (int i = 0; i < nseen; i++)
+        if (seen[i].replica == replica) return seen[i].seen;
+    return 0;
+}
+
+static int note_seen(Crdt* c, CrdtId id) {
+    for (int i = 0; i < c->nseen; i++) {
+        if (c->seen[i].replica != id.replica) continue;
+        if (id.lamport > c->seen[i].seen) c->seen[i].seen = id.lamport;
+        return 0;
+    }
+    if (grow((void**)&c->seen, &c->cap_seen, c->nseen + 1, sizeof(CrdtSeen)) < 0) return -1;
+    c->seen[c->nseen++] = (CrdtSeen){ id.replica, id.lamport };
+    return 0;
+}
+
+/*==============================*/
+/*        연산 읽기 / 쓰기        */
+/*==============================*/
+int crdt_parse_op(const char* line, CrdtOp* op) {
+    memset(op, 0, sizeof(*op));
+    char kind;
+    int n = 0;
+    if (sscanf(line, "%c %" SCNu64 " %" SCNx64 " %" SCNu64 " %" SCNx64 "%n", &kind,
+               &op->id.lamport, &op->id.replica, &op->target.lamport, &op->target.replica, &n) != 5)
+        return -1;
+    if (op->id.lamport == 0) return -1;
+    const char* rest = line + n;
+    if (*rest == ' ') rest++;
+    op->kind = kind;
+    switch (kind) {
+    case 'I':
+    case 'T':
+        op->text = strdup(rest);
+        return op->text ? 0 : -1;
+    case 'S':
+        if (sscanf(rest, "%d", &op->done) != 1) return -1;
+        op->done = op->done != 0;
+        return 0;
+    case 'D':
+        return 0;
+    }
+    return -1;
+}
+
+void crdt_op_free(CrdtOp* op) {
+    free(op->text);
+    op->text = NULL;
+}
+
+void crdt_write_op(FILE* fp, const CrdtOp* op) {
+    fprintf(fp, "%c %" PRIu64 " %" PRIx64 " %" PRIu64 " %" PRIx64, op->kind,
+            op->id.lamport, op->id.replica, op->target.lamport, op->target.replica);
+    if (op->kind == 'S') fprintf(fp, " %d", op->done);
+    else if (op->text) fprintf(fp, " %s", op->text);
+    fputc('\n', fp);
+}
+
+/*==============================*/
+/*           적용               */
+/*==============================*/
+// 상태만 바꿈 (로그/파일은 crdt_apply에서)
+static void apply_state(Crdt* c, const CrdtOp* op) {
+    if (op->kind == 'I') {
+        if (find_item(c, op->id)) return;
+        if (grow((void**)&c->items, &c->cap_items, c->nitems + 1, sizeof(CrdtItem)) < 0) return;
+        char* text = strdup(op->text ? op->text : "");
+        if (!text) return;
+        c->items[c->nitems++] = (CrdtItem){
+            .id = op->id, .origin = op->target, .text = text,
+            .text_ts = op->id, .done_ts = op->id,
+        };
+        c->dirty = 1;
+        return;
+    }
+    // 대상은 crdt_apply가 확인함 (없으면 미뤄 둠)
+    CrdtItem* it = find_item(c, op->target);
+    if (!it) return;
+    if (op->kind == 'T' && id_cmp(op->id, it->text_ts) > 0) {
+        char* text = strdup(op->text ? op->text : "");
+        if (!text) return;
+        free(it->text);
+        it->text = text;
+        it->text_ts = op->id;
+    }
+    else if (op->kind == 'S' && id_cmp(op->id, it->done_ts) > 0) {
+        it->done = op->done;
+        it->done_ts = op->id;
+    }
+    else if (op->kind == 'D') {
+        it->deleted = 1;
+    }
+    c->dirty = 1;
+}
+
+// 대상(T/S/D) 또는 origin(I)이 있어야 적용 가능
+static int deps_ready(Crdt* c, const CrdtOp* op) {
+    if (op->kind == 'I' && id_cmp(op->target, crdt_head) == 0) return 1;
+    return find_item(c, op->target) != NULL;
+}
+
+// pending[0..before) 에 같은 복제본의 연산이 있는지 (있으면 그 뒤 연산도 순서대로 기다림)
+static int pending_from(const Crdt* c, uint64_t replica, int before) {
+    for (int i = 0; i < before; i++)
+        if (c->pending[i].id.replica == replica) return 1;
+    return 0;
+}
+
+static int is_pending(const Crdt* c, CrdtId id) {
+    for (int i = 0; i < c->npending; i++)
+        if (id_cmp(c->pending[i].id, id) == 0) return 1;
+    return 0;
+}
+
+// 로그에 넣고 적용 (op의 text는 로그가 가져감). 반환값: 0 성공, -1 메모리 부족
+static int commit_op(Crdt* c, const CrdtOp* op) {
+    if (grow((void**)&c->log, &c->cap_log, c->nlog + 1, sizeof(CrdtOp)) < 0) return -1;
+    c->log[c->nlog++] = *op;
+    note_seen(c, op->id);
+    if (op->id.lamport > c->clock) c->clock = op->id.lamport;
+    apply_state(c, op);
+    if (c->fp) crdt_write_op(c->fp, op);
+    return 0;
+}
+
+int crdt_apply(Crdt* c, const CrdtOp* op) {
+    if (op->id.lamport <= crdt_seen_in(c->seen, c->nseen, op->id.replica) || is_pending(c, op->id)) return 0;
+    CrdtOp copy = *op;
+    if (op->text && !(copy.text = strdup(op->text))) return 0;
+
+    // 버전 벡터는 복제본마다 "여기까지 모두 받음"이므로, 미룬 연산을 건너뛰어 올라가지 않게
+    // 같은 복제본의 뒤 연산도 함께 미룸 (그래야 상대가 빠진 연산을 다시 보내 줌)
+    if (!deps_ready(c, op) || pending_from(c, op->id.replica, c->npending)) {
+        if (c->npending == CRDT_MAX_PENDING ||
+            grow((void**)&c->pending, &c->cap_pending, c->npending + 1, sizeof(CrdtOp)) < 0) {
+            free(copy.text);
+            return 0;
+        }
+        c->pending[c->npending++] = copy;
+        return 0;
+    }
+    if (commit_op(c, &copy) < 0) {
+        free(copy.text);
+        return 0;
+    }
+
+    // 방금 들어온 항목을 기다리던 연산 (적용할 때마다 처음부터 다시 봄)
+    for (int i = 0; i < c->npending; ) {
+        CrdtOp ready = c->pending[i];
+        if (!deps_ready(c, &ready) || pending_from(c, ready.id.replica, i)) {
+            i++;
+            continue;
+        }
+        memmove(&c->pending[i], &c->pending[i + 1], sizeof(CrdtOp) * (size_t)(c->npending - i - 1));
+        c->npending--;
+        if (commit_op(c, &ready) < 0) free(ready.text);
+        i = 0;
+    }
+    return 1;
+}
+
+void crdt_flush(Crdt* c) {
+    if (c->fp) fflush(c->fp);
+}
+
+/*==============================*/
+/*        화면 순서 (RGA)         */
+/*==============================*/
+// origin 트리를 전위 순회: 같은 origin의 자식은 id가 큰 쪽부터
+static void build_order(Crdt* c) {
+    c->dirty = 0;
+    c->norder = 0;
+    free(c->order);
+    c->order = malloc(sizeof(int) * (size_t)(c->nitems ? c->nitems : 1));
+    int* stack = malloc(sizeof(int) * (size_t)(c->nitems ? c->nitems : 1));
+    int* kids = malloc(sizeof(int) * (size_t)(c->nitems ? c->nitems : 1));
+    if (!c->order || !stack || !kids) {
+        free(stack);
+        free(kids);
+        return;
+    }
+    int top = 0;
+    for (int parent = -1; ; ) {
+        // parent의 자식들을 id 오름차순으로 쌓으면 가장 큰 id가 먼저 나옴
+        CrdtId pid = parent < 0 ? crdt_head : c->items[parent].id;
+        int nk = 0;
+        for (int i = 0; i < c->nitems; i++)
+            if (id_cmp(c->items[i].origin, pid) == 0) kids[nk++] = i;
+        for (int a = 1; a < nk; a++) {
+            int k = kids[a], b = a;
+            for (; b > 0 && id_cmp(c->items[kids[b - 1]].id, c->items[k].id) > 0; b--) kids[b] = kids[b - 1];
+            kids[b] = k;
+        }
+        for (int i = 0; i < nk; i++) stack[top++] = kids[i];
+        if (top == 0) break;
+        parent = stack[--top];
+        if (!c->items[parent].deleted) c->order[c->norder++] = parent;
+    }
+    free(stack);
+    free(kids);
+}
+
+int crdt_count(Crdt* c) {
+    if (c->dirty) build_order(c);
+    return c->norder;
+}
+
+const CrdtItem* crdt_item(Crdt* c, int i) {
+    if (i < 0 || i >= crdt_count(c)) return NULL;
+    return &c->items[c->order[i]];
+}
+
+/*==============================*/
+/*          로컬 편집            */
+/*==============================*/
+static int local_op(Crdt* c, CrdtOp* op) {
+    op->id = (CrdtId){ ++c->clock, c->replica };
+    int r = crdt_apply(c, op) ? 0 : -1;
+    crdt_flush(c);
+    return r;
+}
+
+int crdt_add(Crdt* c, const char* text) {
+    int n = crdt_count(c);
+    CrdtOp op = { .kind = 'I', .target = n ? c->items[c->order[n - 1]].id : crdt_head, .text = (char*)text };
+    return local_op(c, &op);
+}
+
+int crdt_set_text(Crdt* c, int index, const char* text) {
+    const CrdtItem* it = crdt_item(c, index - 1);
+    if (!it) return -1;
+    CrdtOp op = { .kind = 'T', .target = it->id, .text = (char*)text };
+    return local_op(c, &op);
+}
+
+int crdt_set_done(Crdt* c, int index, int done) {
+    const CrdtItem* it = crdt_item(c, index - 1);
+    if (!it) return -1;
+    if (it->done == done) return 0;
+    CrdtOp op = { .kind = 'S', .target = it->id, .done = done };
+    return local_op(c, &op);
+}
+
+int crdt_delete(Crdt* c, int index) {
+    const CrdtItem* it = crdt_item(c, index - 1);
+    if (!it) return -1;
+    CrdtOp op = { .kind = 'D', .target = it->id };
+    return local_op(c, &op);
+}
+
+/*==============================*/
+/*          델타 동기화          */
+/*==============================*/
+void crdt_write_seen(FILE* fp, const Crdt* c) {
+    for (int i = 0; i < c->nseen; i++)
+        fprintf(fp, "V %" PRIx64 " %" PRIu64 "\n", c->seen[i].replica, c->seen[i].seen);
+}
+
+// 로그가 인과 순서이므로 걸러 낸 연산도 그대로 인과 순서
+int crdt_write_delta(FILE* fp, const Crdt* c, const CrdtSeen* seen, int nseen) {
+    int n = 0;
+    for (int i = 0; i < c->nlog; i++) {
+        const CrdtOp* op = &c->log[i];
+        if (op->id.lamport <= crdt_seen_in(seen, nseen, op->id.replica)) continue;
+        crdt_write_op(fp, op);
+        n++;
+    }
+    return n;
+}
+
+/*==============================*/
+/*        파일 열기 / 닫기        */
+/*==============================*/
+// 파일: "R <복제본>" 한 줄, 그 뒤 적용한 연산 줄 (예전 "A <lamport>" 줄은 건너뜀)
+// 한 파일의 복제본 번호는 한 프로세스만 씀: 같은 디렉터리의 다른 UI가 파일을 잡고 있으면
+// 내용만 읽고 이 프로세스만의 새 번호로 (같은 id의 서로 다른 연산이 생기지 않도록)
+int crdt_open(Crdt* c, const char* path) {
+    memset(c, 0, sizeof(*c));
+    int fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+    int shared = flock(fd, LOCK_EX | LOCK_NB) < 0;
+    FILE* fp = (shared && errno != EWOULDBLOCK) ? NULL : fdopen(fd, "a+");
+    if (!fp) {
+        close(fd);
+        return -1;
+    }
+    rewind(fp);
+    char* line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+    while ((len = getline(&line, &cap, fp)) > 0) {
+        if (line[len - 1] == '\n') line[--len] = '\0';
+        CrdtOp op;
+        if (line[0] == 'R') sscanf(line, "R %" SCNx64, &c->replica);
+        else if (crdt_parse_op(line, &op) == 0) {
+            crdt_apply(c, &op);
+            crdt_op_free(&op);
+        }
+    }
+    free(line);
+    if (shared) {
+        fclose(fp);             // 파일은 잡은 프로세스 몫 (이 복제본은 메모리에만)
+        c->replica = 0;
+    }
+    else {
+        c->fp = fp;             // 닫을 때까지 잠금 유지 (crdt_close)
+    }
+    int fresh = c->replica == 0;
+    while (c->replica == 0) {
+        if (getrandom(&c->replica, sizeof(c->replica), 0) != (ssize_t)sizeof(c->replica))
+            c->replica = (uint64_t)time(NULL) * 0x9E3779B97F4A7C15ull;
+    }
+    if (fresh && c->fp) {
+        fprintf(c->fp, "R %" PRIx64 "\n", c->replica);
+        fflush(c->fp);
+    }
+    c->dirty = 1;
+    return shared;
+}
+
+void crdt_close(Crdt* c) {
+    if (c->fp) fclose(c->fp);
+    for (int i = 0; i < c->nitems; i++) free(c->items[i].text);
+    for (int i = 0; i < c->nlog; i++) free(c->log[i].text);
+    for (int i = 0; i < c->npending; i++) free(c->pending[i].text);
+    free(c->items);
+    free(c->log);
+    free(c->pending);
+    free(c->seen);
+    free(c->order);
+    memset(c, 0, sizeof(*c));
+}
@@ -0,0 +1,129 @@
+#ifndef TODO_CRDT_H
+#define TODO_CRDT_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+/*==============================*/
+/*      팀 ToDo CRDT (복제본)     */
+/*==============================*/
+/*
+ * 팀 목록을 복제본마다 따로 고치고 연산(op)만 주고받아도, 받는 순서와 관계없이
+ * 모두 같은 목록으로 수렴하게 하는 자료구조입니다.
+ * - 순서: RGA 방식. 항목마다 "삽입할 때 바로 왼쪽에 있던 항목(origin)"을 기억하고,
+ *   같은 origin 뒤에 동시에 끼어든 항목들은 id가 큰(나중) 쪽이 앞에 옴
+ * - 내용/완료 여부: LWW 레지스터 (id가 가장 큰 쓰기가 이김)
+ * - 삭제: 묘비(tombstone) 표시만 하고 항목은 남김 (다른 항목의 origin일 수 있음)
+ * - id = (Lamport 시계, 복제본 번호): 복제본마다 늘어나므로 복제본별 "어디까지 받았나"
+ *   (버전 벡터)만 주고받으면 상대에게 없는 연산만 골라 보낼 수 있음
+ *
+ * 연산 한 줄 형식 (파일과 통신 공용, id/대상은 "<lamport> <복제본 16진수>"):
+ *   I <id> <origin> <text>     항목 삽입 (origin "0 0" = 맨 앞)
+ *   T <id> <대상> <text>       내용 변경
+ *   S <id> <대상> <0|1>        완료 여부
+ *   D <id> <대상>              삭제
+ * 대상(T/S/D)이나 origin(I)이 아직 없는 연산은 로그와 버전 벡터에 넣지 않고 미뤄 두었다가
+ * 그 항목이 들어오면 적용합니다. (서버 파일이 지워진 뒤 받은 편집이 고아로 남지 않도록)
+ */
+
+#define CRDT_MAX_PENDING 1024       // 미뤄 둘 수 있는 연산 수 (넘으면 버리고 다음 동기화 때 다시 받음)
+
+typedef struct {
+    uint64_t lamport;
+    uint64_t replica;
+} CrdtId;
+
+typedef struct {
+    char     kind;          // 'I', 'T', 'S', 'D'
+    CrdtId   id;
+    CrdtId   target;        // I: origin, 나머지: 대상 항목
+    int      done;          // S
+    char*    text;          // I, T (그 외 NULL)
+} CrdtOp;
+
+typedef struct {
+    CrdtId   id;
+    CrdtId   origin;
+    char*    text;
+    CrdtId   text_ts;
+    int      done;
+    CrdtId   done_ts;
+    int      deleted;
+} CrdtItem;
+
+// 버전 벡터 한 칸: replica의 연산을 lamport seen까지 받았음
+typedef struct {
+    uint64_t replica;
+    uint64_t seen;
+} CrdtSeen;
+
+typedef struct {
+    uint64_t   replica;     // 이 복제본 번호 (처음 만들 때 무작위)
+    uint64_t   clock;       // Lamport 시계 (받은 연산의 시계보다 항상 크게)
+
+    CrdtItem*  items;       // 삽입 순서 (화면 순서는 crdt_visible)
+    int        nitems, cap_items;
+    CrdtOp*    log;         // 받은/만든 연산 전부 (인과 순서), 델타 계산과 저장용
+    int        nlog, cap_log;
+    CrdtSeen*  seen;        // 버전 벡터 (적용한 연산만)
+    int        nseen, cap_seen;
+    CrdtOp*    pending;     // 대상/origin이 아직 없어 미룬 연산 (받은 순서)
+    int        npending, cap_pending;
+
+    int*       order;       // 보이는 항목의 items 인덱스 (dirty면 다시 계산)
+    int        norder;
+    int        dirty;
+    FILE*      fp;          // 연산 로그 파일 (덧붙이기만, 다른 프로세스가 잡고 있으면 NULL)
+} Crdt;
+
+/**
+ * 연산 로그 파일을 읽어 복제본을 만듭니다. 파일이 없으면 새 복제본 번호로 새로 만듭니다.
+ * 파일은 flock으로 잡아 두며, 다른 프로세스가 이미 잡고 있으면 내용만 읽고
+ * 새 복제본 번호로 메모리에서만 이어 갑니다. (편집은 동기화로 서버를 거쳐 그 파일에 들어감)
+ * 반환값: 0 성공, 1 다른 프로세스가 파일을 씀 (메모리 복제본), -1 파일을 열 수 없음
+ */
+int  crdt_open(Crdt* c, const char* path);
+void crdt_close(Crdt* c);
+
+/** 연산 한 줄 해석 (text는 새로 할당, crdt_op_free로 해제). 반환값: 0 성공, -1 형식 오류 */
+int  crdt_parse_op(const char* line, CrdtOp* op);
+void crdt_op_free(CrdtOp* op);
+void crdt_write_op(FILE* fp, const CrdtOp* op);
+
+/**
+ * 받은 연산을 적용하고 로그에 남깁니다. (이미 받은 연산이면 무시)
+ * 대상/origin이 없거나 같은 복제본의 앞선 연산이 미뤄져 있으면 미뤄 두고,
+ * 연산을 적용할 때마다 미룬 연산 중 이제 적용할 수 있는 것을 함께 적용합니다.
+ * 반환값: 1 새 연산을 적용함, 0 중복이거나 미룸
+ */
+int  crdt_apply(Crdt* c, const CrdtOp* op);
+
+/** 로그 파일에 쌓인 쓰기를 내보냄 (연산 묶음을 적용한 뒤 한 번) */
+void crdt_flush(Crdt* c);
+
+/*==============================*/
+/*     로컬 편집 (index: 1부터)   */
+/*==============================*/
+// 반환값: 0 성공, -1 잘못된 번호 / 메모리 부족
+int  crdt_add(Crdt* c, const char* text);   // 맨 뒤에 추가
+int  crdt_set_text(Crdt* c, int index, const char* text);
+int  crdt_set_done(Crdt* c, int index, int done);
+int  crdt_delete(Crdt* c, int index);
+
+/** 화면 순서의 보이는 항목 수와 i번째(0부터) 항목 */
+int  crdt_count(Crdt* c);
+const CrdtItem* crdt_item(Crdt* c, int i);
+
+/*==============================*/
+/*          델타 동기화          */
+/*==============================*/
+/** 버전 벡터에서 replica를 어디까지 받았는지 (없으면 0) */
+uint64_t crdt_seen_in(const CrdtSeen* seen, int nseen, uint64_t replica);
+
+/** 내 버전 벡터를 "V <복제본> <lamport>" 줄들로 씀 */
+void crdt_write_seen(FILE* fp, const Crdt* c);
+
+/** 상대 버전 벡터에 없는 연산만 씀. 반환값: 쓴 연산 수 */
+int  crdt_write_delta(FILE* fp, const Crdt* c, const CrdtSeen* seen, int nseen);
+
+#endif // TODO_CRDT_H
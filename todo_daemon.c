@@ -0,0 +1,349 @@
+/*========================================*/
+/*        사용자별 ToDo 데몬 모듈          */
+/*  - todo_user.txt 를 메모리에 들고 명령  */
+/*    처리, 바뀌면 watch 중인 UI에 전달    */
+/*  - CLI/UI 쪽 접속 함수                  */
+/*========================================*/
+
+#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE                 // struct ucred
+
+#include "todo_daemon.h"
+#include "todo.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define TODO_DAEMON_LINE 1024       // 명령 한 줄 최대 길이
+
+typedef struct {
+    int    fd;
+    int    watch;               // 1이면 UI: 목록이 바뀔 때마다 받음
+    int    dead;                // 닫힘 (이번 회차가 끝나면 테이블에서 뺌)
+    size_t have;
+    char   buf[TODO_DAEMON_LINE];
+} TododClient;
+
+static TododClient clients[TODO_DAEMON_MAX_CLIENTS];
+static int         nclients;
+
+/*==============================*/
+/*         소켓 이름 / 접속       */
+/*==============================*/
+// 사용자와 디렉터리마다 하나: "coshell-todod-<uid>-<디렉터리 경로 FNV-1a>" (추상 이름)
+static socklen_t todod_addr(struct sockaddr_un* addr) {
+    char cwd[4096];
+    uint32_t h = 2166136261u;
+    if (getcwd(cwd, sizeof(cwd)))
+        for (const char* p = cwd; *p; p++) h = (h ^ (uint8_t)*p) * 16777619u;
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    int n = snprintf(addr->sun_path + 1, sizeof(addr->sun_path) - 1,
+                     "coshell-todod-%u-%08x", (unsigned)getuid(), h);
+    return (socklen_t)(offsetof(struct sockaddr_un, sun_path) + 1 + (size_t)n);
+}
+
+static int todod_connect(void) {
+    struct sockaddr_un addr;
+    socklen_t len = todod_addr(&addr);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr*)&addr, len) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int send_all(int fd, const char* p, size_t len) {
+    while (len > 0) {
+        ssize_t w = send(fd, p, len, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return -1;
+        p += w;
+        len -= (size_t)w;
+    }
+    return 0;
+}
+
+/*==============================*/
+/*          데몬 (서버)          */
+/*==============================*/
+// 회차 도중에는 표시만 (poll 배열과 테이블 순서가 어긋나지 않게)
+static void client_close(TododClient* c) {
+    if (c->dead) return;
+    close(c->fd);
+    c->dead = 1;
+}
+
+static void clients_reap(void) {
+    for (int i = nclients - 1; i >= 0; i--)
+        if (clients[i].dead) clients[i] = clients[--nclients];
+}
+
+// UI에 보내는 목록: "list <n>\n" + 항목 n줄
+static char* list_frame(size_t* len) {
+    char* frame = NULL;
+    FILE* fp = open_memstream(&frame, len);
+    if (!fp) return NULL;
+    fprintf(fp, "list %d\n", todo_count);
+    for (int i = 0; i < todo_count; i++) fprintf(fp, "%s\n", todos[i]);
+    fclose(fp);
+    return frame;
+}
+
+// watch 중인 UI 모두에게 (except: 방금 고친 UI는 빼고)
+// 따라오지 못하는 UI(소켓 버퍼가 가득 참)는 끊음 → 그 UI는 파일 감시로 돌아감
+static void push_list(int except) {
+    size_t len;
+    char* frame = list_frame(&len);
+    if (!frame) return;
+    for (int i = 0; i < nclients; i++) {
+        TododClient* c = &clients[i];
+        if (!c->watch || c->dead || c->fd == except) continue;
+        if (send(c->fd, frame, len, MSG_NOSIGNAL | MSG_DONTWAIT) != (ssize_t)len) client_close(c);
+    }
+    free(frame);
+}
+
+// 다른 프로세스(데몬을 모르는 예전 CLI, 편집기 등)가 파일을 고쳤으면 다시 읽고 알림
+static void reload_and_push(int except) {
+    if (reload_todo_if_changed()) push_list(except);
+}
+
+// 명령 한 줄 처리. 반환값: 1 이 연결을 닫음, 2 데몬 종료, 0 계속
+static int handle_line(TododClient* c, const char* line) {
+    if (strcmp(line, "watch") == 0) {
+        reload_and_push(-1);
+        c->watch = 1;
+        size_t len;
+        char* frame = list_frame(&len);
+        int ok = frame && send_all(c->fd, frame, len) == 0;
+        free(frame);
+        return ok ? 0 : 1;
+    }
+    if (strcmp(line, "sync") == 0) {
+        reload_and_push(c->fd);
+        return 0;
+    }
+    if (c->watch) return 0;             // UI 연결은 watch/sync만
+
+    char* reply = NULL;
+    size_t len = 0;
+    FILE* out = open_memstream(&reply, &len);
+    if (!out) return 1;
+    int ret = 1;
+    if (strcmp(line, "stop") == 0) {
+        fprintf(out, "ToDo daemon (pid %d) stopped\n", (int)getpid());
+        ret = 2;
+    }
+    else if (strcmp(line, "status") == 0) {
+        char cwd[4096];
+        int watchers = 0;
+        for (int i = 0; i < nclients; i++) watchers += clients[i].watch && !clients[i].dead;
+        fprintf(out, "ToDo daemon running (pid %d): %s/%s, %d item%s, %d UI%s watching\n",
+                (int)getpid(), getcwd(cwd, sizeof(cwd)) ? cwd : "?", USER_TODO_FILE,
+                todo_count, todo_count == 1 ? "" : "s", watchers, watchers == 1 ? "" : "s");
+    }
+    else {
+        reload_and_push(-1);
+        unsigned long v = todo_version;
+        if (todo_exec(line, out) < 0) fprintf(out, "Unknown CLI command.\n");
+        if (todo_version != v) push_list(-1);
+    }
+    fclose(out);
+    send_all(c->fd, reply, len);        // 응답 뒤 연결을 닫아 CLI가 EOF로 끝을 앎
+    free(reply);
+    return ret;
+}
+
+// 반환값: 1 이 연결을 닫음, 2 데몬 종료, 0 계속
+static int client_read(TododClient* c) {
+    ssize_t r = recv(c->fd, c->buf + c->have, sizeof(c->buf) - 1 - c->have, 0);
+    if (r < 0 && (errno == EAGAIN || errno == EINTR)) return 0;
+    if (r <= 0) return 1;
+    c->have += (size_t)r;
+    char* start = c->buf;
+    char* nl;
+    while ((nl = memchr(start, '\n', c->have - (size_t)(start - c->buf))) != NULL) {
+        *nl = '\0';
+        int ret = handle_line(c, start);
+        if (ret) return ret;
+        start = nl + 1;
+    }
+    c->have -= (size_t)(start - c->buf);
+    memmove(c->buf, start, c->have);
+    return c->have == sizeof(c->buf) - 1 ? 1 : 0;     // 줄이 너무 김
+}
+
+static void todod_accept(int lfd) {
+    int fd;
+    while ((fd = accept4(lfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        // 추상 이름은 파일 권한이 없으므로 같은 사용자인지 직접 확인
+        struct ucred cred;
+        socklen_t len = sizeof(cred);
+        if (nclients == TODO_DAEMON_MAX_CLIENTS ||
+            getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0 || cred.uid != getuid()) {
+            close(fd);
+            continue;
+        }
+        clients[nclients++] = (TododClient){ .fd = fd };
+    }
+}
+
+static void todod_loop(int lfd) {
+    struct pollfd pfds[TODO_DAEMON_MAX_CLIENTS + 1];
+    while (1) {
+        pfds[0] = (struct pollfd){ .fd = lfd, .events = POLLIN };
+        for (int i = 0; i < nclients; i++) pfds[i + 1] = (struct pollfd){ .fd = clients[i].fd, .events = POLLIN };
+        int n = nclients;
+        int ready = poll(pfds, (nfds_t)n + 1, TODO_DAEMON_TICK_MS);
+        if (ready < 0 && errno != EINTR) return;
+        if (ready <= 0) reload_and_push(-1);
+        for (int i = 0; i < n && ready > 0; i++) {
+            if (!pfds[i + 1].revents || clients[i].dead) continue;
+            int ret = client_read(&clients[i]);
+            if (ret == 2) return;
+            if (ret) client_close(&clients[i]);
+        }
+        clients_reap();
+        if (ready > 0 && pfds[0].revents) todod_accept(lfd);
+    }
+}
+
+static int todod_start(void) {
+    struct sockaddr_un addr;
+    socklen_t len = todod_addr(&addr);
+    int lfd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (lfd < 0 || bind(lfd, (struct sockaddr*)&addr, len) < 0 || listen(lfd, SOMAXCONN) < 0) {
+        if (errno == EADDRINUSE) fprintf(stderr, "ToDo daemon is already running for this directory.\n");
+        else perror("todo daemon");
+        if (lfd >= 0) close(lfd);
+        return 1;
+    }
+    load_todo();
+
+    // 소켓을 연 뒤에 떠나므로, 이 명령이 끝나면 바로 CLI가 데몬을 씀
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return 1;
+    }
+    if (pid > 0) {
+        char cwd[4096];
+        printf("ToDo daemon started (pid %d): %s/%s\n", (int)pid,
+               getcwd(cwd, sizeof(cwd)) ? cwd : "?", USER_TODO_FILE);
+        return 0;
+    }
+    setsid();
+    signal(SIGHUP, SIG_IGN);
+    int null = open("/dev/null", O_RDWR);
+    if (null >= 0) {
+        dup2(null, STDIN_FILENO);
+        dup2(null, STDOUT_FILENO);
+        dup2(null, STDERR_FILENO);
+        if (null > STDERR_FILENO) close(null);
+    }
+    todod_loop(lfd);
+    _exit(0);
+}
+
+int todo_daemon_main(int argc, char* argv[]) {
+    if (argc == 0) return todod_start();
+    if (argc == 1 && (strcmp(argv[0], "stop") == 0 || strcmp(argv[0], "status") == 0)) {
+        if (todo_daemon_request(argv[0], stdout) == 0) return 0;
+        printf("No ToDo daemon running for this directory.\n");
+        return strcmp(argv[0], "stop") == 0 ? 1 : 3;
+    }
+    fprintf(stderr, "Usage: coshell daemon [stop|status]\n");
+    return 2;
+}
+
+/*==============================*/
+/*          CLI / UI 쪽          */
+/*==============================*/
+int todo_daemon_request(const char* line, FILE* out) {
+    int fd = todod_connect();
+    if (fd < 0) return -1;
+    char buf[4096];
+    snprintf(buf, sizeof(buf), "%s\n", line);
+    if (send_all(fd, buf, strlen(buf)) < 0) {
+        close(fd);
+        return -1;
+    }
+    // 데몬에 명령이 들어갔으므로 여기서부터는 실패해도 직접 처리하지 않음 (두 번 실행 방지)
+    ssize_t r;
+    while ((r = recv(fd, buf, sizeof(buf), 0)) > 0 || (r < 0 && errno == EINTR))
+        if (r > 0) fwrite(buf, 1, (size_t)r, out);
+    close(fd);
+    return 0;
+}
+
+int todo_daemon_watch(void) {
+    int fd = todod_connect();
+    if (fd < 0) return -1;
+    if (send_all(fd, "watch\n", 6) < 0) {
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+// watch 연결은 프로세스에 하나이므로 받는 버퍼도 하나
+// (마지막 1바이트는 받지 않고 비워 둠: apply_frame이 목록 끝에 잠깐 '\0'을 씀)
+#define WATCH_MAX (MAX_TODO * 260 + 64)
+static char   watch_buf[WATCH_MAX + 1];
+static size_t watch_have;
+
+// 완성된 목록 하나를 반영하고 그 길이를 돌려줌 (아직 덜 왔으면 0)
+static size_t apply_frame(char* p, size_t have) {
+    char* nl = memchr(p, '\n', have);
+    int n;
+    if (!nl || sscanf(p, "list %d", &n) != 1) return 0;
+    char* body = nl + 1;
+    char* end = body;
+    for (int i = 0; i < n; i++) {
+        end = memchr(end, '\n', have - (size_t)(end - p));
+        if (!end) return 0;
+        end++;
+    }
+    // team 모드 목록은 팀 서버가 기준이므로 user 모드일 때만
+    if (strcmp(current_todo_file, USER_TODO_FILE) == 0) {
+        char saved = *end;
+        *end = '\0';
+        parse_todo_list(body);
+        *end = saved;
+    }
+    return (size_t)(end - p);
+}
+
+int todo_daemon_read(int fd) {
+    while (1) {
+        if (watch_have == WATCH_MAX) break;     // 한 목록이 버퍼보다 큼: 데몬과 어긋남
+        ssize_t r = recv(fd, watch_buf + watch_have, WATCH_MAX - watch_have, 0);
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0 && errno == EAGAIN) return 0;
+        if (r <= 0) break;
+        watch_have += (size_t)r;
+        size_t used, off = 0;
+        while ((used = apply_frame(watch_buf + off, watch_have - off)) > 0) off += used;
+        watch_have -= off;
+        memmove(watch_buf, watch_buf + off, watch_have);
+    }
+    watch_have = 0;
+    return -1;
+}
+
+void todo_daemon_sync(int fd) {
+    send(fd, "sync\n", 5, MSG_NOSIGNAL | MSG_DONTWAIT);
+}
@@ -0,0 +1,51 @@
+#ifndef TODO_DAEMON_H
+#define TODO_DAEMON_H
+
+#include <stdio.h>
+
+/*==============================*/
+/*   사용자별 ToDo 데몬 (todod)  */
+/*==============================*/
+/*
+ * "./coshell daemon" 으로 띄우면 실행한 디렉터리의 todo_user.txt 를 메모리에 들고
+ * 유닉스 소켓(추상 이름, 사용자+디렉터리마다 하나)으로 명령을 받습니다.
+ * - CLI(./coshell add|done|undo|del|edit|list)는 데몬이 있으면 명령 한 줄을 넘기고
+ *   응답만 출력 (파일을 읽고 쓰는 일 없이 소켓 왕복 한 번), 없으면 예전처럼 파일 직접 처리
+ * - UI는 "watch" 연결을 열어 두고, 목록이 바뀔 때마다 데몬이 보내는 전체 목록을 바로 반영
+ *   (UI에서 고친 내용은 "sync" 로 알려 다른 UI에도 바로 전달)
+ * - 변경은 매번 파일에도 저장하므로 데몬이 없어져도 그대로 이어서 쓸 수 있음
+ */
+
+#define TODO_DAEMON_MAX_CLIENTS 64  // 동시에 붙을 수 있는 UI + CLI 연결 수
+#define TODO_DAEMON_TICK_MS     1000    // 다른 프로세스가 파일을 직접 고쳤는지 보는 간격
+
+/**
+ * "./coshell daemon [stop|status]" 처리
+ * - 인자 없음: 소켓을 열고 백그라운드로 떠남 (이미 떠 있으면 1)
+ * - stop: 실행 중인 데몬을 끝냄, status: 실행 여부 출력
+ * 반환값: 프로세스 종료 코드
+ */
+int todo_daemon_main(int argc, char* argv[]);
+
+/**
+ * CLI 명령 한 줄을 데몬에 보내고 응답을 out에 씁니다.
+ * 반환값: 0 데몬이 처리함, -1 데몬 없음 (호출 측이 파일로 직접 처리)
+ */
+int todo_daemon_request(const char* line, FILE* out);
+
+/**
+ * UI: 목록 변경 알림을 받을 연결을 엽니다. (곧바로 현재 목록이 옴)
+ * 반환값: 이벤트 루프에 등록할 fd, 데몬이 없으면 -1
+ */
+int todo_daemon_watch(void);
+
+/**
+ * UI: watch fd에 온 목록을 읽어 user 모드면 ToDo 목록에 반영합니다. (team 모드면 버림)
+ * 반환값: 0 정상, -1 데몬이 끝남 (호출 측에서 fd를 닫음)
+ */
+int todo_daemon_read(int fd);
+
+/** UI: 이 프로세스가 파일을 고쳤다고 데몬에 알림 (다른 UI에 바로 전달되게) */
+void todo_daemon_sync(int fd);
+
+#endif // TODO_DAEMON_H
@@ -0,0 +1,194 @@
+/*========================================*/
+/*        io_uring 최소 래퍼 모듈          */
+/*  - 링 생성/mmap, SQE 제출, CQE 순회     */
+/*  - 제공 버퍼 링 (multishot recv 용)     */
+/*========================================*/
+
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE             // syscall(), MAP_ANONYMOUS
+
+#include "uring.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+
+static int sys_setup(unsigned entries, struct io_uring_params* p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int sys_register(int fd, unsigned opcode, void* arg, unsigned nr_args) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+// 커널이 건드리는 링 인덱스는 acquire/release로 읽고 씀
+static unsigned load_acquire(unsigned* p) {
+    return atomic_load_explicit((_Atomic unsigned*)p, memory_order_acquire);
+}
+
+static void store_release(unsigned* p, unsigned v) {
+    atomic_store_explicit((_Atomic unsigned*)p, v, memory_order_release);
+}
+
+int uring_available(void) {
+    // multishot recv와 제공 버퍼 링이 모두 있는 6.0부터
+    struct utsname u;
+    int major = 0, minor = 0;
+    if (uname(&u) < 0 || sscanf(u.release, "%d.%d", &major, &minor) != 2) return 0;
+    if (major < 6) return 0;
+
+    // seccomp 등으로 막혀 있을 수 있으므로 실제로 만들어 봄
+    Uring r;
+    if (uring_init(&r, 8, 16) < 0) return 0;
+    uring_exit(&r);
+    return 1;
+}
+
+int uring_init(Uring* r, unsigned entries, unsigned cq_entries) {
+    memset(r, 0, sizeof(*r));
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    p.flags = IORING_SETUP_CQSIZE;
+    p.cq_entries = cq_entries;
+    r->fd = sys_setup(entries, &p);
+    if (r->fd < 0) return -1;
+    if (!(p.features & IORING_FEAT_SINGLE_MMAP)) {
+        close(r->fd);
+        errno = ENOSYS;
+        return -1;
+    }
+
+    size_t sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    size_t cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    r->ring_size = sq_size > cq_size ? sq_size : cq_size;
+    r->ring_ptr = mmap(NULL, r->ring_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+    if (r->ring_ptr == MAP_FAILED) {
+        close(r->fd);
+        return -1;
+    }
+    r->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = mmap(NULL, r->sqes_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+    if (r->sqes == MAP_FAILED) {
+        munmap(r->ring_ptr, r->ring_size);
+        close(r->fd);
+        return -1;
+    }
+
+    char* ring = r->ring_ptr;
+    r->sq_head = (unsigned*)(ring + p.sq_off.head);
+    r->sq_tail = (unsigned*)(ring + p.sq_off.tail);
+    r->sq_mask = *(unsigned*)(ring + p.sq_off.ring_mask);
+    r->sq_array = (unsigned*)(ring + p.sq_off.array);
+    r->sq_entries = p.sq_entries;
+    r->sqe_tail = *r->sq_tail;
+    r->cq_head = (unsigned*)(ring + p.cq_off.head);
+    r->cq_tail = (unsigned*)(ring + p.cq_off.tail);
+    r->cq_mask = *(unsigned*)(ring + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe*)(ring + p.cq_off.cqes);
+    return 0;
+}
+
+void uring_exit(Uring* r) {
+    if (r->fd < 0) return;
+    munmap(r->sqes, r->sqes_size);
+    munmap(r->ring_ptr, r->ring_size);
+    close(r->fd);
+    r->fd = -1;
+}
+
+struct io_uring_sqe* uring_get_sqe(Uring* r) {
+    if (r->sqe_tail - load_acquire(r->sq_head) >= r->sq_entries) {
+        uring_submit(r, 0);
+        if (r->sqe_tail - load_acquire(r->sq_head) >= r->sq_entries) return NULL;
+    }
+    unsigned idx = r->sqe_tail & r->sq_mask;
+    struct io_uring_sqe* sqe = &r->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    r->sq_array[idx] = idx;
+    r->sqe_tail++;
+    return sqe;
+}
+
+int uring_submit(Uring* r, unsigned wait_nr) {
+    unsigned to_submit = r->sqe_tail - *r->sq_tail;
+    store_release(r->sq_tail, r->sqe_tail);
+    if (to_submit == 0 && wait_nr == 0) return 0;
+    int ret;
+    do {
+        ret = sys_enter(r->fd, to_submit, wait_nr, wait_nr ? IORING_ENTER_GETEVENTS : 0);
+    } while (ret < 0 && errno == EINTR);
+    return ret;
+}
+
+struct io_uring_cqe* uring_peek_cqe(Uring* r) {
+    unsigned head = *r->cq_head;
+    if (head == load_acquire(r->cq_tail)) return NULL;
+    return &r->cqes[head & r->cq_mask];
+}
+
+void uring_cqe_seen(Uring* r) {
+    store_release(r->cq_head, *r->cq_head + 1);
+}
+
+/*==============================*/
+/*         제공 버퍼 링          */
+/*==============================*/
+int uring_bufring_init(Uring* r, UringBufRing* b, uint16_t bgid, unsigned entries, unsigned buf_size) {
+    memset(b, 0, sizeof(*b));
+    b->br_size = entries * sizeof(struct io_uring_buf);
+    b->br = mmap(NULL, b->br_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (b->br == MAP_FAILED) return -1;
+    b->base = malloc((size_t)entries * buf_size);
+    if (!b->base) {
+        munmap(b->br, b->br_size);
+        return -1;
+    }
+    b->entries = entries;
+    b->buf_size = buf_size;
+    b->bgid = bgid;
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)b->br;
+    reg.ring_entries = entries;
+    reg.bgid = bgid;
+    if (sys_register(r->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        free(b->base);
+        munmap(b->br, b->br_size);
+        return -1;
+    }
+    for (unsigned i = 0; i < entries; i++) uring_bufring_recycle(b, i);
+    return 0;
+}
+
+void uring_bufring_free(Uring* r, UringBufRing* b) {
+    if (!b->br) return;
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.bgid = b->bgid;
+    sys_register(r->fd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+    free(b->base);
+    munmap(b->br, b->br_size);
+    b->br = NULL;
+}
+
+void uring_bufring_recycle(UringBufRing* b, unsigned bid) {
+    _Atomic uint16_t* tailp = (_Atomic uint16_t*)&b->br->tail;
+    uint16_t tail = atomic_load_explicit(tailp, memory_order_relaxed);
+    struct io_uring_buf* buf = &b->br->bufs[tail & (b->entries - 1)];
+    buf->addr = (uint64_t)(uintptr_t)uring_buf(b, bid);
+    buf->len = b->buf_size;
+    buf->bid = (uint16_t)bid;
+    atomic_store_explicit(tailp, (uint16_t)(tail + 1), memory_order_release);
+}
@@ -0,0 +1,83 @@
+#ifndef URING_H
+#define URING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <linux/io_uring.h>
+
+/*==============================*/
+/*   io_uring 최소 래퍼 (raw)    */
+/*==============================*/
+/*
+ * liburing 없이 io_uring_setup / io_uring_enter / io_uring_register 시스템 콜을
+ * 직접 부릅니다. 한 링은 한 쓰레드에서만 씁니다(제출/완료 모두 락 없음).
+ * - Linux 6.0 이상 필요 (multishot recv, 제공 버퍼 링)
+ */
+
+typedef struct {
+    int       fd;
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned  sq_mask;
+    unsigned* sq_array;
+    unsigned  sq_entries;
+    unsigned  sqe_tail;         // 아직 커널에 알리지 않은 SQE까지 포함한 꼬리
+    struct io_uring_sqe* sqes;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned  cq_mask;
+    struct io_uring_cqe* cqes;
+    void*     ring_ptr;         // SQ/CQ 링 (IORING_FEAT_SINGLE_MMAP)
+    size_t    ring_size;
+    size_t    sqes_size;
+} Uring;
+
+// 제공 버퍼 링: 커널이 recv 때 골라 쓰는 고정 크기 버퍼 묶음
+typedef struct {
+    struct io_uring_buf_ring* br;
+    char*     base;             // entries * buf_size
+    unsigned  entries;          // 2의 거듭제곱
+    unsigned  buf_size;
+    uint16_t  bgid;
+    size_t    br_size;
+} UringBufRing;
+
+/** 이 커널에서 쓸 수 있는지 (커널 버전 + io_uring_setup 가능 여부) */
+int uring_available(void);
+
+/**
+ * 링을 만듭니다. cq_entries는 SQ보다 넉넉하게 (멀티샷 완료가 몰릴 때 대비)
+ * 반환값: 0 성공, -1 실패 (errno)
+ */
+int uring_init(Uring* r, unsigned entries, unsigned cq_entries);
+void uring_exit(Uring* r);
+
+/** 빈 SQE를 0으로 채워 돌려줍니다. SQ가 가득 차면 먼저 제출합니다. */
+struct io_uring_sqe* uring_get_sqe(Uring* r);
+
+/**
+ * 쌓인 SQE를 제출하고, wait_nr개 이상 완료될 때까지 기다립니다(0이면 기다리지 않음).
+ * 반환값: 제출한 수, 오류 시 -1
+ */
+int uring_submit(Uring* r, unsigned wait_nr);
+
+/** 다음 완료 항목 (없으면 NULL), 처리 후 uring_cqe_seen() */
+struct io_uring_cqe* uring_peek_cqe(Uring* r);
+void uring_cqe_seen(Uring* r);
+
+/**
+ * 제공 버퍼 링을 만들어 bgid로 등록합니다. (entries는 2의 거듭제곱)
+ * 반환값: 0 성공, -1 실패
+ */
+int uring_bufring_init(Uring* r, UringBufRing* b, uint16_t bgid, unsigned entries, unsigned buf_size);
+void uring_bufring_free(Uring* r, UringBufRing* b);
+
+/** 버퍼 bid의 시작 주소 */
+static inline char* uring_buf(UringBufRing* b, unsigned bid) {
+    return b->base + (size_t)bid * b->buf_size;
+}
+
+/** 다 쓴 버퍼 bid를 다시 커널에 돌려줍니다. */
+void uring_bufring_recycle(UringBufRing* b, unsigned bid);
+
+#endif // URING_H
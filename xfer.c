@@ -0,0 +1,801 @@
+/*========================================*/
+/*         채팅 서버 경유 파일 전송         */
+/*  - 조각 단위 + 조각별 CRC-32 + 창 흐름제어 */
+/*  - 서버: splice로 받고 sendfile로 보냄   */
+/*  - 끊기면 확인된 offset부터 이어 감      */
+/*========================================*/
+
+#define _GNU_SOURCE                 // splice, flock
+
+#include "xfer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/random.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <dirent.h>
+
+#define XFER_LINE_MAX 512           // 헤더/응답 한 줄 (이름 255자 포함)
+
+/*==============================*/
+/*     CRC-32 (slicing-by-8)     */
+/*==============================*/
+// 바이트 하나씩 표를 찾는 대신 8바이트씩 표 8개를 한 번에 찾음 (조각마다 64KiB를 계산하므로)
+static uint32_t crc_table[8][256];
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static void crc_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) c = (c >> 1) ^ (0xEDB88320u & (0u - (c & 1)));
+        crc_table[0][i] = c;
+    }
+    for (int t = 1; t < 8; t++)
+        for (int i = 0; i < 256; i++)
+            crc_table[t][i] = (crc_table[t - 1][i] >> 8) ^ crc_table[0][crc_table[t - 1][i] & 0xFF];
+}
+
+uint32_t xfer_crc32(uint32_t crc, const void* data, size_t len) {
+    pthread_once(&crc_once, crc_init);
+    const unsigned char* p = data;
+    crc = ~crc;
+    for (; len >= 8; p += 8, len -= 8) {
+        uint32_t lo = crc ^ ((uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24);
+        uint32_t hi = (uint32_t)p[4] | (uint32_t)p[5] << 8 | (uint32_t)p[6] << 16 | (uint32_t)p[7] << 24;
+        crc = crc_table[7][lo & 0xFF] ^ crc_table[6][(lo >> 8) & 0xFF] ^
+              crc_table[5][(lo >> 16) & 0xFF] ^ crc_table[4][lo >> 24] ^
+              crc_table[3][hi & 0xFF] ^ crc_table[2][(hi >> 8) & 0xFF] ^
+              crc_table[1][(hi >> 16) & 0xFF] ^ crc_table[0][hi >> 24];
+    }
+    while (len--) crc = (crc >> 8) ^ crc_table[0][(crc ^ *p++) & 0xFF];
+    return ~crc;
+}
+
+/*==============================*/
+/*          소켓 공용            */
+/*==============================*/
+// 블로킹으로 돌리되 멈춘 상대는 XFER_TIMEOUT_SEC 뒤에 오류로 끝남 (connect, splice, sendfile 포함)
+static void set_timeouts(int fd) {
+    struct timeval tv = { .tv_sec = XFER_TIMEOUT_SEC };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+static int send_all(int fd, const void* data, size_t len, int flags) {
+    const char* p = data;
+    while (len > 0) {
+        ssize_t w = send(fd, p, len, flags | MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return -1;
+        p += w;
+        len -= (size_t)w;
+    }
+    return 0;
+}
+
+static int recv_exact(int fd, void* data, size_t len) {
+    char* p = data;
+    while (len > 0) {
+        ssize_t r = recv(fd, p, len, MSG_WAITALL);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return -1;
+        p += r;
+        len -= (size_t)r;
+    }
+    return 0;
+}
+
+// 헤더 한 줄만 읽음 (MSG_PEEK로 개행까지만 가져가 뒤따르는 본문은 소켓에 남김: 서버는 그걸 splice)
+// 개행은 떼어 냄. 반환값: 0 성공, -1 끊김/시간 초과/줄이 너무 김
+static int recv_line(int fd, char* line, size_t size) {
+    size_t have = 0;
+    while (have < size - 1) {
+        ssize_t n = recv(fd, line + have, size - 1 - have, MSG_PEEK);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        char* nl = memchr(line + have, '\n', (size_t)n);
+        size_t take = nl ? (size_t)(nl - (line + have)) + 1 : (size_t)n;
+        if (recv_exact(fd, line + have, take) < 0) return -1;
+        have += take;
+        if (nl) {
+            line[have - 1] = '\0';
+            if (have >= 2 && line[have - 2] == '\r') line[have - 2] = '\0';
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int send_str(int fd, const char* s) {
+    return send_all(fd, s, strlen(s), 0);
+}
+
+// 파일 [off, off+len)의 CRC: 페이지 캐시를 그대로 매핑해 읽음 (사용자 버퍼로 복사하지 않음)
+static int crc_file_range(int file, uint64_t off, size_t len, uint32_t* crc) {
+    uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+    uint64_t base = off & ~(page - 1);
+    size_t skip = (size_t)(off - base);
+    void* p = mmap(NULL, skip + len, PROT_READ, MAP_SHARED, file, (off_t)base);
+    if (p == MAP_FAILED) return -1;
+    *crc = xfer_crc32(0, (const char*)p + skip, len);
+    munmap(p, skip + len);
+    return 0;
+}
+
+// 16진수 16자리 (올리기 키 / 서버가 정한 파일 id, 보관 파일 이름으로 쓰므로 엄격히 검사)
+static int valid_id(const char* id) {
+    size_t n = strspn(id, "0123456789abcdef");
+    return n == 16 && id[n] == '\0';
+}
+
+// 경로를 떼고 제어 문자/구분자를 '_'로 (한 줄 안에 들어가야 하고 받는 쪽 파일 이름이 됨)
+static void clean_name(char* out, size_t size, const char* name) {
+    const char* slash = strrchr(name, '/');
+    if (slash && slash[1]) name = slash + 1;
+    size_t n = 0;
+    for (; *name && n < size - 1; name++)
+        out[n++] = ((unsigned char)*name < 0x20 || *name == '/' || *name == 0x7F) ? '_' : *name;
+    out[n] = '\0';
+    if (n == 0) snprintf(out, size, "file");
+    if (out[0] == '.') out[0] = '_';    // 숨김 파일 / ".." 방지
+}
+
+void xfer_format_size(char* out, size_t size, uint64_t bytes) {
+    if (bytes < 1024) snprintf(out, size, "%" PRIu64 " B", bytes);
+    else if (bytes < 1024 * 1024) snprintf(out, size, "%.1f KB", bytes / 1024.0);
+    else if (bytes < 1024ull * 1024 * 1024) snprintf(out, size, "%.1f MB", bytes / (1024.0 * 1024));
+    else snprintf(out, size, "%.2f GB", bytes / (1024.0 * 1024 * 1024));
+}
+
+/*==============================*/
+/*       서버 (전송 쓰레드)       */
+/*==============================*/
+typedef struct {
+    int  fd;
+    char line[];
+} ServeReq;
+
+static atomic_int serve_active;
+
+// 보관 디렉터리 한도: 이미 쓴 양 + 진행 중인 올리기가 앞으로 쓸 양 (예약)
+static pthread_mutex_t spool_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t        spool_reserved;
+
+static uint64_t spool_usage(void) {
+    uint64_t total = 0;
+    DIR* d = opendir(XFER_SPOOL_DIR);
+    if (!d) return 0;
+    struct dirent* e;
+    struct stat st;
+    while ((e = readdir(d)) != NULL)
+        if (fstatat(dirfd(d), e->d_name, &st, 0) == 0 && S_ISREG(st.st_mode)) total += (uint64_t)st.st_size;
+    closedir(d);
+    return total;
+}
+
+// 반환값: 0 예약함, -1 한도 초과
+static int spool_reserve(uint64_t bytes) {
+    pthread_mutex_lock(&spool_lock);
+    int ok = spool_usage() + spool_reserved + bytes <= XFER_SPOOL_QUOTA;
+    if (ok) spool_reserved += bytes;
+    pthread_mutex_unlock(&spool_lock);
+    return ok ? 0 : -1;
+}
+
+static void spool_release(uint64_t bytes) {
+    pthread_mutex_lock(&spool_lock);
+    spool_reserved -= bytes;
+    pthread_mutex_unlock(&spool_lock);
+}
+
+// 다 받은 파일에 서버가 새 id를 붙임 (무작위, 이미 있는 파일은 절대 덮어쓰지 않음)
+// 반환값: 0 성공 (id에 기록), -1 실패
+static int spool_publish(const char* part, char id[17]) {
+    for (int tries = 0; tries < 8; tries++) {
+        uint64_t r;
+        char path[64];
+        if (getrandom(&r, sizeof(r), 0) != (ssize_t)sizeof(r)) return -1;
+        snprintf(id, 17, "%016" PRIx64, r);
+        snprintf(path, sizeof(path), XFER_SPOOL_DIR "/%s", id);
+        if (link(part, path) == 0) {
+            unlink(part);
+            return 0;
+        }
+        if (errno != EEXIST) return -1;
+    }
+    return -1;
+}
+
+// 창 안에서 미리 와 있던 조각(앞 조각이 /nak 된 뒤의 것)은 읽어 버림
+static int drain(int fd, size_t len) {
+    char scratch[4096];
+    while (len > 0) {
+        size_t n = len < sizeof(scratch) ? len : sizeof(scratch);
+        if (recv_exact(fd, scratch, n) < 0) return -1;
+        len -= n;
+    }
+    return 0;
+}
+
+// 소켓 → 파이프 → 파일 (off 위치), 커널 안에서만 옮김
+static int splice_in(int sock, const int pipefd[2], int file, uint64_t off, size_t len) {
+    loff_t pos = (loff_t)off;
+    while (len > 0) {
+        ssize_t n = splice(sock, NULL, pipefd[1], NULL, len, SPLICE_F_MOVE);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        len -= (size_t)n;
+        while (n > 0) {
+            ssize_t w = splice(pipefd[0], NULL, file, &pos, (size_t)n, SPLICE_F_MOVE);
+            if (w < 0 && errno == EINTR) continue;
+            if (w <= 0) return -1;
+            n -= w;
+        }
+    }
+    return 0;
+}
+
+static int sendfile_all(int sock, int file, uint64_t off, size_t len) {
+    off_t pos = (off_t)off;
+    while (len > 0) {
+        ssize_t n = sendfile(sock, file, &pos, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// .meta: "<확인한 offset 20자리> <전체 크기>" (offset은 자리수가 고정이라 조각마다 제자리에 덮어씀)
+// 쓰기에 실패해도 다음 조각에서 다시 씀 (끝내 못 쓰면 재접속 때 더 앞에서부터 받을 뿐)
+static void meta_store(int meta, uint64_t acked) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%020" PRIu64, acked);
+    ssize_t w = pwrite(meta, buf, 20, 0);
+    (void)w;
+}
+
+// 올리기 키는 보낸 클라이언트만 알고(알림에는 나가지 않음) 이어 받기에만 쓰임
+// 받은 파일의 공개 id는 다 받은 뒤 서버가 정하므로, 남의 파일을 이어 쓰거나 덮거나 다시 알릴 수 없음
+static void serve_upload(int fd, const char* args) {
+    char key[17], id[17], nick[64], name[256];
+    uint64_t size;
+    int n = 0;
+    if (sscanf(args, "%16s %" SCNu64 " %63s %n", key, &size, nick, &n) != 3 || !valid_id(key) ||
+        size == 0 || !args[n]) {
+        send_str(fd, "/error bad upload request\n");
+        return;
+    }
+    if (size > XFER_MAX_FILE) {
+        char max[32], msg[96];
+        xfer_format_size(max, sizeof(max), XFER_MAX_FILE);
+        snprintf(msg, sizeof(msg), "/error file is too large (the server accepts up to %s)\n", max);
+        send_str(fd, msg);
+        return;
+    }
+    clean_name(name, sizeof(name), args + n);
+
+    char part[64], meta_path[64], line[XFER_LINE_MAX];
+    snprintf(part, sizeof(part), XFER_SPOOL_DIR "/up-%s.part", key);
+    snprintf(meta_path, sizeof(meta_path), XFER_SPOOL_DIR "/up-%s.meta", key);
+
+    uint64_t acked = 0, reserved = 0;
+    struct stat st;
+    int file = open(part, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    int meta = open(meta_path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    int pipefd[2] = { -1, -1 };
+    if (file < 0 || meta < 0 || pipe2(pipefd, O_CLOEXEC) < 0) {
+        send_str(fd, "/error cannot store the file on the server\n");
+        goto out;
+    }
+    // 같은 파일을 동시에 두 번 올리는 경우: 먼저 온 쪽만
+    if (flock(file, LOCK_EX | LOCK_NB) < 0) {
+        send_str(fd, "/error this file is already being uploaded\n");
+        goto out;
+    }
+    // 끊기기 전에 확인해 준 데까지 이어 받음 (크기가 다르면 다른 파일이므로 처음부터)
+    char buf[64] = "";
+    uint64_t old_size = 0;
+    if (pread(meta, buf, sizeof(buf) - 1, 0) <= 0 ||
+        sscanf(buf, "%" SCNu64 " %" SCNu64, &acked, &old_size) != 2 || old_size != size ||
+        fstat(file, &st) < 0 || (uint64_t)st.st_size < acked)
+        acked = 0;
+    if (ftruncate(file, (off_t)acked) < 0) acked = 0;
+    int len = snprintf(buf, sizeof(buf), "%020" PRIu64 " %" PRIu64 "\n", acked, size);
+    if (pwrite(meta, buf, (size_t)len, 0) != len || ftruncate(meta, len) < 0) {
+        send_str(fd, "/error cannot store the file on the server\n");
+        goto out;
+    }
+    // 남은 양을 보관 한도에서 미리 잡아 둠 (동시에 올리는 클라이언트들이 함께 넘지 않게)
+    if (spool_reserve(size - acked) < 0) {
+        send_str(fd, "/error the server's file storage is full\n");
+        goto out;
+    }
+    reserved = size - acked;
+    snprintf(line, sizeof(line), "/upload-at %" PRIu64 "\n", acked);
+    if (send_str(fd, line) < 0) goto out;
+
+    while (acked < size) {
+        uint64_t off;
+        unsigned clen, crc, got;
+        if (recv_line(fd, line, sizeof(line)) < 0) goto out;
+        if (sscanf(line, "/chunk %" SCNu64 " %u %x", &off, &clen, &crc) != 3 ||
+            clen == 0 || clen > XFER_CHUNK || off > size || clen > size - off) {
+            send_str(fd, "/error bad chunk\n");
+            goto out;
+        }
+        if (off != acked) {     // /nak 앞서 보낸 조각: 클라이언트가 acked부터 다시 보냄
+            if (drain(fd, clen) < 0) goto out;
+            continue;
+        }
+        if (splice_in(fd, pipefd, file, off, clen) < 0 || crc_file_range(file, off, clen, &got) < 0) goto out;
+        if (got != crc) {
+            if (ftruncate(file, (off_t)off) < 0) goto out;
+            snprintf(line, sizeof(line), "/nak %" PRIu64 "\n", off);
+        }
+        else {
+            acked += clen;
+            meta_store(meta, acked);
+            if (acked == size) break;   // 마지막 확인은 파일에 id를 붙이고 알린 뒤
+            snprintf(line, sizeof(line), "/ack %" PRIu64 "\n", acked);
+        }
+        if (send_str(fd, line) < 0) goto out;
+    }
+    if (spool_publish(part, id) < 0) {
+        send_str(fd, "/error cannot store the file on the server\n");
+        goto out;
+    }
+    unlink(meta_path);
+    // 모두에게 알림 (보낸 사람 포함): 받는 쪽은 이 줄을 보고 /get
+    n = snprintf(line, sizeof(line), "/file %s %" PRIu64 " %s %s\n", id, size, nick, name);
+    chat_server_announce(line, (size_t)n);
+    snprintf(line, sizeof(line), "/ack %" PRIu64 "\n", size);
+    send_str(fd, line);
+    printf(">> file: %s (%" PRIu64 " bytes) from %s\n", name, size, nick);
+out:
+    if (reserved) spool_release(reserved);
+    if (file >= 0) close(file);
+    if (meta >= 0) close(meta);
+    if (pipefd[0] >= 0) close(pipefd[0]);
+    if (pipefd[1] >= 0) close(pipefd[1]);
+}
+
+static void serve_download(int fd, const char* args) {
+    char id[17], path[64], line[XFER_LINE_MAX];
+    uint64_t off;
+    if (sscanf(args, "%16s %" SCNu64, id, &off) != 2 || !valid_id(id)) {
+        send_str(fd, "/error bad download request\n");
+        return;
+    }
+    snprintf(path, sizeof(path), XFER_SPOOL_DIR "/%s", id);
+    struct stat st;
+    int file = open(path, O_RDONLY | O_CLOEXEC);
+    if (file < 0 || fstat(file, &st) < 0) {
+        send_str(fd, "/error no such file on the server\n");
+        if (file >= 0) close(file);
+        return;
+    }
+    uint64_t size = (uint64_t)st.st_size;
+    if (off > size) off = 0;
+    snprintf(line, sizeof(line), "/file-at %" PRIu64 " %" PRIu64 "\n", off, size);
+    if (send_str(fd, line) < 0) goto out;
+
+    uint64_t sent = off, acked = off;
+    while (acked < size) {
+        // 창이 찰 때까지: 헤더는 본문과 같은 세그먼트로 (MSG_MORE), 본문은 페이지 캐시에서 바로
+        while (sent < size && sent - acked < (uint64_t)XFER_WINDOW * XFER_CHUNK) {
+            size_t len = size - sent < XFER_CHUNK ? (size_t)(size - sent) : XFER_CHUNK;
+            uint32_t crc;
+            if (crc_file_range(file, sent, len, &crc) < 0) goto out;
+            int n = snprintf(line, sizeof(line), "/chunk %" PRIu64 " %zu %08x\n", sent, len, crc);
+            if (send_all(fd, line, (size_t)n, MSG_MORE) < 0 || sendfile_all(fd, file, sent, len) < 0) goto out;
+            sent += len;
+        }
+        uint64_t v;
+        if (recv_line(fd, line, sizeof(line)) < 0 ||
+            sscanf(line, "/ack %" SCNu64, &v) != 1 || v <= acked || v > sent) goto out;
+        acked = v;
+    }
+out:
+    close(file);
+}
+
+static void* serve_thread(void* p) {
+    ServeReq* r = p;
+    int fl = fcntl(r->fd, F_GETFL);
+    if (fl >= 0) fcntl(r->fd, F_SETFL, fl & ~O_NONBLOCK);  // 샤드에서 넘어온 소켓은 논블로킹
+    set_timeouts(r->fd);
+    if (mkdir(XFER_SPOOL_DIR, 0700) < 0 && errno != EEXIST)
+        send_str(r->fd, "/error cannot store the file on the server\n");
+    else if (strncmp(r->line, "/upload ", 8) == 0) serve_upload(r->fd, r->line + 8);
+    else serve_download(r->fd, r->line + 10);
+    close(r->fd);
+    free(r);
+    atomic_fetch_sub(&serve_active, 1);
+    return NULL;
+}
+
+int xfer_serve(int fd, const char* line, size_t len) {
+    if (atomic_fetch_add(&serve_active, 1) >= XFER_MAX_ACTIVE) {
+        atomic_fetch_sub(&serve_active, 1);
+        const char* busy = "/error server busy, try again later\n";
+        send(fd, busy, strlen(busy), MSG_DONTWAIT | MSG_NOSIGNAL);
+        return -1;
+    }
+    ServeReq* r = malloc(sizeof(ServeReq) + len + 1);
+    pthread_attr_t attr;
+    pthread_t tid;
+    if (r) {
+        r->fd = fd;
+        memcpy(r->line, line, len);
+        r->line[len] = '\0';
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        int err = pthread_create(&tid, &attr, serve_thread, r);
+        pthread_attr_destroy(&attr);
+        if (err == 0) return 0;
+        free(r);
+    }
+    atomic_fetch_sub(&serve_active, 1);
+    return -1;
+}
+
+/*==============================*/
+/*     클라이언트 (전송 쓰레드)    */
+/*==============================*/
+typedef struct {
+    struct sockaddr_storage addr;
+    socklen_t      addr_len;
+    xfer_report_fn report;
+    int            file;        // 올리기: 원본, 받기: .part
+    uint64_t       size;
+    char           id[17];      // 올리기: 이어 받기용 키 (서버에만), 받기: 서버가 알린 파일 id
+    char           nick[64];
+    char           name[256];
+    char           part[PATH_MAX];
+    char*          buf;         // 조각 하나
+    int            last_pct;    // 마지막으로 알린 진행률 (25% 단위)
+    char           why[128];    // 마지막 실패 이유
+} XferJob;
+
+static void job_report(XferJob* j, const char* fmt, ...) {
+    char msg[512];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+    j->report(msg);
+}
+
+// 이전 접속(또는 이전 실행)에서 확인된 데부터 이어 갈 때 한 번 알림
+static void job_resumed(XferJob* j, uint64_t at) {
+    if (at == 0 || at == j->size) return;
+    char sz[32];
+    xfer_format_size(sz, sizeof(sz), at);
+    job_report(j, "[file] %s: resuming after %s\n", j->name, sz);
+}
+
+// 큰 파일만 25% 단위로 알림 (작은 파일은 끝났을 때 한 번)
+static void job_progress(XferJob* j, const char* verb, uint64_t done) {
+    if (j->size < (uint64_t)XFER_WINDOW * XFER_CHUNK || done == j->size) return;
+    int pct = (int)(done * 4 / j->size) * 25;
+    if (pct <= j->last_pct) return;
+    j->last_pct = pct;
+    job_report(j, "[file] %s %s: %d%%\n", verb, j->name, pct);
+}
+
+static int job_connect(XferJob* j) {
+    int fd = socket(j->addr.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    set_timeouts(fd);
+    if (connect(fd, (struct sockaddr*)&j->addr, j->addr_len) < 0) {
+        int e = errno;
+        close(fd);
+        errno = e;
+        return -1;
+    }
+    return fd;
+}
+
+// 서버가 "/error <이유>" 로 거절했으면 이유를 남기고 1
+static int server_refused(XferJob* j, const char* line) {
+    if (strncmp(line, "/error ", 7) != 0) return 0;
+    snprintf(j->why, sizeof(j->why), "%.120s", line + 7);
+    return 1;
+}
+
+// 접속 한 번 동안 올림. 반환값: 0 끝남, 1 끊김(다시 접속해 이어 감), -1 포기
+static int send_once(XferJob* j, uint64_t* acked) {
+    char line[XFER_LINE_MAX];
+    int fd = job_connect(j), ret = 1;
+    if (fd < 0) {
+        snprintf(j->why, sizeof(j->why), "%s", strerror(errno));
+        return 1;
+    }
+    snprintf(j->why, sizeof(j->why), "connection lost");
+    snprintf(line, sizeof(line), "/upload %s %" PRIu64 " %s %s\n", j->id, j->size, j->nick, j->name);
+    uint64_t at;
+    if (send_str(fd, line) < 0 || recv_line(fd, line, sizeof(line)) < 0) goto out;
+    if (server_refused(j, line)) {
+        ret = -1;
+        goto out;
+    }
+    if (sscanf(line, "/upload-at %" SCNu64, &at) != 1 || at > j->size) goto out;
+
+    if (at != *acked) job_resumed(j, at);
+    uint64_t next = *acked = at;
+    while (*acked < j->size) {
+        while (next < j->size && next - *acked < (uint64_t)XFER_WINDOW * XFER_CHUNK) {
+            size_t len = j->size - next < XFER_CHUNK ? (size_t)(j->size - next) : XFER_CHUNK;
+            ssize_t r = pread(j->file, j->buf, len, (off_t)next);
+            if (r != (ssize_t)len) {
+                snprintf(j->why, sizeof(j->why), "file changed while sending");
+                ret = -1;
+                goto out;
+            }
+            int n = snprintf(line, sizeof(line), "/chunk %" PRIu64 " %zu %08x\n",
+                             next, len, xfer_crc32(0, j->buf, len));
+            if (send_all(fd, line, (size_t)n, MSG_MORE) < 0 || send_all(fd, j->buf, len, 0) < 0) goto out;
+            next += len;
+        }
+        uint64_t v;
+        if (recv_line(fd, line, sizeof(line)) < 0) goto out;
+        if (server_refused(j, line)) {
+            ret = -1;
+            goto out;
+        }
+        if (sscanf(line, "/ack %" SCNu64, &v) == 1 && v > *acked && v <= next) *acked = v;
+        else if (sscanf(line, "/nak %" SCNu64, &v) == 1 && v == *acked) next = v;     // 그 조각부터 다시
+        else goto out;
+        job_progress(j, "sending", *acked);
+    }
+    ret = 0;
+out:
+    close(fd);
+    return ret;
+}
+
+// 접속 한 번 동안 받음. 반환값: 0 끝남, 1 끊김/CRC 불일치(다시 접속해 이어 감), -1 포기
+static int get_once(XferJob* j, uint64_t* done) {
+    struct stat st;
+    if (fstat(j->file, &st) < 0) return -1;
+    uint64_t off = (uint64_t)st.st_size;       // .part에는 확인한 조각만 순서대로 씀
+    if (off > j->size && ftruncate(j->file, 0) == 0) off = 0;
+    if (off != *done) job_resumed(j, off);
+    *done = off;
+    if (off == j->size) return 0;
+
+    char line[XFER_LINE_MAX];
+    int fd = job_connect(j), ret = 1;
+    if (fd < 0) {
+        snprintf(j->why, sizeof(j->why), "%s", strerror(errno));
+        return 1;
+    }
+    snprintf(j->why, sizeof(j->why), "connection lost");
+    snprintf(line, sizeof(line), "/download %s %" PRIu64 "\n", j->id, off);
+    uint64_t at, total;
+    if (send_str(fd, line) < 0 || recv_line(fd, line, sizeof(line)) < 0) goto out;
+    if (server_refused(j, line)) {
+        ret = -1;
+        goto out;
+    }
+    if (sscanf(line, "/file-at %" SCNu64 " %" SCNu64, &at, &total) != 2 || at != off || total != j->size) {
+        snprintf(j->why, sizeof(j->why), "server has a different file");
+        ret = -1;
+        goto out;
+    }
+    while (off < j->size) {
+        uint64_t coff;
+        unsigned len, crc;
+        if (recv_line(fd, line, sizeof(line)) < 0) goto out;
+        if (sscanf(line, "/chunk %" SCNu64 " %u %x", &coff, &len, &crc) != 3 ||
+            coff != off || len == 0 || len > XFER_CHUNK || len > j->size - off) goto out;
+        if (recv_exact(fd, j->buf, len) < 0) goto out;
+        if (xfer_crc32(0, j->buf, len) != crc) {
+            snprintf(j->why, sizeof(j->why), "checksum mismatch at %" PRIu64, off);
+            goto out;
+        }
+        if (pwrite(j->file, j->buf, len, (off_t)off) != (ssize_t)len) {
+            snprintf(j->why, sizeof(j->why), "%s", strerror(errno));
+            ret = -1;
+            goto out;
+        }
+        off += len;
+        *done = off;
+        int n = snprintf(line, sizeof(line), "/ack %" PRIu64 "\n", off);
+        if (send_all(fd, line, (size_t)n, 0) < 0) goto out;
+        job_progress(j, "receiving", off);
+    }
+    ret = 0;
+out:
+    close(fd);
+    return ret;
+}
+
+// 끊기면 다시 접속해 이어 감: 진전이 없을 때만 실패로 세고 기다리는 시간을 두 배로
+static int job_run(XferJob* j, int (*once)(XferJob*, uint64_t*)) {
+    uint64_t done = 0;
+    int fails = 0;
+    while (1) {
+        uint64_t before = done;
+        int r = once(j, &done);
+        if (r <= 0) return r;
+        fails = done > before ? 1 : fails + 1;
+        if (fails > XFER_RETRIES) return -1;
+        unsigned wait = 1u << (fails - 1);
+        job_report(j, "[file] %s: %s, resuming in %us\n", j->name, j->why, wait);
+        sleep(wait);
+    }
+}
+
+static void job_free(XferJob* j) {
+    if (j->file >= 0) close(j->file);
+    free(j->buf);
+    free(j);
+}
+
+static void* send_thread(void* p) {
+    XferJob* j = p;
+    char sz[32];
+    xfer_format_size(sz, sizeof(sz), j->size);
+    if (job_run(j, send_once) == 0) job_report(j, "[file] sent %s (%s)\n", j->name, sz);
+    else job_report(j, "[file] could not send %s: %s\n", j->name, j->why);
+    job_free(j);
+    return NULL;
+}
+
+// 받은 파일 이름이 겹치면 "name.1", "name.2", ...
+static void* get_thread(void* p) {
+    XferJob* j = p;
+    char sz[32], path[PATH_MAX];
+    xfer_format_size(sz, sizeof(sz), j->size);
+    if (job_run(j, get_once) < 0) {
+        job_report(j, "[file] could not receive %s: %s\n", j->name, j->why);
+        job_free(j);
+        return NULL;
+    }
+    snprintf(path, sizeof(path), XFER_DOWNLOAD_DIR "/%s", j->name);
+    for (int i = 1; access(path, F_OK) == 0 && i < 1000; i++)
+        snprintf(path, sizeof(path), XFER_DOWNLOAD_DIR "/%s.%d", j->name, i);
+    if (rename(j->part, path) == 0) job_report(j, "[file] saved %s (%s)\n", path, sz);
+    else job_report(j, "[file] could not save %s: %s\n", path, strerror(errno));
+    job_free(j);
+    return NULL;
+}
+
+static XferJob* job_new(const struct sockaddr* addr, socklen_t addr_len, xfer_report_fn report) {
+    if (addr_len > sizeof(struct sockaddr_storage)) return NULL;
+    XferJob* j = calloc(1, sizeof(XferJob));
+    if (!j) return NULL;
+    j->buf = malloc(XFER_CHUNK);
+    if (!j->buf) {
+        free(j);
+        return NULL;
+    }
+    memcpy(&j->addr, addr, addr_len);
+    j->addr_len = addr_len;
+    j->report = report;
+    j->file = -1;
+    j->last_pct = 0;
+    return j;
+}
+
+static int job_start(XferJob* j, void* (*fn)(void*)) {
+    pthread_attr_t attr;
+    pthread_t tid;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int err = pthread_create(&tid, &attr, fn, j);
+    pthread_attr_destroy(&attr);
+    if (err == 0) return 0;
+    job_free(j);
+    errno = err;
+    return -1;
+}
+
+static uint64_t       key_salt;
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+
+static void key_salt_init(void) {
+    if (getrandom(&key_salt, sizeof(key_salt), 0) != (ssize_t)sizeof(key_salt))
+        key_salt = (uint64_t)time(NULL) ^ ((uint64_t)getpid() << 32);
+}
+
+int xfer_send_start(const struct sockaddr* addr, socklen_t addr_len,
+                    const char* path, const char* nick, xfer_report_fn report) {
+    struct stat st;
+    char real[PATH_MAX];
+    XferJob* j = job_new(addr, addr_len, report);
+    if (!j) {
+        errno = ENOMEM;
+        return -1;
+    }
+    j->file = open(path, O_RDONLY | O_CLOEXEC);
+    if (j->file < 0 || fstat(j->file, &st) < 0 || !realpath(path, real)) {
+        int e = errno;
+        job_free(j);
+        errno = e;
+        return -1;
+    }
+    if (!S_ISREG(st.st_mode) || st.st_size == 0) {
+        job_free(j);
+        errno = S_ISREG(st.st_mode) ? ENODATA : EISDIR;
+        return -1;
+    }
+    j->size = (uint64_t)st.st_size;
+
+    // 올리기 키: 이 실행의 무작위 값 + 경로 + 크기 + 수정 시각의 FNV-1a 해시
+    // (실행 중에 같은 파일을 다시 보내면 같은 키라 서버가 이어 받음, 다른 사람은 키를 알 수 없음)
+    pthread_once(&key_once, key_salt_init);
+    uint64_t h = 1469598103934665603ull;
+    char key[PATH_MAX + 64];
+    int n = snprintf(key, sizeof(key), "%016" PRIx64 "|%s|%" PRIu64 "|%lld.%09ld", key_salt, real, j->size,
+                     (long long)st.st_mtim.tv_sec, st.st_mtim.tv_nsec);
+    for (int i = 0; i < n; i++) h = (h ^ (unsigned char)key[i]) * 1099511628211ull;
+    snprintf(j->id, sizeof(j->id), "%016" PRIx64, h);
+
+    // 닉네임은 한 단어로 (서버 줄 형식)
+    snprintf(j->nick, sizeof(j->nick), "%s", nick && nick[0] ? nick : "anonymous");
+    for (char* c = j->nick; *c; c++)
+        if (*c == ' ' || (unsigned char)*c < 0x20) *c = '_';
+    clean_name(j->name, sizeof(j->name), real);
+
+    char sz[32];
+    xfer_format_size(sz, sizeof(sz), j->size);
+    job_report(j, "[file] sending %s (%s)...\n", j->name, sz);
+    return job_start(j, send_thread);
+}
+
+int xfer_get_start(const struct sockaddr* addr, socklen_t addr_len,
+                   const char* id, uint64_t size, const char* name, xfer_report_fn report) {
+    if (!valid_id(id)) {
+        errno = EINVAL;
+        return -1;
+    }
+    XferJob* j = job_new(addr, addr_len, report);
+    if (!j) {
+        errno = ENOMEM;
+        return -1;
+    }
+    snprintf(j->id, sizeof(j->id), "%s", id);
+    j->size = size;
+    clean_name(j->name, sizeof(j->name), name);
+    snprintf(j->part, sizeof(j->part), XFER_DOWNLOAD_DIR "/.%s.part", id);
+    if (mkdir(XFER_DOWNLOAD_DIR, 0755) < 0 && errno != EEXIST) {
+        int e = errno;
+        job_free(j);
+        errno = e;
+        return -1;
+    }
+    j->file = open(j->part, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (j->file < 0) {
+        int e = errno;
+        job_free(j);
+        errno = e;
+        return -1;
+    }
+    // 같은 파일을 두 번 /get 하면 먼저 시작한 쪽만
+    if (flock(j->file, LOCK_EX | LOCK_NB) < 0) {
+        job_free(j);
+        errno = EALREADY;
+        return -1;
+    }
+    char sz[32];
+    xfer_format_size(sz, sizeof(sz), size);
+    job_report(j, "[file] receiving %s (%s)...\n", j->name, sz);
+    return job_start(j, get_thread);
+}
@@ -0,0 +1,83 @@
+#ifndef XFER_H
+#define XFER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/socket.h>
+
+/*==============================*/
+/*     채팅 서버 경유 파일 전송    */
+/*==============================*/
+/*
+ * 파일 하나를 옮길 때마다 채팅 서버에 연결을 하나 더 열어, 첫 줄로 채팅 연결이 아님을 알립니다.
+ * 서버 샤드는 그 연결을 전송 쓰레드에 넘기므로 큰 파일이 채팅 메시지를 막지 않습니다.
+ * 조각(chunk)마다 헤더 한 줄 뒤에 원본 바이트가 그대로 따라옵니다.
+ *   "/chunk <offset> <len> <crc32 16진수>\n" + len 바이트
+ *
+ * 올리기 (클라이언트 → 서버)
+ *   C: "/upload <key> <size> <nick> <name>"  S: "/upload-at <offset>" (이미 받아 둔 데까지)
+ *      key는 보낸 클라이언트만 아는 이어 받기용 값 (알림에 나가지 않음)
+ *   C: 조각을 XFER_WINDOW개까지 앞서 보냄    S: 조각마다 "/ack <다음 offset>" 또는 "/nak <offset>"
+ *   서버는 소켓 → 파이프 → 파일로 splice 하고(사용자 공간 복사 없음) mmap으로 CRC를 확인합니다.
+ *   다 받으면 서버가 무작위 id를 새로 붙여 모두에게 "/file <id> <size> <nick> <name>" 을 중계합니다.
+ *   (이미 있는 파일은 덮어쓰지 않고, 다른 사람이 남의 파일을 이어 쓰거나 다시 알릴 수 없음)
+ * 받기 (서버 → 클라이언트)
+ *   C: "/download <id> <offset>"             S: "/file-at <offset> <size>"
+ *   S: 조각을 XFER_WINDOW개까지 앞서 보냄     C: 확인한 조각마다 "/ack <다음 offset>"
+ *   서버는 조각의 CRC를 mmap으로 구하고 본문은 sendfile로 보냅니다.
+ * 끊기면 클라이언트가 다시 접속해 마지막으로 확인된 offset부터 이어 갑니다.
+ * (올리기: 서버가 .meta에 남긴 offset, 같은 클라이언트 실행 안에서만 / 받기: 확인한 조각만 쓴 .part 파일 크기)
+ */
+
+#define XFER_CHUNK          (64 * 1024)     // 조각 크기 (마지막 조각만 더 작음)
+#define XFER_WINDOW         8               // 확인 없이 앞서 보내는 조각 수
+#define XFER_TIMEOUT_SEC    30              // 상대가 이 시간 동안 조용하면 끊고 이어 받기
+#define XFER_RETRIES        5               // 진전 없이 연속으로 실패하면 포기 (대기 1, 2, 4... 초)
+#define XFER_MAX_ACTIVE     32              // 서버: 동시에 도는 전송 쓰레드 한도
+#define XFER_MAX_FILE       (4ull << 30)    // 서버: 파일 하나의 최대 크기
+#define XFER_SPOOL_QUOTA    (16ull << 30)   // 서버: 보관 디렉터리 전체 한도 (진행 중인 올리기 포함)
+#define XFER_SPOOL_DIR      "coshell-files"     // 서버: 실행한 디렉터리 아래 받은 파일 보관
+#define XFER_DOWNLOAD_DIR   "coshell-downloads" // 클라이언트: 실행한 디렉터리 아래 받은 파일
+
+/** CRC-32 (IEEE, zlib과 같은 값). crc는 이어 계산할 때 앞 결과, 처음이면 0 */
+uint32_t xfer_crc32(uint32_t crc, const void* data, size_t len);
+
+/** 사람이 읽는 크기 ("512 B", "1.5 MB", ...) */
+void xfer_format_size(char* out, size_t size, uint64_t bytes);
+
+/*==============================*/
+/*          클라이언트           */
+/*==============================*/
+/** 진행 상황 한 줄 (개행 포함). 전송 쓰레드에서 불리므로 화면은 직접 건드리지 말 것 */
+typedef void (*xfer_report_fn)(const char* msg);
+
+/**
+ * path를 올리는 쓰레드를 시작합니다. addr: 채팅 서버 주소 (채팅 소켓의 getpeername)
+ * 실행 중에 같은 파일(경로, 크기, 수정 시각)을 다시 보내면 서버가 받아 둔 데부터 이어 갑니다.
+ * 반환값: 0 시작함, -1 실패 (errno: 파일을 열 수 없음 등)
+ */
+int xfer_send_start(const struct sockaddr* addr, socklen_t addr_len,
+                    const char* path, const char* nick, xfer_report_fn report);
+
+/**
+ * 서버가 알린 파일(id, size, name)을 XFER_DOWNLOAD_DIR 로 받는 쓰레드를 시작합니다.
+ * 전에 받다 만 .part 파일이 있으면 그 뒤부터 받습니다.
+ * 반환값: 0 시작함, -1 실패
+ */
+int xfer_get_start(const struct sockaddr* addr, socklen_t addr_len,
+                   const char* id, uint64_t size, const char* name, xfer_report_fn report);
+
+/*==============================*/
+/*            서버               */
+/*==============================*/
+/**
+ * 첫 줄이 "/upload ..." / "/download ..." 인 연결을 넘겨받아 전송 쓰레드에서 처리합니다.
+ * (샤드는 fd를 이벤트 루프에서 뺀 뒤 호출, 이후 fd는 쓰레드가 닫음)
+ * 반환값: 0 넘겨받음, -1 실패 (쓰레드 한도 초과 등, fd는 호출 측이 닫음)
+ */
+int xfer_serve(int fd, const char* line, size_t len);
+
+/** chat_server.c 제공: 모든 샤드의 클라이언트에게 data를 중계 (어느 쓰레드에서나) */
+void chat_server_announce(const char* data, size_t len);
+
+#endif // XFER_H